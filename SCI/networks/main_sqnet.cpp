@@ -17,25 +17,13 @@ int32_t kScale = 12;
 void MatAddBroadCast2(
     int64_t s1, int64_t s2, uint64_t *A, uint64_t *B, uint64_t *outArr
 ) {
-    for (uint64_t i1 = (int32_t)0; i1 < s1; i1++) {
-        for (uint64_t i2 = (int32_t)0; i2 < s2; i2++) {
-            Arr2DIdxRowM(outArr, s1, s2, i1, i2) = SecretAdd(
-                Arr2DIdxRowM(A, s1, s2, i1, i2), Arr1DIdxRowM(B, s2, i2)
-            );
-        }
-    }
+    MatAddBroadCast(s1, s2, A, B, outArr);
 }
 
 void MatAdd2(
     int64_t s1, int64_t s2, uint64_t *A, uint64_t *B, uint64_t *outArr
 ) {
-    for (uint64_t i1 = (int32_t)0; i1 < s1; i1++) {
-        for (uint64_t i2 = (int32_t)0; i2 < s2; i2++) {
-            Arr2DIdxRowM(outArr, s1, s2, i1, i2) = SecretAdd(
-                Arr2DIdxRowM(A, s1, s2, i1, i2), Arr2DIdxRowM(B, s1, s2, i1, i2)
-            );
-        }
-    }
+    ElemWiseSecretAdd(s1 * s2, A, B, outArr);
 }
 
 void MatAddBroadCast4(
@@ -47,19 +35,7 @@ void MatAddBroadCast4(
     uint64_t *B,
     uint64_t *outArr
 ) {
-    for (uint64_t i1 = (int32_t)0; i1 < s1; i1++) {
-        for (uint64_t i2 = (int32_t)0; i2 < s2; i2++) {
-            for (uint64_t i3 = (int32_t)0; i3 < s3; i3++) {
-                for (uint64_t i4 = (int32_t)0; i4 < s4; i4++) {
-                    Arr4DIdxRowM(outArr, s1, s2, s3, s4, i1, i2, i3, i4) =
-                        SecretAdd(
-                            Arr4DIdxRowM(A, s1, s2, s3, s4, i1, i2, i3, i4),
-                            Arr1DIdxRowM(B, s4, i4)
-                        );
-                }
-            }
-        }
-    }
+    MatAddBroadCast(s1 * s2 * s3, s4, A, B, outArr);
 }
 
 void MatAdd4(
@@ -71,19 +47,7 @@ void MatAdd4(
     uint64_t *B,
     uint64_t *outArr
 ) {
-    for (uint64_t i1 = (int32_t)0; i1 < s1; i1++) {
-        for (uint64_t i2 = (int32_t)0; i2 < s2; i2++) {
-            for (uint64_t i3 = (int32_t)0; i3 < s3; i3++) {
-                for (uint64_t i4 = (int32_t)0; i4 < s4; i4++) {
-                    Arr4DIdxRowM(outArr, s1, s2, s3, s4, i1, i2, i3, i4) =
-                        SecretAdd(
-                            Arr4DIdxRowM(A, s1, s2, s3, s4, i1, i2, i3, i4),
-                            Arr4DIdxRowM(B, s1, s2, s3, s4, i1, i2, i3, i4)
-                        );
-                }
-            }
-        }
-    }
+    ElemWiseSecretAdd(s1 * s2 * s3 * s4, A, B, outArr);
 }
 
 void MatAddBroadCast5(
@@ -96,25 +60,7 @@ void MatAddBroadCast5(
     uint64_t *B,
     uint64_t *outArr
 ) {
-    for (uint64_t i1 = (int32_t)0; i1 < s1; i1++) {
-        for (uint64_t i2 = (int32_t)0; i2 < s2; i2++) {
-            for (uint64_t i3 = (int32_t)0; i3 < s3; i3++) {
-                for (uint64_t i4 = (int32_t)0; i4 < s4; i4++) {
-                    for (uint64_t i5 = (int32_t)0; i5 < s5; i5++) {
-                        Arr5DIdxRowM(
-                            outArr, s1, s2, s3, s4, s5, i1, i2, i3, i4, i5
-                        ) =
-                            SecretAdd(
-                                Arr5DIdxRowM(
-                                    A, s1, s2, s3, s4, s5, i1, i2, i3, i4, i5
-                                ),
-                                Arr1DIdxRowM(B, s5, i5)
-                            );
-                    }
-                }
-            }
-        }
-    }
+    MatAddBroadCast(s1 * s2 * s3 * s4, s5, A, B, outArr);
 }
 
 void MatAdd5(
@@ -127,27 +73,7 @@ void MatAdd5(
     uint64_t *B,
     uint64_t *outArr
 ) {
-    for (uint64_t i1 = (int32_t)0; i1 < s1; i1++) {
-        for (uint64_t i2 = (int32_t)0; i2 < s2; i2++) {
-            for (uint64_t i3 = (int32_t)0; i3 < s3; i3++) {
-                for (uint64_t i4 = (int32_t)0; i4 < s4; i4++) {
-                    for (uint64_t i5 = (int32_t)0; i5 < s5; i5++) {
-                        Arr5DIdxRowM(
-                            outArr, s1, s2, s3, s4, s5, i1, i2, i3, i4, i5
-                        ) =
-                            SecretAdd(
-                                Arr5DIdxRowM(
-                                    A, s1, s2, s3, s4, s5, i1, i2, i3, i4, i5
-                                ),
-                                Arr5DIdxRowM(
-                                    B, s1, s2, s3, s4, s5, i1, i2, i3, i4, i5
-                                )
-                            );
-                    }
-                }
-            }
-        }
-    }
+    ElemWiseSecretAdd(s1 * s2 * s3 * s4 * s5, A, B, outArr);
 }
 
 void CreateTensor1(int64_t s1, int64_t val, int64_t *arr) {
@@ -2860,89 +2786,17 @@ void Floor2(
 void ScaleUp1(int64_t s1, uint64_t *arr, int64_t sf) { ScaleUp(s1, arr, sf); }
 
 void ScaleUp2(int64_t s1, int64_t s2, uint64_t *arr, int64_t sf) {
-    int64_t size = (s1 * s2);
-
-    uint64_t *reshapedArr = make_array<uint64_t>(size);
-    for (uint64_t i1 = (int32_t)0; i1 < s1; i1++) {
-        for (uint64_t i2 = (int32_t)0; i2 < s2; i2++) {
-            int64_t linIdx = ((i1 * s2) + i2);
-            Arr1DIdxRowM(reshapedArr, size, linIdx) =
-                Arr2DIdxRowM(arr, s1, s2, i1, i2);
-        }
-    }
-    ScaleUp(size, reshapedArr, sf);
-    for (uint64_t i1 = (int32_t)0; i1 < s1; i1++) {
-        for (uint64_t i2 = (int32_t)0; i2 < s2; i2++) {
-            int64_t linIdx = ((i1 * s2) + i2);
-            Arr2DIdxRowM(arr, s1, s2, i1, i2) =
-                Arr1DIdxRowM(reshapedArr, size, linIdx);
-        }
-    }
-    ClearMemSecret1(size, reshapedArr);
+    ScaleUp(s1 * s2, arr, sf);
 }
 
 void ScaleUp3(int64_t s1, int64_t s2, int64_t s3, uint64_t *arr, int64_t sf) {
-    int64_t size = ((s1 * s2) * s3);
-
-    uint64_t *reshapedArr = make_array<uint64_t>(size);
-    for (uint64_t i1 = (int32_t)0; i1 < s1; i1++) {
-        for (uint64_t i2 = (int32_t)0; i2 < s2; i2++) {
-            for (uint64_t i3 = (int32_t)0; i3 < s3; i3++) {
-                int64_t linIdx = ((((i1 * s2) * s3) + (i2 * s3)) + i3);
-                Arr1DIdxRowM(reshapedArr, size, linIdx) =
-                    Arr3DIdxRowM(arr, s1, s2, s3, i1, i2, i3);
-            }
-        }
-    }
-    ScaleUp(size, reshapedArr, sf);
-    for (uint64_t i1 = (int32_t)0; i1 < s1; i1++) {
-        for (uint64_t i2 = (int32_t)0; i2 < s2; i2++) {
-            for (uint64_t i3 = (int32_t)0; i3 < s3; i3++) {
-                int64_t linIdx = ((((i1 * s2) * s3) + (i2 * s3)) + i3);
-                Arr3DIdxRowM(arr, s1, s2, s3, i1, i2, i3) =
-                    Arr1DIdxRowM(reshapedArr, size, linIdx);
-            }
-        }
-    }
-    ClearMemSecret1(size, reshapedArr);
+    ScaleUp(s1 * s2 * s3, arr, sf);
 }
 
 void ScaleUp4(
     int64_t s1, int64_t s2, int64_t s3, int64_t s4, uint64_t *arr, int64_t sf
 ) {
-    int64_t size = (((s1 * s2) * s3) * s4);
-
-    uint64_t *reshapedArr = make_array<uint64_t>(size);
-    for (uint64_t i1 = (int32_t)0; i1 < s1; i1++) {
-        for (uint64_t i2 = (int32_t)0; i2 < s2; i2++) {
-            for (uint64_t i3 = (int32_t)0; i3 < s3; i3++) {
-                for (uint64_t i4 = (int32_t)0; i4 < s4; i4++) {
-                    int64_t linIdx =
-                        ((((((i1 * s2) * s3) * s4) + ((i2 * s3) * s4)) +
-                          (i3 * s4)) +
-                         i4);
-                    Arr1DIdxRowM(reshapedArr, size, linIdx) =
-                        Arr4DIdxRowM(arr, s1, s2, s3, s4, i1, i2, i3, i4);
-                }
-            }
-        }
-    }
-    ScaleUp(size, reshapedArr, sf);
-    for (uint64_t i1 = (int32_t)0; i1 < s1; i1++) {
-        for (uint64_t i2 = (int32_t)0; i2 < s2; i2++) {
-            for (uint64_t i3 = (int32_t)0; i3 < s3; i3++) {
-                for (uint64_t i4 = (int32_t)0; i4 < s4; i4++) {
-                    int64_t linIdx =
-                        ((((((i1 * s2) * s3) * s4) + ((i2 * s3) * s4)) +
-                          (i3 * s4)) +
-                         i4);
-                    Arr4DIdxRowM(arr, s1, s2, s3, s4, i1, i2, i3, i4) =
-                        Arr1DIdxRowM(reshapedArr, size, linIdx);
-                }
-            }
-        }
-    }
-    ClearMemSecret1(size, reshapedArr);
+    ScaleUp(s1 * s2 * s3 * s4, arr, sf);
 }
 
 void ScaleDown1(int64_t s1, uint64_t *arr, int64_t sf) {
@@ -310,6 +310,94 @@ void AuxProtocols::msb1_to_wrap(
     }
 }
 
+// With the MSB of x being 0, Wrap(x) = msb(x_A) OR msb(x_B)
+//   = msb(x_A) + msb(x_B) * (1 - msb(x_A)),
+// i.e., one COT with BOB's msb as the choice bit and (1 - msb(x_A)) as the
+// correlation.
+void AuxProtocols::msb0_to_arith_wrap(
+    uint64_t *x, uint64_t *wrap_x, int32_t size, int32_t bw_x, int32_t bw_wrap
+) {
+    assert(bw_x <= 64 && bw_wrap <= 64 && bw_wrap >= 1);
+    if (bw_wrap == 1) {
+        uint8_t *wrap_b = new uint8_t[size];
+        msb0_to_wrap(x, wrap_b, size, bw_x);
+        for (int i = 0; i < size; i++) {
+            wrap_x[i] = wrap_b[i];
+        }
+        delete[] wrap_b;
+        return;
+    }
+    uint64_t mask = (bw_wrap == 64 ? -1 : ((1ULL << bw_wrap) - 1));
+
+    if (party == sci::ALICE) {
+        uint64_t *corr_data = new uint64_t[size];
+        for (int i = 0; i < size; i++) {
+            uint64_t msb_xa = (x[i] >> (bw_x - 1)) & 1;
+            corr_data[i] = (1 - msb_xa) & mask;
+        }
+        otpack->iknp_straight->send_cot(wrap_x, corr_data, size, bw_wrap);
+
+        for (int i = 0; i < size; i++) {
+            uint64_t msb_xa = (x[i] >> (bw_x - 1)) & 1;
+            wrap_x[i] = (msb_xa - wrap_x[i]) & mask;
+        }
+        delete[] corr_data;
+    } else {  // party == sci::BOB
+        uint8_t *msb_xb = new uint8_t[size];
+        for (int i = 0; i < size; i++) {
+            msb_xb[i] = (x[i] >> (bw_x - 1)) & 1;
+        }
+        otpack->iknp_straight->recv_cot(wrap_x, (bool *)msb_xb, size, bw_wrap);
+
+        for (int i = 0; i < size; i++) {
+            wrap_x[i] &= mask;
+        }
+        delete[] msb_xb;
+    }
+}
+
+// With the MSB of x being 1, Wrap(x) = msb(x_A) AND msb(x_B)
+//   = msb(x_B) * msb(x_A).
+void AuxProtocols::msb1_to_arith_wrap(
+    uint64_t *x, uint64_t *wrap_x, int32_t size, int32_t bw_x, int32_t bw_wrap
+) {
+    assert(bw_x <= 64 && bw_wrap <= 64 && bw_wrap >= 1);
+    if (bw_wrap == 1) {
+        uint8_t *wrap_b = new uint8_t[size];
+        msb1_to_wrap(x, wrap_b, size, bw_x);
+        for (int i = 0; i < size; i++) {
+            wrap_x[i] = wrap_b[i];
+        }
+        delete[] wrap_b;
+        return;
+    }
+    uint64_t mask = (bw_wrap == 64 ? -1 : ((1ULL << bw_wrap) - 1));
+
+    if (party == sci::ALICE) {
+        uint64_t *corr_data = new uint64_t[size];
+        for (int i = 0; i < size; i++) {
+            corr_data[i] = (x[i] >> (bw_x - 1)) & 1;
+        }
+        otpack->iknp_straight->send_cot(wrap_x, corr_data, size, bw_wrap);
+
+        for (int i = 0; i < size; i++) {
+            wrap_x[i] = (-wrap_x[i]) & mask;
+        }
+        delete[] corr_data;
+    } else {  // party == sci::BOB
+        uint8_t *msb_xb = new uint8_t[size];
+        for (int i = 0; i < size; i++) {
+            msb_xb[i] = (x[i] >> (bw_x - 1)) & 1;
+        }
+        otpack->iknp_straight->recv_cot(wrap_x, (bool *)msb_xb, size, bw_wrap);
+
+        for (int i = 0; i < size; i++) {
+            wrap_x[i] &= mask;
+        }
+        delete[] msb_xb;
+    }
+}
+
 void AuxProtocols::AND(uint8_t *x, uint8_t *y, uint8_t *z, int32_t size) {
     int old_size = size;
     size = ceil(size / 8.0) * 8;
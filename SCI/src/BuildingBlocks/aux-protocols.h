@@ -143,6 +143,35 @@ class AuxProtocols {
         int32_t bw_x
     );
 
+    // msb0_to_wrap and B2A in one COT: arithmetic shares of Wrap(x) over
+    // Z_{2^bw_wrap}, with the MSB of x known to be 0
+    void msb0_to_arith_wrap(
+        // input vector
+        uint64_t *x,
+        // output (arithmetic) shares of Wrap(x)
+        uint64_t *wrap_x,
+        // size of input vector
+        int32_t size,
+        // bitwidth of x
+        int32_t bw_x,
+        // bitwidth of wrap_x
+        int32_t bw_wrap
+    );
+
+    // msb1_to_wrap and B2A in one COT, with the MSB of x known to be 1
+    void msb1_to_arith_wrap(
+        // input vector
+        uint64_t *x,
+        // output (arithmetic) shares of Wrap(x)
+        uint64_t *wrap_x,
+        // size of input vector
+        int32_t size,
+        // bitwidth of x
+        int32_t bw_x,
+        // bitwidth of wrap_x
+        int32_t bw_wrap
+    );
+
     // Bitwise AND
     void AND(
         // input A (boolean) vector
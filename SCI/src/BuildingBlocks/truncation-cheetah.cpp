@@ -7,7 +7,8 @@ void Truncation::truncate(
     int32_t bw,
     bool signed_arithmetic,
     uint8_t *msb_x,
-    bool apply_msb0_heuristic
+    bool apply_msb0_heuristic,
+    int32_t bound_bits
 ) {
     if (msb_x != nullptr)
         return truncate(dim, inA, outB, shift, bw, signed_arithmetic, msb_x);
@@ -30,7 +31,9 @@ void Truncation::truncate(
         // Ref "Secure evaluation of quantized neural networks"
         // https://eprint.iacr.org/2019/131.pdf
         if (party == sci::BOB) {
-            const int m = bw - 3;
+            const int m =
+                bound_bits < 0 ? bw - 3 : std::max<int>(bound_bits, shift);
+            assert(m <= bw - 2);
             std::vector<uint64_t> adjust(dim);
             uint64_t big_positive = 1UL << m;
             std::transform(inA, inA + dim, adjust.data(), [&](uint64_t x) {
@@ -211,15 +214,13 @@ void Truncation::truncate_msb0(
         }
     }
 
-    uint8_t *wrap_upper = new uint8_t[dim];
-
+    // The wrap goes to Z_{2^shift} in the same COT, as it is multiplied
+    // by 2^(bw - shift)
+    uint64_t *arith_wrap_upper = new uint64_t[dim];
     if (signed_arithmetic)
-        this->aux->msb1_to_wrap(inA, wrap_upper, dim, bw);
+        this->aux->msb1_to_arith_wrap(inA, arith_wrap_upper, dim, bw, shift);
     else
-        this->aux->msb0_to_wrap(inA, wrap_upper, dim, bw);
-
-    uint64_t *arith_wrap_upper = new uint64_t[dim];
-    this->aux->B2A(wrap_upper, arith_wrap_upper, dim, shift);
+        this->aux->msb0_to_arith_wrap(inA, arith_wrap_upper, dim, bw, shift);
     io->flush();
 
     for (int i = 0; i < dim; i++) {
@@ -235,7 +236,6 @@ void Truncation::truncate_msb0(
         }
     }
     delete[] inA_orig;
-    delete[] wrap_upper;
     delete[] arith_wrap_upper;
 
     return;
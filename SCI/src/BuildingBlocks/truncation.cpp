@@ -193,7 +193,8 @@ void Truncation::truncate(
     int32_t bw,
     bool signed_arithmetic,
     uint8_t *msb_x,
-    bool _dummy
+    bool _dummy,
+    int32_t _dummy_bound
 ) {
     if (shift == 0) {
         memcpy(outB, inA, sizeof(uint64_t) * dim);
@@ -68,7 +68,9 @@ class Truncation {
         // msb of input vector elements
         uint8_t *msb_x = nullptr,
         // add big positive before truncation
-        bool apply_msb0_heuristic = true
+        bool apply_msb0_heuristic = true,
+        // |x| < 2^bound_bits for the heuristic. Negative: bw - 3
+        int32_t bound_bits = -1
     );
 
     // Truncate (right-shift) by shift in the same ring (round towards -inf)
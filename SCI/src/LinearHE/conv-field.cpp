@@ -630,7 +630,7 @@ void ConvField::non_strided_conv(
     int32_t CO,
     Image *image,
     Filters *filters,
-    vector<vector<vector<uint64_t>>> &outArr,
+    uint64_t *outArr,
     bool verbose
 ) {
     data.image_h = H;
@@ -695,8 +695,7 @@ void ConvField::non_strided_conv(
 
         for (int idx = 0; idx < data.output_h * data.output_w; idx++) {
             for (int chan = 0; chan < CO; chan++) {
-                outArr[idx / data.output_w][idx % data.output_w][chan] +=
-                    HE_result[chan][idx];
+                outArr[(int64_t)idx * CO + chan] += HE_result[chan][idx];
             }
         }
     } else  // party == ALICE
@@ -779,7 +778,7 @@ void ConvField::non_strided_conv(
 
         for (int idx = 0; idx < data.output_h * data.output_w; idx++) {
             for (int chan = 0; chan < CO; chan++) {
-                outArr[idx / data.output_w][idx % data.output_w][chan] +=
+                outArr[(int64_t)idx * CO + chan] +=
                     (prime_mod - secret_share[chan][idx]);
             }
         }
@@ -798,6 +797,11 @@ void ConvField::non_strided_conv(
 // Alice privately holds `filterArr`.
 // The `inputArr' is secretly shared between Alice and Bob.
 // The underlying Arithmetic is `prime_mod`.
+//
+// Flat-array version: `inputArr` is H x W x CI, `filterArr` is FH x FW x CI x
+// CO and `outArr` is newH x newW x CO, all dense and in row-major order. The
+// per-channel matrices are read through strided Eigen maps, so the caller
+// does not need to reshape its tensors.
 void ConvField::convolution(
     int32_t N,
     int32_t H,
@@ -812,41 +816,32 @@ void ConvField::convolution(
     int32_t zPadWRight,
     int32_t strideH,
     int32_t strideW,
-    const vector<vector<vector<vector<uint64_t>>>> &inputArr,
-    const vector<vector<vector<vector<uint64_t>>>> &filterArr,
-    vector<vector<vector<vector<uint64_t>>>> &outArr,
+    const uint64_t *inputArr,
+    const uint64_t *filterArr,
+    uint64_t *outArr,
     bool verify_output,
     bool verbose
 ) {
+    assert(N == 1);
     int paddedH = H + zPadHLeft + zPadHRight;
     int paddedW = W + zPadWLeft + zPadWRight;
     int newH = 1 + (paddedH - FH) / strideH;
     int newW = 1 + (paddedW - FW) / strideW;
     int limitH = FH + ((paddedH - FH) / strideH) * strideH;
     int limitW = FW + ((paddedW - FW) / strideW) * strideW;
+    const int64_t out_size = (int64_t)newH * newW * CO;
 
-    for (int i = 0; i < newH; i++) {
-        for (int j = 0; j < newW; j++) {
-            for (int k = 0; k < CO; k++) {
-                outArr[0][i][j][k] = 0;
-            }
-        }
-    }
+    std::fill_n(outArr, out_size, 0ULL);
 
-    Image image;
-    Filters filters;
+    auto to_field = [](uint64_t x) {
+        return (uint64_t)neg_mod((int64_t)x, (int64_t)prime_mod);
+    };
 
-    image.resize(CI);
+    Image image(CI);
     for (int chan = 0; chan < CI; chan++) {
-        Channel tmp_chan(H, W);
-        for (int h = 0; h < H; h++) {
-            for (int w = 0; w < W; w++) {
-                tmp_chan(h, w) = neg_mod(
-                    (int64_t)inputArr[0][h][w][chan], (int64_t)prime_mod
-                );
-            }
-        }
-        image[chan] = tmp_chan;
+        image[chan] =
+            ConstChannelMap(inputArr + chan, H, W, ChannelStride(W * CI, CI))
+                .unaryExpr(to_field);
     }
 
     if (party == BOB) {
@@ -859,7 +854,6 @@ void ConvField::convolution(
                 Image lImage(CI);
                 for (int chan = 0; chan < CI; chan++) {
                     Channel tmp_chan(lH, lW);
-                    // lImage[chan] = new uint64_t[lH*lW];
                     for (int row = 0; row < lH; row++) {
                         for (int col = 0; col < lW; col++) {
                             int idxH = row * strideH + s_row - zPadHLeft;
@@ -868,10 +862,7 @@ void ConvField::convolution(
                                 (idxW < 0 || idxW >= W)) {
                                 tmp_chan(row, col) = 0;
                             } else {
-                                tmp_chan(row, col) = neg_mod(
-                                    inputArr[0][idxH][idxW][chan],
-                                    (int64_t)prime_mod
-                                );
+                                tmp_chan(row, col) = image[chan](idxH, idxW);
                             }
                         }
                     }
@@ -879,39 +870,42 @@ void ConvField::convolution(
                 }
                 if (lFH > 0 && lFW > 0) {
                     non_strided_conv(
-                        lH, lW, CI, lFH, lFW, CO, &lImage, nullptr, outArr[0],
+                        lH, lW, CI, lFH, lFW, CO, &lImage, nullptr, outArr,
                         verbose
                     );
                 }
             }
         }
-        for (int idx = 0; idx < newH * newW; idx++) {
-            for (int chan = 0; chan < CO; chan++) {
-                outArr[0][idx / newW][idx % newW][chan] = neg_mod(
-                    (int64_t)outArr[0][idx / newW][idx % newW][chan], prime_mod
-                );
-            }
+        for (int64_t idx = 0; idx < out_size; idx++) {
+            outArr[idx] = to_field(outArr[idx]);
         }
 
-        if (verify_output) verify(H, W, CI, CO, image, nullptr, outArr);
+        if (verify_output)
+            verify(H, W, CI, CO, newH, newW, image, nullptr, outArr);
     } else  // party == ALICE
     {
-        filters.resize(CO);
+        // Filter (inp_c, out_c) is a FH x FW matrix with strides
+        // (FW * CI * CO, CI * CO) in `filterArr`.
+        const int64_t fstride_w = (int64_t)CI * CO;
+        const int64_t fstride_h = FW * fstride_w;
+        Filters filters(CO);
         for (int out_c = 0; out_c < CO; out_c++) {
-            Image tmp_img(CI);
+            filters[out_c].resize(CI);
             for (int inp_c = 0; inp_c < CI; inp_c++) {
-                Channel tmp_chan(FH, FW);
-                for (int idx = 0; idx < FH * FW; idx++) {
-                    int64_t val =
-                        (int64_t)filterArr[idx / FW][idx % FW][inp_c][out_c];
-                    if (val > int64_t(prime_mod / 2)) {
-                        val = val - prime_mod;
-                    }
-                    tmp_chan(idx / FW, idx % FW) = val;
-                }
-                tmp_img[inp_c] = tmp_chan;
+                filters[out_c][inp_c] =
+                    ConstChannelMap(
+                        filterArr + inp_c * CO + out_c, FH, FW,
+                        ChannelStride(fstride_h, fstride_w)
+                    )
+                        .unaryExpr([](uint64_t x) {
+                            int64_t val =
+                                neg_mod((int64_t)x, (int64_t)prime_mod);
+                            if (val > int64_t(prime_mod / 2)) {
+                                val = val - prime_mod;
+                            }
+                            return (uint64_t)val;
+                        });
             }
-            filters[out_c] = tmp_img;
         }
 
         for (int s_row = 0; s_row < strideH; s_row++) {
@@ -920,32 +914,28 @@ void ConvField::convolution(
                 int lW = ((limitW - s_col + strideW - 1) / strideW);
                 int lFH = ((FH - s_row + strideH - 1) / strideH);
                 int lFW = ((FW - s_col + strideW - 1) / strideW);
+                if (lFH <= 0 || lFW <= 0) continue;
                 Filters lFilters(CO);
                 for (int out_c = 0; out_c < CO; out_c++) {
-                    Image tmp_img(CI);
+                    lFilters[out_c].resize(CI);
                     for (int inp_c = 0; inp_c < CI; inp_c++) {
-                        Channel tmp_chan(lFH, lFW);
-                        for (int row = 0; row < lFH; row++) {
-                            for (int col = 0; col < lFW; col++) {
-                                int idxFH = row * strideH + s_row;
-                                int idxFW = col * strideW + s_col;
-                                tmp_chan(row, col) = neg_mod(
-                                    filterArr[idxFH][idxFW][inp_c][out_c],
-                                    (int64_t)prime_mod
-                                );
-                            }
-                        }
-                        tmp_img[inp_c] = tmp_chan;
+                        lFilters[out_c][inp_c] =
+                            ConstChannelMap(
+                                filterArr + s_row * fstride_h +
+                                    s_col * fstride_w + inp_c * CO + out_c,
+                                lFH, lFW,
+                                ChannelStride(
+                                    strideH * fstride_h, strideW * fstride_w
+                                )
+                            )
+                                .unaryExpr(to_field);
                     }
-                    lFilters[out_c] = tmp_img;
                 }
 
-                if (lFH > 0 && lFW > 0) {
-                    non_strided_conv(
-                        lH, lW, CI, lFH, lFW, CO, nullptr, &lFilters, outArr[0],
-                        verbose
-                    );
-                }
+                non_strided_conv(
+                    lH, lW, CI, lFH, lFW, CO, nullptr, &lFilters, outArr,
+                    verbose
+                );
             }
         }
         data.image_h = H;
@@ -966,14 +956,81 @@ void ConvField::convolution(
 
         for (int idx = 0; idx < newH * newW; idx++) {
             for (int chan = 0; chan < CO; chan++) {
-                outArr[0][idx / newW][idx % newW][chan] = neg_mod(
+                uint64_t &out = outArr[(int64_t)idx * CO + chan];
+                out = neg_mod(
                     (int64_t)local_result[chan](idx / newW, idx % newW) +
-                        (int64_t)outArr[0][idx / newW][idx % newW][chan],
+                        (int64_t)out,
                     prime_mod
                 );
             }
         }
-        if (verify_output) verify(H, W, CI, CO, image, &filters, outArr);
+        if (verify_output)
+            verify(H, W, CI, CO, newH, newW, image, &filters, outArr);
+    }
+}
+
+void ConvField::convolution(
+    int32_t N,
+    int32_t H,
+    int32_t W,
+    int32_t CI,
+    int32_t FH,
+    int32_t FW,
+    int32_t CO,
+    int32_t zPadHLeft,
+    int32_t zPadHRight,
+    int32_t zPadWLeft,
+    int32_t zPadWRight,
+    int32_t strideH,
+    int32_t strideW,
+    const vector<vector<vector<vector<uint64_t>>>> &inputArr,
+    const vector<vector<vector<vector<uint64_t>>>> &filterArr,
+    vector<vector<vector<vector<uint64_t>>>> &outArr,
+    bool verify_output,
+    bool verbose
+) {
+    int newH = 1 + (H + zPadHLeft + zPadHRight - FH) / strideH;
+    int newW = 1 + (W + zPadWLeft + zPadWRight - FW) / strideW;
+
+    vector<uint64_t> flat_input((int64_t)H * W * CI);
+    for (int h = 0; h < H; h++) {
+        for (int w = 0; w < W; w++) {
+            std::copy_n(
+                inputArr[0][h][w].data(), CI,
+                flat_input.data() + ((int64_t)h * W + w) * CI
+            );
+        }
+    }
+    vector<uint64_t> flat_filter;
+    if (party == ALICE) {
+        flat_filter.resize((int64_t)FH * FW * CI * CO);
+        for (int h = 0; h < FH; h++) {
+            for (int w = 0; w < FW; w++) {
+                for (int c = 0; c < CI; c++) {
+                    std::copy_n(
+                        filterArr[h][w][c].data(), CO,
+                        flat_filter.data() +
+                            (((int64_t)h * FW + w) * CI + c) * CO
+                    );
+                }
+            }
+        }
+    }
+    vector<uint64_t> flat_output((int64_t)newH * newW * CO);
+
+    convolution(
+        N, H, W, CI, FH, FW, CO, zPadHLeft, zPadHRight, zPadWLeft, zPadWRight,
+        strideH, strideW, flat_input.data(), flat_filter.data(),
+        flat_output.data(), verify_output, verbose
+    );
+
+    for (int h = 0; h < newH; h++) {
+        for (int w = 0; w < newW; w++) {
+            std::copy_n(
+                flat_output.data() + ((int64_t)h * newW + w) * CO, CO,
+                outArr[0][h][w].data()
+            );
+        }
     }
 }
 
@@ -982,24 +1039,18 @@ void ConvField::verify(
     int W,
     int CI,
     int CO,
+    int newH,
+    int newW,
     Image &image,
     const Filters *filters,
-    const vector<vector<vector<vector<uint64_t>>>> &outArr
+    const uint64_t *outArr
 ) {
-    int newH = outArr[0].size();
-    int newW = outArr[0][0].size();
-
+    const int64_t out_size = (int64_t)newH * newW * CO;
     if (party == BOB) {
         for (int i = 0; i < CI; i++) {
             io->send_data(image[i].data(), H * W * sizeof(uint64_t));
         }
-        for (int i = 0; i < newH; i++) {
-            for (int j = 0; j < newW; j++) {
-                io->send_data(
-                    outArr[0][i][j].data(), sizeof(uint64_t) * data.out_chans
-                );
-            }
-        }
+        io->send_data(outArr, sizeof(uint64_t) * out_size);
     } else  // party == ALICE
     {
         Image image_0(CI);  // = new Channel[CI];
@@ -1018,30 +1069,17 @@ void ConvField::verify(
         }
 
         Image result = ideal_functionality(image, *filters);
-        vector<vector<vector<vector<uint64_t>>>> outArr_0;
-        outArr_0.resize(1);
-        outArr_0[0].resize(newH);
-        for (int i = 0; i < newH; i++) {
-            outArr_0[0][i].resize(newW);
-            for (int j = 0; j < newW; j++) {
-                outArr_0[0][i][j].resize(CO);
-                io->recv_data(outArr_0[0][i][j].data(), sizeof(uint64_t) * CO);
-            }
-        }
-        for (int i = 0; i < newH; i++) {
-            for (int j = 0; j < newW; j++) {
-                for (int k = 0; k < CO; k++) {
-                    outArr_0[0][i][j][k] =
-                        (outArr_0[0][i][j][k] + outArr[0][i][j][k]) % prime_mod;
-                }
-            }
+        vector<uint64_t> outArr_0(out_size);
+        io->recv_data(outArr_0.data(), sizeof(uint64_t) * out_size);
+        for (int64_t i = 0; i < out_size; i++) {
+            outArr_0[i] = (outArr_0[i] + outArr[i]) % prime_mod;
         }
 
         bool pass = true;
         for (int i = 0; i < CO; i++) {
             for (int j = 0; j < newH; j++) {
                 for (int k = 0; k < newW; k++) {
-                    if ((int64_t)outArr_0[0][j][k][i] !=
+                    if ((int64_t)outArr_0[((int64_t)j * newW + k) * CO + i] !=
                         neg_mod(result[i](j, k), (int64_t)prime_mod)) {
                         pass = false;
                     }
@@ -35,6 +35,10 @@ typedef Eigen::Matrix<uint64_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
     Channel;
 typedef std::vector<Channel> Image;
 typedef std::vector<Image> Filters;
+// Read-only view of a channel inside a flat (e.g., HWC) array
+typedef Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic> ChannelStride;
+typedef Eigen::Map<const Channel, Eigen::Unaligned, ChannelStride>
+    ConstChannelMap;
 
 struct ConvMetadata {
     int slot_count;
@@ -185,7 +189,30 @@ class ConvField {
         int32_t CO,
         Image *image,
         Filters *filters,
-        std::vector<std::vector<std::vector<uint64_t>>> &outArr,
+        uint64_t *outArr,
+        bool verbose = false
+    );
+
+    // `inputArr` (H x W x CI), `filterArr` (FH x FW x CI x CO) and `outArr`
+    // (newH x newW x CO) are dense row-major arrays.
+    void convolution(
+        int32_t N,
+        int32_t H,
+        int32_t W,
+        int32_t CI,
+        int32_t FH,
+        int32_t FW,
+        int32_t CO,
+        int32_t zPadHLeft,
+        int32_t zPadHRight,
+        int32_t zPadWLeft,
+        int32_t zPadWRight,
+        int32_t strideH,
+        int32_t strideW,
+        const uint64_t *inputArr,
+        const uint64_t *filterArr,
+        uint64_t *outArr,
+        bool verify_output = false,
         bool verbose = false
     );
 
@@ -217,10 +244,11 @@ class ConvField {
         int W,
         int CI,
         int CO,
+        int newH,
+        int newW,
         Image &image,
         const Filters *filters,
-        const std::vector<std::vector<std::vector<std::vector<uint64_t>>>>
-            &outArr
+        const uint64_t *outArr
     );
 };
 
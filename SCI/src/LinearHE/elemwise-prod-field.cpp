@@ -60,6 +60,20 @@ void ElemWiseProdField::elemwise_product(
     vector<uint64_t> &outputArr,
     bool verify_output,
     bool verbose
+) {
+    elemwise_product(
+        size, inArr.data(), multArr.data(), outputArr.data(), verify_output,
+        verbose
+    );
+}
+
+void ElemWiseProdField::elemwise_product(
+    int32_t size,
+    const uint64_t *inArr,
+    const uint64_t *multArr,
+    uint64_t *outputArr,
+    bool verify_output,
+    bool verbose
 ) {
     int num_ct = ceil(float(size) / slot_count);
 
@@ -90,7 +104,7 @@ void ElemWiseProdField::elemwise_product(
                 outputArr[j + offset] = tmp_vec[j];
             }
         }
-        if (verify_output) verify(inArr, nullptr, outputArr);
+        if (verify_output) verify(size, inArr, nullptr, outputArr);
     } else  // party == ALICE
     {
         vector<Plaintext> multArr_pt(num_ct);
@@ -174,13 +188,17 @@ void ElemWiseProdField::elemwise_product(
 
         vector<uint64_t> multArr_lifted(size, 0);
         for (int i = 0; i < size; i++) {
-            int64_t val = (int64_t)multArr[i];
+            int64_t val = neg_mod((int64_t)multArr[i], (int64_t)prime_mod);
             if (val > int64_t(prime_mod / 2)) {
                 val = val - prime_mod;
             }
             multArr_lifted[i] = val;
         }
-        auto result = ideal_functionality(inArr, multArr_lifted);
+        vector<uint64_t> inArr_(size);
+        for (int i = 0; i < size; i++) {
+            inArr_[i] = neg_mod((int64_t)inArr[i], (int64_t)prime_mod);
+        }
+        auto result = ideal_functionality(inArr_, multArr_lifted);
 
         for (int i = 0; i < num_ct; i++) {
             int offset = i * slot_count;
@@ -191,33 +209,36 @@ void ElemWiseProdField::elemwise_product(
                 );
             }
         }
-        if (verify_output) verify(inArr, &multArr_lifted, outputArr);
+        if (verify_output) verify(size, inArr, &multArr_lifted, outputArr);
     }
 }
 
 void ElemWiseProdField::verify(
-    vector<uint64_t> &inArr, vector<uint64_t> *multArr, vector<uint64_t> &outArr
+    int32_t size,
+    const uint64_t *inArr,
+    vector<uint64_t> *multArr,
+    const uint64_t *outArr
 ) {
     if (party == BOB) {
-        io->send_data(inArr.data(), inArr.size() * sizeof(uint64_t));
-        io->send_data(outArr.data(), outArr.size() * sizeof(uint64_t));
+        io->send_data(inArr, size * sizeof(uint64_t));
+        io->send_data(outArr, size * sizeof(uint64_t));
     } else  // party == ALICE
     {
-        vector<uint64_t> inArr_0(inArr.size());
-        io->recv_data(inArr_0.data(), inArr.size() * sizeof(uint64_t));
-        for (size_t i = 0; i < inArr.size(); i++) {
+        vector<uint64_t> inArr_0(size);
+        io->recv_data(inArr_0.data(), size * sizeof(uint64_t));
+        for (int32_t i = 0; i < size; i++) {
             inArr_0[i] = (inArr[i] + inArr_0[i]) % prime_mod;
         }
 
         auto result = ideal_functionality(inArr_0, *multArr);
 
-        vector<uint64_t> outArr_0(outArr.size());
-        io->recv_data(outArr_0.data(), outArr.size() * sizeof(uint64_t));
-        for (size_t i = 0; i < outArr.size(); i++) {
+        vector<uint64_t> outArr_0(size);
+        io->recv_data(outArr_0.data(), size * sizeof(uint64_t));
+        for (int32_t i = 0; i < size; i++) {
             outArr_0[i] = (outArr[i] + outArr_0[i]) % prime_mod;
         }
         bool pass = true;
-        for (size_t i = 0; i < outArr.size(); i++) {
+        for (int32_t i = 0; i < size; i++) {
             if (neg_mod(result[i], (int64_t)prime_mod) !=
                 (int64_t)outArr_0[i]) {
                 pass = false;
@@ -54,10 +54,20 @@ class ElemWiseProdField {
         bool verbose = false
     );
 
+    void elemwise_product(
+        int32_t size,
+        const uint64_t *inArr,
+        const uint64_t *multArr,
+        uint64_t *outputArr,
+        bool verify_output = false,
+        bool verbose = false
+    );
+
     void verify(
-        std::vector<uint64_t> &inArr,
+        int32_t size,
+        const uint64_t *inArr,
         std::vector<uint64_t> *multArr,
-        std::vector<uint64_t> &outArr
+        const uint64_t *outArr
     );
 };
 
@@ -242,6 +242,46 @@ void FCField::matrix_multiplication(
     bool verbose
 ) {
     assert(num_cols == 1);
+    vector<uint64_t> flat_A;
+    if (party == ALICE) {
+        flat_A.resize((int64_t)num_rows * common_dim);
+        for (int i = 0; i < num_rows; i++) {
+            std::copy_n(
+                A[i].data(), common_dim, flat_A.data() + (int64_t)i * common_dim
+            );
+        }
+    }
+    vector<uint64_t> vec(common_dim);
+    for (int i = 0; i < common_dim; i++) {
+        vec[i] = B[i][0];
+    }
+    vector<uint64_t> flat_C(num_rows);
+
+    matrix_multiplication(
+        num_rows, common_dim, flat_A.data(), common_dim, 1, vec.data(),
+        flat_C.data(), verify_output, verbose
+    );
+
+    for (int i = 0; i < num_rows; i++) {
+        C[i][0] = flat_C[i];
+    }
+}
+
+// Flat-array version: A[i][j] is read at A[i * A_row_stride + j *
+// A_col_stride], which allows passing e.g. the transpose of a row-major
+// matrix without copying it. `vec` has `common_dim` entries and `C` has
+// `num_rows` entries.
+void FCField::matrix_multiplication(
+    int32_t num_rows,
+    int32_t common_dim,
+    const uint64_t *A,
+    int64_t A_row_stride,
+    int64_t A_col_stride,
+    const uint64_t *vec,
+    uint64_t *C,
+    bool verify_output,
+    bool verbose
+) {
     data.filter_h = num_rows;
     data.filter_w = common_dim;
     data.image_size = common_dim;
@@ -277,14 +317,13 @@ void FCField::matrix_multiplication(
         zero_ = this->zero;
     }
 
-    if (party == BOB) {
-        vector<uint64_t> vec(common_dim);
-        for (int i = 0; i < common_dim; i++) {
-            vec[i] = B[i][0];
-        }
-        if (verbose) cout << "[Client] Vector Generated" << endl;
+    vector<uint64_t> vec_(common_dim);
+    for (int i = 0; i < common_dim; i++) {
+        vec_[i] = neg_mod((int64_t)vec[i], (int64_t)prime_mod);
+    }
 
-        auto ct = preprocess_vec(vec.data(), data, *encryptor_, *encoder_);
+    if (party == BOB) {
+        auto ct = preprocess_vec(vec_.data(), data, *encryptor_, *encoder_);
         send_ciphertext(io, ct);
         if (verbose) cout << "[Client] Vector processed and sent" << endl;
 
@@ -294,30 +333,23 @@ void FCField::matrix_multiplication(
             fc_postprocess(enc_result, data, *encoder_, *decryptor_);
         if (verbose) cout << "[Client] Result received and decrypted" << endl;
 
-        for (int i = 0; i < num_rows; i++) {
-            C[i][0] = HE_result[i];
-        }
-        if (verify_output) verify(&vec, nullptr, C);
+        std::copy_n(HE_result, num_rows, C);
+        if (verify_output) verify(vec_.data(), nullptr, C);
 
         delete[] HE_result;
     } else  // party == ALICE
     {
-        vector<uint64_t> vec(common_dim);
-        for (int i = 0; i < common_dim; i++) {
-            vec[i] = B[i][0];
-        }
-
-        if (verbose) cout << "[Server] Vector Generated" << endl;
-
         vector<uint64_t *> matrix_mod_p(num_rows);
         vector<uint64_t *> matrix(num_rows);
         for (int i = 0; i < num_rows; i++) {
             matrix_mod_p[i] = new uint64_t[common_dim];
             matrix[i] = new uint64_t[common_dim];
+            const uint64_t *row = A + i * A_row_stride;
             for (int j = 0; j < common_dim; j++) {
-                matrix_mod_p[i][j] =
-                    neg_mod((int64_t)A[i][j], (int64_t)prime_mod);
-                int64_t val = (int64_t)A[i][j];
+                int64_t val = neg_mod(
+                    (int64_t)row[j * A_col_stride], (int64_t)prime_mod
+                );
+                matrix_mod_p[i][j] = val;
                 if (val > int64_t(prime_mod / 2)) {
                     val = val - prime_mod;
                 }
@@ -369,15 +401,15 @@ void FCField::matrix_multiplication(
         send_ciphertext(io, HE_result);
         if (verbose) cout << "[Server] Result computed and sent" << endl;
 
-        auto result = ideal_functionality(vec.data(), matrix.data());
+        auto result = ideal_functionality(vec_.data(), matrix.data());
 
         for (int i = 0; i < num_rows; i++) {
-            C[i][0] = neg_mod(
+            C[i] = neg_mod(
                 (int64_t)result[i] - (int64_t)secret_share[i],
                 (int64_t)prime_mod
             );
         }
-        if (verify_output) verify(&vec, &matrix, C);
+        if (verify_output) verify(vec_.data(), &matrix, C);
 
         for (int i = 0; i < num_rows; i++) {
             delete[] matrix_mod_p[i];
@@ -394,34 +426,31 @@ void FCField::matrix_multiplication(
 }
 
 void FCField::verify(
-    vector<uint64_t> *vec,
+    const uint64_t *vec,
     vector<uint64_t *> *matrix,
-    vector<vector<uint64_t>> &C
+    const uint64_t *C
 ) {
     if (party == BOB) {
-        io->send_data(vec->data(), data.filter_w * sizeof(uint64_t));
+        io->send_data(vec, data.filter_w * sizeof(uint64_t));
         io->flush();
-        for (int i = 0; i < data.filter_h; i++) {
-            io->send_data(C[i].data(), sizeof(uint64_t));
-        }
+        io->send_data(C, data.filter_h * sizeof(uint64_t));
     } else  // party == ALICE
     {
         vector<uint64_t> vec_0(data.filter_w);
         io->recv_data(vec_0.data(), data.filter_w * sizeof(uint64_t));
         for (int i = 0; i < data.filter_w; i++) {
-            vec_0[i] = (vec_0[i] + (*vec)[i]) % prime_mod;
+            vec_0[i] = (vec_0[i] + vec[i]) % prime_mod;
         }
         auto result = ideal_functionality(vec_0.data(), matrix->data());
 
-        vector<vector<uint64_t>> C_0(data.filter_h);
+        vector<uint64_t> C_0(data.filter_h);
+        io->recv_data(C_0.data(), data.filter_h * sizeof(uint64_t));
         for (int i = 0; i < data.filter_h; i++) {
-            C_0[i].resize(1);
-            io->recv_data(C_0[i].data(), sizeof(uint64_t));
-            C_0[i][0] = (C_0[i][0] + C[i][0]) % prime_mod;
+            C_0[i] = (C_0[i] + C[i]) % prime_mod;
         }
         bool pass = true;
         for (int i = 0; i < data.filter_h; i++) {
-            if (neg_mod(result[i], (int64_t)prime_mod) != (int64_t)C_0[i][0]) {
+            if (neg_mod(result[i], (int64_t)prime_mod) != (int64_t)C_0[i]) {
                 pass = false;
             }
         }
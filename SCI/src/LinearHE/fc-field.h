@@ -110,10 +110,24 @@ class FCField {
         bool verbose = false
     );
 
+    // A[i][j] = A[i * A_row_stride + j * A_col_stride]; `vec` and `C` are
+    // dense vectors of `common_dim` and `num_rows` entries.
+    void matrix_multiplication(
+        int32_t num_rows,
+        int32_t common_dim,
+        const uint64_t *A,
+        int64_t A_row_stride,
+        int64_t A_col_stride,
+        const uint64_t *vec,
+        uint64_t *C,
+        bool verify_output = false,
+        bool verbose = false
+    );
+
     void verify(
-        std::vector<uint64_t> *vec,
+        const uint64_t *vec,
         std::vector<uint64_t *> *matrix,
-        std::vector<std::vector<uint64_t>> &C
+        const uint64_t *C
     );
 };
 #endif
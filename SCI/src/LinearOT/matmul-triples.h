@@ -0,0 +1,370 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef MATMUL_TRIPLES_H__
+#define MATMUL_TRIPLES_H__
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <deque>
+#include <map>
+#include <vector>
+
+#ifdef USE_EIGEN
+#include <Eigen/Dense>
+#endif
+
+#include "OT/ferret/silent_ot.h"
+#include "utils/emp-tool.h"
+
+// Matrix Beaver triples (A, B, C = A * B) of shape (s1,s2) * (s2,s3) over
+// Z_{2^bitlength}, for the products of two secret-shared matrices
+// (MultMode::None).
+//
+// The triples are generated offline, in bulk, from the random correlated OTs
+// of the silent (Ferret) OT: the cross terms A_0 * B_1 and A_1 * B_0 take one
+// COT per bit of B, each carrying a column of A, as in
+// MatMulUniform::funcOTSenderInputA/funcOTReceiverInputB. Only the packed
+// corrections are sent. Online, a product only opens E = X - A and F = Y - B
+// (one exchange), and the rest is two local matrix products.
+//
+// The party is the sender of `silentOT` and the receiver of
+// `silentOTReversed`, i.e., OTPack::silent_ot and OTPack::silent_ot_reversed.
+// Both parties MUST generate and consume the triples of a shape in the same
+// order.
+template <typename IO, typename intType>
+class MatMulTriples {
+   public:
+    struct Triple {
+        std::vector<intType> A;  // (s1,s2)
+        std::vector<intType> B;  // (s2,s3)
+        std::vector<intType> C;  // (s1,s3)
+    };
+
+    MatMulTriples(
+        int party,
+        int bitlength,
+        IO *io,
+        cheetah::SilentOT<IO> *silentOT,
+        cheetah::SilentOT<IO> *silentOTReversed
+    )
+        : party(party),
+          bitlength(bitlength),
+          io(io),
+          silentOT(silentOT),
+          silentOTReversed(silentOTReversed) {
+        assert(((party == 1) || (party == 2)) && "PartyNum should be 1 or 2.");
+        assert(bitlength > 0 && bitlength <= 8 * (int)sizeof(intType));
+        moduloMask = sci::all1Mask(bitlength);
+    }
+
+    // Generates `count` triples of the shape into the store.
+    void generate(int s1, int s2, int s3, int count) {
+        if (count <= 0) return;
+        std::vector<Triple> triples(count);
+        generate(s1, s2, s3, triples.data(), count);
+        auto &store = store_[{s1, s2, s3}];
+        for (auto &t : triples) store.push_back(std::move(t));
+    }
+
+    size_t available(int s1, int s2, int s3) const {
+        auto it = store_.find({s1, s2, s3});
+        return it == store_.end() ? 0 : it->second.size();
+    }
+
+    // Z = X * Y on shares, with a stored triple of the shape, or with a fresh
+    // one when the store is empty.
+    void matmul(
+        int s1, int s2, int s3, const intType *X, const intType *Y, intType *Z
+    ) {
+        Triple triple;
+        auto &store = store_[{s1, s2, s3}];
+        if (store.empty()) {
+            generate(s1, s2, s3, &triple, 1);
+        } else {
+            triple = std::move(store.front());
+            store.pop_front();
+        }
+        matmul(s1, s2, s3, X, Y, Z, triple);
+    }
+
+    // The online phase, with the given triple (to be used only once).
+    void matmul(
+        int s1,
+        int s2,
+        int s3,
+        const intType *X,
+        const intType *Y,
+        intType *Z,
+        const Triple &triple
+    ) {
+        const int64_t nE = (int64_t)s1 * s2;
+        const int64_t nF = (int64_t)s2 * s3;
+        std::vector<intType> EF(nE + nF), EF_other(nE + nF);
+        for (int64_t i = 0; i < nE; i++) {
+            EF[i] = (X[i] - triple.A[i]) & moduloMask;
+        }
+        for (int64_t i = 0; i < nF; i++) {
+            EF[nE + i] = (Y[i] - triple.B[i]) & moduloMask;
+        }
+        if (party == sci::ALICE) {
+            io->send_data(EF.data(), sizeof(intType) * (nE + nF));
+            io->recv_data(EF_other.data(), sizeof(intType) * (nE + nF));
+        } else {
+            io->recv_data(EF_other.data(), sizeof(intType) * (nE + nF));
+            io->send_data(EF.data(), sizeof(intType) * (nE + nF));
+        }
+        for (int64_t i = 0; i < nE + nF; i++) {
+            EF[i] += EF_other[i];
+        }
+        const intType *E = EF.data();
+        const intType *F = EF.data() + nE;
+
+        // Z = C + E * B + A * F, and ALICE adds E * F, i.e., uses B + F.
+        std::vector<intType> BF(triple.B);
+        if (party == sci::ALICE) {
+            for (int64_t i = 0; i < nF; i++) BF[i] += F[i];
+        }
+        std::vector<intType> AF(s1 * s3);
+        localMatMul(s1, s2, s3, E, BF.data(), Z);
+        localMatMul(s1, s2, s3, triple.A.data(), F, AF.data());
+        for (int64_t i = 0; i < (int64_t)s1 * s3; i++) {
+            Z[i] = (Z[i] + AF[i] + triple.C[i]) & moduloMask;
+        }
+    }
+
+    int party;
+    int bitlength;
+    intType moduloMask;
+
+   private:
+    // COTs per batch: bounds the memory to the pads of one batch.
+    static constexpr int64_t kMaxBatchOTs = 1LL << 16;
+    static constexpr int64_t kMaxBatchElems = 1LL << 24;
+
+    void generate(int s1, int s2, int s3, Triple *triples, int count) {
+        const int64_t nA = (int64_t)s1 * s2;
+        const int64_t nB = (int64_t)s2 * s3;
+        const int64_t nC = (int64_t)s1 * s3;
+        std::vector<intType> A(count * nA), B(count * nB);
+        std::vector<intType> C(count * nC), CTemp(count * nC);
+        prg.random_data(A.data(), A.size() * sizeof(intType));
+        prg.random_data(B.data(), B.size() * sizeof(intType));
+        if (party == sci::ALICE) {
+            crossTermSender(count, s1, s2, s3, A.data(), C.data(), silentOT);
+            crossTermReceiver(
+                count, s1, s2, s3, B.data(), CTemp.data(), silentOTReversed
+            );
+        } else {
+            crossTermReceiver(count, s1, s2, s3, B.data(), C.data(), silentOT);
+            crossTermSender(
+                count, s1, s2, s3, A.data(), CTemp.data(), silentOTReversed
+            );
+        }
+        for (int t = 0; t < count; t++) {
+            Triple &triple = triples[t];
+            triple.A.assign(A.begin() + t * nA, A.begin() + (t + 1) * nA);
+            triple.B.assign(B.begin() + t * nB, B.begin() + (t + 1) * nB);
+            triple.C.resize(nC);
+            localMatMul(
+                s1, s2, s3, triple.A.data(), triple.B.data(), triple.C.data()
+            );
+            for (int64_t i = 0; i < nC; i++) {
+                triple.C[i] += C[t * nC + i] + CTemp[t * nC + i];
+                triple.C[i] &= moduloMask;
+            }
+            for (auto &a : triple.A) a &= moduloMask;
+            for (auto &b : triple.B) b &= moduloMask;
+        }
+    }
+
+    int64_t batchOTs(int s1) const {
+        return std::max<int64_t>(
+            1, std::min<int64_t>(kMaxBatchOTs, kMaxBatchElems / s1)
+        );
+    }
+
+    // The COT #j, for j in [0, count * s2 * s3 * bitlength), multiplies the
+    // bit i of B[t][r][c] with the column A[t][:, r]. It is laid out as
+    // j = ((t * s2 + r) * s3 + c) * bitlength + i.
+    static void cotIndex(
+        int64_t j, int s2, int s3, int bitlength, int &t, int &r, int &c, int &i
+    ) {
+        i = j % bitlength;
+        j /= bitlength;
+        c = j % s3;
+        j /= s3;
+        r = j % s2;
+        t = j / s2;
+    }
+
+    // C[t] -= (the sender's share of) A[t] * B_other[t].
+    void crossTermSender(
+        int count,
+        int s1,
+        int s2,
+        int s3,
+        const intType *A,
+        intType *C,
+        cheetah::SilentOT<IO> *ot
+    ) {
+        const int64_t nA = (int64_t)s1 * s2;
+        const int64_t nC = (int64_t)s1 * s3;
+        // Columns of A, and of C, contiguous.
+        std::vector<intType> AT(count * nA);
+        std::vector<intType> CT(count * nC, 0);
+        for (int t = 0; t < count; t++) {
+            sci::convertRowToColMajor<intType>(
+                s1, s2, A + t * nA, AT.data() + t * nA
+            );
+        }
+        const int64_t numOTs = (int64_t)count * s2 * s3 * bitlength;
+        const int64_t batch = batchOTs(s1);
+        const int numHashes = (s1 + 1) / 2;
+        std::vector<sci::block128> keys(batch);
+        std::vector<sci::block128> pads(2 * numHashes);
+        std::vector<uint8_t> packed;
+        const sci::block128 delta = ot->ferret->Delta;
+
+        for (int64_t j0 = 0; j0 < numOTs; j0 += batch) {
+            const int64_t n = std::min(batch, numOTs - j0);
+            ot->send_ot_rcm_cc(keys.data(), n);
+            packed.assign(packedBytes(j0, n, s1) + 8, 0);
+            uint64_t bitPtr = 0;
+            for (int64_t j = j0; j < j0 + n; j++) {
+                int t, r, c, i;
+                cotIndex(j, s2, s3, bitlength, t, r, c, i);
+                for (int h = 0; h < numHashes; h++) {
+                    pads[h] = keys[j - j0] ^ sci::toBlock(h);
+                    pads[numHashes + h] = pads[h] ^ delta;
+                }
+                crh.Hn(pads.data(), pads.data(), 2 * numHashes);
+                const uint64_t *R0 = (const uint64_t *)pads.data();
+                const uint64_t *R1 =
+                    (const uint64_t *)(pads.data() + numHashes);
+                const int chunk = bitlength - i;
+                const uint64_t chunkMask = sci::all1Mask(chunk);
+                const intType *corr = AT.data() + t * nA + (int64_t)r * s1;
+                intType *out = CT.data() + t * nC + (int64_t)c * s1;
+                for (int k = 0; k < s1; k++) {
+                    sci::writeToPackedArr(
+                        packed.data(), packed.size(), bitPtr, chunk,
+                        (R1[k] - R0[k] - corr[k]) & chunkMask
+                    );
+                    bitPtr += chunk;
+                    out[k] -= (intType)(R0[k] & chunkMask) << i;
+                }
+            }
+            io->send_data(packed.data(), packed.size() - 8);
+        }
+        for (int t = 0; t < count; t++) {
+            sci::convertColToRowMajor<intType>(
+                s1, s3, CT.data() + t * nC, C + t * nC
+            );
+        }
+    }
+
+    // C[t] += (the receiver's share of) A_other[t] * B[t].
+    void crossTermReceiver(
+        int count,
+        int s1,
+        int s2,
+        int s3,
+        const intType *B,
+        intType *C,
+        cheetah::SilentOT<IO> *ot
+    ) {
+        const int64_t nB = (int64_t)s2 * s3;
+        const int64_t nC = (int64_t)s1 * s3;
+        std::vector<intType> CT(count * nC, 0);
+        const int64_t numOTs = (int64_t)count * s2 * s3 * bitlength;
+        const int64_t batch = batchOTs(s1);
+        const int numHashes = (s1 + 1) / 2;
+        std::vector<sci::block128> keys(batch);
+        std::vector<sci::block128> pads(numHashes);
+        std::vector<uint8_t> packed;
+        bool *choices = new bool[batch];
+
+        for (int64_t j0 = 0; j0 < numOTs; j0 += batch) {
+            const int64_t n = std::min(batch, numOTs - j0);
+            for (int64_t j = j0; j < j0 + n; j++) {
+                int t, r, c, i;
+                cotIndex(j, s2, s3, bitlength, t, r, c, i);
+                choices[j - j0] = (B[t * nB + (int64_t)r * s3 + c] >> i) & 1;
+            }
+            ot->recv_ot_rcm_cc(keys.data(), choices, n);
+            packed.assign(packedBytes(j0, n, s1) + 8, 0);
+            io->recv_data(packed.data(), packed.size() - 8);
+            uint64_t bitPtr = 0;
+            for (int64_t j = j0; j < j0 + n; j++) {
+                int t, r, c, i;
+                cotIndex(j, s2, s3, bitlength, t, r, c, i);
+                for (int h = 0; h < numHashes; h++) {
+                    pads[h] = keys[j - j0] ^ sci::toBlock(h);
+                }
+                crh.Hn(pads.data(), pads.data(), numHashes);
+                const uint64_t *R = (const uint64_t *)pads.data();
+                const int chunk = bitlength - i;
+                const uint64_t chunkMask = sci::all1Mask(chunk);
+                const bool b = choices[j - j0];
+                intType *out = CT.data() + t * nC + (int64_t)c * s1;
+                for (int k = 0; k < s1; k++) {
+                    uint64_t v = R[k];
+                    if (b) {
+                        v -= sci::readFromPackedArr(
+                            packed.data(), packed.size(), bitPtr, chunk
+                        );
+                    }
+                    bitPtr += chunk;
+                    out[k] += (intType)(v & chunkMask) << i;
+                }
+            }
+        }
+        delete[] choices;
+        for (int t = 0; t < count; t++) {
+            sci::convertColToRowMajor<intType>(
+                s1, s3, CT.data() + t * nC, C + t * nC
+            );
+        }
+    }
+
+    // Bytes of the corrections of the COTs [j0, j0 + n).
+    uint64_t packedBytes(int64_t j0, int64_t n, int s1) const {
+        uint64_t bits = 0;
+        for (int64_t j = j0; j < j0 + n; j++) {
+            bits += (uint64_t)(bitlength - j % bitlength) * s1;
+        }
+        return (bits + 7) / 8;
+    }
+
+    void localMatMul(
+        int s1, int s2, int s3, const intType *A, const intType *B, intType *C
+    ) const {
+#ifdef USE_EIGEN
+        using RowMajor = Eigen::Matrix<
+            intType, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+        Eigen::Map<const RowMajor> a(A, s1, s2);
+        Eigen::Map<const RowMajor> b(B, s2, s3);
+        Eigen::Map<RowMajor> c(C, s1, s3);
+        c.noalias() = a * b;
+#else
+        for (int i = 0; i < s1; i++) {
+            for (int j = 0; j < s3; j++) {
+                intType acc = 0;
+                for (int k = 0; k < s2; k++) {
+                    acc += A[i * s2 + k] * B[k * s3 + j];
+                }
+                C[i * s3 + j] = acc;
+            }
+        }
+#endif
+    }
+
+    IO *io;
+    cheetah::SilentOT<IO> *silentOT;
+    cheetah::SilentOT<IO> *silentOTReversed;
+    sci::PRG128 prg;
+    sci::CRH crh;
+    std::map<std::array<int, 3>, std::deque<Triple>> store_;
+};
+
+#endif  // MATMUL_TRIPLES_H__
@@ -1020,3 +1020,411 @@ void MathFunctions::ReLU(
     delete[] tmp;
     delete[] tmp_msb;
 }
+
+void MathFunctions::row_max(
+    int32_t rows, int32_t cols, uint64_t *x, uint64_t *max_x, int32_t bw_x
+) {
+    uint64_t mask_x = (bw_x == 64 ? -1 : ((1ULL << bw_x) - 1));
+
+    // cur: rows x width, the maxima of the previous level
+    uint64_t *cur = new uint64_t[rows * cols];
+    uint64_t *diff = new uint64_t[rows * (cols / 2)];
+    uint64_t *relu_diff = new uint64_t[rows * (cols / 2)];
+    memcpy(cur, x, rows * cols * sizeof(uint64_t));
+    int32_t width = cols;
+    while (width > 1) {
+        int32_t half = width / 2;
+        int32_t next = half + (width & 1);
+        for (int r = 0; r < rows; r++) {
+            for (int k = 0; k < half; k++) {
+                diff[r * half + k] = (cur[r * width + 2 * k] -
+                                      cur[r * width + 2 * k + 1]) &
+                                     mask_x;
+            }
+        }
+        // max(a, b) = b + ReLU(a - b)
+        ReLU(rows * half, diff, relu_diff, bw_x);
+        // In place: the level is read ahead of where it is written
+        for (int r = 0; r < rows; r++) {
+            for (int k = 0; k < half; k++) {
+                cur[r * next + k] =
+                    (cur[r * width + 2 * k + 1] + relu_diff[r * half + k]) &
+                    mask_x;
+            }
+            if (width & 1) {
+                cur[r * next + half] = cur[r * width + width - 1];
+            }
+        }
+        width = next;
+    }
+    memcpy(max_x, cur, rows * sizeof(uint64_t));
+
+    delete[] cur;
+    delete[] diff;
+    delete[] relu_diff;
+}
+
+void MathFunctions::row_mean(
+    int32_t rows,
+    int32_t cols,
+    uint64_t *x,
+    uint64_t *mean_x,
+    int32_t bw_x,
+    bool signed_x
+) {
+    int32_t bw_sum = bw_x + ceil(log2(cols));
+    // 1/cols ~ c / 2^k, for the largest k with sum * c in 64 bits
+    int32_t k = 64 - bw_sum + ceil(log2(cols));
+    uint64_t c;
+    int32_t bw_prod;
+    do {
+        k--;
+        c = llround(ldexp(1.0, k) / cols);
+        bw_prod = bw_sum + (64 - __builtin_clzll(c));
+    } while (bw_prod > 64);
+    assert(bw_prod - k >= bw_x);
+    uint64_t mask_prod = (bw_prod == 64 ? -1 : ((1ULL << bw_prod) - 1));
+
+    uint64_t *x_ext = new uint64_t[rows * cols];
+    if (signed_x) {
+        xt->s_extend(rows * cols, x, x_ext, bw_x, bw_prod);
+    } else {
+        xt->z_extend(rows * cols, x, x_ext, bw_x, bw_prod);
+    }
+    uint64_t *tmp = new uint64_t[rows];
+    for (int r = 0; r < rows; r++) {
+        uint64_t sum = 0;
+        for (int j = 0; j < cols; j++) {
+            sum += x_ext[r * cols + j];
+        }
+        tmp[r] = (sum * c) & mask_prod;
+    }
+    // tmp: bw = bw_prod - k
+    trunc->truncate_and_reduce(rows, tmp, tmp, k, bw_prod);
+    aux->reduce(rows, tmp, mean_x, bw_prod - k, bw_x);
+
+    delete[] x_ext;
+    delete[] tmp;
+}
+
+void MathFunctions::softmax(
+    int32_t rows,
+    int32_t cols,
+    uint64_t *x,
+    uint64_t *y,
+    int32_t bw_x,
+    int32_t bw_y,
+    int32_t s_x,
+    int32_t s_y
+) {
+    assert(bw_y >= (s_y + 2));
+    int32_t dim = rows * cols;
+    uint64_t mask_x = (bw_x == 64 ? -1 : ((1ULL << bw_x) - 1));
+    uint64_t mask_y = (bw_y == 64 ? -1 : ((1ULL << bw_y) - 1));
+    // The sums of the exponents are in [1, cols]
+    int32_t bw_sum = s_y + 2 + ceil(log2(cols));
+    uint64_t mask_sum = (bw_sum == 64 ? -1 : ((1ULL << bw_sum) - 1));
+    uint8_t *zero_shares = new uint8_t[dim];
+    for (int i = 0; i < dim; i++) {
+        zero_shares[i] = 0;
+    }
+
+    uint64_t *max_x = new uint64_t[rows];
+    row_max(rows, cols, x, max_x, bw_x);
+
+    // tmp_1 = x - max_x <= 0
+    uint64_t *tmp_1 = new uint64_t[dim];
+    uint64_t *tmp_2 = new uint64_t[dim];
+    for (int i = 0; i < dim; i++) {
+        tmp_1[i] = (x[i] - max_x[i / cols]) & mask_x;
+    }
+    // exp_x: bw = s_y + 2, scale = s_y
+    uint64_t *exp_x = new uint64_t[dim];
+    lookup_table_exp(dim, tmp_1, exp_x, bw_x, s_y + 2, s_x, s_y);
+
+    // sum_exp: bw = bw_sum, scale = s_y
+    xt->z_extend(dim, exp_x, tmp_1, s_y + 2, bw_sum, zero_shares);
+    uint64_t *sum_exp = new uint64_t[rows];
+    uint64_t *one = new uint64_t[rows];
+    for (int r = 0; r < rows; r++) {
+        sum_exp[r] = 0;
+        for (int j = 0; j < cols; j++) {
+            sum_exp[r] += tmp_1[r * cols + j];
+        }
+        sum_exp[r] &= mask_sum;
+        one[r] = (party == sci::ALICE ? 1 : 0);
+    }
+    // inv_sum = 1/sum_exp: bw = s_y + 2, scale = s_y
+    uint64_t *inv_sum = new uint64_t[rows];
+    div(rows, one, sum_exp, inv_sum, 2, bw_sum, s_y + 2, 0, s_y, s_y, true,
+        true);
+
+    // y = exp_x * inv_sum
+    for (int i = 0; i < dim; i++) {
+        tmp_2[i] = inv_sum[i / cols];
+    }
+    mult->hadamard_product(
+        dim, exp_x, tmp_2, tmp_1, s_y + 2, s_y + 2, 2 * s_y + 2, false, false,
+        MultMode::None, zero_shares, zero_shares
+    );
+    trunc->truncate_and_reduce(dim, tmp_1, tmp_2, s_y, 2 * s_y + 2);
+    if (bw_y <= (s_y + 2)) {
+        for (int i = 0; i < dim; i++) {
+            y[i] = tmp_2[i] & mask_y;
+        }
+    } else {
+        xt->z_extend(dim, tmp_2, y, s_y + 2, bw_y, zero_shares);
+    }
+
+    delete[] zero_shares;
+    delete[] max_x;
+    delete[] tmp_1;
+    delete[] tmp_2;
+    delete[] exp_x;
+    delete[] sum_exp;
+    delete[] one;
+    delete[] inv_sum;
+}
+
+void MathFunctions::layer_norm(
+    int32_t rows,
+    int32_t cols,
+    uint64_t *x,
+    uint64_t *y,
+    int32_t bw_x,
+    int32_t bw_y,
+    int32_t s_x,
+    int32_t s_y
+) {
+    assert(bw_x + s_x <= 64 && bw_y + s_x <= 64 && bw_y <= bw_x);
+    int32_t dim = rows * cols;
+    uint64_t mask_x = (bw_x == 64 ? -1 : ((1ULL << bw_x) - 1));
+    // 1/sqrt(var + 2^-s_x) < 2^(s_x/2)
+    int32_t bw_inv = s_y + (s_x + 1) / 2 + 2;
+    uint8_t *zero_shares = new uint8_t[dim];
+    for (int i = 0; i < dim; i++) {
+        zero_shares[i] = 0;
+    }
+
+    // d = x - mean_x: bw = bw_x, scale = s_x
+    uint64_t *mean_x = new uint64_t[rows];
+    row_mean(rows, cols, x, mean_x, bw_x, true);
+    uint64_t *d = new uint64_t[dim];
+    for (int i = 0; i < dim; i++) {
+        d[i] = (x[i] - mean_x[i / cols]) & mask_x;
+    }
+    uint8_t *msb_d = new uint8_t[dim];
+    aux->MSB(d, msb_d, dim, bw_x);
+
+    // tmp_2 = d^2: bw = bw_x, scale = s_x
+    uint64_t *tmp_1 = new uint64_t[dim];
+    uint64_t *tmp_2 = new uint64_t[dim];
+    mult->hadamard_product(
+        dim, d, d, tmp_1, bw_x, bw_x, bw_x + s_x, true, true, MultMode::None,
+        msb_d, msb_d
+    );
+    trunc->truncate_and_reduce(dim, tmp_1, tmp_2, s_x, bw_x + s_x);
+
+    // var = mean(d^2) + 2^-s_x, which also keeps 1/sqrt defined
+    uint64_t *var = new uint64_t[rows];
+    row_mean(rows, cols, tmp_2, var, bw_x, false);
+    for (int r = 0; r < rows; r++) {
+        var[r] = (var[r] + (party == sci::ALICE ? 1 : 0)) & mask_x;
+    }
+    // inv_std: bw = bw_inv, scale = s_y
+    uint64_t *inv_std = new uint64_t[rows];
+    sqrt(rows, var, inv_std, bw_x, bw_inv, s_x, s_y, true);
+
+    // y = d * inv_std: bw = bw_prod, scale = s_x + s_y
+    for (int i = 0; i < dim; i++) {
+        tmp_2[i] = inv_std[i / cols];
+    }
+    int32_t bw_prod = std::max(bw_y + s_x, std::max(bw_x, bw_inv));
+    mult->hadamard_product(
+        dim, d, tmp_2, tmp_1, bw_x, bw_inv, bw_prod, true, false,
+        MultMode::None, msb_d, zero_shares
+    );
+    trunc->truncate_and_reduce(dim, tmp_1, tmp_2, s_x, bw_prod);
+    aux->reduce(dim, tmp_2, y, bw_prod - s_x, bw_y);
+
+    delete[] zero_shares;
+    delete[] mean_x;
+    delete[] d;
+    delete[] msb_d;
+    delete[] tmp_1;
+    delete[] tmp_2;
+    delete[] var;
+    delete[] inv_std;
+}
+
+void MathFunctions::gelu(
+    int32_t dim,
+    uint64_t *x,
+    uint64_t *y,
+    int32_t bw_x,
+    int32_t bw_y,
+    int32_t s_x,
+    int32_t s_y
+) {
+    // 1.702 ~ c / 2^k
+    const int32_t k = 8;
+    const uint64_t c = llround(1.702 * (1ULL << k));
+    const int32_t bw_c = 64 - __builtin_clzll(c);
+    assert(bw_x + bw_c <= 64 && bw_y + s_x <= 64);
+    uint64_t mask_t =
+        ((bw_x + bw_c) == 64 ? -1 : ((1ULL << (bw_x + bw_c)) - 1));
+    uint8_t *zero_shares = new uint8_t[dim];
+    for (int i = 0; i < dim; i++) {
+        zero_shares[i] = 0;
+    }
+
+    uint8_t *msb_x = new uint8_t[dim];
+    aux->MSB(x, msb_x, dim, bw_x);
+
+    // t = 1.702 * x: bw = bw_x, scale = s_x
+    uint64_t *tmp_1 = new uint64_t[dim];
+    uint64_t *tmp_2 = new uint64_t[dim];
+    xt->s_extend(dim, x, tmp_1, bw_x, bw_x + bw_c, msb_x);
+    for (int i = 0; i < dim; i++) {
+        tmp_1[i] = (tmp_1[i] * c) & mask_t;
+    }
+    trunc->truncate_and_reduce(dim, tmp_1, tmp_2, k, bw_x + bw_c);
+    aux->reduce(dim, tmp_2, tmp_2, bw_x + bw_c - k, bw_x);
+
+    // sig: bw = s_y + 2, scale = s_y
+    uint64_t *sig = new uint64_t[dim];
+    sigmoid(dim, tmp_2, sig, bw_x, s_y + 2, s_x, s_y);
+
+    // y = x * sig: bw = bw_y + s_x, scale = s_x + s_y
+    mult->hadamard_product(
+        dim, x, sig, tmp_1, bw_x, s_y + 2, bw_y + s_x, true, false,
+        MultMode::None, msb_x, zero_shares
+    );
+    trunc->truncate_and_reduce(dim, tmp_1, y, s_x, bw_y + s_x);
+
+    delete[] zero_shares;
+    delete[] msb_x;
+    delete[] tmp_1;
+    delete[] tmp_2;
+    delete[] sig;
+}
+
+void MathFunctions::piecewise_poly(
+    int32_t dim,
+    uint64_t *x,
+    uint64_t *y,
+    int32_t bw_x,
+    int32_t bw_y,
+    int32_t s_x,
+    int32_t s_y,
+    const PiecewisePoly &pp
+) {
+    assert(pp.s_x == s_x && pp.s_c >= s_y);
+    int32_t num_knots = pp.knots.size();
+    int32_t degree = pp.degree;
+    uint64_t mask_x = (bw_x == 64 ? -1 : ((1ULL << bw_x) - 1));
+
+    // bw_c: bitwidth of the coefficients and the terms, scale = s_c. The
+    // tails are linear, and they take any x.
+    int32_t bw_c = std::max(pp.bw_terms, bw_x - s_x);
+    for (int i : {0, num_knots}) {
+        double tail = std::abs(pp.coeffs[i][0]);
+        if (degree > 0) {
+            tail += std::abs(pp.coeffs[i][1]) * ldexp(1.0, bw_x - s_x - 1);
+        }
+        bw_c = std::max(bw_c, int32_t(ceil(log2(tail + 1))) + 1);
+    }
+    int32_t bw_prod = bw_c + s_x;
+    assert(bw_prod <= 64);
+    uint64_t mask_c = (bw_c == 64 ? -1 : ((1ULL << bw_c) - 1));
+    uint64_t mask_prod = (bw_prod == 64 ? -1 : ((1ULL << bw_prod) - 1));
+
+    // One batch: MSB(x - knot_j) for all the knots, and MSB(x)
+    uint64_t *tmp_1 = new uint64_t[(num_knots + 1) * dim];
+    uint8_t *msb = new uint8_t[(num_knots + 1) * dim];
+    for (int j = 0; j < num_knots; j++) {
+        uint64_t knot = (party == sci::ALICE ? pp.knots[j] : 0);
+        for (int i = 0; i < dim; i++) {
+            tmp_1[j * dim + i] = (x[i] - knot) & mask_x;
+        }
+    }
+    memcpy(tmp_1 + num_knots * dim, x, dim * sizeof(uint64_t));
+    aux->MSB(tmp_1, msb, (num_knots + 1) * dim, bw_x);
+    uint8_t *msb_x = msb + num_knots * dim;
+
+    // ge[j] = (x >= knot_j)
+    for (int i = 0; i < num_knots * dim; i++) {
+        msb[i] ^= (party == sci::ALICE ? 1 : 0);
+    }
+    uint64_t *ge = new uint64_t[num_knots * dim];
+    aux->B2A(msb, ge, num_knots * dim, bw_prod);
+
+    // coeff_m = coeffs[0][m] + sum_j ge[j] * (coeffs[j+1][m] - coeffs[j][m]).
+    // coeff_0 is scaled by 2^s_x, to be added to the terms.
+    uint64_t *coeff_0 = new uint64_t[dim];
+    uint64_t *coeff = new uint64_t[std::max(degree, 1) * dim];
+    for (int m = 0; m <= degree; m++) {
+        uint64_t *out = (m == 0 ? coeff_0 : coeff + (m - 1) * dim);
+        int32_t shift = (m == 0 ? s_x : 0);
+        for (int i = 0; i < dim; i++) {
+            out[i] = (party == sci::ALICE ? uint64_t(pp.coeffs[0][m]) << shift
+                                          : 0);
+        }
+        for (int j = 0; j < num_knots; j++) {
+            uint64_t delta = uint64_t(pp.coeffs[j + 1][m] - pp.coeffs[j][m])
+                             << shift;
+            if (delta == 0) continue;
+            for (int i = 0; i < dim; i++) {
+                out[i] += ge[j * dim + i] * delta;
+            }
+        }
+        for (int i = 0; i < dim; i++) {
+            out[i] &= (m == 0 ? mask_prod : mask_c);
+        }
+    }
+
+    // pw[m-1] = x^m: bw = bw_x, scale = s_x
+    uint64_t *pw = new uint64_t[std::max(degree, 1) * dim];
+    memcpy(pw, x, dim * sizeof(uint64_t));
+    uint64_t *tmp_2 = new uint64_t[std::max(degree, 1) * dim];
+    for (int m = 2; m <= degree; m++) {
+        mult->hadamard_product(
+            dim, pw + (m - 2) * dim, x, tmp_2, bw_x, bw_x, bw_x + s_x, true,
+            true, MultMode::None, (m == 2 ? msb_x : nullptr), msb_x
+        );
+        trunc->truncate_and_reduce(
+            dim, tmp_2, pw + (m - 1) * dim, s_x, bw_x + s_x
+        );
+    }
+
+    // acc = sum_m coeff_m * x^m: bw = bw_prod, scale = s_c + s_x
+    uint64_t *acc = coeff_0;
+    if (degree > 0) {
+        mult->hadamard_product(
+            degree * dim, coeff, pw, tmp_2, bw_c, bw_x, bw_prod, true, true,
+            MultMode::None, nullptr, (degree == 1 ? msb_x : nullptr)
+        );
+        for (int m = 0; m < degree; m++) {
+            for (int i = 0; i < dim; i++) {
+                acc[i] = (acc[i] + tmp_2[m * dim + i]) & mask_prod;
+            }
+        }
+    }
+
+    // y: bw = bw_c - s_c + s_y, scale = s_y
+    int32_t bw_out = bw_c - pp.s_c + s_y;
+    trunc->truncate_and_reduce(dim, acc, tmp_2, s_x + pp.s_c - s_y, bw_prod);
+    if (bw_out >= bw_y) {
+        aux->reduce(dim, tmp_2, y, bw_out, bw_y);
+    } else {
+        xt->s_extend(dim, tmp_2, y, bw_out, bw_y);
+    }
+
+    delete[] tmp_1;
+    delete[] tmp_2;
+    delete[] msb;
+    delete[] ge;
+    delete[] coeff_0;
+    delete[] coeff;
+    delete[] pw;
+}
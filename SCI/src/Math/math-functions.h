@@ -26,6 +26,7 @@ SOFTWARE.
 #include "BuildingBlocks/truncation.h"
 #include "BuildingBlocks/value-extension.h"
 #include "LinearOT/linear-ot.h"
+#include "Math/piecewise-poly.h"
 
 class MathFunctions {
    public:
@@ -131,6 +132,82 @@ class MathFunctions {
     void ReLU(
         int32_t dim, uint64_t *x, uint64_t *y, int32_t bw_x, uint64_t six = 0
     );
+
+    // The row-wise functions below take a rows x cols matrix in row-major
+    // order. All the rows share each protocol call, so the number of rounds
+    // only depends on cols.
+
+    // max_x[r] = max(x[r]); bw = bw_x
+    // Assumes that the differences within a row fit in bw_x bits
+    void row_max(
+        int32_t rows, int32_t cols, uint64_t *x, uint64_t *max_x, int32_t bw_x
+    );
+
+    // mean_x[r] = mean(x[r]); bw = bw_x
+    void row_mean(
+        int32_t rows,
+        int32_t cols,
+        uint64_t *x,
+        uint64_t *mean_x,
+        int32_t bw_x,
+        bool signed_x = true
+    );
+
+    // y[r] = softmax(x[r]); bw_y >= s_y + 2
+    void softmax(
+        int32_t rows,
+        int32_t cols,
+        uint64_t *x,
+        uint64_t *y,
+        int32_t bw_x,
+        int32_t bw_y,
+        int32_t s_x,
+        int32_t s_y
+    );
+
+    // y[r] = (x[r] - mean(x[r])) / sqrt(var(x[r]) + 2^-s_x), without the
+    // affine transform, which is an element-wise product and sum.
+    // Assumes that (x - mean)^2 < 2^(bw_x - s_x - 1) and bw_y <= bw_x
+    void layer_norm(
+        int32_t rows,
+        int32_t cols,
+        uint64_t *x,
+        uint64_t *y,
+        int32_t bw_x,
+        int32_t bw_y,
+        int32_t s_x,
+        int32_t s_y
+    );
+
+    // y = x * sigmoid(1.702 * x), the sigmoid approximation of GELU.
+    // Assumes that |1.702 * x| < 2^(bw_x - s_x - 1) and
+    // bw_y - s_y >= bw_x - s_x
+    void gelu(
+        int32_t dim,
+        uint64_t *x,
+        uint64_t *y,
+        int32_t bw_x,
+        int32_t bw_y,
+        int32_t s_x,
+        int32_t s_y
+    );
+
+    // y = pp(x), for a segment table of any function, see piecewise-poly.h.
+    // The segment is selected with one comparison per knot, all in one
+    // batch, and the terms are summed before one truncation.
+    // Assumes that |x - knot| < 2^(bw_x - s_x - 1) for all the knots,
+    // |x|^degree < 2^(bw_x - s_x - 1) on the inner segments,
+    // pp.s_x = s_x and pp.s_c >= s_y
+    void piecewise_poly(
+        int32_t dim,
+        uint64_t *x,
+        uint64_t *y,
+        int32_t bw_x,
+        int32_t bw_y,
+        int32_t s_x,
+        int32_t s_y,
+        const PiecewisePoly &pp
+    );
 };
 
 #endif
@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: MIT
+
+#include "Math/piecewise-poly.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+// Least-squares polynomial through the points (xs, ys), as the coefficients
+// of the monomials of x. It is solved in t = (x - c) / h for conditioning.
+std::vector<double> least_squares(
+    const std::vector<double> &xs,
+    const std::vector<double> &ys,
+    int32_t degree
+) {
+    int32_t d = std::min<int32_t>(degree, xs.size() - 1);
+    int32_t k = d + 1;
+    double c = (xs.front() + xs.back()) / 2;
+    double h = std::max((xs.back() - xs.front()) / 2, 1e-9);
+
+    // Normal equations, [A | b]
+    std::vector<std::vector<double>> A(k, std::vector<double>(k + 1, 0.0));
+    std::vector<double> pw(k);
+    for (size_t n = 0; n < xs.size(); n++) {
+        double t = (xs[n] - c) / h;
+        pw[0] = 1.0;
+        for (int32_t j = 1; j < k; j++) pw[j] = pw[j - 1] * t;
+        for (int32_t i = 0; i < k; i++) {
+            for (int32_t j = 0; j < k; j++) A[i][j] += pw[i] * pw[j];
+            A[i][k] += pw[i] * ys[n];
+        }
+    }
+    for (int32_t i = 0; i < k; i++) {
+        int32_t pivot = i;
+        for (int32_t r = i + 1; r < k; r++) {
+            if (fabs(A[r][i]) > fabs(A[pivot][i])) pivot = r;
+        }
+        std::swap(A[i], A[pivot]);
+        for (int32_t r = 0; r < k; r++) {
+            if (r == i || A[i][i] == 0.0) continue;
+            double ratio = A[r][i] / A[i][i];
+            for (int32_t j = i; j <= k; j++) A[r][j] -= ratio * A[i][j];
+        }
+    }
+
+    // sum_j q_j ((x - c) / h)^j in the monomials of x
+    std::vector<double> coeffs(degree + 1, 0.0);
+    for (int32_t j = 0; j < k; j++) {
+        double q = (A[j][j] == 0.0 ? 0.0 : A[j][k] / A[j][j]) / pow(h, j);
+        double binom = 1.0;
+        for (int32_t i = 0; i <= j; i++) {
+            coeffs[i] += q * binom * pow(-c, j - i);
+            binom = binom * (j - i) / (i + 1);
+        }
+    }
+    return coeffs;
+}
+
+struct Segment {
+    std::vector<int64_t> coeffs;
+    double err;
+};
+
+// Fits f on the inputs [a, b) of scale s_x
+Segment fit_segment(
+    const std::function<double(double)> &f,
+    int64_t a,
+    int64_t b,
+    int32_t degree,
+    int32_t s_x,
+    int32_t s_c
+) {
+    const int64_t kMaxSamples = 1024;
+    int64_t stride = std::max<int64_t>(1, (b - a) / kMaxSamples);
+    std::vector<double> xs, ys;
+    for (int64_t v = a; v < b; v += stride) {
+        xs.push_back(v / double(1LL << s_x));
+        ys.push_back(f(xs.back()));
+    }
+    if (xs.back() != (b - 1) / double(1LL << s_x)) {
+        xs.push_back((b - 1) / double(1LL << s_x));
+        ys.push_back(f(xs.back()));
+    }
+    std::vector<double> coeffs = least_squares(xs, ys, degree);
+
+    Segment seg;
+    seg.coeffs.resize(degree + 1);
+    for (int32_t m = 0; m <= degree; m++) {
+        seg.coeffs[m] = llround(ldexp(coeffs[m], s_c));
+    }
+    seg.err = 0.0;
+    for (int64_t v = a; v < b; v++) {
+        double x = v / double(1LL << s_x);
+        double y = 0.0;
+        for (int32_t m = degree; m >= 0; m--) {
+            y = y * x + seg.coeffs[m] / double(1LL << s_c);
+        }
+        seg.err = std::max(seg.err, fabs(y - f(x)));
+    }
+    return seg;
+}
+
+}  // namespace
+
+PiecewisePoly fit_piecewise_poly(
+    const std::function<double(double)> &f,
+    double lo,
+    double hi,
+    int32_t degree,
+    double max_err,
+    int32_t s_x,
+    int32_t s_c,
+    int32_t max_segments
+) {
+    assert(degree >= 0 && max_segments >= 3 && s_x < 62 && s_c < 62);
+    int64_t lo_x = int64_t(ceil(ldexp(lo, s_x)));
+    int64_t hi_x = int64_t(ceil(ldexp(hi, s_x)));
+    assert(lo_x < hi_x);
+
+    PiecewisePoly pp;
+    pp.degree = degree;
+    pp.s_x = s_x;
+    pp.s_c = s_c;
+
+    // The tails are fitted on half of the width of [lo, hi) each
+    int64_t tail = std::max<int64_t>(1, (hi_x - lo_x) / 2);
+    int32_t tail_degree = std::min(degree, 1);
+    Segment left = fit_segment(f, lo_x - tail, lo_x, tail_degree, s_x, s_c);
+    left.coeffs.resize(degree + 1, 0);
+    pp.coeffs.push_back(left.coeffs);
+    pp.max_err = left.err;
+
+    double bound = 0.0;
+    int64_t a = lo_x;
+    while (a < hi_x) {
+        int64_t b = hi_x;
+        Segment seg = fit_segment(f, a, b, degree, s_x, s_c);
+        // The last inner segment takes the rest
+        if (seg.err > max_err && pp.num_segments() < max_segments - 2) {
+            // The largest b with the error in bound
+            int64_t good = a + 1, bad = b;
+            seg = fit_segment(f, a, good, degree, s_x, s_c);
+            while (bad - good > 1) {
+                int64_t mid = good + (bad - good) / 2;
+                Segment cand = fit_segment(f, a, mid, degree, s_x, s_c);
+                if (cand.err <= max_err) {
+                    good = mid;
+                    seg = cand;
+                } else {
+                    bad = mid;
+                }
+            }
+            b = good;
+        }
+        pp.knots.push_back(a);
+        pp.coeffs.push_back(seg.coeffs);
+        pp.max_err = std::max(pp.max_err, seg.err);
+        for (int64_t v : {a, b - 1}) {
+            // |x|^m is the largest at one of the ends
+            double x = fabs(v / double(1LL << s_x));
+            double terms = 0.0;
+            for (int32_t m = 0; m <= degree; m++) {
+                terms += fabs(seg.coeffs[m] / double(1LL << s_c)) * pow(x, m);
+            }
+            bound = std::max(bound, terms);
+        }
+        a = b;
+    }
+
+    Segment right = fit_segment(f, hi_x, hi_x + tail, tail_degree, s_x, s_c);
+    right.coeffs.resize(degree + 1, 0);
+    pp.knots.push_back(hi_x);
+    pp.coeffs.push_back(right.coeffs);
+    pp.max_err = std::max(pp.max_err, right.err);
+
+    pp.bw_terms = int32_t(ceil(log2(ldexp(bound, s_c) + 1))) + 1;
+    return pp;
+}
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef MATH_PIECEWISE_POLY_H__
+#define MATH_PIECEWISE_POLY_H__
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// A segment table for MathFunctions::piecewise_poly: on segment i,
+// f(x) ~ sum_m coeffs[i][m] * x^m.
+//
+// Segment i covers [knots[i - 1], knots[i]); the first and the last segments
+// are unbounded, and they are linear, so that they extend the function
+// outside the fitted range.
+struct PiecewisePoly {
+    int32_t degree = 0;
+    // Scale of the knots, i.e., of the input
+    int32_t s_x = 0;
+    // Scale of the coefficients
+    int32_t s_c = 0;
+    // Increasing, fixed-point with scale s_x
+    std::vector<int64_t> knots;
+    // coeffs[i][m], fixed-point with scale s_c
+    std::vector<std::vector<int64_t>> coeffs;
+    // Bits (incl. the sign) of the terms and of their sums on the inner
+    // segments, with scale s_c
+    int32_t bw_terms = 0;
+    // Max. absolute error measured by the fit
+    double max_err = 0.0;
+
+    int32_t num_segments() const { return coeffs.size(); }
+
+    // In the clear, with the fixed-point coefficients
+    double eval(double x) const {
+        int64_t x_fixed = int64_t(floor(x * (1LL << s_x)));
+        size_t seg = 0;
+        while (seg < knots.size() && x_fixed >= knots[seg]) seg++;
+        double y = 0.0;
+        for (int32_t m = degree; m >= 0; m--) {
+            y = y * (x_fixed / double(1LL << s_x)) +
+                coeffs[seg][m] / double(1LL << s_c);
+        }
+        return y;
+    }
+
+    // Format: "<degree> <s_x> <s_c> <bw_terms> <max_err> <#segments>", then
+    // one "<knot> <coeff_0> ... <coeff_degree>" per segment, without the
+    // knot for the first one. '#' starts a comment.
+    bool load(const std::string &path) {
+        std::ifstream in(path);
+        if (!in) return false;
+        std::stringstream ss;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            ss << line << "\n";
+        }
+        int32_t nsegs = 0;
+        if (!(ss >> degree >> s_x >> s_c >> bw_terms >> max_err >> nsegs) ||
+            nsegs < 1 || degree < 0) {
+            return false;
+        }
+        knots.assign(nsegs - 1, 0);
+        coeffs.assign(nsegs, std::vector<int64_t>(degree + 1, 0));
+        for (int32_t i = 0; i < nsegs; i++) {
+            if (i > 0 && !(ss >> knots[i - 1])) return false;
+            for (int32_t m = 0; m <= degree; m++) {
+                if (!(ss >> coeffs[i][m])) return false;
+            }
+        }
+        return true;
+    }
+
+    bool save(const std::string &path) const {
+        std::ofstream out(path);
+        if (!out) return false;
+        out << "# degree s_x s_c bw_terms max_err segments\n";
+        out << degree << " " << s_x << " " << s_c << " " << bw_terms << " "
+            << max_err << " " << num_segments() << "\n";
+        out << "# knot coeff_0 ... coeff_degree\n";
+        for (int32_t i = 0; i < num_segments(); i++) {
+            if (i > 0) out << knots[i - 1] << " ";
+            for (int32_t m = 0; m <= degree; m++) {
+                out << coeffs[i][m] << (m == degree ? "\n" : " ");
+            }
+        }
+        return true;
+    }
+};
+
+// Offline: fits f on [lo, hi) with as few segments of the given degree as
+// meet max_err on every input of scale s_x, up to max_segments. The
+// segments are grown greedily from lo, with least-squares polynomials. The
+// error of the fixed-point coefficients is included, that of the secure
+// evaluation (a few ULPs of s_y) is not.
+PiecewisePoly fit_piecewise_poly(
+    const std::function<double(double)> &f,
+    double lo,
+    double hi,
+    int32_t degree,
+    double max_err,
+    int32_t s_x,
+    int32_t s_c,
+    int32_t max_segments = 64
+);
+
+#endif  // MATH_PIECEWISE_POLY_H__
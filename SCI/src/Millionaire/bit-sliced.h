@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef MILLIONAIRE_BIT_SLICED_H__
+#define MILLIONAIRE_BIT_SLICED_H__
+#include <immintrin.h>
+
+#include <cstdint>
+#include <cstring>
+
+// The building blocks of the bit-sliced comparisons (see
+// MillionaireProtocol::bit_sliced): the shares of the leaves and of the ANDs
+// are bit-vectors, packed as in utils/bit-vector.h, and the AND tree works on
+// 64 comparisons per word.
+namespace sci {
+    inline uint8_t get_bit(const uint8_t *bits, size_t i) {
+        return (bits[i / 8] >> (i % 8)) & 1;
+    }
+
+    // The OT messages of n leaves, N = 2^beta bytes per leaf, for the
+    // digits d: bit 1 is (d > j) (or d < j) ^ the leaf's bit of mask_cmp,
+    // bit 0 is (d == j) ^ its bit of mask_eq. A null mask leaves its bit out,
+    // and the other bit is then bit 0.
+    inline void set_leaf_messages(
+        uint8_t *out,
+        const uint8_t *digits,
+        size_t n,
+        int N,
+        const uint8_t *mask_cmp,
+        const uint8_t *mask_eq,
+        bool greater_than
+    ) {
+        const uint8_t cmp_bit = mask_cmp ? (mask_eq ? 2 : 1) : 0;
+        const uint8_t eq_bit = mask_eq ? 1 : 0;
+        auto leaf_mask = [&](size_t i) {
+            uint8_t x = 0;
+            if (mask_cmp) x |= get_bit(mask_cmp, i) * cmp_bit;
+            if (mask_eq) x |= get_bit(mask_eq, i);
+            return x;
+        };
+
+        size_t i = 0;
+        // With beta = 4 (MILL_PARAM), a leaf is a 128-bit lane of messages.
+#if defined(__AVX512BW__)
+        if (N == 16) {
+            const __m512i iota = _mm512_broadcast_i32x4(_mm_setr_epi8(
+                0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+            ));
+            // Byte k of each 32-bit word to the k-th lane.
+            const __m512i lanes = _mm512_set_epi64(
+                0x0303030303030303LL, 0x0303030303030303LL,
+                0x0202020202020202LL, 0x0202020202020202LL,
+                0x0101010101010101LL, 0x0101010101010101LL, 0, 0
+            );
+            const __m512i cmp_one = _mm512_set1_epi8(cmp_bit);
+            const __m512i eq_one = _mm512_set1_epi8(eq_bit);
+            for (; i + 4 <= n; i += 4) {
+                uint32_t d4, x4 = 0;
+                std::memcpy(&d4, digits + i, sizeof(d4));
+                for (int k = 0; k < 4; ++k) x4 |= leaf_mask(i + k) << (8 * k);
+                const __m512i d =
+                    _mm512_shuffle_epi8(_mm512_set1_epi32(d4), lanes);
+                const __m512i x =
+                    _mm512_shuffle_epi8(_mm512_set1_epi32(x4), lanes);
+                const __mmask64 eq = _mm512_cmpeq_epu8_mask(d, iota);
+                const __mmask64 cmp = greater_than
+                                          ? _mm512_cmpgt_epu8_mask(d, iota)
+                                          : _mm512_cmplt_epu8_mask(d, iota);
+                __m512i v = _mm512_or_si512(
+                    _mm512_maskz_mov_epi8(cmp, cmp_one),
+                    _mm512_maskz_mov_epi8(eq, eq_one)
+                );
+                v = _mm512_xor_si512(v, x);
+                _mm512_storeu_si512((void *)(out + i * 16), v);
+            }
+        }
+#endif
+#if defined(__AVX2__)
+        if (N == 16) {
+            const __m256i iota = _mm256_setr_epi8(
+                0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2,
+                3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+            );
+            // Byte k of each 16-bit word to the k-th lane.
+            const __m256i lanes = _mm256_setr_epi64x(
+                0, 0, 0x0101010101010101LL, 0x0101010101010101LL
+            );
+            const __m256i cmp_one = _mm256_set1_epi8(cmp_bit);
+            const __m256i eq_one = _mm256_set1_epi8(eq_bit);
+            for (; i + 2 <= n; i += 2) {
+                const uint16_t d2 = digits[i] | (digits[i + 1] << 8);
+                const uint16_t x2 = leaf_mask(i) | (leaf_mask(i + 1) << 8);
+                const __m256i d =
+                    _mm256_shuffle_epi8(_mm256_set1_epi16(d2), lanes);
+                const __m256i x =
+                    _mm256_shuffle_epi8(_mm256_set1_epi16(x2), lanes);
+                // No unsigned compare: d > j iff max(d, j) = d != j.
+                const __m256i eq = _mm256_cmpeq_epi8(d, iota);
+                const __m256i ext = greater_than ? _mm256_max_epu8(d, iota)
+                                                 : _mm256_min_epu8(d, iota);
+                const __m256i cmp =
+                    _mm256_andnot_si256(eq, _mm256_cmpeq_epi8(ext, d));
+                __m256i v = _mm256_or_si256(
+                    _mm256_and_si256(cmp, cmp_one), _mm256_and_si256(eq, eq_one)
+                );
+                v = _mm256_xor_si256(v, x);
+                _mm256_storeu_si256((__m256i *)(out + i * 16), v);
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            const uint8_t d = digits[i];
+            const uint8_t x = leaf_mask(i);
+            uint8_t *msg = out + i * N;
+            for (int j = 0; j < N; ++j) {
+                const bool cmp = greater_than ? d > j : d < j;
+                msg[j] = (cmp * cmp_bit | (d == j) * eq_bit) ^ x;
+            }
+        }
+    }
+
+    // Packs bit `bit` of each of the n bytes of `in`.
+    inline void pack_bit_plane(
+        const uint8_t *in, size_t n, int bit, uint8_t *out
+    ) {
+        size_t i = 0;
+#if defined(__AVX2__)
+        for (; i + 32 <= n; i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+            v = _mm256_slli_epi16(v, 7 - bit);
+            const uint32_t bits = _mm256_movemask_epi8(v);
+            std::memcpy(out + i / 8, &bits, sizeof(bits));
+        }
+#endif
+        for (; i < n; ++i) {
+            if (i % 8 == 0) out[i / 8] = 0;
+            out[i / 8] |= ((in[i] >> bit) & 1) << (i % 8);
+        }
+    }
+
+    // One party's shares of e = x ^ a and f = y ^ b, the values opened by
+    // an AND with the bit-triple (a, b, c), over n bytes of packed bits.
+    inline void and_open(
+        uint8_t *e,
+        uint8_t *f,
+        const uint8_t *x,
+        const uint8_t *y,
+        const uint8_t *a,
+        const uint8_t *b,
+        size_t n
+    ) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            uint64_t wx, wy, wa, wb;
+            std::memcpy(&wx, x + i, 8);
+            std::memcpy(&wy, y + i, 8);
+            std::memcpy(&wa, a + i, 8);
+            std::memcpy(&wb, b + i, 8);
+            wx ^= wa;
+            wy ^= wb;
+            std::memcpy(e + i, &wx, 8);
+            std::memcpy(f + i, &wy, 8);
+        }
+        for (; i < n; ++i) {
+            e[i] = x[i] ^ a[i];
+            f[i] = y[i] ^ b[i];
+        }
+    }
+
+    // The share of x & y from the opened e and f: (e & f, for one party
+    // only) ^ (f & a) ^ (e & b) ^ c.
+    inline void and_close(
+        uint8_t *z,
+        const uint8_t *e,
+        const uint8_t *f,
+        const uint8_t *a,
+        const uint8_t *b,
+        const uint8_t *c,
+        size_t n,
+        bool add_ef
+    ) {
+        const uint64_t ef_mask = add_ef ? ~0ULL : 0;
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            uint64_t we, wf, wa, wb, wc;
+            std::memcpy(&we, e + i, 8);
+            std::memcpy(&wf, f + i, 8);
+            std::memcpy(&wa, a + i, 8);
+            std::memcpy(&wb, b + i, 8);
+            std::memcpy(&wc, c + i, 8);
+            const uint64_t wz =
+                (we & wf & ef_mask) ^ (wf & wa) ^ (we & wb) ^ wc;
+            std::memcpy(z + i, &wz, 8);
+        }
+        for (; i < n; ++i) {
+            z[i] = (e[i] & f[i] & (uint8_t)ef_mask) ^ (f[i] & a[i]) ^
+                   (e[i] & b[i]) ^ c[i];
+        }
+    }
+
+    inline void xor_bits(uint8_t *x, const uint8_t *y, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            uint64_t wx, wy;
+            std::memcpy(&wx, x + i, 8);
+            std::memcpy(&wy, y + i, 8);
+            wx ^= wy;
+            std::memcpy(x + i, &wx, 8);
+        }
+        for (; i < n; ++i) x[i] ^= y[i];
+    }
+}  // namespace sci
+#endif  // MILLIONAIRE_BIT_SLICED_H__
@@ -0,0 +1,311 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef TRIPLE_POOL_H__
+#define TRIPLE_POOL_H__
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Millionaire/bit-triple-generator.h"
+
+// A store of pre-generated, packed bit-triples.
+//
+// The pool is filled during setup (or idle time) so that the comparison
+// protocols only run the online AND openings. Both parties MUST consume the
+// pool in the same order: every decision to refill is taken on the amount of
+// consumed triples, which is identical on both sides.
+//
+// The refills run over the `io` and `otpack` given to the constructor, which
+// the pool does not own. When `background = true`, a refill is queued as soon
+// as the pool drops below its low watermark, and the refills run one after
+// the other on a thread of the pool. Thus the given `io`/`otpack` MUST be
+// dedicated to the pool, and stop() must be called before they are
+// destroyed. Otherwise, the refill is done synchronously when the pool runs
+// dry.
+template <typename IO>
+class TriplePool {
+   public:
+    static constexpr int64_t kMaxChunk = 1LL << 22;  // triples per generate()
+
+    TriplePool(
+        int party,
+        IO *io,
+        sci::OTPack<IO> *otpack,
+        TripleGenMethod method,
+        bool background = false
+    )
+        : party_(party), method_(method), background_(background) {
+        // Correlated triples (i.e., _8KKOT) share the `a` part and thus can
+        // not be used for independent ANDs.
+        assert(method != _8KKOT);
+        triple_gen_ = new TripleGenerator<IO>(party, io, otpack);
+        if (background_) {
+            refill_ = std::thread(&TriplePool::refill_loop, this);
+        }
+    }
+
+    ~TriplePool() {
+        stop();
+        delete triple_gen_;
+    }
+
+    IO *io() const { return triple_gen_->io; }
+
+    sci::OTPack<IO> *otpack() const { return triple_gen_->otpack; }
+
+    // Runs the queued refills and joins the refill thread. The other party
+    // queued the same refills and waits for their messages.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stopping_ = true;
+        }
+        refilled_.notify_all();
+        if (refill_.joinable()) refill_.join();
+    }
+
+    // Number of bit-triples consumed by one comparison of `bitlength` bits
+    // with radix `radix_base`. See MillionaireProtocol::configure.
+    static int64_t triples_per_cmp(int bitlength, int radix_base = 4) {
+        if (bitlength <= radix_base) return 0;
+        int num_digits = (bitlength + radix_base - 1) / radix_base;
+        int log_num_digits = sci::bitlen(num_digits);
+        return 2 * num_digits - 2 - log_num_digits;
+    }
+
+    // Generate `num_triples` triples now (blocking). Call during setup.
+    void fill(int64_t num_triples) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        wait_idle(lock);
+        lock.unlock();
+        std::vector<uint8_t> a, b, c;
+        generate(num_triples, a, b, c);
+        lock.lock();
+        scheduled_ += 8 * a.size();
+        append(a, b, c);
+    }
+
+    // Once the pool drops below `low_watermark` triples, another `refill_size`
+    // triples are generated (in the background if enabled).
+    void set_watermark(int64_t low_watermark, int64_t refill_size) {
+        low_watermark_ = low_watermark;
+        refill_size_ = refill_size;
+    }
+
+    // Triples consumed by the following fetch() calls are accounted to
+    // `layer`.
+    void set_layer(const std::string &layer) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        layer_ = layer;
+    }
+
+    void fetch(Triple *triples) {
+        fetch(
+            triples->ai, triples->bi, triples->ci, triples->num_triples,
+            triples->packed
+        );
+    }
+
+    void fetch(
+        uint8_t *ai, uint8_t *bi, uint8_t *ci, int num_triples, bool packed
+    ) {
+        if (num_triples <= 0) return;
+        const int64_t nbytes = (num_triples + 7) / 8;
+        ensure(nbytes);
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            const uint8_t *a = a_.data() + head_;
+            const uint8_t *b = b_.data() + head_;
+            const uint8_t *c = c_.data() + head_;
+            if (packed) {
+                std::memcpy(ai, a, nbytes);
+                std::memcpy(bi, b, nbytes);
+                std::memcpy(ci, c, nbytes);
+            } else {
+                for (int i = 0; i < num_triples; i += 8) {
+                    int len = std::min(8, num_triples - i);
+                    sci::uint8_to_bool(ai + i, a[i / 8], len);
+                    sci::uint8_to_bool(bi + i, b[i / 8], len);
+                    sci::uint8_to_bool(ci + i, c[i / 8], len);
+                }
+            }
+            head_ += nbytes;
+            consumed_[layer_] += 8 * nbytes;
+            total_consumed_ += 8 * nbytes;
+        }
+        maybe_refill();
+    }
+
+    int64_t available() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return buffered();
+    }
+
+    // Number of triples consumed per layer name.
+    std::map<std::string, uint64_t> consumed_per_layer() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return consumed_;
+    }
+
+    void print_stats(std::ostream &os = std::cout) {
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            wait_idle(lock);
+        }
+        os << "TriplePool: generated " << total_generated_ << ", consumed "
+           << total_consumed_ << ", available " << available()
+           << ", online refills " << online_refills_
+           << ", background refills " << background_refills_ << "\n";
+        for (const auto &kv : consumed_per_layer()) {
+            os << "  " << kv.first << ": " << kv.second << " triples\n";
+        }
+    }
+
+   private:
+    void generate(
+        int64_t num_triples,
+        std::vector<uint8_t> &a,
+        std::vector<uint8_t> &b,
+        std::vector<uint8_t> &c
+    ) {
+        // The generators require multiple of 8 (packed) and even numbers.
+        num_triples = (num_triples + 7) / 8 * 8;
+        a.resize(num_triples / 8);
+        b.resize(num_triples / 8);
+        c.resize(num_triples / 8);
+        for (int64_t done = 0; done < num_triples; done += kMaxChunk) {
+            int n = (int)std::min(kMaxChunk, num_triples - done);
+            triple_gen_->generate(
+                party_, a.data() + done / 8, b.data() + done / 8,
+                c.data() + done / 8, n, method_, /*packed*/ true
+            );
+        }
+        // Nothing else sends on a dedicated channel after the last messages.
+        triple_gen_->io->flush();
+    }
+
+    // Caller must hold `mtx_`.
+    int64_t buffered() const { return 8 * (int64_t)(a_.size() - head_); }
+
+    // Caller must hold `mtx_`.
+    void append(
+        const std::vector<uint8_t> &a,
+        const std::vector<uint8_t> &b,
+        const std::vector<uint8_t> &c
+    ) {
+        if (head_ > 0) {
+            a_.erase(a_.begin(), a_.begin() + head_);
+            b_.erase(b_.begin(), b_.begin() + head_);
+            c_.erase(c_.begin(), c_.begin() + head_);
+            head_ = 0;
+        }
+        a_.insert(a_.end(), a.begin(), a.end());
+        b_.insert(b_.end(), b.begin(), b.end());
+        c_.insert(c_.end(), c.begin(), c.end());
+        total_generated_ += 8 * a.size();
+    }
+
+    void ensure(int64_t nbytes) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (8 * nbytes <= buffered()) return;
+        // The pool was too small for the model: fall back to an online refill.
+        if (!background_) {
+            const int64_t missing = 8 * nbytes - buffered();
+            ++online_refills_;
+            lock.unlock();
+            fill(std::max(missing, refill_size_));
+            return;
+        }
+        // Wait for the queued refills, and queue one more if they are short.
+        const int64_t missing =
+            8 * nbytes - (int64_t)(scheduled_ - total_consumed_);
+        if (missing > 0) {
+            ++online_refills_;
+            schedule(std::max(missing, refill_size_));
+        }
+        refilled_.wait(lock, [&] { return 8 * nbytes <= buffered(); });
+    }
+
+    // The decision is taken on the triples consumed and scheduled so far, not
+    // on the ones the refill thread has delivered yet, so that both parties
+    // queue the same refills. Never waits for the refill thread.
+    void maybe_refill() {
+        if (!background_ || refill_size_ <= 0) return;
+        std::lock_guard<std::mutex> lock(mtx_);
+        if ((int64_t)(scheduled_ - total_consumed_) < low_watermark_) {
+            schedule(refill_size_);
+        }
+    }
+
+    // Caller must hold `mtx_`.
+    void schedule(int64_t num_triples) {
+        num_triples = (num_triples + 7) / 8 * 8;
+        scheduled_ += num_triples;
+        requests_.push_back(num_triples);
+        refilled_.notify_all();
+    }
+
+    // Caller must hold `lock` on `mtx_`.
+    void wait_idle(std::unique_lock<std::mutex> &lock) {
+        refilled_.wait(lock, [&] { return requests_.empty() && !refilling_; });
+    }
+
+    // The refill thread: one refill at a time on the pool's channel, in the
+    // order they were queued, until stop().
+    void refill_loop() {
+        std::unique_lock<std::mutex> lock(mtx_);
+        while (true) {
+            refilled_.wait(lock, [&] {
+                return stopping_ || !requests_.empty();
+            });
+            if (requests_.empty()) return;
+            const int64_t num_triples = requests_.front();
+            requests_.pop_front();
+            refilling_ = true;
+            lock.unlock();
+            std::vector<uint8_t> a, b, c;
+            generate(num_triples, a, b, c);
+            lock.lock();
+            append(a, b, c);
+            refilling_ = false;
+            ++background_refills_;
+            refilled_.notify_all();
+        }
+    }
+
+    int party_;
+    TripleGenMethod method_;
+    bool background_;
+    TripleGenerator<IO> *triple_gen_ = nullptr;
+
+    std::mutex mtx_;
+    // Signals the queued refills to the refill thread, and their completion
+    // to the waiting consumers.
+    std::condition_variable refilled_;
+    std::thread refill_;
+    // The sizes of the refills not started yet.
+    std::deque<int64_t> requests_;
+    bool refilling_ = false;
+    bool stopping_ = false;
+    std::vector<uint8_t> a_, b_, c_;
+    size_t head_ = 0;
+    int64_t low_watermark_ = 0;
+    int64_t refill_size_ = 0;
+
+    std::string layer_ = "default";
+    std::map<std::string, uint64_t> consumed_;
+    uint64_t total_consumed_ = 0;
+    uint64_t total_generated_ = 0;
+    // Triples generated, or queued for the refill thread.
+    uint64_t scheduled_ = 0;
+    uint64_t online_refills_ = 0;
+    uint64_t background_refills_ = 0;
+};
+
+#endif  // TRIPLE_POOL_H__
@@ -22,6 +22,7 @@ SOFTWARE.
 #ifndef EQUALITY_H__
 #define EQUALITY_H__
 #include <cmath>
+#include <vector>
 
 #include "Millionaire/millionaire.h"
 #include "OT/emp-ot.h"
@@ -148,6 +149,11 @@ class Equality {
             return;
         }
 
+        if (mill->bit_sliced) {
+            check_equality_bit_sliced(res_eq, data, num_eqs);
+            return;
+        }
+
         int old_num_eqs = num_eqs;
         // num_eqs should be a multiple of 8
         num_eqs = ceil(num_eqs / 8.0) * 8;
@@ -289,6 +295,98 @@ class Equality {
         delete[] leaf_res_eq;
     }
 
+    // check_equality() with bit-vectors, see
+    // MillionaireProtocol::compare_bit_sliced. All the digits use the leaf
+    // OTs of beta bits.
+    void check_equality_bit_sliced(
+        uint8_t *res_eq, const uint64_t *data, int num_eqs
+    ) {
+        const int n = (num_eqs + 7) / 8 * 8;
+        const size_t nb = n / 8;
+        std::vector<uint8_t> digits(num_digits * n, 0);
+        for (int i = 0; i < num_digits; i++) {
+            const uint8_t mask =
+                (i == num_digits - 1 && r != 0) ? mask_r : mask_beta;
+            for (int j = 0; j < num_eqs; j++) {
+                digits[i * n + j] = (uint8_t)(data[j] >> i * beta) & mask;
+            }
+        }
+
+        std::vector<uint8_t> leaf_eq(num_digits * nb);
+        if (party == sci::ALICE) {
+            triple_gen->prg->random_data(leaf_eq.data(), leaf_eq.size());
+            std::vector<uint8_t> messages((size_t)num_digits * n * beta_pow);
+            std::vector<uint8_t *> leaf_ot_messages(num_digits * n);
+            for (int i = 0; i < num_digits * n; i++) {
+                leaf_ot_messages[i] = messages.data() + (size_t)i * beta_pow;
+            }
+            sci::set_leaf_messages(
+                messages.data(), digits.data(), num_digits * n, beta_pow,
+                nullptr, leaf_eq.data(), true
+            );
+            otpack->kkot[beta - 1]->send(
+                leaf_ot_messages.data(), num_digits * n, 1
+            );
+        } else {
+            std::vector<uint8_t> leaf_res(num_digits * n);
+            otpack->kkot[beta - 1]->recv(
+                leaf_res.data(), digits.data(), num_digits * n, 1
+            );
+            sci::pack_bit_plane(
+                leaf_res.data(), num_digits * n, 0, leaf_eq.data()
+            );
+        }
+
+        Triple triples(num_triples * n, true);
+        if (mill->triple_pool != nullptr) {
+            mill->triple_pool->fetch(&triples);
+        } else {
+            triple_gen->generate(party, &triples, _16KKOT_to_4OT);
+        }
+
+        std::vector<uint8_t> ef_mine(2 * num_triples * nb);
+        std::vector<uint8_t> ef_theirs(2 * num_triples * nb);
+        auto eq = [&](int j) { return leaf_eq.data() + j * nb; };
+        int used = 0;
+        for (int i = 1; i < num_digits; i *= 2) {
+            int num_ands = 0;
+            for (int j = 0; j + i < num_digits; j += 2 * i) num_ands++;
+            uint8_t *e = ef_mine.data();
+            uint8_t *f = ef_mine.data() + num_ands * nb;
+            for (int j = 0, k = 0; j + i < num_digits; j += 2 * i, k++) {
+                sci::and_open(
+                    e + k * nb, f + k * nb, eq(j), eq(j + i),
+                    triples.ai + (used + k) * nb, triples.bi + (used + k) * nb,
+                    nb
+                );
+            }
+
+            const size_t level_bytes = 2 * num_ands * nb;
+            if (party == sci::ALICE) {
+                io->send_data(ef_mine.data(), level_bytes);
+                io->recv_data(ef_theirs.data(), level_bytes);
+            } else {
+                io->recv_data(ef_theirs.data(), level_bytes);
+                io->send_data(ef_mine.data(), level_bytes);
+            }
+            sci::xor_bits(ef_theirs.data(), ef_mine.data(), level_bytes);
+            e = ef_theirs.data();
+            f = ef_theirs.data() + num_ands * nb;
+
+            for (int j = 0, k = 0; j + i < num_digits; j += 2 * i, k++) {
+                sci::and_close(
+                    eq(j), e + k * nb, f + k * nb,
+                    triples.ai + (used + k) * nb, triples.bi + (used + k) * nb,
+                    triples.ci + (used + k) * nb, nb, party == sci::ALICE
+                );
+            }
+            used += num_ands;
+        }
+        assert(used == num_triples);
+
+        sci::unpack_bits(leaf_eq.data(), num_eqs, res_eq);
+    }
+
     /**************************************************************************************************
      *                         AND computation related functions
      **************************************************************************************************/
@@ -297,7 +395,11 @@ class Equality {
         Triple triples_std((num_triples)*num_eqs, true);
 
         // Generate required Bit-Triples
-        triple_gen->generate(party, &triples_std, _16KKOT_to_4OT);
+        if (mill->triple_pool != nullptr) {
+            mill->triple_pool->fetch(&triples_std);
+        } else {
+            triple_gen->generate(party, &triples_std, _16KKOT_to_4OT);
+        }
 
         // Combine leaf OT results in a bottom-up fashion
         int counter_triples_used = 0, old_counter_triples_used = 0;
@@ -24,8 +24,11 @@ SOFTWARE.
 #ifndef MILLIONAIRE_H__
 #define MILLIONAIRE_H__
 #include <cmath>
+#include <vector>
 
+#include "Millionaire/bit-sliced.h"
 #include "Millionaire/bit-triple-generator.h"
+#include "Millionaire/bit-triple-pool.h"
 #include "OT/emp-ot.h"
 #include "utils/emp-tool.h"
 
@@ -37,6 +40,11 @@ class MillionaireProtocol {
     IO *io = nullptr;
     sci::OTPack<IO> *otpack;
     TripleGenerator<IO> *triple_gen;
+    // Optional store of pre-generated triples; not owned.
+    TriplePool<IO> *triple_pool = nullptr;
+    // Bit-sliced comparisons (see compare_bit_sliced), also for the
+    // Equality on top of this instance. Both parties must agree.
+    bool bit_sliced = false;
     int party;
     int l, r, log_alpha, beta, beta_pow;
     int num_digits, num_triples_corr, num_triples_std, log_num_digits;
@@ -137,6 +145,11 @@ class MillionaireProtocol {
             return;
         }
 
+        if (bit_sliced) {
+            compare_bit_sliced(res, data, num_cmps, greater_than);
+            return;
+        }
+
         int old_num_cmps = num_cmps;
         // num_cmps should be a multiple of 8
         num_cmps = ceil(num_cmps / 8.0) * 8;
@@ -364,6 +377,149 @@ class MillionaireProtocol {
         delete[] leaf_res_eq;
     }
 
+    // compare() with the leaves and the ANDs kept as bit-vectors: the leaf
+    // OT messages are set by SIMD (see set_leaf_messages), in one buffer,
+    // and the AND tree runs on 64 comparisons per word, without unpacking.
+    // All the digits use the 2-bit leaf OTs and independent triples, as with
+    // WAN_EXEC, which costs a few more OTs without USE_CHEETAH.
+    void compare_bit_sliced(
+        uint8_t *res, const uint64_t *data, int num_cmps, bool greater_than
+    ) {
+        const int n = (num_cmps + 7) / 8 * 8;
+        const int nb = n / 8;
+        std::vector<uint8_t> digits(num_digits * n, 0);
+        for (int i = 0; i < num_digits; i++) {
+            const uint8_t mask =
+                (i == num_digits - 1 && r != 0) ? mask_r : mask_beta;
+            for (int j = 0; j < num_cmps; j++) {
+                digits[i * n + j] = (uint8_t)(data[j] >> i * beta) & mask;
+            }
+        }
+
+        // The shares of the comparisons and the equalities of the digits.
+        std::vector<uint8_t> leaf_cmp(num_digits * nb);
+        std::vector<uint8_t> leaf_eq(num_digits * nb);
+        if (party == sci::ALICE) {
+            triple_gen->prg->random_data(leaf_cmp.data(), leaf_cmp.size());
+            triple_gen->prg->random_data(leaf_eq.data(), leaf_eq.size());
+            std::vector<uint8_t> messages((size_t)num_digits * n * beta_pow);
+            std::vector<uint8_t *> leaf_ot_messages(num_digits * n);
+            for (int i = 0; i < num_digits * n; i++) {
+                leaf_ot_messages[i] = messages.data() + (size_t)i * beta_pow;
+            }
+            // The least significant digit only needs the comparison.
+            sci::set_leaf_messages(
+                messages.data(), digits.data(), n, beta_pow, leaf_cmp.data(),
+                nullptr, greater_than
+            );
+            sci::set_leaf_messages(
+                messages.data() + (size_t)n * beta_pow, digits.data() + n,
+                (num_digits - 1) * n, beta_pow, leaf_cmp.data() + nb,
+                leaf_eq.data() + nb, greater_than
+            );
+            otpack->kkot[beta - 1]->send(
+                leaf_ot_messages.data(), num_digits * n, 2
+            );
+        } else {
+            std::vector<uint8_t> leaf_res(num_digits * n);
+            otpack->kkot[beta - 1]->recv(
+                leaf_res.data(), digits.data(), num_digits * n, 2
+            );
+            sci::pack_bit_plane(leaf_res.data(), n, 0, leaf_cmp.data());
+            sci::pack_bit_plane(
+                leaf_res.data() + n, (num_digits - 1) * n, 1,
+                leaf_cmp.data() + nb
+            );
+            sci::pack_bit_plane(
+                leaf_res.data() + n, (num_digits - 1) * n, 0,
+                leaf_eq.data() + nb
+            );
+        }
+
+        traverse_bit_sliced(n, leaf_cmp.data(), leaf_eq.data());
+        sci::unpack_bits(leaf_cmp.data(), num_cmps, res);
+    }
+
+    // The AND tree of compare_bit_sliced on n (multiple of 8) comparisons.
+    // Each level opens all its ANDs in one round.
+    void traverse_bit_sliced(int n, uint8_t *leaf_cmp, uint8_t *leaf_eq) {
+        const size_t nb = n / 8;
+        Triple triples(num_triples * n, true);
+        if (triple_pool != nullptr) {
+            triple_pool->fetch(&triples);
+        } else {
+#if USE_CHEETAH
+            triple_gen->generate(party, &triples, _2ROT);
+#else
+            triple_gen->generate(party, &triples, _16KKOT_to_4OT);
+#endif
+        }
+
+        // The shares of e of a level, then those of f.
+        std::vector<uint8_t> ef_mine(2 * num_triples * nb);
+        std::vector<uint8_t> ef_theirs(2 * num_triples * nb);
+        auto cmp = [&](int j) { return leaf_cmp + j * nb; };
+        auto eq = [&](int j) { return leaf_eq + j * nb; };
+        auto a = [&](int k) { return triples.ai + k * nb; };
+        auto b = [&](int k) { return triples.bi + k * nb; };
+        auto c = [&](int k) { return triples.ci + k * nb; };
+
+        int used = 0;
+        for (int i = 1; i < num_digits; i *= 2) {
+            int num_ands = 0;
+            for (int j = 0; j + i < num_digits; j += 2 * i) {
+                num_ands += (j == 0) ? 1 : 2;
+            }
+            uint8_t *e = ef_mine.data();
+            uint8_t *f = ef_mine.data() + num_ands * nb;
+            int k = 0;
+            for (int j = 0; j + i < num_digits; j += 2 * i) {
+                // cmp_j & eq_{j+i}, and eq_j & eq_{j+i} but for j = 0.
+                sci::and_open(
+                    e + k * nb, f + k * nb, cmp(j), eq(j + i), a(used + k),
+                    b(used + k), nb
+                );
+                k++;
+                if (j == 0) continue;
+                sci::and_open(
+                    e + k * nb, f + k * nb, eq(j), eq(j + i), a(used + k),
+                    b(used + k), nb
+                );
+                k++;
+            }
+
+            const size_t level_bytes = 2 * num_ands * nb;
+            if (party == sci::ALICE) {
+                io->send_data(ef_mine.data(), level_bytes);
+                io->recv_data(ef_theirs.data(), level_bytes);
+            } else {
+                io->recv_data(ef_theirs.data(), level_bytes);
+                io->send_data(ef_mine.data(), level_bytes);
+            }
+            sci::xor_bits(ef_theirs.data(), ef_mine.data(), level_bytes);
+            e = ef_theirs.data();
+            f = ef_theirs.data() + num_ands * nb;
+
+            k = 0;
+            for (int j = 0; j + i < num_digits; j += 2 * i) {
+                sci::and_close(
+                    cmp(j), e + k * nb, f + k * nb, a(used + k), b(used + k),
+                    c(used + k), nb, party == sci::ALICE
+                );
+                sci::xor_bits(cmp(j), cmp(j + i), nb);
+                k++;
+                if (j == 0) continue;
+                sci::and_close(
+                    eq(j), e + k * nb, f + k * nb, a(used + k), b(used + k),
+                    c(used + k), nb, party == sci::ALICE
+                );
+                k++;
+            }
+            used += num_ands;
+        }
+        assert(used == num_triples);
+    }
+
     void set_leaf_ot_messages(
         uint8_t *ot_messages,
         uint8_t digit,
@@ -400,16 +556,24 @@ class MillionaireProtocol {
         Triple triples_std(num_triples_std * num_cmps, true);
 #endif
         // Generate required Bit-Triples
+        if (triple_pool != nullptr) {
+            // Independent triples can replace the correlated ones.
+#if !defined(WAN_EXEC) && !USE_CHEETAH
+            triple_pool->fetch(&triples_corr);
+#endif
+            triple_pool->fetch(&triples_std);
+        } else {
 #if USE_CHEETAH
-        triple_gen->generate(party, &triples_std, _2ROT);
+            triple_gen->generate(party, &triples_std, _2ROT);
 #elif defined(WAN_EXEC)
-        // std::cout<<"Running on WAN_EXEC; Skipping correlated
-        // triples"<<std::endl;
-        triple_gen->generate(party, &triples_std, _16KKOT_to_4OT);
+            // std::cout<<"Running on WAN_EXEC; Skipping correlated
+            // triples"<<std::endl;
+            triple_gen->generate(party, &triples_std, _16KKOT_to_4OT);
 #else
-        triple_gen->generate(party, &triples_corr, _8KKOT);
-        triple_gen->generate(party, &triples_std, _16KKOT_to_4OT);
+            triple_gen->generate(party, &triples_corr, _8KKOT);
+            triple_gen->generate(party, &triples_std, _16KKOT_to_4OT);
 #endif
+        }
         // std::cout << "Bit Triples Generated" << std::endl;
 
         // Combine leaf OT results in a bottom-up fashion
@@ -695,11 +859,11 @@ class MillionaireProtocol {
         int num_ANDs
     ) {
         assert(num_ANDs % 8 == 0);
-        for (int i = 0; i < num_ANDs; i += 8) {
-            ei[i / 8] = ai[i / 8];
-            fi[i / 8] = bi[i / 8];
-            ei[i / 8] ^= sci::bool_to_uint8(xi + i, 8);
-            fi[i / 8] ^= sci::bool_to_uint8(yi + i, 8);
+        sci::pack_bits(xi, num_ANDs, ei);
+        sci::pack_bits(yi, num_ANDs, fi);
+        for (int i = 0; i < num_ANDs / 8; i++) {
+            ei[i] ^= ai[i];
+            fi[i] ^= bi[i];
         }
     }
     void AND_step_2(
@@ -714,16 +878,16 @@ class MillionaireProtocol {
         int num_ANDs
     ) {
         assert(num_ANDs % 8 == 0);
-        for (int i = 0; i < num_ANDs; i += 8) {
+        for (int i = 0; i < num_ANDs / 8; i++) {
             uint8_t temp_z;
             if (party == sci::ALICE)
-                temp_z = e[i / 8] & f[i / 8];
+                temp_z = e[i] & f[i];
             else
                 temp_z = 0;
-            temp_z ^= f[i / 8] & ai[i / 8];
-            temp_z ^= e[i / 8] & bi[i / 8];
-            temp_z ^= ci[i / 8];
-            sci::uint8_to_bool(zi + i, temp_z, 8);
+            temp_z ^= f[i] & ai[i];
+            temp_z ^= e[i] & bi[i];
+            temp_z ^= ci[i];
+            sci::unpack_bits(&temp_z, 8, zi + 8 * i);
         }
     }
 };
@@ -320,7 +320,11 @@ class MillionaireWithEquality {
         Triple triples_corr((num_triples)*num_cmps, true, num_cmps);
 
         // Generate required Bit-Triples
-        triple_gen->generate(party, &triples_corr, _8KKOT);
+        if (mill->triple_pool != nullptr) {
+            mill->triple_pool->fetch(&triples_corr);
+        } else {
+            triple_gen->generate(party, &triples_corr, _8KKOT);
+        }
 
         // Combine leaf OT results in a bottom-up fashion
         int counter_triples_used = 0, old_counter_triples_used = 0;
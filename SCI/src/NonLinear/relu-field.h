@@ -164,7 +164,9 @@ class ReLUFieldProtocol : public ReLUProtocol<IO, type> {
         uint8_t *drelu_res = nullptr,
         bool skip_ot = false,
         bool do_trunc = false,
-        bool approximated = false
+        bool approximated = false,
+        int drop_lo = -1,
+        int drop_hi = 0
     ) {
         uint8_t *drelu_ans = new uint8_t[num_relu];
         drelu(drelu_ans, (uint64_t *)share, num_relu);
@@ -32,7 +32,11 @@ class ReLUProtocol {
         uint8_t *drelu_res = nullptr,
         bool skip_ot = false,
         bool do_trunc = false,
-        bool approximated = false
+        bool approximated = false,
+        // Low/high bits dropped by the approximated ReLU (see LayerBitwidth).
+        // A negative `drop_lo` takes the built-in default.
+        int drop_lo = -1,
+        int drop_hi = 0
     ) = 0;
 };
 
@@ -152,7 +152,9 @@ class ReLURingProtocol : public ReLUProtocol<IO, type> {
         uint8_t *drelu_res = nullptr,
         bool skip_ot = false,
         bool do_trunc = false,
-        bool approx = false
+        bool approx = false,
+        int drop_lo = -1,
+        int drop_hi = 0
     ) {
         uint8_t *msb_local_share = new uint8_t[num_relu];
         uint64_t *array64;
@@ -174,11 +176,21 @@ class ReLURingProtocol : public ReLUProtocol<IO, type> {
             // NOTE(lwj): we don't drop too much for double width fixed-point.
             int lo = do_trunc ? kScale * 3 / 2 : kScale;
             int this_l = bitlength - lo;
-            // NOTE(lwj): we can also drop some high-order bits
-            this_l -= ((this_l - 1) % this->b);
+            if (drop_lo >= 0) {
+                // Calibrated per layer: round up to the radix, which only
+                // keeps more of the high-order bits.
+                lo = drop_lo;
+                this_l = bitlength - lo - drop_hi;
+                this_l += (this->b - (this_l - 1) % this->b) % this->b;
+                this_l = std::min(this_l, bitlength - lo);
+                assert(this_l >= 2);
+            } else {
+                // NOTE(lwj): we can also drop some high-order bits
+                this_l -= ((this_l - 1) % this->b);
+            }
 
-            type _mask = (1 << this_l) - 1;
-            type _upper = 1 << (this_l - 1);
+            type _mask = ((type)1 << this_l) - 1;
+            type _upper = (type)1 << (this_l - 1);
             // x0, x1 \in [0, 2^l)
             // x'0, x'1 \in [0, 2^k)
             for (int i = 0; i < num_relu; i++) {
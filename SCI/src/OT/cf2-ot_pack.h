@@ -44,25 +44,50 @@ namespace sci {
             delete iknp_reversed;
         }
 
+        // Only the IKNPs run public-key base OTs. The 256 base OTs of each
+        // KKOT are extended from iknp_reversed, two 128-bit OTs of the same
+        // choice bit per 256-bit key.
         void SetupBaseOTs() {
+            const int lambda = kkot[0]->lambda;
+            const int n = KKOT_TYPES * lambda;
+            block256 *k0 = new (std::align_val_t(32)) block256[n];
             switch (party) {
-                case 1:
-                    kkot[0]->setup_send();
+                case 1: {
                     iknp_straight->setup_send();
                     iknp_reversed->setup_recv();
-                    for (int i = 1; i < KKOT_TYPES; i++) {
-                        kkot[i]->setup_send();
+                    bool *s = new bool[n];
+                    bool *s2 = new bool[2 * n];
+                    PRG128 prg;
+                    prg.random_bool(s, n);
+                    for (int j = 0; j < n; j++) {
+                        s2[2 * j] = s2[2 * j + 1] = s[j];
+                    }
+                    iknp_reversed->recv((block128 *)k0, s2, 2 * n);
+                    for (int i = 0; i < KKOT_TYPES; i++) {
+                        kkot[i]->setup_send(k0 + i * lambda, s + i * lambda);
                     }
+                    delete[] s;
+                    delete[] s2;
                     break;
-                case 2:
-                    kkot[0]->setup_recv();
+                }
+                case 2: {
                     iknp_straight->setup_recv();
                     iknp_reversed->setup_send();
-                    for (int i = 1; i < KKOT_TYPES; i++) {
-                        kkot[i]->setup_recv();
+                    block256 *k1 = new (std::align_val_t(32)) block256[n];
+                    PRG128 prg;
+                    prg.random_block(k0, n);
+                    prg.random_block(k1, n);
+                    iknp_reversed->send(
+                        (const block128 *)k0, (const block128 *)k1, 2 * n
+                    );
+                    for (int i = 0; i < KKOT_TYPES; i++) {
+                        kkot[i]->setup_recv(k0 + i * lambda, k1 + i * lambda);
                     }
+                    delete[] k1;
                     break;
+                }
             }
+            delete[] k0;
             io->flush();
         }
 
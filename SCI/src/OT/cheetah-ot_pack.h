@@ -4,6 +4,7 @@
 
 #include "OT/emp-ot.h"
 #include "OT/ferret/silent_ot.h"
+#include "OT/ot-state-store.h"
 #include "OT/split-kkot.h"
 #include "utils/emp-tool.h"
 #define KKOT_TYPES 8
@@ -34,23 +35,44 @@ namespace sci {
 
         T *ios[1];
 
-        OTPack(T *io, int party, bool do_setup = true) {
+        // With a `store`, the Ferret states are kept per thread and session
+        // in the store, see OTStateStore. Otherwise, they are kept in the
+        // fixed PRE_OT_DATA_* files, which all the OTPacks of the directory
+        // share.
+        OTPack(
+            T *io,
+            int party,
+            bool do_setup = true,
+            OTStateStore *store = nullptr,
+            int thread = 0
+        ) {
             std::cout << "using silent ot pack" << std::endl;
 
             this->party = party;
             // this->do_setup = do_setup;
             this->io = io;
+            this->store = store;
+            this->thread = thread;
 
             ios[0] = io;
+            std::string send_file = party == sci::ALICE
+                                        ? PRE_OT_DATA_REG_SEND_FILE_ALICE
+                                        : PRE_OT_DATA_REG_RECV_FILE_BOB;
+            std::string recv_file = party == sci::ALICE
+                                        ? PRE_OT_DATA_REG_RECV_FILE_ALICE
+                                        : PRE_OT_DATA_REG_SEND_FILE_BOB;
+            bool warm_up = true;
+            if (store) {
+                claim_states();
+                send_file = slots[0].work;
+                recv_file = slots[1].work;
+                warm_up = store->warm_up();
+            }
             silent_ot = new cheetah::SilentOT<T>(
-                party, 1, ios, false, true,
-                party == sci::ALICE ? PRE_OT_DATA_REG_SEND_FILE_ALICE
-                                    : PRE_OT_DATA_REG_RECV_FILE_BOB
+                party, 1, ios, false, true, send_file, warm_up
             );
             silent_ot_reversed = new cheetah::SilentOT<T>(
-                3 - party, 1, ios, false, true,
-                party == sci::ALICE ? PRE_OT_DATA_REG_RECV_FILE_ALICE
-                                    : PRE_OT_DATA_REG_SEND_FILE_BOB
+                3 - party, 1, ios, false, true, recv_file, warm_up
             );
 
             for (int i = 0; i < KKOT_TYPES; i++) {
@@ -65,6 +87,12 @@ namespace sci {
             delete silent_ot;
             for (int i = 0; i < KKOT_TYPES; i++) delete kkot[i];
             delete iknp_reversed;
+            // The Ferret instances have written their states.
+            if (store) {
+                store->release(slots[0]);
+                store->release(slots[1]);
+                store->save_tag(thread, tag);
+            }
         }
 
         void SetupBaseOTs() {}
@@ -78,6 +106,48 @@ namespace sci {
          * current implementation does not support this.
          */
 
+       private:
+        OTStateStore *store = nullptr;
+        int thread = 0;
+        OTStateSlot slots[2];
+        block128 tag;
+
+        // Both sides start warm iff they both hold the states saved by the
+        // same run, and agree on the tag of this run.
+        void claim_states() {
+            slots[0] = store->claim(thread, "silent_ot");
+            slots[1] = store->claim(thread, "silent_ot_reversed");
+            const block128 zero = zero_block();
+            block128 mine = zero, theirs;
+            if (slots[0].warm && slots[1].warm) {
+                mine = store->load_tag(thread);
+            }
+            store->clear_tag(thread);
+            if (party == sci::ALICE) {
+                io->send_block(&mine, 1);
+                io->flush();
+                io->recv_block(&theirs, 1);
+            } else {
+                io->recv_block(&theirs, 1);
+                io->send_block(&mine, 1);
+                io->flush();
+            }
+            const bool warm =
+                cmpBlock(&mine, &theirs, 1) && !cmpBlock(&mine, &zero, 1);
+            if (!warm) {
+                store->discard(slots[0]);
+                store->discard(slots[1]);
+            }
+            if (party == sci::ALICE) {
+                PRG128 prg;
+                prg.random_block(&tag, 1);
+                io->send_block(&tag, 1);
+                io->flush();
+            } else {
+                io->recv_block(&tag, 1);
+            }
+        }
+
         // void copy(OTPack<T> *copy_from) {
         // assert(this->do_setup == false && copy_from->do_setup == true);
         // SplitKKOT<T> *kkot_base = copy_from->kkot[0];
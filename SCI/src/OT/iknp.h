@@ -29,13 +29,13 @@ Modified by Nishant Kumar
 #define OT_IKNP_H__
 #include <algorithm>
 
-#include "OT/np.h"
 #include "OT/ot.h"
+#include "OT/simplest-ot.h"
 namespace sci {
     template <typename IO>
     class IKNP : public OT<IKNP<IO>> {
        public:
-        OTNP<IO> *base_ot;
+        SimplestOT<IO> *base_ot;
         PRG128 prg;
         const int lambda = 128;
         const int block_size = 1024 * 16;
@@ -50,7 +50,7 @@ namespace sci {
 
         IKNP(IO *io) {
             this->io = io;
-            base_ot = new OTNP<IO>(io);
+            base_ot = new SimplestOT<IO>(io);
             s = new bool[lambda];
             k0 = new block128[lambda];
             k1 = new block128[lambda];
@@ -21,14 +21,14 @@ SOFTWARE.
 
 #ifndef OT_KKOT_H__
 #define OT_KKOT_H__
-#include "OT/np.h"
 #include "OT/ot.h"
+#include "OT/simplest-ot.h"
 
 namespace sci {
     template <typename IO>
     class KKOT : public OT<KKOT<IO>> {
        public:
-        OTNP<IO> *base_ot;
+        SimplestOT<IO> *base_ot;
         PRG128 prg;
         const int lambda = 256;
         int block_size = 1024 * 16;
@@ -44,7 +44,7 @@ namespace sci {
 
         KKOT(IO *io) {
             this->io = io;
-            base_ot = new OTNP<IO>(io);
+            base_ot = new SimplestOT<IO>(io);
             s = new bool[lambda];
             k0 = new (std::align_val_t(32)) block256[lambda];
             k1 = new (std::align_val_t(32)) block256[lambda];
@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef CHEETAH_OT_STATE_STORE_H__
+#define CHEETAH_OT_STATE_STORE_H__
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "utils/emp-tool.h"
+
+namespace sci {
+
+    // The claim on one saved Ferret pre-OT state, see OTStateStore.
+    struct OTStateSlot {
+        std::string path;  // the saved state
+        std::string work;  // the file the Ferret instance reads and writes
+        bool warm = false; // a saved state was claimed
+    };
+
+    // Keeps the pre-OT states of the Ferret instances of the OTPacks
+    // between runs, under <dir>/<session>/, one file per (party, thread,
+    // instance). Without a saved state, Ferret runs its base OTs, which is
+    // the bulk of the OTPack setup.
+    //
+    // A state is claimed by renaming it to a file private to the process,
+    // which Ferret then reads at setup and overwrites when destroyed, and
+    // is published back by renaming it. Thus two processes never share a
+    // state, and a crash leaves either the old state or nothing.
+    //
+    // The two parties' states of an OTPack are only usable together. Each
+    // side keeps the tag of the run that last saved them: the tags are
+    // compared at setup, and both sides start cold unless they match.
+    class OTStateStore {
+       public:
+        // `session` tells the peers apart, e.g., the port of a server, or
+        // the address:port of its client. When `warm_up` is set, the
+        // OTPacks extend their first batch of COTs at construction.
+        OTStateStore(
+            const std::string &dir,
+            const std::string &session,
+            int party,
+            bool warm_up = true
+        )
+            : warm_up_(warm_up) {
+            root_ = dir + "/" + sanitize(session);
+            prefix_ = root_ + "/" + (party == ALICE ? "alice" : "bob");
+            suffix_ = "." + std::to_string(getpid());
+            make_dirs(root_);
+        }
+
+        bool warm_up() const { return warm_up_; }
+
+        OTStateSlot claim(int thread, const std::string &name) {
+            OTStateSlot slot;
+            slot.path = prefix_ + "-t" + std::to_string(thread) + "-" + name;
+            slot.work = slot.path + suffix_ + ".work";
+            std::remove(slot.work.c_str());
+            slot.warm = std::rename(slot.path.c_str(), slot.work.c_str()) == 0;
+            return slot;
+        }
+
+        // Ferret starts cold on this slot.
+        void discard(OTStateSlot &slot) {
+            std::remove(slot.work.c_str());
+            slot.warm = false;
+        }
+
+        // Publishes the state written by the (destroyed) Ferret instance.
+        void release(const OTStateSlot &slot) {
+            std::rename(slot.work.c_str(), slot.path.c_str());
+        }
+
+        // The tag of the states of the thread, 0 if none.
+        block128 load_tag(int thread) {
+            block128 tag = zero_block();
+            std::ifstream in(tag_path(thread), std::ios::binary);
+            if (!in.read((char *)&tag, sizeof(tag))) {
+                tag = zero_block();
+            }
+            return tag;
+        }
+
+        void save_tag(int thread, const block128 &tag) {
+            const std::string path = tag_path(thread);
+            const std::string tmp = path + suffix_ + ".tmp";
+            {
+                std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+                out.write((const char *)&tag, sizeof(tag));
+                if (!out) {
+                    std::remove(tmp.c_str());
+                    return;
+                }
+            }
+            std::rename(tmp.c_str(), path.c_str());
+        }
+
+        // Drops the tag before the states are overwritten, so that an
+        // interrupted run is never mistaken for a consistent one.
+        void clear_tag(int thread) { std::remove(tag_path(thread).c_str()); }
+
+       private:
+        std::string tag_path(int thread) const {
+            return prefix_ + "-t" + std::to_string(thread) + ".tag";
+        }
+
+        static std::string sanitize(std::string s) {
+            for (char &c : s) {
+                if (c == '/' || c == ':') c = '_';
+            }
+            return s.empty() ? "default" : s;
+        }
+
+        static void make_dirs(const std::string &dir) {
+            for (size_t pos = dir.find('/', 1); pos != std::string::npos;
+                 pos = dir.find('/', pos + 1)) {
+                mkdir(dir.substr(0, pos).c_str(), 0700);
+            }
+            mkdir(dir.c_str(), 0700);
+        }
+
+        bool warm_up_;
+        std::string root_;
+        std::string prefix_;
+        std::string suffix_;
+    };
+
+}  // namespace sci
+#endif  // CHEETAH_OT_STATE_STORE_H__
@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef OT_SIMPLEST_OT_H__
+#define OT_SIMPLEST_OT_H__
+#include <vector>
+
+#include "OT/ot.h"
+/** @addtogroup OT
+        @{
+*/
+namespace sci {
+    /*
+     * The base OTs of the OT extensions: Chou-Orlandi OT as in emp::OTCO,
+     * for the block128 and block256 messages, in one batch.
+     * [REF] "The Simplest Protocol for Oblivious Transfer"
+     * https://eprint.iacr.org/2015/267.pdf
+     *
+     * Compared to OTNP, the sender does one variable-base multiplication
+     * per OT instead of three, and the receiver's multiplications are all
+     * by a fixed base: the generator, and the sender's point A, for which a
+     * table is precomputed in the large batches. The points go in one
+     * buffer per flight (IOChannel::send_pts), and the instances share the
+     * group of the thread that runs the OTs instead of precomputing the
+     * generator table each. The group is looked up per batch: IKNP and KKOT
+     * run their base OTs lazily, e.g., in the worker threads of a layer,
+     * and the group (and its BN_CTX) must not be shared across threads.
+     */
+    template <typename IO>
+    class SimplestOT : public OT<SimplestOT<IO>> {
+       public:
+        IO *io;
+
+        // Below this many OTs, the table of A costs more than it saves.
+        static constexpr int kFixedBaseMin = 512;
+
+        SimplestOT(IO *io) { this->io = io; }
+
+        void send_impl(
+            const block128 *data0, const block128 *data1, int length
+        ) {
+            send_batch(data0, data1, length);
+        }
+
+        void send_impl(
+            const block256 *data0, const block256 *data1, int length
+        ) {
+            send_batch(data0, data1, length);
+        }
+
+        void recv_impl(block128 *data, const bool *b, int length) {
+            recv_batch(data, b, length);
+        }
+
+        void recv_impl(block256 *data, const bool *b, int length) {
+            recv_batch(data, b, length);
+        }
+
+       private:
+        static emp::Group *thread_group() {
+            static thread_local emp::Group group;
+            return &group;
+        }
+
+        static block128 kdf(emp::Point &p, uint64_t id, const block128 *) {
+            return Hash::KDF128(p, id);
+        }
+
+        static block256 kdf(emp::Point &p, uint64_t id, const block256 *) {
+            return Hash::KDF256(p, id);
+        }
+
+        // One field inversion for all the points, instead of one per point
+        // when they are serialized.
+        static void make_affine(emp::Group *G, std::vector<emp::Point> &pts) {
+            std::vector<EC_POINT *> raw(pts.size());
+            for (size_t i = 0; i < pts.size(); ++i) raw[i] = pts[i].point;
+            if (!EC_POINTs_make_affine(
+                    G->ec_group, raw.size(), raw.data(), G->bn_ctx
+                )) {
+                error("ECC MAKE_AFFINE");
+            }
+        }
+
+        template <typename T>
+        void send_batch(const T *data0, const T *data1, int length) {
+            emp::Group *G = thread_group();
+            emp::BigInt a;
+            G->get_rand_bn(a);
+            emp::Point A = G->mul_gen(a);
+            io->send_pts(G, &A, 1);
+            io->flush();
+
+            std::vector<emp::Point> B(length), BA(length);
+            io->recv_pts(G, B.data(), length);
+            emp::Point AaInv = A.mul(a).inv();
+            for (int i = 0; i < length; ++i) {
+                B[i] = B[i].mul(a);
+                BA[i] = B[i].add(AaInv);
+            }
+            make_affine(G, B);
+            make_affine(G, BA);
+
+            std::vector<T> m(2 * length);
+            for (int i = 0; i < length; ++i) {
+                m[2 * i] = xorBlocks(data0[i], kdf(B[i], i, data0));
+                m[2 * i + 1] = xorBlocks(data1[i], kdf(BA[i], i, data0));
+            }
+            io->send_data(m.data(), 2 * length * sizeof(T));
+        }
+
+        template <typename T>
+        void recv_batch(T *data, const bool *b, int length) {
+            emp::Group *G = thread_group();
+            std::vector<emp::BigInt> x(length);
+            for (int i = 0; i < length; ++i) G->get_rand_bn(x[i]);
+            emp::Point A;
+            io->recv_pts(G, &A, 1);
+
+            std::vector<emp::Point> B(length);
+            for (int i = 0; i < length; ++i) {
+                B[i] = G->mul_gen(x[i]);
+                if (b[i]) B[i] = B[i].add(A);
+            }
+            make_affine(G, B);
+            io->send_pts(G, B.data(), length);
+            io->flush();
+
+            // x_i * A, with A as the generator of a copy of the group.
+            EC_GROUP *GA = nullptr;
+            if (length >= kFixedBaseMin) {
+                GA = EC_GROUP_dup(G->ec_group);
+                if (!EC_GROUP_set_generator(
+                        GA, A.point, G->order.n, BN_value_one()
+                    ) ||
+                    !EC_GROUP_precompute_mult(GA, G->bn_ctx)) {
+                    error("ECC PRECOMPUTE");
+                }
+            }
+            std::vector<emp::Point> K(length);
+            for (int i = 0; i < length; ++i) {
+                if (GA) {
+                    K[i] = emp::Point(G);
+                    if (!EC_POINT_mul(
+                            GA, K[i].point, x[i].n, nullptr, nullptr,
+                            G->bn_ctx
+                        )) {
+                        error("ECC GEN MUL");
+                    }
+                } else {
+                    K[i] = A.mul(x[i]);
+                }
+            }
+            if (GA) EC_GROUP_free(GA);
+            make_affine(G, K);
+
+            std::vector<T> m(2 * length);
+            io->recv_data(m.data(), 2 * length * sizeof(T));
+            for (int i = 0; i < length; ++i) {
+                data[i] = xorBlocks(m[2 * i + b[i]], kdf(K[i], i, data));
+            }
+        }
+    };
+    /**@}*/
+}  // namespace sci
+#endif  // OT_SIMPLEST_OT_H__
@@ -25,16 +25,16 @@ SOFTWARE.
 // In split functions, OT is split
 // into offline and online phase.
 
-#include "OT/np.h"
 #include "OT/ot-utils.h"
 #include "OT/ot.h"
+#include "OT/simplest-ot.h"
 #include "split-utils.h"
 
 namespace sci {
     template <typename IO>
     class SplitIKNP : public OT<SplitIKNP<IO>> {
        public:
-        OTNP<IO> *base_ot;
+        SimplestOT<IO> *base_ot;
         PRG128 prg;
         int party;
         const int lambda = 128;
@@ -68,7 +68,7 @@ namespace sci {
             assert(party == ALICE || party == BOB);
             this->party = party;
             this->io = io;
-            base_ot = new OTNP<IO>(io);
+            base_ot = new SimplestOT<IO>(io);
             s = new bool[lambda];
             k0 = new block128[lambda];
             k1 = new block128[lambda];
@@ -28,16 +28,16 @@ SOFTWARE.
 // online offline split can
 // be found in OT/kkot.h
 
-#include "OT/np.h"
 #include "OT/ot-utils.h"
 #include "OT/ot.h"
+#include "OT/simplest-ot.h"
 #include "OT/split-utils.h"
 
 namespace sci {
     template <typename IO>
     class SplitKKOT : public OT<SplitKKOT<IO>> {
        public:
-        OTNP<IO> *base_ot;
+        SimplestOT<IO> *base_ot;
         PRG128 prg;
         int party;
         const int lambda = 256;
@@ -80,7 +80,7 @@ namespace sci {
             this->io = io;
             assert(N > 0);
             this->N = N;
-            base_ot = new OTNP<IO>(io);
+            base_ot = new SimplestOT<IO>(io);
             s = new bool[lambda];
             k0 = new (std::align_val_t(32)) block256[lambda];
             k1 = new (std::align_val_t(32)) block256[lambda];
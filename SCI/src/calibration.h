@@ -0,0 +1,278 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef CALIBRATION_H__
+#define CALIBRATION_H__
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+// The version of the bitwidth configs and of the calibration stats. Files of
+// another version name the layers differently and are rejected.
+// 1 (no version line): the call order, with two numbers per ReLU call.
+// 2: layerNumber(), i.e., the graph node in the graph runtime.
+constexpr int kCalibrationVersion = 2;
+
+// Per-layer bitwidths of the reduced-ring ReLU and of the truncation.
+//
+// The layers are named "relu.<k>" and "trunc.<k>" after their layerNumber(),
+// which is identical for the calibration run and for the secure inference of
+// the same network.
+struct LayerBitwidth {
+    // Low-order bits dropped before the ReLU comparison. Negative: the
+    // kScale based default of ReLURingProtocol.
+    int drop_lo = -1;
+    // High-order bits that only hold the sign extension. For a truncation,
+    // the layer input x satisfies |x| < 2^(bitlength - drop_hi - 1).
+    int drop_hi = 0;
+    // Mixed bitwidths: the layer runs over Z_{2^ring} instead of the global
+    // ring (0: the global ring). Its input is reduced to 2^ring locally, and
+    // its output is extended back to the global ring. drop_lo/drop_hi still
+    // refer to the global bitlength.
+    int ring = 0;
+};
+
+class BitwidthConfig {
+   public:
+    // Format: "version <v>", then one "<layer> <drop_lo> <drop_hi> [<ring>]"
+    // per line, '#' starts a comment. The caller checks version().
+    bool load(const std::string &path) {
+        std::ifstream in(path);
+        if (!in) return false;
+        layers_.clear();
+        version_ = 1;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream ss(line);
+            std::string name;
+            LayerBitwidth bw;
+            if (!(ss >> name)) continue;
+            if (name == "version") {
+                ss >> version_;
+                continue;
+            }
+            if (!(ss >> bw.drop_lo >> bw.drop_hi)) continue;
+            if (!(ss >> bw.ring)) bw.ring = 0;
+            layers_[name] = bw;
+        }
+        return true;
+    }
+
+    bool save(const std::string &path) const {
+        std::ofstream out(path);
+        if (!out) return false;
+        out << "version " << kCalibrationVersion << "\n";
+        out << "# layer drop_lo drop_hi ring\n";
+        for (const auto &kv : layers_) {
+            out << kv.first << " " << kv.second.drop_lo << " "
+                << kv.second.drop_hi << " " << kv.second.ring << "\n";
+        }
+        return true;
+    }
+
+    const LayerBitwidth *find(const std::string &layer) const {
+        auto kv = layers_.find(layer);
+        return kv == layers_.end() ? nullptr : &kv->second;
+    }
+
+    void set(const std::string &layer, const LayerBitwidth &bw) {
+        layers_[layer] = bw;
+    }
+
+    size_t size() const { return layers_.size(); }
+
+    int version() const { return version_; }
+
+    // Both parties MUST run with the same config.
+    uint64_t digest() const {
+        std::ostringstream ss;
+        for (const auto &kv : layers_) {
+            ss << kv.first << " " << kv.second.drop_lo << " "
+               << kv.second.drop_hi << " " << kv.second.ring << "\n";
+        }
+        return std::hash<std::string>()(ss.str());
+    }
+
+   private:
+    std::map<std::string, LayerBitwidth> layers_;
+    int version_ = kCalibrationVersion;
+};
+
+// Collects the activation ranges of the ReLU and truncation layers in the
+// clear, and turns them into a BitwidthConfig.
+class BitwidthCalibrator {
+   public:
+    struct Stats {
+        bool is_relu = false;
+        bool do_trunc = false;  // ReLU followed by a truncation
+        int scale = 0;          // fixed-point scale of the layer
+        uint64_t count = 0;
+        int max_bits = 0;  // max. bit length of |x|
+        // pos_hist[k]: number of 0 < x < 2^k with bit length k.
+        uint64_t pos_hist[65] = {0};
+    };
+
+    // The following record() calls are accounted to `layer`.
+    void set_layer(const std::string &layer) { layer_ = layer; }
+
+    void record(
+        const int64_t *x, int64_t n, bool is_relu, bool do_trunc, int scale
+    ) {
+        Stats &st = stats_[layer_];
+        st.is_relu = is_relu;
+        st.do_trunc = do_trunc;
+        st.scale = scale;
+        st.count += n;
+        for (int64_t i = 0; i < n; ++i) {
+            uint64_t a = x[i] < 0 ? -(uint64_t)x[i] : (uint64_t)x[i];
+            int bits = bit_length(a);
+            st.max_bits = std::max(st.max_bits, bits);
+            if (x[i] > 0) st.pos_hist[bits] += 1;
+        }
+    }
+
+    // The statistics are accumulated over runs, so the sample set can be
+    // evaluated one input at a time. The caller checks stats_version().
+    bool load_stats(const std::string &path) {
+        std::ifstream in(path);
+        if (!in) return false;
+        stats_version_ = 1;
+        std::string name;
+        Stats st;
+        while (in >> name) {
+            if (name == "version") {
+                in >> stats_version_;
+                continue;
+            }
+            if (!(in >> st.is_relu >> st.do_trunc >> st.scale >> st.count >>
+                  st.max_bits)) {
+                break;
+            }
+            for (int k = 0; k <= 64; ++k) in >> st.pos_hist[k];
+            Stats &dst = stats_[name];
+            dst.is_relu = st.is_relu;
+            dst.do_trunc = st.do_trunc;
+            dst.scale = st.scale;
+            dst.count += st.count;
+            dst.max_bits = std::max(dst.max_bits, st.max_bits);
+            for (int k = 0; k <= 64; ++k) dst.pos_hist[k] += st.pos_hist[k];
+        }
+        return true;
+    }
+
+    bool save_stats(const std::string &path) const {
+        std::ofstream out(path);
+        if (!out) return false;
+        out << "version " << kCalibrationVersion << "\n";
+        for (const auto &kv : stats_) {
+            const Stats &st = kv.second;
+            out << kv.first << " " << st.is_relu << " " << st.do_trunc << " "
+                << st.scale << " " << st.count << " " << st.max_bits;
+            for (int k = 0; k <= 64; ++k) out << " " << st.pos_hist[k];
+            out << "\n";
+        }
+        return true;
+    }
+
+    // Pick the bitwidths of each layer.
+    // ReLU: drop the most low-order bits such that at most a `budget`
+    // fraction of the inputs (those in (0, 2^drop_lo)) may be zeroed, and
+    // without dropping any integer bit. Keep `guard_bits` on top of the
+    // largest observed magnitude.
+    // Truncation: only the high-order headroom is recorded.
+    // With `mixed_rings`, a ReLU layer also runs over the smallest ring that
+    // holds its inputs, see LayerBitwidth::ring.
+    BitwidthConfig derive(
+        int bitlength, double budget, int guard_bits = 1,
+        bool mixed_rings = false
+    ) const {
+        BitwidthConfig config;
+        for (const auto &kv : stats_) {
+            const Stats &st = kv.second;
+            // Bits to hold the sign and the magnitude of the inputs.
+            const int need_bits =
+                std::min(bitlength, st.max_bits + 1 + guard_bits);
+            LayerBitwidth bw;
+            bw.drop_hi = bitlength - need_bits;
+            if (st.is_relu) {
+                const int frac_bits = st.do_trunc ? 2 * st.scale : st.scale;
+                const int max_lo = std::min(frac_bits, bitlength - 2);
+                uint64_t zeroed = 0;
+                bw.drop_lo = 0;
+                for (int lo = 1; lo <= max_lo; ++lo) {
+                    zeroed += st.pos_hist[lo];
+                    if (zeroed > budget * st.count) break;
+                    bw.drop_lo = lo;
+                }
+                // x / 2^drop_lo is compared on this_l bits.
+                const int this_l = std::max(2, need_bits - bw.drop_lo);
+                bw.drop_hi = std::max(0, bitlength - bw.drop_lo - this_l);
+                // The truncation needs more than the shifted bits.
+                const int ring = std::max(need_bits, frac_bits + 2);
+                if (mixed_rings && ring < bitlength) bw.ring = ring;
+            }
+            config.set(kv.first, bw);
+        }
+        return config;
+    }
+
+    // Compared bits per ReLU with the default and with the calibrated
+    // bitwidths.
+    void print_report(
+        const BitwidthConfig &config,
+        int bitlength,
+        std::ostream &os = std::cout
+    ) const {
+        uint64_t default_bits = 0, calib_bits = 0;
+        for (const auto &kv : stats_) {
+            const Stats &st = kv.second;
+            const LayerBitwidth *bw = config.find(kv.first);
+            if (bw == nullptr) continue;
+            if (!st.is_relu) {
+                os << kv.first << ": |x| < 2^"
+                   << (bitlength - bw->drop_hi - 1) << "\n";
+                continue;
+            }
+            const int lo = st.do_trunc ? st.scale * 3 / 2 : st.scale;
+            const int def_l = bitlength - lo;
+            const int new_l = bitlength - bw->drop_lo - bw->drop_hi;
+            default_bits += st.count * def_l;
+            calib_bits += st.count * new_l;
+            os << kv.first << ": drop " << bw->drop_lo << " low, "
+               << bw->drop_hi << " high bits, compare " << new_l
+               << " bits (default " << def_l << ")";
+            if (bw->ring > 0) os << ", ring 2^" << bw->ring;
+            os << "\n";
+        }
+        if (default_bits > 0) {
+            os << "ReLU compared bits: " << calib_bits << " vs. "
+               << default_bits << " by default ("
+               << (100. * calib_bits / default_bits) << "%)\n";
+        }
+    }
+
+    const std::map<std::string, Stats> &stats() const { return stats_; }
+
+    int stats_version() const { return stats_version_; }
+
+   private:
+    static int bit_length(uint64_t a) {
+        return a == 0 ? 0 : 64 - __builtin_clzll(a);
+    }
+
+    std::string layer_ = "default";
+    std::map<std::string, Stats> stats_;
+    int stats_version_ = kCalibrationVersion;
+};
+
+// Set during the calibration run only.
+extern BitwidthCalibrator *bitwidthCalibrator;
+// Set when a calibrated config is given to the secure inference.
+extern BitwidthConfig *bitwidthConfig;
+
+#endif  // CALIBRATION_H__
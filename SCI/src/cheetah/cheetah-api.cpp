@@ -3,10 +3,13 @@
 
 #include <seal/seal.h>
 
+#include "cheetah/conv-shard.h"
+#include "gemini/cheetah/hom_mask_pool.h"
 #include "gemini/cheetah/shape_inference.h"
 #include "gemini/cheetah/tensor_encoder.h"
 #include "utils/constants.h"  // ALICE & BOB
 #include "utils/net_io_channel.h"
+#include "utils/ring-ops.h"
 
 template <class CtType>
 void send_ciphertext(sci::NetIO *io, const CtType &ct) {
@@ -44,8 +47,10 @@ static void recv_ciphertext(
 namespace gemini {
 
     TensorShape GetConv2DOutShape(const HomConv2DSS::Meta &meta) {
+        TensorShape fshape = meta.fshape;
+        fshape.Update(0, meta.ishape.channels());  // grouped conv
         auto o = shape_inference::Conv2D(
-            meta.ishape, meta.fshape, meta.padding, meta.stride
+            meta.ishape, fshape, meta.padding, meta.stride
         );
         if (!o) {
             printf("GetConv2DOutShape failed\n");
@@ -59,6 +64,34 @@ namespace gemini {
         return io_ ? io_->counter : 0;
     }
 
+    void CheetahLinear::set_conv_workers(const std::string &workers) {
+        if (party_ == sci::BOB) {
+            throw std::logic_error("set_conv_workers: server only");
+        }
+        conv_shards_ =
+            std::make_shared<ConvShardCoordinator>(workers, *context_, *pk_);
+    }
+
+    void CheetahLinear::set_mask_pool(size_t capacity) {
+        if (party_ == sci::BOB) {
+            throw std::logic_error("set_mask_pool: server only");
+        }
+        mask_pool_ = std::make_shared<HomMaskPool>(*context_, pk_, capacity);
+        // The outputs are re-randomized at the last level, in non-NTT form.
+        // Other keys are learned at their first miss.
+        auto code =
+            mask_pool_->fill(context_->last_parms_id(), false, nthreads_);
+        if (code != Code::OK) {
+            throw std::runtime_error(
+                "HomMaskPool fill failed [" + CodeMessage(code) + "]"
+            );
+        }
+        conv2d_impl_.setMaskPool(mask_pool_);
+        fc_impl_.setMaskPool(mask_pool_);
+        bn_impl_.setMaskPool(mask_pool_);
+        mask_pool_->start();
+    }
+
     int64_t CheetahLinear::get_signed(uint64_t x) const {
         if (x >= base_mod_) {
             LOG(FATAL) << "CheetahLinear::get_signed input out-of-bound";
@@ -320,17 +353,28 @@ namespace gemini {
                 Tensor<uint64_t>::Wrap(out_tensor_raw.data(), oshape);
 
             // Reconstruct
-            in_tensor.tensor() += in_tensor_share.tensor();
-            out_tensor.tensor() += out_tensor_share.tensor();
-
-            in_tensor.tensor() =
-                in_tensor.tensor().unaryExpr([this](uint64_t v) {
-                    return reduce(v);
-                });
-            out_tensor.tensor() =
-                out_tensor.tensor().unaryExpr([this](uint64_t v) {
-                    return reduce(v);
-                });
+            if (barrett_reducer_) {
+                in_tensor.tensor() += in_tensor_share.tensor();
+                out_tensor.tensor() += out_tensor_share.tensor();
+
+                in_tensor.tensor() =
+                    in_tensor.tensor().unaryExpr([this](uint64_t v) {
+                        return reduce(v);
+                    });
+                out_tensor.tensor() =
+                    out_tensor.tensor().unaryExpr([this](uint64_t v) {
+                        return reduce(v);
+                    });
+            } else {
+                sci::ring_add(
+                    in_tensor.NumElements(), in_tensor.data(),
+                    in_tensor_share.data(), in_tensor.data(), mod_mask_
+                );
+                sci::ring_add(
+                    out_tensor.NumElements(), out_tensor.data(),
+                    out_tensor_share.data(), out_tensor.data(), mod_mask_
+                );
+            }
 
             auto cast_to_double = [this](uint64_t v, int nbits) -> double {
                 // reduce to [0, p) from [0, 2p)
@@ -523,13 +567,19 @@ namespace gemini {
                 );
             }
         } else {
+            // The filters are encoded by the workers in the model-parallel
+            // mode.
             std::vector<std::vector<seal::Plaintext>> encoded_filters;
-            code =
-                impl.encodeFilters(filters, meta, encoded_filters, nthreads_);
-            if (code != Code::OK) {
-                throw std::runtime_error(
-                    "CheetahLinear::conv2d ecnodeFilters " + CodeMessage(code)
+            if (!conv_shards_) {
+                code = impl.encodeFilters(
+                    filters, meta, encoded_filters, nthreads_
                 );
+                if (code != Code::OK) {
+                    throw std::runtime_error(
+                        "CheetahLinear::conv2d ecnodeFilters " +
+                        CodeMessage(code)
+                    );
+                }
             }
 
             std::vector<seal::Plaintext> encoded_share;
@@ -547,10 +597,16 @@ namespace gemini {
             recv_encrypted_vector(io_, *context_, ct_buff, false);
 
             std::vector<seal::Ciphertext> out_ct;
-            auto code = impl.conv2DSS(
-                ct_buff, encoded_share, encoded_filters, meta, out_ct,
-                out_tensor, nthreads_
-            );
+            if (conv_shards_) {
+                code = conv_shards_->conv2DSS(
+                    ct_buff, encoded_share, filters, meta, out_ct, out_tensor
+                );
+            } else {
+                code = impl.conv2DSS(
+                    ct_buff, encoded_share, encoded_filters, meta, out_ct,
+                    out_tensor, nthreads_
+                );
+            }
             if (code != Code::OK) {
                 throw std::runtime_error(
                     "CheetahLinear::conv2d conv2DSS: " + CodeMessage(code)
@@ -560,6 +616,118 @@ namespace gemini {
         }
     }
 
+    void CheetahLinear::conv2d_tiled(
+        const Tensor<uint64_t> &in_tensor,
+        const std::vector<Tensor<uint64_t>> &filters,
+        const ConvMeta &meta,
+        size_t n_tiles,
+        const std::function<void(const ConvMeta &, Tensor<uint64_t> &)>
+            &on_tile
+    ) const {
+        if (n_tiles <= 1 || conv_shards_) {
+            Tensor<uint64_t> out_tensor;
+            conv2d(in_tensor, filters, meta, out_tensor);
+            on_tile(meta, out_tensor);
+            return;
+        }
+        if (!meta.ishape.IsSameSize(in_tensor.shape())) {
+            throw std::invalid_argument(
+                "CheetahLinear::conv2d_tiled meta.ishape mismatch"
+            );
+        }
+        if (meta.n_filters != filters.size()) {
+            throw std::invalid_argument(
+                "CheetahLinear::conv2d_tiled meta.n_filters mismatch"
+            );
+        }
+
+        const auto &impl = conv2d_impl_;
+        n_tiles = std::min(n_tiles, meta.n_filters);
+
+        Code code;
+        if (party_ == sci::BOB) {
+            {
+                std::vector<seal::Serializable<seal::Ciphertext>> ct_buff;
+                code = impl.encryptImage(in_tensor, meta, ct_buff, nthreads_);
+                if (code != Code::OK) {
+                    throw std::runtime_error(
+                        "CheetahLinear::conv2d_tiled encryptImage " +
+                        CodeMessage(code)
+                    );
+                }
+                send_encrypted_vector(io_, ct_buff);
+            }
+
+            for (size_t t = 0; t < n_tiles; ++t) {
+                const ConvMeta tile = HomConv2DSS::ShardMeta(meta, t, n_tiles);
+                std::vector<seal::Ciphertext> ct_buff;
+                recv_encrypted_vector(io_, *context_, ct_buff, true);
+
+                Tensor<uint64_t> out_tile;
+                code = impl.decryptToTensor(ct_buff, tile, out_tile, nthreads_);
+                if (code != Code::OK) {
+                    throw std::runtime_error(
+                        "CheetahLinear::conv2d_tiled decryptToTensor " +
+                        CodeMessage(code)
+                    );
+                }
+                on_tile(tile, out_tile);
+            }
+        } else {
+            std::vector<seal::Plaintext> encoded_share;
+            if (meta.is_shared_input) {
+                code =
+                    impl.encodeImage(in_tensor, meta, encoded_share, nthreads_);
+                if (code != Code::OK) {
+                    throw std::runtime_error(
+                        "CheetahLinear::conv2d_tiled encodeImage " +
+                        CodeMessage(code)
+                    );
+                }
+            }
+
+            std::vector<seal::Ciphertext> ct_buff;
+            recv_encrypted_vector(io_, *context_, ct_buff, false);
+
+            for (size_t t = 0; t < n_tiles; ++t) {
+                const ConvMeta tile = HomConv2DSS::ShardMeta(meta, t, n_tiles);
+                // The filters are encoded right before their tile, so that the
+                // first tile leaves early.
+                std::vector<std::vector<seal::Plaintext>> encoded_filters;
+                code = impl.encodeFilters(
+                    std::vector<Tensor<uint64_t>>(
+                        filters.begin() + tile.filter_offset,
+                        filters.begin() + tile.filter_offset + tile.n_filters
+                    ),
+                    tile, encoded_filters, nthreads_
+                );
+                if (code != Code::OK) {
+                    throw std::runtime_error(
+                        "CheetahLinear::conv2d_tiled encodeFilters " +
+                        CodeMessage(code)
+                    );
+                }
+
+                std::vector<seal::Ciphertext> out_ct;
+                Tensor<uint64_t> out_tile;
+                code = impl.conv2DSS(
+                    ct_buff, encoded_share, encoded_filters, tile, out_ct,
+                    out_tile, nthreads_
+                );
+                if (code != Code::OK) {
+                    throw std::runtime_error(
+                        "CheetahLinear::conv2d_tiled conv2DSS: " +
+                        CodeMessage(code)
+                    );
+                }
+                send_encrypted_vector(io_, out_ct);
+                // Not buffered until the next receive.
+                io_->flush();
+                on_tile(tile, out_tile);
+            }
+        }
+    }
+
     void CheetahLinear::bn(
         const Tensor<uint64_t> &input_vector,
         const Tensor<uint64_t> &scale_vector,
@@ -2,6 +2,8 @@
 #ifndef SCI_CHEETAH_CHEETAH_API_H_
 #define SCI_CHEETAH_CHEETAH_API_H_
 
+#include <functional>
+
 #include "gemini/cheetah/hom_bn_ss.h"
 #include "gemini/cheetah/hom_conv2d_ss.h"
 #include "gemini/cheetah/hom_fc_ss.h"
@@ -12,6 +14,9 @@ namespace sci {
 
 namespace gemini {
 
+    class ConvShardCoordinator;
+    class HomMaskPool;
+
     // The set of the linear protocols in the Cheetah's paper.
     class CheetahLinear {
        public:
@@ -25,7 +30,8 @@ namespace gemini {
 
         ~CheetahLinear() = default;
 
-        // HomConv
+        // HomConv. Grouped and depthwise convolutions are given by
+        // meta.n_groups, and then each filter is of shape [C / n_groups, h, w].
         void conv2d(
             const Tensor<uint64_t> &in_tensor,
             const std::vector<Tensor<uint64_t>> &filters,
@@ -33,6 +39,22 @@ namespace gemini {
             Tensor<uint64_t> &out_tensor
         ) const;
 
+        // HomConv in n_tiles tiles of output channels (see
+        // HomConv2DSS::ShardMeta). The image is sent once, and the output
+        // share of each tile is handed to on_tile as soon as it is ready,
+        // i.e., the client decrypts the first tiles while the server is still
+        // computing the others. The tiles come in the order of the channels;
+        // on_tile gets the tile's meta (filter_offset, n_filters) and its
+        // [n_filters, H', W'] share. A single tile with the conv workers.
+        void conv2d_tiled(
+            const Tensor<uint64_t> &in_tensor,
+            const std::vector<Tensor<uint64_t>> &filters,
+            const ConvMeta &meta,
+            size_t n_tiles,
+            const std::function<void(const ConvMeta &, Tensor<uint64_t> &)>
+                &on_tile
+        ) const;
+
         // HomFC
         void fc(
             const Tensor<uint64_t> &input_matrix,
@@ -60,6 +82,18 @@ namespace gemini {
 
         uint64_t io_counter() const;
 
+        // Server only. Runs the HomConv layers on the worker processes
+        // listening at `workers` ("ip:port,ip:port,..."), see conv-shard.h.
+        void set_conv_workers(const std::string &workers);
+
+        // Server only. Prepares `capacity` encryptions of zero and output
+        // masks for the re-randomization of the HomConv/HomFC/HomBN outputs,
+        // and keeps the pool refilled in the background, see
+        // hom_mask_pool.h.
+        void set_mask_pool(size_t capacity);
+
+        const HomMaskPool *mask_pool() const { return mask_pool_.get(); }
+
         int party() const { return party_; }
 
         bool verify(
@@ -105,6 +139,9 @@ namespace gemini {
         HomFCSS fc_impl_;
         HomConv2DSS conv2d_impl_;
         HomBNSS bn_impl_;
+
+        std::shared_ptr<ConvShardCoordinator> conv_shards_{nullptr};
+        std::shared_ptr<HomMaskPool> mask_pool_{nullptr};
     };
 
 }  // namespace gemini
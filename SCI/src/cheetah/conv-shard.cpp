@@ -0,0 +1,382 @@
+// SPDX-License-Identifier: MIT
+
+#include "cheetah/conv-shard.h"
+
+#include <seal/seal.h>
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <sstream>
+#include <thread>
+
+#include "gemini/core/logging.h"
+#include "utils/net_io_channel.h"
+
+namespace gemini {
+
+    namespace {
+        enum Op : uint32_t { kBye = 0, kConv = 1 };
+
+        constexpr size_t kMetaFields = 12;
+
+        template <class Obj>
+        std::string save_to_string(const Obj &obj) {
+            std::stringstream os;
+            obj.save(os);
+            return os.str();
+        }
+
+        void send_blob(sci::NetIO &io, const std::string &blob) {
+            uint64_t sze = blob.size();
+            io.send_data(&sze, sizeof(uint64_t));
+            io.send_data(blob.data(), sze);
+        }
+
+        std::string recv_blob(sci::NetIO &io) {
+            uint64_t sze{0};
+            io.recv_data(&sze, sizeof(uint64_t));
+            std::string blob(sze, '\0');
+            io.recv_data(&blob[0], sze);
+            return blob;
+        }
+
+        void send_meta(sci::NetIO &io, const HomConv2DSS::Meta &meta) {
+            std::array<int64_t, kMetaFields> fields{
+                meta.ishape.channels(),
+                meta.ishape.height(),
+                meta.ishape.width(),
+                meta.fshape.channels(),
+                meta.fshape.height(),
+                meta.fshape.width(),
+                (int64_t)meta.n_filters,
+                (int64_t)meta.padding,
+                (int64_t)meta.stride,
+                (int64_t)meta.n_groups,
+                (int64_t)meta.filter_offset,
+                (int64_t)meta.n_total_filters};
+            io.send_data(fields.data(), sizeof(fields));
+        }
+
+        HomConv2DSS::Meta recv_meta(sci::NetIO &io) {
+            std::array<int64_t, kMetaFields> fields{0};
+            io.recv_data(fields.data(), sizeof(fields));
+            HomConv2DSS::Meta meta;
+            meta.ishape = TensorShape({fields[0], fields[1], fields[2]});
+            meta.fshape = TensorShape({fields[3], fields[4], fields[5]});
+            meta.n_filters = fields[6];
+            meta.padding = static_cast<Padding>(fields[7]);
+            meta.stride = fields[8];
+            meta.n_groups = fields[9];
+            meta.filter_offset = fields[10];
+            meta.n_total_filters = fields[11];
+            meta.is_shared_input = false;
+            return meta;
+        }
+
+        // FNV-1a over the layer meta and the raw filters of a shard.
+        uint64_t shard_digest(
+            const std::vector<Tensor<uint64_t>> &filters,
+            const HomConv2DSS::Meta &shard
+        ) {
+            uint64_t h = 0xcbf29ce484222325ULL;
+            auto mix = [&h](uint64_t v) {
+                for (int i = 0; i < 8; ++i, v >>= 8) {
+                    h = (h ^ (v & 0xFF)) * 0x100000001b3ULL;
+                }
+            };
+            mix(shard.ishape.num_elements());
+            mix(shard.fshape.num_elements());
+            mix((uint64_t)shard.padding);
+            mix(shard.stride);
+            mix(shard.n_groups);
+            mix(shard.filter_offset);
+            mix(shard.n_total_filters);
+            for (size_t m = 0; m < shard.n_filters; ++m) {
+                const auto &f = filters[shard.filter_offset + m];
+                const uint64_t *ptr = f.data();
+                for (size_t i = 0; i < f.NumElements(); ++i) mix(ptr[i]);
+            }
+            return h;
+        }
+    }  // namespace
+
+    ConvShardCoordinator::ConvShardCoordinator(
+        const std::string &workers,
+        const seal::SEALContext &context,
+        const seal::PublicKey &pk
+    ) {
+        context_ = std::make_shared<seal::SEALContext>(context);
+        evaluator_ = std::make_shared<seal::Evaluator>(*context_);
+
+        const std::string parms =
+            save_to_string(context_->key_context_data()->parms());
+        const std::string pk_str = save_to_string(pk);
+
+        std::stringstream list(workers);
+        std::string addr;
+        while (std::getline(list, addr, ',')) {
+            const size_t colon = addr.rfind(':');
+            if (colon == std::string::npos) {
+                throw std::invalid_argument(
+                    "ConvShardCoordinator: expect ip:port, got " + addr
+                );
+            }
+            const std::string ip = addr.substr(0, colon);
+            const int port = std::stoi(addr.substr(colon + 1));
+            workers_.emplace_back(new sci::NetIO(ip.c_str(), port, true));
+            send_blob(*workers_.back(), parms);
+            send_blob(*workers_.back(), pk_str);
+            workers_.back()->flush();
+        }
+        if (workers_.empty()) {
+            throw std::invalid_argument("ConvShardCoordinator: no worker");
+        }
+    }
+
+    ConvShardCoordinator::~ConvShardCoordinator() {
+        for (auto &io : workers_) {
+            uint32_t op = kBye;
+            io->send_data(&op, sizeof(uint32_t));
+            io->flush();
+        }
+    }
+
+    Code ConvShardCoordinator::conv2DSS(
+        const std::vector<seal::Ciphertext> &img_share0,
+        const std::vector<seal::Plaintext> &img_share1,
+        const std::vector<Tensor<uint64_t>> &filters,
+        const HomConv2DSS::Meta &meta,
+        std::vector<seal::Ciphertext> &out_share0,
+        Tensor<uint64_t> &out_share1
+    ) {
+        ENSURE_OR_RETURN(
+            filters.size() == meta.n_filters, Code::ERR_DIM_MISMATCH
+        );
+        ENSURE_OR_RETURN(meta.n_total_filters == 0, Code::ERR_INVALID_ARG);
+        if (meta.is_shared_input) {
+            ENSURE_OR_RETURN(
+                img_share0.size() == img_share1.size(), Code::ERR_DIM_MISMATCH
+            );
+        }
+
+        // The image ciphertexts are serialized once for all the workers. The
+        // server's share is added here so that the workers see a plain
+        // (non-shared) input.
+        std::vector<std::string> image(img_share0.size());
+        try {
+            for (size_t i = 0; i < image.size(); ++i) {
+                if (meta.is_shared_input) {
+                    seal::Ciphertext ct;
+                    evaluator_->add_plain(img_share0[i], img_share1[i], ct);
+                    image[i] = save_to_string(ct);
+                } else {
+                    image[i] = save_to_string(img_share0[i]);
+                }
+            }
+        } catch (const std::logic_error &e) {
+            LOG(WARNING) << "SEAL ERROR: " << e.what();
+            return Code::ERR_INTERNAL;
+        }
+
+        HomConv2DSS::Meta layer = meta;
+        layer.is_shared_input = false;
+
+        const size_t W = workers_.size();
+        std::vector<HomConv2DSS::Meta> shards(W);
+        std::vector<Code> codes(W, Code::OK);
+        std::vector<std::vector<seal::Ciphertext>> out_cts(W);
+        std::vector<Tensor<uint64_t>> out_masks(W);
+        auto exchange = [&](size_t w) {
+            const HomConv2DSS::Meta &shard = shards[w];
+            sci::NetIO &io = *workers_[w];
+            uint32_t op = kConv;
+            io.send_data(&op, sizeof(uint32_t));
+            send_meta(io, shard);
+            uint64_t digest = shard_digest(filters, shard);
+            io.send_data(&digest, sizeof(uint64_t));
+
+            uint8_t has_filters{0};
+            io.recv_data(&has_filters, sizeof(uint8_t));
+            if (!has_filters) {
+                for (size_t m = 0; m < shard.n_filters; ++m) {
+                    const auto &f = filters[shard.filter_offset + m];
+                    io.send_data(f.data(), f.NumElements() * sizeof(uint64_t));
+                }
+            }
+
+            uint32_t ncts = image.size();
+            io.send_data(&ncts, sizeof(uint32_t));
+            for (const auto &ct : image) send_blob(io, ct);
+
+            uint32_t code{0};
+            io.recv_data(&code, sizeof(uint32_t));
+            codes[w] = static_cast<Code>(code);
+            if (codes[w] != Code::OK) return;
+
+            io.recv_data(&ncts, sizeof(uint32_t));
+            out_cts[w].resize(ncts);
+            for (auto &ct : out_cts[w]) {
+                std::stringstream is(recv_blob(io));
+                // Truncated by the worker, see HomConv2DSS::conv2DSS.
+                ct.unsafe_load(*context_, is);
+            }
+            std::array<int64_t, 3> dims{0};
+            io.recv_data(dims.data(), sizeof(dims));
+            out_masks[w].Reshape(TensorShape({dims[0], dims[1], dims[2]}));
+            io.recv_data(
+                out_masks[w].data(),
+                out_masks[w].NumElements() * sizeof(uint64_t)
+            );
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t w = 0; w < W; ++w) {
+            shards[w] = HomConv2DSS::ShardMeta(layer, w, W);
+            if (shards[w].n_filters > 0) threads.emplace_back(exchange, w);
+        }
+        for (auto &t : threads) t.join();
+
+        int64_t out_h = 0, out_w = 0;
+        size_t n_out_ct = 0;
+        for (size_t w = 0; w < W; ++w) {
+            if (shards[w].n_filters == 0) continue;
+            if (codes[w] != Code::OK) {
+                LOG(WARNING) << "conv2DSS: worker #" << w << " failed "
+                             << CodeMessage(codes[w]);
+                return codes[w];
+            }
+            out_h = out_masks[w].shape().height();
+            out_w = out_masks[w].shape().width();
+            n_out_ct += out_cts[w].size();
+        }
+
+        out_share0.clear();
+        out_share0.reserve(n_out_ct);
+        const int64_t M = meta.n_filters;
+        out_share1.Reshape(TensorShape({M, out_h, out_w}));
+        for (size_t w = 0; w < W; ++w) {
+            if (shards[w].n_filters == 0) continue;
+            std::move(
+                out_cts[w].begin(), out_cts[w].end(),
+                std::back_inserter(out_share0)
+            );
+            ENSURE_OR_RETURN(
+                out_masks[w].shape().height() == out_h &&
+                    out_masks[w].shape().width() == out_w,
+                Code::ERR_DIM_MISMATCH
+            );
+            std::copy_n(
+                out_masks[w].data(), out_masks[w].NumElements(),
+                out_share1.data() + shards[w].filter_offset * out_h * out_w
+            );
+        }
+        return Code::OK;
+    }
+
+    ConvShardWorker::ConvShardWorker(int port, size_t nthreads)
+        : port_(port), nthreads_(std::max<size_t>(1, nthreads)) {}
+
+    Code ConvShardWorker::serve() {
+        sci::NetIO io(nullptr, port_, true);
+        CHECK_ERR(setUp(io), "setUp");
+        for (;;) {
+            uint32_t op{kBye};
+            io.recv_data(&op, sizeof(uint32_t));
+            if (op == kBye) return Code::OK;
+            ENSURE_OR_RETURN(op == kConv, Code::ERR_INVALID_ARG);
+            CHECK_ERR(conv2DSS(io), "conv2DSS");
+        }
+    }
+
+    Code ConvShardWorker::setUp(sci::NetIO &io) {
+        std::string parms = recv_blob(io);
+        std::string pk = recv_blob(io);
+        try {
+            if (parms != parms_) {
+                // The encoded filters depend on the parameters.
+                filters_.clear();
+                seal::EncryptionParameters seal_parms;
+                std::stringstream is(parms);
+                seal_parms.load(is);
+                // Same as CheetahLinear: no special prime.
+                seal_parms.set_n_special_primes(0);
+                context_ = std::make_shared<seal::SEALContext>(
+                    seal_parms, true, seal::sec_level_type::tc128
+                );
+                parms_ = std::move(parms);
+            }
+            pk_ = std::make_shared<seal::PublicKey>();
+            std::stringstream is(pk);
+            pk_->load(*context_, is);
+        } catch (const std::exception &e) {
+            LOG(WARNING) << "ConvShardWorker::setUp: " << e.what();
+            return Code::ERR_CONFIG;
+        }
+        return impl_.setUp(*context_, std::nullopt, pk_);
+    }
+
+    Code ConvShardWorker::conv2DSS(sci::NetIO &io) {
+        const HomConv2DSS::Meta meta = recv_meta(io);
+        uint64_t digest{0};
+        io.recv_data(&digest, sizeof(uint64_t));
+
+        auto kv = filters_.find(digest);
+        uint8_t has_filters = kv != filters_.end();
+        io.send_data(&has_filters, sizeof(uint8_t));
+        io.flush();
+
+        Code code = Code::OK;
+        if (!has_filters) {
+            std::vector<Tensor<uint64_t>> raw(meta.n_filters);
+            for (auto &f : raw) {
+                f.Reshape(meta.fshape);
+                io.recv_data(f.data(), f.NumElements() * sizeof(uint64_t));
+            }
+            std::vector<std::vector<seal::Plaintext>> encoded;
+            code = impl_.encodeFilters(raw, meta, encoded, nthreads_);
+            if (code == Code::OK) {
+                kv = filters_.emplace(digest, std::move(encoded)).first;
+            }
+        }
+
+        uint32_t ncts{0};
+        io.recv_data(&ncts, sizeof(uint32_t));
+        std::vector<seal::Ciphertext> image(ncts);
+        for (auto &ct : image) {
+            std::stringstream is(recv_blob(io));
+            try {
+                ct.load(*context_, is);
+            } catch (const std::exception &e) {
+                LOG(WARNING) << "ConvShardWorker: " << e.what();
+                code = Code::ERR_INVALID_ARG;
+            }
+        }
+
+        std::vector<seal::Ciphertext> out_share0;
+        Tensor<uint64_t> out_share1;
+        if (code == Code::OK) {
+            code = impl_.conv2DSS(
+                image, {}, kv->second, meta, out_share0, out_share1, nthreads_
+            );
+        }
+
+        uint32_t ret = static_cast<uint32_t>(code);
+        io.send_data(&ret, sizeof(uint32_t));
+        if (code == Code::OK) {
+            ncts = out_share0.size();
+            io.send_data(&ncts, sizeof(uint32_t));
+            for (const auto &ct : out_share0) send_blob(io, save_to_string(ct));
+            std::array<int64_t, 3> dims{
+                out_share1.shape().channels(), out_share1.shape().height(),
+                out_share1.shape().width()};
+            io.send_data(dims.data(), sizeof(dims));
+            io.send_data(
+                out_share1.data(), out_share1.NumElements() * sizeof(uint64_t)
+            );
+        }
+        io.flush();
+        return Code::OK;
+    }
+
+}  // namespace gemini
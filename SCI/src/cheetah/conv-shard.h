@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef SCI_CHEETAH_CONV_SHARD_H_
+#define SCI_CHEETAH_CONV_SHARD_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gemini/cheetah/hom_conv2d_ss.h"
+
+namespace sci {
+    class NetIO;
+}
+
+namespace gemini {
+
+    // Model-parallel HomConv on the server side.
+    //
+    // The server of the 2PC (the coordinator) forwards the client's image
+    // ciphertexts to N worker processes. The i-th worker convolves them with
+    // the i-th shard of the filters (HomConv2DSS::ShardMeta), and returns its
+    // masked output ciphertexts together with its mask, i.e., its output
+    // share. The coordinator concatenates them into out_share0/out_share1 as
+    // returned by HomConv2DSS::conv2DSS for the whole layer.
+    //
+    // The workers are trusted by the server: they see the filters in clear.
+    // A worker encodes a filter shard at its first use and keeps the encoded
+    // filters, so that the following inferences only ship the image.
+    class ConvShardCoordinator {
+       public:
+        // `workers` is a comma-separated list of "ip:port". Connects to the
+        // workers, and sends them the parameters and the client's public key.
+        ConvShardCoordinator(
+            const std::string &workers,
+            const seal::SEALContext &context,
+            const seal::PublicKey &pk
+        );
+
+        // Tells the workers that the session is over.
+        ~ConvShardCoordinator();
+
+        size_t num_workers() const { return workers_.size(); }
+
+        // Same as HomConv2DSS::conv2DSS, with the raw filters of the layer.
+        Code conv2DSS(
+            const std::vector<seal::Ciphertext> &img_share0,
+            const std::vector<seal::Plaintext> &img_share1,
+            const std::vector<Tensor<uint64_t>> &filters,
+            const HomConv2DSS::Meta &meta,
+            std::vector<seal::Ciphertext> &out_share0,
+            Tensor<uint64_t> &out_share1
+        );
+
+       private:
+        std::shared_ptr<seal::SEALContext> context_;
+        std::shared_ptr<seal::Evaluator> evaluator_;
+        std::vector<std::unique_ptr<sci::NetIO>> workers_;
+    };
+
+    // A worker process: serves the sessions of the coordinators, one after
+    // another, on the given port.
+    class ConvShardWorker {
+       public:
+        explicit ConvShardWorker(int port, size_t nthreads = 1);
+
+        // Serves one session, i.e., until the coordinator says goodbye.
+        Code serve();
+
+       private:
+        Code setUp(sci::NetIO &io);
+
+        Code conv2DSS(sci::NetIO &io);
+
+        int port_;
+        size_t nthreads_;
+        std::string parms_;
+        std::shared_ptr<seal::SEALContext> context_;
+        std::shared_ptr<seal::PublicKey> pk_;
+        HomConv2DSS impl_;
+        // Encoded filter shards, keyed by a digest of the raw shard.
+        std::unordered_map<uint64_t, std::vector<std::vector<seal::Plaintext>>>
+            filters_;
+    };
+
+}  // namespace gemini
+
+#endif
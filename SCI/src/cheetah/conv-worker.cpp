@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: MIT
+
+// A worker of the model-parallel HomConv, see conv-shard.h. It serves the
+// sessions of the servers run with `workers=ip:port,...`, one at a time.
+#include <iostream>
+
+#include "cheetah/conv-shard.h"
+#include "utils/ArgMapping/ArgMapping.h"
+
+int port = 33000;
+int num_threads = 4;
+
+int main(int argc, char **argv) {
+    ArgMapping amap;
+    amap.arg("p", port, "Port Number");
+    amap.arg("nt", num_threads, "Number of Threads");
+    amap.parse(argc, argv);
+
+    gemini::ConvShardWorker worker(port, num_threads);
+    for (;;) {
+        Code code = worker.serve();
+        if (code != Code::OK) {
+            std::cerr << "conv-worker: session failed "
+                      << CodeMessage(code) << std::endl;
+        }
+    }
+}
@@ -31,6 +31,8 @@ SOFTWARE.
 #include <iostream>
 #include <vector>
 
+#include "calibration.h"
+
 extern uint64_t prime_mod;
 extern uint64_t moduloMask;
 extern uint64_t moduloMidPt;
@@ -376,6 +378,11 @@ void Relu_pt(
     uint64_t sf,
     uint64_t doTruncation
 ) {
+    if (bitwidthCalibrator != nullptr) {
+        std::vector<int64_t> x(s1);
+        for (uint64_t i1 = 0; i1 < s1; i1++) x[i1] = getSignedVal(inArr[i1]);
+        bitwidthCalibrator->record(x.data(), s1, true, doTruncation, sf);
+    }
     for (uint64_t i1 = (int32_t)0; i1 < s1; i1++) {
         outArr[i1] = (PublicGT(inArr[i1], (int64_t)0)) ? inArr[i1] : (int64_t)0;
     }
@@ -617,6 +624,11 @@ void ScaleUp_pt(uint64_t s1, uint64_1D &arr, uint64_t sf) {
 }
 
 void ScaleDown_pt(uint64_t s1, uint64_1D &arr, uint64_t sf) {
+    if (bitwidthCalibrator != nullptr) {
+        std::vector<int64_t> x(s1);
+        for (uint64_t i1 = 0; i1 < s1; i1++) x[i1] = getSignedVal(arr[i1]);
+        bitwidthCalibrator->record(x.data(), s1, false, false, sf);
+    }
     for (uint64_t i1 = (int32_t)0; i1 < s1; i1++) {
         arr[i1] = (PublicRShiftA(arr[i1], sf));
     }
@@ -23,6 +23,7 @@ SOFTWARE.
 #define FUNCTIONALITIES_UNIFORM_H__
 
 #include <cmath>
+#include <map>
 
 #include "globals.h"
 
@@ -197,6 +198,27 @@ intType funcSigendDivIdeal(intType x, uint32_t y) {
     }
 }
 
+#ifdef SCI_OT
+// The ReLU protocols over Z_{2^ring} of the mixed-bitwidth layers (see
+// LayerBitwidth::ring), per lane and thread, created at their first use.
+std::map<int, ReLUProtocol<sci::NetIO, intType> *>
+    reluRingArr[MAX_LANES][MAX_THREADS];
+
+ReLUProtocol<sci::NetIO, intType> *funcReLUForRing(int tid, int ring) {
+    if (ring <= 0 || ring == bitlength) return reluArr[tid];
+    auto &relu = reluRingArr[kLane][tid][ring];
+    if (relu == nullptr) {
+        relu = new ReLURingProtocol<sci::NetIO, intType>(
+            (tid & 1) ? 3 - party : party, RING, ioArr[tid], ring, MILL_PARAM,
+            otpackArr[tid]
+        );
+    }
+    return relu;
+}
+#endif
+
+// A positive `ring` runs the ReLU over Z_{2^ring}, and then `dropHi` is
+// still relative to the global bitlength.
 void funcReLUThread(
     int tid,
     intType *outp,
@@ -205,11 +227,24 @@ void funcReLUThread(
     uint8_t *drelu_res = nullptr,
     bool skip_ot = false,
     bool doTrunc = false,
-    bool approx = true
+    bool approx = true,
+    int dropLo = -1,
+    int dropHi = 0,
+    int ring = 0
 ) {
+#ifdef SCI_OT
+    if (ring > 0 && ring != bitlength) {
+        funcReLUForRing(tid, ring)->relu(
+            outp, inp, numRelu, drelu_res, skip_ot,
+            /*do_trunc*/ doTrunc, /*approx*/ approx, dropLo,
+            std::max(0, dropHi - (bitlength - ring))
+        );
+        return;
+    }
+#endif
     reluArr[tid]->relu(
         outp, inp, numRelu, drelu_res, skip_ot,
-        /*do_trunc*/ doTrunc, /*approx*/ approx
+        /*do_trunc*/ doTrunc, /*approx*/ approx, dropLo, dropHi
     );
 }
 
@@ -233,10 +268,13 @@ void funcTruncateThread(
     int32_t scalingF,
     int32_t bw,
     bool isSigned,
-    uint8_t *msb
+    uint8_t *msb,
+    bool msb0Heuristic = true,
+    int32_t boundBits = -1
 ) {
     truncationArr[tid]->truncate(
-        size, inpArr, outpArr, scalingF, bw, isSigned, msb
+        size, inpArr, outpArr, scalingF, bw, isSigned, msb, msb0Heuristic,
+        boundBits
     );
 }
 
@@ -560,7 +598,9 @@ void funcTruncateTwoPowerRingWrapper(
     int consSF,
     int bw,
     bool isSigned,
-    uint8_t *msbShare
+    uint8_t *msbShare,
+    bool msb0Heuristic = true,
+    int32_t boundBits = -1
 ) {
     assert(size % 8 == 0);
 #ifdef MULTITHREADED_TRUNC
@@ -580,21 +620,72 @@ void funcTruncateTwoPowerRingWrapper(
         uint8_t *msbShareArg = msbShare;
         if (msbShare != nullptr) msbShareArg = msbShareArg + offset;
 
-        truncThreads[i] = std::thread(
+        truncThreads[i] = LaneThread(
             funcTruncateThread, i, curSize, inp + offset, outp + offset, consSF,
-            bw, isSigned, msbShareArg
+            bw, isSigned, msbShareArg, msb0Heuristic, boundBits
         );
     }
     for (int i = 0; i < num_threads; ++i) {
         truncThreads[i].join();
     }
 #else
-    funcTruncateThread(0, size, inp, outp, consSF, bw, isSigned, msgShare);
+    funcTruncateThread(
+        0, size, inp, outp, consSF, bw, isSigned, msbShare, msb0Heuristic,
+        boundBits
+    );
 #endif
 }
 #endif
 
 #ifdef SCI_OT
+void funcExtendThread(
+    int tid,
+    int32_t size,
+    intType *inpArr,
+    intType *outpArr,
+    int32_t bwA,
+    int32_t bwB,
+    bool nonNegative
+) {
+    if (nonNegative) {
+        // The msb is known to be 0, which saves the comparison.
+        std::vector<uint8_t> msb(size, 0);
+        xtArr[tid]->z_extend(size, inpArr, outpArr, bwA, bwB, msb.data());
+    } else {
+        xtArr[tid]->s_extend(size, inpArr, outpArr, bwA, bwB);
+    }
+}
+
+// Extends the shares of Z_{2^bwA} to Z_{2^bwB}, bwA < bwB, e.g., the output
+// of a mixed-bitwidth layer back to the global ring.
+void funcExtendRingWrapper(
+    int size, intType *inp, intType *outp, int bwA, int bwB, bool nonNegative
+) {
+    assert(size % 8 == 0);
+#ifdef MULTITHREADED_TRUNC
+    std::thread extThreads[num_threads];
+    int chunk_size = (size / (8 * num_threads)) * 8;
+    for (int i = 0; i < num_threads; i++) {
+        int offset = i * chunk_size;
+        int curSize;
+        if (i == (num_threads - 1)) {
+            curSize = size - offset;
+        } else {
+            curSize = chunk_size;
+        }
+        extThreads[i] = LaneThread(
+            funcExtendThread, i, curSize, inp + offset, outp + offset, bwA,
+            bwB, nonNegative
+        );
+    }
+    for (int i = 0; i < num_threads; ++i) {
+        extThreads[i].join();
+    }
+#else
+    funcExtendThread(0, size, inp, outp, bwA, bwB, nonNegative);
+#endif
+}
+
 #if USE_CHEETAH
 void funcReLUTruncateTwoPowerRingWrapper(
     int size, intType *inp, intType *outp, int consSF, int32_t bw, bool isSigned
@@ -614,7 +705,7 @@ void funcReLUTruncateTwoPowerRingWrapper(
         int curParty = party;
         if (i & 1) curParty = 3 - curParty;
 
-        truncThreads[i] = std::thread(
+        truncThreads[i] = LaneThread(
             funcReLUTruncateThread, i, curSize, inp + offset, outp + offset,
             consSF, bw, isSigned
         );
@@ -942,7 +1033,7 @@ void funcAvgPoolTwoPowerRingWrapper(
         }
         int curParty = party;
         if (i & 1) curParty = 3 - curParty;
-        truncThreads[i] = std::thread(
+        truncThreads[i] = LaneThread(
             funcAvgPoolTwoPowerRing, curParty, ioArr[i], otpackArr[i],
             otInstanceArr[i], kkotInstanceArr[i], reluArr[i], prgInstanceArr[i],
             curSize, inp + offset, outp + offset, divisor
@@ -1288,7 +1379,7 @@ void funcFieldDivWrapper(
         if (i & 1) curParty = 3 - curParty;
         uint8_t *msbShareArg = msbShare;
         if (msbShare != nullptr) msbShareArg = msbShareArg + offset;
-        truncThreads[i] = std::thread(
+        truncThreads[i] = LaneThread(
             funcFieldDiv<intType>, curParty, ioArr[i], otpackArr[i],
             otInstanceArr[i], kkotInstanceArr[i], reluArr[i], prgInstanceArr[i],
             curSize, inp + offset, outp + offset, divisor, msbShareArg
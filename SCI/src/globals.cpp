@@ -21,99 +21,226 @@ SOFTWARE.
 
 #include "globals.h"
 
-sci::NetIO *io;
-sci::OTPack<sci::NetIO> *otpack;
+thread_local sci::NetIO *io;
+thread_local sci::OTPack<sci::NetIO> *otpack;
 
 #ifdef SCI_OT
-LinearOT *mult;
-AuxProtocols *aux;
-Truncation *truncation;
-XTProtocol *xt;
-MathFunctions *math;
+thread_local LinearOT *mult;
+thread_local AuxProtocols *aux;
+thread_local Truncation *truncation;
+thread_local XTProtocol *xt;
+thread_local MathFunctions *math;
 #endif
-ArgMaxProtocol<sci::NetIO, intType> *argmax;
-ReLUProtocol<sci::NetIO, intType> *relu;
-MaxPoolProtocol<sci::NetIO, intType> *maxpool;
+thread_local ArgMaxProtocol<sci::NetIO, intType> *argmax;
+thread_local ReLUProtocol<sci::NetIO, intType> *relu;
+thread_local MaxPoolProtocol<sci::NetIO, intType> *maxpool;
 // Additional classes for Athos
 #ifdef SCI_OT
-MatMulUniform<sci::NetIO, intType, sci::IKNP<sci::NetIO>> *multUniform;
+thread_local MatMulUniform<sci::NetIO, intType, sci::IKNP<sci::NetIO>>
+    *multUniform;
 #endif
 
 #ifdef SCI_HE
-FCField *he_fc;
-ElemWiseProdField *he_prod;
+thread_local FCField *he_fc;
+thread_local ElemWiseProdField *he_prod;
 #endif
 
 #if USE_CHEETAH
-gemini::CheetahLinear *cheetah_linear;
-bool kIsSharedInput;
+thread_local gemini::CheetahLinear *cheetah_linear;
+thread_local bool kIsSharedInput;
 #elif defined(SCI_HE)
-ConvField *he_conv;
+thread_local ConvField *he_conv;
 #endif
 
-sci::IKNP<sci::NetIO> *iknpOT;
-sci::IKNP<sci::NetIO> *iknpOTRoleReversed;
-sci::KKOT<sci::NetIO> *kkot;
-sci::PRG128 *prg128Instance;
+thread_local sci::IKNP<sci::NetIO> *iknpOT;
+thread_local sci::IKNP<sci::NetIO> *iknpOTRoleReversed;
+thread_local sci::KKOT<sci::NetIO> *kkot;
+thread_local sci::PRG128 *prg128Instance;
 
-sci::NetIO *ioArr[MAX_THREADS];
-sci::OTPack<sci::NetIO> *otpackArr[MAX_THREADS];
+thread_local sci::NetIO *ioArr[MAX_THREADS];
+thread_local sci::OTPack<sci::NetIO> *otpackArr[MAX_THREADS];
 #ifdef SCI_OT
-LinearOT *multArr[MAX_THREADS];
-AuxProtocols *auxArr[MAX_THREADS];
-Truncation *truncationArr[MAX_THREADS];
-XTProtocol *xtArr[MAX_THREADS];
-MathFunctions *mathArr[MAX_THREADS];
+thread_local LinearOT *multArr[MAX_THREADS];
+thread_local AuxProtocols *auxArr[MAX_THREADS];
+thread_local Truncation *truncationArr[MAX_THREADS];
+thread_local XTProtocol *xtArr[MAX_THREADS];
+thread_local MathFunctions *mathArr[MAX_THREADS];
 #endif
-ReLUProtocol<sci::NetIO, intType> *reluArr[MAX_THREADS];
-MaxPoolProtocol<sci::NetIO, intType> *maxpoolArr[MAX_THREADS];
+thread_local ReLUProtocol<sci::NetIO, intType> *reluArr[MAX_THREADS];
+thread_local MaxPoolProtocol<sci::NetIO, intType>
+    *maxpoolArr[MAX_THREADS];
 // Additional classes for Athos
 #ifdef SCI_OT
-MatMulUniform<sci::NetIO, intType, sci::IKNP<sci::NetIO>>
+thread_local MatMulUniform<sci::NetIO, intType, sci::IKNP<sci::NetIO>>
     *multUniformArr[MAX_THREADS];
 #endif
-sci::IKNP<sci::NetIO> *otInstanceArr[MAX_THREADS];
-sci::KKOT<sci::NetIO> *kkotInstanceArr[MAX_THREADS];
-sci::PRG128 *prgInstanceArr[MAX_THREADS];
+int64_t kTriplePoolCmps = 0;
+bool kBitSlicedCmp = false;
+bool kActivationCHW = false;
+std::string kCalibStatsPath;
+std::string kBitwidthConfigPath;
+double kCalibBudget = 0.01;
+bool kMixedRings = false;
+BitwidthCalibrator *bitwidthCalibrator = nullptr;
+BitwidthConfig *bitwidthConfig = nullptr;
+std::string kMemPlanPath;
+ActivationPlanner *activationPlanner = nullptr;
+std::string kConvWorkers;
+int64_t kHomMaskPool = 0;
+double kLocalTruncFail = 0.;
+std::string kNetProfile;
+#if USE_CHEETAH
+std::string kOTStateDir = "data";
+std::string kOTSession;
+bool kOTWarmUp = true;
+#endif
+LocalTruncation *localTruncation = nullptr;
+#ifdef SCI_OT
+thread_local TriplePool<sci::NetIO> *triplePoolArr[MAX_THREADS];
+#endif
+thread_local sci::IKNP<sci::NetIO> *otInstanceArr[MAX_THREADS];
+thread_local sci::KKOT<sci::NetIO> *kkotInstanceArr[MAX_THREADS];
+thread_local sci::PRG128 *prgInstanceArr[MAX_THREADS];
+
+int kLanes = 1;
+int kConvTiles = 0;
+ProtocolLane protocolLanes[MAX_LANES];
+thread_local int kLane = 0;
+thread_local int kGraphNode = -1;
+
+void SaveLane(int lane) {
+    ProtocolLane &l = protocolLanes[lane];
+    l.io = io;
+    l.otpack = otpack;
+#ifdef SCI_OT
+    l.mult = mult;
+    l.aux = aux;
+    l.truncation = truncation;
+    l.xt = xt;
+    l.math = math;
+    l.multUniform = multUniform;
+#elif defined(SCI_HE)
+    l.he_fc = he_fc;
+    l.he_prod = he_prod;
+#endif
+    l.argmax = argmax;
+    l.relu = relu;
+    l.maxpool = maxpool;
+#if USE_CHEETAH
+    l.cheetah_linear = cheetah_linear;
+#elif defined(SCI_HE)
+    l.he_conv = he_conv;
+#endif
+    l.iknpOT = iknpOT;
+    l.iknpOTRoleReversed = iknpOTRoleReversed;
+    l.kkot = kkot;
+    l.prg128Instance = prg128Instance;
+    for (int i = 0; i < MAX_THREADS; i++) {
+        l.ioArr[i] = ioArr[i];
+        l.otpackArr[i] = otpackArr[i];
+#ifdef SCI_OT
+        l.multArr[i] = multArr[i];
+        l.auxArr[i] = auxArr[i];
+        l.truncationArr[i] = truncationArr[i];
+        l.xtArr[i] = xtArr[i];
+        l.mathArr[i] = mathArr[i];
+        l.multUniformArr[i] = multUniformArr[i];
+        l.triplePoolArr[i] = triplePoolArr[i];
+#endif
+        l.reluArr[i] = reluArr[i];
+        l.maxpoolArr[i] = maxpoolArr[i];
+        l.otInstanceArr[i] = otInstanceArr[i];
+        l.kkotInstanceArr[i] = kkotInstanceArr[i];
+        l.prgInstanceArr[i] = prgInstanceArr[i];
+    }
+}
+
+void EnterLane(int lane) {
+    const ProtocolLane &l = protocolLanes[lane];
+    kLane = lane;
+    io = l.io;
+    otpack = l.otpack;
+#ifdef SCI_OT
+    mult = l.mult;
+    aux = l.aux;
+    truncation = l.truncation;
+    xt = l.xt;
+    math = l.math;
+    multUniform = l.multUniform;
+#elif defined(SCI_HE)
+    he_fc = l.he_fc;
+    he_prod = l.he_prod;
+#endif
+    argmax = l.argmax;
+    relu = l.relu;
+    maxpool = l.maxpool;
+#if USE_CHEETAH
+    cheetah_linear = l.cheetah_linear;
+#elif defined(SCI_HE)
+    he_conv = l.he_conv;
+#endif
+    iknpOT = l.iknpOT;
+    iknpOTRoleReversed = l.iknpOTRoleReversed;
+    kkot = l.kkot;
+    prg128Instance = l.prg128Instance;
+    for (int i = 0; i < MAX_THREADS; i++) {
+        ioArr[i] = l.ioArr[i];
+        otpackArr[i] = l.otpackArr[i];
+#ifdef SCI_OT
+        multArr[i] = l.multArr[i];
+        auxArr[i] = l.auxArr[i];
+        truncationArr[i] = l.truncationArr[i];
+        xtArr[i] = l.xtArr[i];
+        mathArr[i] = l.mathArr[i];
+        multUniformArr[i] = l.multUniformArr[i];
+        triplePoolArr[i] = l.triplePoolArr[i];
+#endif
+        reluArr[i] = l.reluArr[i];
+        maxpoolArr[i] = l.maxpoolArr[i];
+        otInstanceArr[i] = l.otInstanceArr[i];
+        kkotInstanceArr[i] = l.kkotInstanceArr[i];
+        prgInstanceArr[i] = l.prgInstanceArr[i];
+    }
+}
 
 std::chrono::time_point<std::chrono::high_resolution_clock> start_time;
-uint64_t comm_threads[MAX_THREADS];
+uint64_t comm_threads[MAX_LANES * MAX_THREADS];
 uint64_t num_rounds;
 
 #ifdef LOG_LAYERWISE
-uint64_t ConvTimeInMilliSec = 0;
-uint64_t MatAddTimeInMilliSec = 0;
-uint64_t BatchNormInMilliSec = 0;
-uint64_t TruncationTimeInMilliSec = 0;
-uint64_t ReluTimeInMilliSec = 0;
-uint64_t MaxpoolTimeInMilliSec = 0;
-uint64_t AvgpoolTimeInMilliSec = 0;
-uint64_t MatMulTimeInMilliSec = 0;
-uint64_t MatAddBroadCastTimeInMilliSec = 0;
-uint64_t MulCirTimeInMilliSec = 0;
-uint64_t ScalarMulTimeInMilliSec = 0;
-uint64_t SigmoidTimeInMilliSec = 0;
-uint64_t TanhTimeInMilliSec = 0;
-uint64_t SqrtTimeInMilliSec = 0;
-uint64_t NormaliseL2TimeInMilliSec = 0;
-uint64_t ArgMaxTimeInMilliSec = 0;
+std::atomic<uint64_t> ConvTimeInMilliSec{0};
+std::atomic<uint64_t> MatAddTimeInMilliSec{0};
+std::atomic<uint64_t> BatchNormInMilliSec{0};
+std::atomic<uint64_t> TruncationTimeInMilliSec{0};
+std::atomic<uint64_t> ReluTimeInMilliSec{0};
+std::atomic<uint64_t> MaxpoolTimeInMilliSec{0};
+std::atomic<uint64_t> AvgpoolTimeInMilliSec{0};
+std::atomic<uint64_t> MatMulTimeInMilliSec{0};
+std::atomic<uint64_t> MatAddBroadCastTimeInMilliSec{0};
+std::atomic<uint64_t> MulCirTimeInMilliSec{0};
+std::atomic<uint64_t> ScalarMulTimeInMilliSec{0};
+std::atomic<uint64_t> SigmoidTimeInMilliSec{0};
+std::atomic<uint64_t> TanhTimeInMilliSec{0};
+std::atomic<uint64_t> SqrtTimeInMilliSec{0};
+std::atomic<uint64_t> NormaliseL2TimeInMilliSec{0};
+std::atomic<uint64_t> ArgMaxTimeInMilliSec{0};
 
-uint64_t ConvCommSent = 0;
-uint64_t MatAddCommSent = 0;
-uint64_t BatchNormCommSent = 0;
-uint64_t TruncationCommSent = 0;
-uint64_t ReluCommSent = 0;
-uint64_t MaxpoolCommSent = 0;
-uint64_t AvgpoolCommSent = 0;
-uint64_t MatMulCommSent = 0;
-uint64_t MatAddBroadCastCommSent = 0;
-uint64_t MulCirCommSent = 0;
-uint64_t ScalarMulCommSent = 0;
-uint64_t SigmoidCommSent = 0;
-uint64_t TanhCommSent = 0;
-uint64_t SqrtCommSent = 0;
-uint64_t NormaliseL2CommSent = 0;
-uint64_t ArgMaxCommSent = 0;
+std::atomic<uint64_t> ConvCommSent{0};
+std::atomic<uint64_t> MatAddCommSent{0};
+std::atomic<uint64_t> BatchNormCommSent{0};
+std::atomic<uint64_t> TruncationCommSent{0};
+std::atomic<uint64_t> ReluCommSent{0};
+std::atomic<uint64_t> MaxpoolCommSent{0};
+std::atomic<uint64_t> AvgpoolCommSent{0};
+std::atomic<uint64_t> MatMulCommSent{0};
+std::atomic<uint64_t> MatAddBroadCastCommSent{0};
+std::atomic<uint64_t> MulCirCommSent{0};
+std::atomic<uint64_t> ScalarMulCommSent{0};
+std::atomic<uint64_t> SigmoidCommSent{0};
+std::atomic<uint64_t> TanhCommSent{0};
+std::atomic<uint64_t> SqrtCommSent{0};
+std::atomic<uint64_t> NormaliseL2CommSent{0};
+std::atomic<uint64_t> ArgMaxCommSent{0};
 
-uint64_t CountElementMul = 0;
+std::atomic<uint64_t> CountElementMul{0};
 #endif
@@ -23,22 +23,28 @@ SOFTWARE.
 #ifndef GLOBALS_H___
 #define GLOBALS_H___
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <string>
 #include <thread>
 
 #include "NonLinear/argmax.h"
 #include "NonLinear/maxpool.h"
 #include "NonLinear/relu-interface.h"
 #include "OT/kkot.h"
+#include "calibration.h"
 #include "defines.h"
 #include "defines_uniform.h"
+#include "local-truncation.h"
+#include "memory-planner.h"
 #ifdef SCI_OT
 #include "BuildingBlocks/aux-protocols.h"
 #include "BuildingBlocks/truncation.h"
 #include "LinearOT/linear-ot.h"
 #include "LinearOT/linear-uniform.h"
 #include "Math/math-functions.h"
+#include "Millionaire/bit-triple-pool.h"
 #endif
 // Additional Headers for Athos
 #ifdef SCI_HE
@@ -49,106 +55,263 @@ SOFTWARE.
 
 #if USE_CHEETAH
 #include "cheetah/cheetah-api.h"
+#include "gemini/cheetah/hom_mask_pool.h"
 #endif
 
 // #define MULTI_THREADING
 
 #define MAX_THREADS 4
+// Independent branches of a network run at the same time on their own
+// protocol instances, see ProtocolLane.
+#define MAX_LANES 4
 
-extern sci::NetIO *io;
-extern sci::OTPack<sci::NetIO> *otpack;
+// The protocol instances are per thread: they are those of the lane of the
+// thread (see EnterLane), which is lane 0 for the main thread.
+extern thread_local sci::NetIO *io;
+extern thread_local sci::OTPack<sci::NetIO> *otpack;
 
 #ifdef SCI_OT
-extern LinearOT *mult;
-extern AuxProtocols *aux;
-extern Truncation *truncation;
-extern XTProtocol *xt;
-extern MathFunctions *math;
+extern thread_local LinearOT *mult;
+extern thread_local AuxProtocols *aux;
+extern thread_local Truncation *truncation;
+extern thread_local XTProtocol *xt;
+extern thread_local MathFunctions *math;
 #endif
-extern ArgMaxProtocol<sci::NetIO, intType> *argmax;
-extern ReLUProtocol<sci::NetIO, intType> *relu;
-extern MaxPoolProtocol<sci::NetIO, intType> *maxpool;
+extern thread_local ArgMaxProtocol<sci::NetIO, intType> *argmax;
+extern thread_local ReLUProtocol<sci::NetIO, intType> *relu;
+extern thread_local MaxPoolProtocol<sci::NetIO, intType> *maxpool;
 // Additional classes for Athos
 
 #ifdef SCI_OT
-extern MatMulUniform<sci::NetIO, intType, sci::IKNP<sci::NetIO>> *multUniform;
+extern thread_local MatMulUniform<sci::NetIO, intType, sci::IKNP<sci::NetIO>>
+    *multUniform;
 #elif defined(SCI_HE)
-extern FCField *he_fc;
-extern ElemWiseProdField *he_prod;
+extern thread_local FCField *he_fc;
+extern thread_local ElemWiseProdField *he_prod;
 #endif
 
 #if USE_CHEETAH
-extern gemini::CheetahLinear *cheetah_linear;
-extern bool kIsSharedInput;
+extern thread_local gemini::CheetahLinear *cheetah_linear;
+extern thread_local bool kIsSharedInput;
 #elif defined(SCI_HE)
-extern ConvField *he_conv;
+extern thread_local ConvField *he_conv;
 #endif
 
-extern sci::IKNP<sci::NetIO> *iknpOT;
-extern sci::IKNP<sci::NetIO> *iknpOTRoleReversed;
-extern sci::KKOT<sci::NetIO> *kkot;
-extern sci::PRG128 *prg128Instance;
+extern thread_local sci::IKNP<sci::NetIO> *iknpOT;
+extern thread_local sci::IKNP<sci::NetIO> *iknpOTRoleReversed;
+extern thread_local sci::KKOT<sci::NetIO> *kkot;
+extern thread_local sci::PRG128 *prg128Instance;
 
-extern sci::NetIO *ioArr[MAX_THREADS];
-extern sci::OTPack<sci::NetIO> *otpackArr[MAX_THREADS];
+extern thread_local sci::NetIO *ioArr[MAX_THREADS];
+extern thread_local sci::OTPack<sci::NetIO> *otpackArr[MAX_THREADS];
 #ifdef SCI_OT
-extern LinearOT *multArr[MAX_THREADS];
-extern AuxProtocols *auxArr[MAX_THREADS];
-extern Truncation *truncationArr[MAX_THREADS];
-extern XTProtocol *xtArr[MAX_THREADS];
-extern MathFunctions *mathArr[MAX_THREADS];
+extern thread_local LinearOT *multArr[MAX_THREADS];
+extern thread_local AuxProtocols *auxArr[MAX_THREADS];
+extern thread_local Truncation *truncationArr[MAX_THREADS];
+extern thread_local XTProtocol *xtArr[MAX_THREADS];
+extern thread_local MathFunctions *mathArr[MAX_THREADS];
 #endif
-extern ReLUProtocol<sci::NetIO, intType> *reluArr[MAX_THREADS];
-extern MaxPoolProtocol<sci::NetIO, intType> *maxpoolArr[MAX_THREADS];
+extern thread_local ReLUProtocol<sci::NetIO, intType> *reluArr[MAX_THREADS];
+extern thread_local MaxPoolProtocol<sci::NetIO, intType>
+    *maxpoolArr[MAX_THREADS];
 // Additional classes for Athos
 #ifdef SCI_OT
-extern MatMulUniform<sci::NetIO, intType, sci::IKNP<sci::NetIO>>
+extern thread_local MatMulUniform<sci::NetIO, intType, sci::IKNP<sci::NetIO>>
     *multUniformArr[MAX_THREADS];
 #endif
-extern sci::IKNP<sci::NetIO> *otInstanceArr[MAX_THREADS];
-extern sci::KKOT<sci::NetIO> *kkotInstanceArr[MAX_THREADS];
-extern sci::PRG128 *prgInstanceArr[MAX_THREADS];
+// Expected number of comparisons per inference. When positive, a pool of
+// bit-triples is pre-generated per thread in StartComputation(), and refilled
+// in the background on its own channel (port + MAX_LANES * MAX_THREADS + i)
+// until finalize().
+extern int64_t kTriplePoolCmps;
+// When set, the comparisons and equality tests of the ReLU, MaxPool, ArgMax
+// and truncation layers run bit-sliced (see
+// MillionaireProtocol::compare_bit_sliced). Both parties must agree.
+extern bool kBitSlicedCmp;
+// When set, 4D activations are kept as NCHW (instead of NHWC) between
+// layers. Only the Cheetah linear layers and the pooling layers honour it.
+extern bool kActivationCHW;
+// Per-layer ReLU/truncation bitwidths, see calibration.h. A non-empty
+// kCalibStatsPath turns the run into a calibration run, which reveals the
+// input of every ReLU and truncation to the client: only use it with sample
+// data. Otherwise, kBitwidthConfigPath is the config to run with, and both
+// parties MUST use the same one.
+extern std::string kCalibStatsPath;
+extern std::string kBitwidthConfigPath;
+extern double kCalibBudget;
+// Calibration run: also derive a smaller ring per ReLU layer, which then
+// runs over Z_{2^ring} (see LayerBitwidth::ring).
+extern bool kMixedRings;
+// When set, the arrays of the network are placed in an arena planned from
+// the allocations of a first run, see memory-planner.h. The plan is recorded
+// to kMemPlanPath if the file does not exist, and replayed otherwise.
+extern std::string kMemPlanPath;
+// Server only, Cheetah only: the HomConv layers are sharded by filters over
+// the worker processes (conv-worker-cheetah) at these "ip:port,..." addresses.
+extern std::string kConvWorkers;
+// Server only, Cheetah only: when positive, the encryptions of zero and the
+// masks of the linear layers' outputs are pre-computed, see hom_mask_pool.h.
+extern int64_t kHomMaskPool;
+// When positive, the truncations (ScaleDown and after a ReLU) are done
+// locally on the shares for the layers whose calibrated bound (see
+// kBitwidthConfigPath) keeps the failure probability per element under
+// kLocalTruncFail, see local-truncation.h. Ring (SCI_OT) only.
+extern double kLocalTruncFail;
+// When set, the traffic of every thread is projected onto this network (see
+// sci::NetProfile::parse, e.g., "wan"), and EndComputation() reports the
+// projected time next to the real one. The actual traffic is not delayed.
+extern std::string kNetProfile;
+#if USE_CHEETAH
+// The Ferret pre-OT states of the OTPacks are kept under
+// kOTStateDir/kOTSession/ between the runs (see sci::OTStateStore). An empty
+// dir keeps the shared PRE_OT_DATA_* files; an empty session is derived from
+// the port (and the server's address for the client).
+extern std::string kOTStateDir;
+extern std::string kOTSession;
+// Extend the first batch of COTs when the OTPacks are set up.
+extern bool kOTWarmUp;
+#endif
+#ifdef SCI_OT
+extern thread_local TriplePool<sci::NetIO> *triplePoolArr[MAX_THREADS];
+#endif
+extern thread_local sci::IKNP<sci::NetIO> *otInstanceArr[MAX_THREADS];
+extern thread_local sci::KKOT<sci::NetIO> *kkotInstanceArr[MAX_THREADS];
+extern thread_local sci::PRG128 *prgInstanceArr[MAX_THREADS];
+
+// The protocol instances of a lane: its own num_threads channels and OT packs,
+// and the protocols on top of them (including a CheetahLinear). The lanes
+// talk to the same lanes of the other party, on the ports
+// port + lane * MAX_THREADS + i, so that the layers of one lane never wait
+// for the messages of another.
+struct ProtocolLane {
+    sci::NetIO *io;
+    sci::OTPack<sci::NetIO> *otpack;
+#ifdef SCI_OT
+    LinearOT *mult;
+    AuxProtocols *aux;
+    Truncation *truncation;
+    XTProtocol *xt;
+    MathFunctions *math;
+    MatMulUniform<sci::NetIO, intType, sci::IKNP<sci::NetIO>> *multUniform;
+#elif defined(SCI_HE)
+    FCField *he_fc;
+    ElemWiseProdField *he_prod;
+#endif
+    ArgMaxProtocol<sci::NetIO, intType> *argmax;
+    ReLUProtocol<sci::NetIO, intType> *relu;
+    MaxPoolProtocol<sci::NetIO, intType> *maxpool;
+#if USE_CHEETAH
+    gemini::CheetahLinear *cheetah_linear;
+#elif defined(SCI_HE)
+    ConvField *he_conv;
+#endif
+    sci::IKNP<sci::NetIO> *iknpOT;
+    sci::IKNP<sci::NetIO> *iknpOTRoleReversed;
+    sci::KKOT<sci::NetIO> *kkot;
+    sci::PRG128 *prg128Instance;
+
+    sci::NetIO *ioArr[MAX_THREADS];
+    sci::OTPack<sci::NetIO> *otpackArr[MAX_THREADS];
+#ifdef SCI_OT
+    LinearOT *multArr[MAX_THREADS];
+    AuxProtocols *auxArr[MAX_THREADS];
+    Truncation *truncationArr[MAX_THREADS];
+    XTProtocol *xtArr[MAX_THREADS];
+    MathFunctions *mathArr[MAX_THREADS];
+    MatMulUniform<sci::NetIO, intType, sci::IKNP<sci::NetIO>>
+        *multUniformArr[MAX_THREADS];
+    TriplePool<sci::NetIO> *triplePoolArr[MAX_THREADS];
+#endif
+    ReLUProtocol<sci::NetIO, intType> *reluArr[MAX_THREADS];
+    MaxPoolProtocol<sci::NetIO, intType> *maxpoolArr[MAX_THREADS];
+    sci::IKNP<sci::NetIO> *otInstanceArr[MAX_THREADS];
+    sci::KKOT<sci::NetIO> *kkotInstanceArr[MAX_THREADS];
+    sci::PRG128 *prgInstanceArr[MAX_THREADS];
+};
+
+// Number of lanes set up by StartComputation(), at most MAX_LANES. Only the
+// graph runtime (graph-runtime.h) runs layers on the lanes other than 0.
+extern int kLanes;
+// Cheetah only: the Conv2D -> ReLU pairs of the graph runtime are pipelined
+// over this many tiles of output channels (<= 1: off), with the ReLUs on
+// lane 1, see Conv2DReluWrapper.
+extern int kConvTiles;
+extern ProtocolLane protocolLanes[MAX_LANES];
+// The lane of the calling thread.
+extern thread_local int kLane;
+// The graph node run by the calling thread (see GraphExecutor), -1 outside
+// of the graph runtime. The layers are numbered after it instead of the
+// order of their calls, which is not fixed across the lanes.
+extern thread_local int kGraphNode;
+
+// The number of a layer in the logs, the calibration and the bitwidth
+// configs: its graph node (from 1) in the graph runtime, the count of the
+// calls of the layer otherwise.
+inline int layerNumber(std::atomic<int> &ctr) {
+    return kGraphNode >= 0 ? kGraphNode + 1 : ctr++;
+}
+
+// Records the protocol instances of the calling thread as those of `lane`.
+void SaveLane(int lane);
+
+// Switches the calling thread to the protocol instances of `lane`.
+void EnterLane(int lane);
+
+// std::thread(f, args...) on the lane of the calling thread, for the threads
+// of a layer that use the per-thread protocol instances, e.g., reluArr[tid].
+template <typename F, typename... Args>
+std::thread LaneThread(F &&f, Args &&...args) {
+    return std::thread(
+        [lane = kLane](auto &&fn, auto &&...a) {
+            EnterLane(lane);
+            fn(a...);
+        },
+        std::forward<F>(f), std::forward<Args>(args)...
+    );
+}
 
 extern std::chrono::time_point<std::chrono::high_resolution_clock> start_time;
-extern uint64_t comm_threads[MAX_THREADS];
+// Bytes sent by the thread `lane * MAX_THREADS + i` at the start.
+extern uint64_t comm_threads[MAX_LANES * MAX_THREADS];
 extern uint64_t num_rounds;
 
 #ifdef LOG_LAYERWISE
-extern uint64_t ConvTimeInMilliSec;
-extern uint64_t MatAddTimeInMilliSec;
-extern uint64_t BatchNormInMilliSec;
-extern uint64_t TruncationTimeInMilliSec;
-extern uint64_t ReluTimeInMilliSec;
-extern uint64_t MaxpoolTimeInMilliSec;
-extern uint64_t AvgpoolTimeInMilliSec;
-extern uint64_t MatMulTimeInMilliSec;
-extern uint64_t MatAddBroadCastTimeInMilliSec;
-extern uint64_t MulCirTimeInMilliSec;
-extern uint64_t ScalarMulTimeInMilliSec;
-extern uint64_t SigmoidTimeInMilliSec;
-extern uint64_t TanhTimeInMilliSec;
-extern uint64_t SqrtTimeInMilliSec;
-extern uint64_t NormaliseL2TimeInMilliSec;
-extern uint64_t ArgMaxTimeInMilliSec;
-
-extern uint64_t ConvCommSent;
-extern uint64_t MatAddCommSent;
-extern uint64_t BatchNormCommSent;
-extern uint64_t TruncationCommSent;
-extern uint64_t ReluCommSent;
-extern uint64_t MaxpoolCommSent;
-extern uint64_t AvgpoolCommSent;
-extern uint64_t MatMulCommSent;
-extern uint64_t MatAddBroadCastCommSent;
-extern uint64_t MulCirCommSent;
-extern uint64_t ScalarMulCommSent;
-extern uint64_t SigmoidCommSent;
-extern uint64_t TanhCommSent;
-extern uint64_t SqrtCommSent;
-extern uint64_t NormaliseL2CommSent;
-extern uint64_t ArgMaxCommSent;
-
-extern uint64_t CountElementMul;
+// Accumulated by the layers, which run concurrently on the lanes.
+extern std::atomic<uint64_t> ConvTimeInMilliSec;
+extern std::atomic<uint64_t> MatAddTimeInMilliSec;
+extern std::atomic<uint64_t> BatchNormInMilliSec;
+extern std::atomic<uint64_t> TruncationTimeInMilliSec;
+extern std::atomic<uint64_t> ReluTimeInMilliSec;
+extern std::atomic<uint64_t> MaxpoolTimeInMilliSec;
+extern std::atomic<uint64_t> AvgpoolTimeInMilliSec;
+extern std::atomic<uint64_t> MatMulTimeInMilliSec;
+extern std::atomic<uint64_t> MatAddBroadCastTimeInMilliSec;
+extern std::atomic<uint64_t> MulCirTimeInMilliSec;
+extern std::atomic<uint64_t> ScalarMulTimeInMilliSec;
+extern std::atomic<uint64_t> SigmoidTimeInMilliSec;
+extern std::atomic<uint64_t> TanhTimeInMilliSec;
+extern std::atomic<uint64_t> SqrtTimeInMilliSec;
+extern std::atomic<uint64_t> NormaliseL2TimeInMilliSec;
+extern std::atomic<uint64_t> ArgMaxTimeInMilliSec;
+
+extern std::atomic<uint64_t> ConvCommSent;
+extern std::atomic<uint64_t> MatAddCommSent;
+extern std::atomic<uint64_t> BatchNormCommSent;
+extern std::atomic<uint64_t> TruncationCommSent;
+extern std::atomic<uint64_t> ReluCommSent;
+extern std::atomic<uint64_t> MaxpoolCommSent;
+extern std::atomic<uint64_t> AvgpoolCommSent;
+extern std::atomic<uint64_t> MatMulCommSent;
+extern std::atomic<uint64_t> MatAddBroadCastCommSent;
+extern std::atomic<uint64_t> MulCirCommSent;
+extern std::atomic<uint64_t> ScalarMulCommSent;
+extern std::atomic<uint64_t> SigmoidCommSent;
+extern std::atomic<uint64_t> TanhCommSent;
+extern std::atomic<uint64_t> SqrtCommSent;
+extern std::atomic<uint64_t> NormaliseL2CommSent;
+extern std::atomic<uint64_t> ArgMaxCommSent;
+
+extern std::atomic<uint64_t> CountElementMul;
 #endif
 
 #endif  // GLOBALS_H__
@@ -0,0 +1,611 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef GRAPH_IR_H__
+#define GRAPH_IR_H__
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// A compact description of a network: the tensors with their shapes, and the
+// layers in execution order. The graph is executed by GraphExecutor (see
+// graph-runtime.h) on top of the layers of library_fixed_uniform*.cpp.
+//
+// Text format, one statement per line, '#' starts a comment:
+//
+//   graph <name>
+//   input  <tensor> <d0> <d1> ...   client input, read from stdin
+//   weight <tensor> <d0> <d1> ...   server input, read from stdin in the
+//                                   order of declaration
+//   <op> <tensor> = <in0> [<in1> ...] [<key>=<v0>,<v1>,...]
+//   output <tensor>
+//
+// Every tensor is assigned once. The shapes of the layer outputs are
+// inferred. 4D activations are NHWC; with kActivationCHW only their memory
+// layout changes. An attribute value `scale` stands for kScale.
+//
+//   pad           in                 pads=n0,n1,h0,h1,w0,w1,c0,c1
+//   conv2d        in filter          stride=sh,sw pad=hl,hr,wl,wr
+//                                    [groups=g] [private=1]
+//   fused_bn_conv in filter mul bias stride=.. pad=.. [private=1]
+//   batchnorm     in mul bias        mul_shift=k bias_shift=k
+//   relu          in                 trunc=0|1
+//   maxpool       in                 kernel=kh,kw stride=sh,sw pad=..
+//   avgpool       in                 kernel=kh,kw stride=sh,sw pad=..
+//   add           a b
+//   bias_add      in bias            (bias over the last dimension)
+//   scale_up      in                 shift=k
+//   scale_down    in                 shift=k
+//   concat        a b                axis=k
+//   reshape       in                 shape=d0,d1,...
+//   matmul        a b                (one of them is a weight)
+//   argmax        in                 (over the last dimension)
+//
+// `private=1` marks a convolution on the plain input of the client (i.e.,
+// kIsSharedInput = false for Cheetah).
+enum class GraphOp {
+    kPad,
+    kConv2D,
+    kFusedBNConv,
+    kBatchNorm,
+    kRelu,
+    kMaxPool,
+    kAvgPool,
+    kAdd,
+    kBiasAdd,
+    kScaleUp,
+    kScaleDown,
+    kConcat,
+    kReshape,
+    kMatMul,
+    kArgMax,
+};
+
+struct GraphTensor {
+    enum Kind { kInput, kWeight, kActivation };
+
+    std::string name;
+    Kind kind = kActivation;
+    std::vector<int64_t> shape;
+    int producer = -1;  // node index, -1 for inputs and weights
+    int last_use = -1;  // node index, -1 if never read
+    bool is_output = false;
+
+    int64_t size() const {
+        int64_t n = 1;
+        for (int64_t d : shape) n *= d;
+        return n;
+    }
+};
+
+struct GraphNode {
+    GraphOp op;
+    std::vector<int> inputs;  // tensor indices
+    int output = -1;
+    std::map<std::string, std::vector<int64_t>> attrs;
+    // Set by Graph::plan_inplace: the output takes the buffer of inputs[0].
+    bool inplace = false;
+    // Set by Graph::plan_pipeline: the layer is part of the Conv2D -> ReLU
+    // chain that runs as a whole at the ReLU, i.e., the layer pipe.
+    int pipe = -1;
+    int line = 0;
+
+    // kScale is substituted at run time for the value `scale`.
+    static constexpr int64_t kScaleToken = INT64_MIN;
+
+    int64_t attr(const std::string &key, size_t i, int64_t def) const {
+        auto kv = attrs.find(key);
+        if (kv == attrs.end() || i >= kv->second.size()) return def;
+        return kv->second[i];
+    }
+};
+
+class Graph {
+   public:
+    bool load(const std::string &path) {
+        std::ifstream in(path);
+        if (!in) {
+            std::cerr << "Graph: can not open " << path << std::endl;
+            return false;
+        }
+        return parse(in);
+    }
+
+    bool parse(std::istream &in) {
+        std::string line;
+        for (int lineno = 1; std::getline(in, line); ++lineno) {
+            auto hash = line.find('#');
+            if (hash != std::string::npos) line.resize(hash);
+            std::istringstream ss(line);
+            std::vector<std::string> tok;
+            for (std::string t; ss >> t;) tok.push_back(t);
+            if (tok.empty()) continue;
+            if (!parse_statement(tok, lineno)) return false;
+        }
+        for (const GraphTensor &t : tensors_) {
+            if (t.is_output) return analyze();
+        }
+        std::cerr << "Graph: no output" << std::endl;
+        return false;
+    }
+
+    const std::string &name() const { return name_; }
+    const std::vector<GraphTensor> &tensors() const { return tensors_; }
+    const std::vector<GraphNode> &nodes() const { return nodes_; }
+
+    // Tensor indices of the inputs and the weights, in declaration order.
+    const std::vector<int> &inputs() const { return inputs_; }
+    const std::vector<int> &weights() const { return weights_; }
+
+    int find(const std::string &name) const {
+        auto kv = index_.find(name);
+        return kv == index_.end() ? -1 : kv->second;
+    }
+
+    // Element-wise layers write their output over their (first) input when
+    // the input is not read afterwards, nor again by the layer itself (e.g.,
+    // add y = x x).
+    void plan_inplace() {
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            GraphNode &node = nodes_[i];
+            switch (node.op) {
+                case GraphOp::kScaleUp:
+                case GraphOp::kScaleDown:
+                case GraphOp::kAdd:
+                case GraphOp::kBiasAdd:
+                    break;
+                default:
+                    continue;
+            }
+            const GraphTensor &in = tensors_[node.inputs[0]];
+            const bool reread =
+                std::find(
+                    node.inputs.begin() + 1, node.inputs.end(), node.inputs[0]
+                ) != node.inputs.end();
+            node.inplace = in.kind != GraphTensor::kInput &&
+                           in.last_use == (int)i && !in.is_output && !reread;
+        }
+    }
+
+    // Marks the chains conv2d/fused_bn_conv [-> bias_add] -> relu whose
+    // intermediate results are not read elsewhere, to be run by
+    // Conv2DReluWrapper at the position of the ReLU. The layers in between
+    // must not overwrite the inputs of the conv. Returns the number of
+    // chains.
+    int plan_pipeline() {
+        std::vector<std::vector<int>> readers(tensors_.size());
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            for (int t : nodes_[i].inputs) readers[t].push_back(i);
+        }
+        // The only reader of the output of layer i, or -1.
+        auto next = [&](int i) {
+            const int t = nodes_[i].output;
+            if (tensors_[t].is_output || readers[t].size() != 1) return -1;
+            const int r = readers[t][0];
+            return nodes_[r].inputs[0] == t ? r : -1;
+        };
+
+        int n_chains = 0;
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            GraphNode &conv = nodes_[i];
+            if ((conv.op != GraphOp::kConv2D &&
+                 conv.op != GraphOp::kFusedBNConv) ||
+                conv.attr("groups", 0, 1) != 1) {
+                continue;
+            }
+            int bias = -1, relu = next(i);
+            if (relu >= 0 && nodes_[relu].op == GraphOp::kBiasAdd &&
+                conv.op == GraphOp::kConv2D) {
+                bias = relu;
+                relu = next(bias);
+            }
+            if (relu < 0 || nodes_[relu].op != GraphOp::kRelu) continue;
+
+            bool clobbered = false;
+            for (int j = i + 1; j < relu; ++j) {
+                if (j == bias || !nodes_[j].inplace) continue;
+                for (int t : conv.inputs) {
+                    clobbered |= nodes_[j].inputs[0] == t;
+                }
+            }
+            if (clobbered) continue;
+            conv.pipe = relu;
+            if (bias >= 0) nodes_[bias].pipe = relu;
+            nodes_[relu].pipe = relu;
+            ++n_chains;
+        }
+        return n_chains;
+    }
+
+    // The layers that a layer waits for: the producers of its inputs and,
+    // for an in-place layer, the other readers of the buffer it overwrites.
+    std::vector<std::vector<int>> dependencies() const {
+        std::vector<std::vector<int>> deps(nodes_.size());
+        std::vector<std::vector<int>> readers(tensors_.size());
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            const GraphNode &node = nodes_[i];
+            for (int t : node.inputs) {
+                if (tensors_[t].producer >= 0) {
+                    deps[i].push_back(tensors_[t].producer);
+                }
+            }
+            if (node.inplace) {
+                for (int r : readers[node.inputs[0]]) deps[i].push_back(r);
+            }
+            for (int t : node.inputs) readers[t].push_back(i);
+        }
+        return deps;
+    }
+
+    // Assigns the layers to `lanes` lanes by list scheduling: in execution
+    // order, a layer goes to the lane where it can start first given the
+    // rough costs of the layers, preferring the lane of the producer of its
+    // first input. Thus the independent branches, e.g., the expand layers
+    // of a fire module, end up on different lanes. The local layers stay on
+    // the preferred lane. Deterministic, so that both parties run the same
+    // layers on the same lanes.
+    std::vector<int> schedule(int lanes) const {
+        std::vector<int> lane(nodes_.size(), 0);
+        if (lanes <= 1) return lane;
+        const auto deps = dependencies();
+        std::vector<int64_t> finish(nodes_.size(), 0), lane_free(lanes, 0);
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            int64_t ready = 0;
+            for (int d : deps[i]) ready = std::max(ready, finish[d]);
+            int best = 0;
+            for (int t : nodes_[i].inputs) {
+                if (tensors_[t].producer >= 0) {
+                    best = lane[tensors_[t].producer];
+                    break;
+                }
+            }
+            int64_t start = std::max(ready, lane_free[best]);
+            for (int l = 0; l < lanes && !is_local(nodes_[i].op); ++l) {
+                if (std::max(ready, lane_free[l]) < start) {
+                    best = l;
+                    start = std::max(ready, lane_free[l]);
+                }
+            }
+            lane[i] = best;
+            finish[i] = start + cost(nodes_[i]);
+            lane_free[best] = finish[i];
+        }
+        return lane;
+    }
+
+    // The layer runs on the shares only, without any communication.
+    static bool is_local(GraphOp op) {
+        switch (op) {
+            case GraphOp::kPad:
+            case GraphOp::kAdd:
+            case GraphOp::kBiasAdd:
+            case GraphOp::kScaleUp:
+            case GraphOp::kConcat:
+            case GraphOp::kReshape:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Rough cost of a layer, in multiplications: a comparison (or a
+    // truncation) counts as 64.
+    int64_t cost(const GraphNode &node) const {
+        const int64_t size = tensors_[node.output].size();
+        const auto &in = in_shape(node, 0);
+        switch (node.op) {
+            case GraphOp::kConv2D:
+            case GraphOp::kFusedBNConv: {
+                const auto &f = in_shape(node, 1);
+                return size * f[0] * f[1] * f[2] /
+                       std::max<int64_t>(1, node.attr("groups", 0, 1));
+            }
+            case GraphOp::kMatMul:
+                return size * in.back();
+            case GraphOp::kMaxPool:
+            case GraphOp::kAvgPool:
+                return 64 * size * node.attr("kernel", 0, 1) *
+                       node.attr("kernel", 1, 1);
+            case GraphOp::kRelu:
+            case GraphOp::kBatchNorm:
+            case GraphOp::kScaleDown:
+                return 64 * size;
+            case GraphOp::kArgMax:
+                return 64 * tensors_[node.inputs[0]].size();
+            default:
+                return size;
+        }
+    }
+
+    void print_summary(std::ostream &os = std::cout) const {
+        int64_t weight_elems = 0, act_elems = 0;
+        int num_inplace = 0;
+        for (const GraphTensor &t : tensors_) {
+            if (t.kind == GraphTensor::kWeight) weight_elems += t.size();
+            if (t.kind == GraphTensor::kActivation) act_elems += t.size();
+        }
+        int num_pipes = 0;
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            num_inplace += nodes_[i].inplace;
+            num_pipes += nodes_[i].pipe == (int)i;
+        }
+        os << "Graph " << name_ << ": " << nodes_.size() << " layers, "
+           << weights_.size() << " weights (" << weight_elems
+           << " elements), " << act_elems << " activation elements, "
+           << num_inplace << " in-place layers";
+        if (num_pipes > 0) os << ", " << num_pipes << " pipelined convs";
+        os << std::endl;
+    }
+
+    static const char *op_name(GraphOp op) {
+        for (const auto &kv : op_table()) {
+            if (kv.second == op) return kv.first.c_str();
+        }
+        return "?";
+    }
+
+   private:
+    static const std::map<std::string, GraphOp> &op_table() {
+        static const std::map<std::string, GraphOp> table = {
+            {"pad", GraphOp::kPad},
+            {"conv2d", GraphOp::kConv2D},
+            {"fused_bn_conv", GraphOp::kFusedBNConv},
+            {"batchnorm", GraphOp::kBatchNorm},
+            {"relu", GraphOp::kRelu},
+            {"maxpool", GraphOp::kMaxPool},
+            {"avgpool", GraphOp::kAvgPool},
+            {"add", GraphOp::kAdd},
+            {"bias_add", GraphOp::kBiasAdd},
+            {"scale_up", GraphOp::kScaleUp},
+            {"scale_down", GraphOp::kScaleDown},
+            {"concat", GraphOp::kConcat},
+            {"reshape", GraphOp::kReshape},
+            {"matmul", GraphOp::kMatMul},
+            {"argmax", GraphOp::kArgMax},
+        };
+        return table;
+    }
+
+    bool error(int lineno, const std::string &msg) const {
+        std::cerr << "Graph: line " << lineno << ": " << msg << std::endl;
+        return false;
+    }
+
+    static bool to_int(const std::string &s, int64_t &v) {
+        if (s == "scale") {
+            v = GraphNode::kScaleToken;
+            return true;
+        }
+        char *end = nullptr;
+        v = std::strtoll(s.c_str(), &end, 10);
+        return !s.empty() && *end == '\0';
+    }
+
+    int add_tensor(const std::string &name, GraphTensor::Kind kind) {
+        GraphTensor t;
+        t.name = name;
+        t.kind = kind;
+        index_[name] = tensors_.size();
+        tensors_.push_back(t);
+        return tensors_.size() - 1;
+    }
+
+    bool parse_statement(const std::vector<std::string> &tok, int lineno) {
+        const std::string &kw = tok[0];
+        if (kw == "graph") {
+            if (tok.size() > 1) name_ = tok[1];
+            return true;
+        }
+        if (kw == "input" || kw == "weight") {
+            if (tok.size() < 3) return error(lineno, "missing shape");
+            if (find(tok[1]) >= 0) return error(lineno, "redefined " + tok[1]);
+            const bool is_input = (kw == "input");
+            int t = add_tensor(
+                tok[1], is_input ? GraphTensor::kInput : GraphTensor::kWeight
+            );
+            for (size_t i = 2; i < tok.size(); ++i) {
+                int64_t d;
+                if (!to_int(tok[i], d) || d <= 0) {
+                    return error(lineno, "bad dimension " + tok[i]);
+                }
+                tensors_[t].shape.push_back(d);
+            }
+            (is_input ? inputs_ : weights_).push_back(t);
+            return true;
+        }
+        if (kw == "output") {
+            for (size_t i = 1; i < tok.size(); ++i) {
+                int t = find(tok[i]);
+                if (t < 0) return error(lineno, "unknown tensor " + tok[i]);
+                tensors_[t].is_output = true;
+            }
+            return true;
+        }
+
+        auto op = op_table().find(kw);
+        if (op == op_table().end()) return error(lineno, "unknown op " + kw);
+        if (tok.size() < 4 || tok[2] != "=") {
+            return error(lineno, "expected <op> <out> = <inputs>");
+        }
+        if (find(tok[1]) >= 0) return error(lineno, "redefined " + tok[1]);
+
+        GraphNode node;
+        node.op = op->second;
+        node.line = lineno;
+        for (size_t i = 3; i < tok.size(); ++i) {
+            auto eq = tok[i].find('=');
+            if (eq == std::string::npos) {
+                int t = find(tok[i]);
+                if (t < 0) return error(lineno, "unknown tensor " + tok[i]);
+                node.inputs.push_back(t);
+                continue;
+            }
+            std::vector<int64_t> &vals = node.attrs[tok[i].substr(0, eq)];
+            std::istringstream vs(tok[i].substr(eq + 1));
+            for (std::string v; std::getline(vs, v, ',');) {
+                int64_t x;
+                if (!to_int(v, x)) return error(lineno, "bad value " + v);
+                vals.push_back(x);
+            }
+        }
+        node.output = add_tensor(tok[1], GraphTensor::kActivation);
+        tensors_[node.output].producer = nodes_.size();
+        nodes_.push_back(node);
+        if (!infer_shape(nodes_.back())) {
+            return error(lineno, "invalid shapes for " + kw);
+        }
+        return true;
+    }
+
+    const std::vector<int64_t> &in_shape(const GraphNode &node, int i) const {
+        return tensors_[node.inputs[i]].shape;
+    }
+
+    static int64_t window_out(int64_t in, int64_t k, int64_t s, int64_t pad) {
+        return (in + pad - k) / s + 1;
+    }
+
+    bool infer_shape(const GraphNode &node) {
+        std::vector<int64_t> &out = tensors_[node.output].shape;
+        auto num_inputs = [&](size_t n) { return node.inputs.size() == n; };
+        auto pads = [&](int i) { return node.attr("pad", i, 0); };
+        switch (node.op) {
+            case GraphOp::kPad: {
+                if (!num_inputs(1) || in_shape(node, 0).size() != 4) break;
+                out = in_shape(node, 0);
+                for (int d = 0; d < 4; ++d) {
+                    out[d] += node.attr("pads", 2 * d, 0) +
+                              node.attr("pads", 2 * d + 1, 0);
+                }
+                return true;
+            }
+            case GraphOp::kConv2D:
+            case GraphOp::kFusedBNConv: {
+                const size_t n = node.op == GraphOp::kConv2D ? 2 : 4;
+                if (!num_inputs(n)) break;
+                const auto &x = in_shape(node, 0);
+                const auto &f = in_shape(node, 1);
+                const int64_t groups = node.attr("groups", 0, 1);
+                if (x.size() != 4 || f.size() != 4) break;
+                if (groups <= 0 || x[3] != f[2] * groups) break;
+                if (f[3] % groups != 0) break;
+                const std::vector<int64_t> co = {f[3]};
+                if (n == 4 &&
+                    (in_shape(node, 2) != co || in_shape(node, 3) != co)) {
+                    break;
+                }
+                const int64_t sh = node.attr("stride", 0, 1);
+                const int64_t sw = node.attr("stride", 1, 1);
+                out = {x[0], window_out(x[1], f[0], sh, pads(0) + pads(1)),
+                       window_out(x[2], f[1], sw, pads(2) + pads(3)), f[3]};
+                return true;
+            }
+            case GraphOp::kBatchNorm: {
+                if (!num_inputs(3) || in_shape(node, 0).size() != 4) break;
+                const std::vector<int64_t> c = {in_shape(node, 0)[3]};
+                if (in_shape(node, 1) != c || in_shape(node, 2) != c) break;
+                out = in_shape(node, 0);
+                return true;
+            }
+            case GraphOp::kRelu:
+            case GraphOp::kScaleUp:
+            case GraphOp::kScaleDown: {
+                if (!num_inputs(1)) break;
+                out = in_shape(node, 0);
+                return true;
+            }
+            case GraphOp::kMaxPool:
+            case GraphOp::kAvgPool: {
+                if (!num_inputs(1) || in_shape(node, 0).size() != 4) break;
+                const auto &x = in_shape(node, 0);
+                const int64_t kh = node.attr("kernel", 0, 1);
+                const int64_t kw = node.attr("kernel", 1, 1);
+                const int64_t sh = node.attr("stride", 0, 1);
+                const int64_t sw = node.attr("stride", 1, 1);
+                out = {x[0], window_out(x[1], kh, sh, pads(0) + pads(1)),
+                       window_out(x[2], kw, sw, pads(2) + pads(3)), x[3]};
+                return true;
+            }
+            case GraphOp::kAdd: {
+                if (!num_inputs(2) || in_shape(node, 0) != in_shape(node, 1)) {
+                    break;
+                }
+                out = in_shape(node, 0);
+                return true;
+            }
+            case GraphOp::kBiasAdd: {
+                if (!num_inputs(2) || in_shape(node, 1).size() != 1) break;
+                if (in_shape(node, 0).back() != in_shape(node, 1)[0]) break;
+                out = in_shape(node, 0);
+                return true;
+            }
+            case GraphOp::kConcat: {
+                if (!num_inputs(2)) break;
+                const auto &a = in_shape(node, 0);
+                const auto &b = in_shape(node, 1);
+                const int64_t rank = a.size();
+                const int64_t axis = node.attr("axis", 0, rank - 1);
+                if ((int64_t)b.size() != rank || axis < 0 || axis >= rank) {
+                    break;
+                }
+                out = a;
+                for (size_t d = 0; d < a.size(); ++d) {
+                    if ((int64_t)d == axis) {
+                        out[d] += b[d];
+                    } else if (a[d] != b[d]) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            case GraphOp::kReshape: {
+                if (!num_inputs(1) || !node.attrs.count("shape")) break;
+                out = node.attrs.at("shape");
+                return tensors_[node.output].size() ==
+                       tensors_[node.inputs[0]].size();
+            }
+            case GraphOp::kMatMul: {
+                if (!num_inputs(2)) break;
+                const auto &a = in_shape(node, 0);
+                const auto &b = in_shape(node, 1);
+                if (a.size() != 2 || b.size() != 2 || a[1] != b[0]) break;
+                const bool a_weight =
+                    tensors_[node.inputs[0]].kind == GraphTensor::kWeight;
+                const bool b_weight =
+                    tensors_[node.inputs[1]].kind == GraphTensor::kWeight;
+                if (a_weight == b_weight) break;
+                out = {a[0], b[1]};
+                return true;
+            }
+            case GraphOp::kArgMax: {
+                if (!num_inputs(1) || in_shape(node, 0).size() < 2) break;
+                out = in_shape(node, 0);
+                out.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Liveness: the last layer that reads each tensor.
+    bool analyze() {
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            for (int t : nodes_[i].inputs) tensors_[t].last_use = i;
+        }
+        return true;
+    }
+
+    std::string name_ = "graph";
+    std::vector<GraphTensor> tensors_;
+    std::vector<GraphNode> nodes_;
+    std::vector<int> inputs_;
+    std::vector<int> weights_;
+    std::map<std::string, int> index_;
+};
+
+#endif  // GRAPH_IR_H__
@@ -0,0 +1,571 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef GRAPH_RUNTIME_H__
+#define GRAPH_RUNTIME_H__
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "graph-ir.h"
+#include "library_fixed.h"
+
+// Runs a Graph with the layers of library_fixed_uniform*.cpp, i.e., the same
+// calls as the generated network programs.
+//
+// Every activation is allocated with make_array right before the layer that
+// writes it, and freed after the last layer that reads it (see
+// Graph::analyze), so the memory plan of ActivationPlanner applies as is.
+//
+// With kLanes > 1, the layers are spread over the protocol lanes (see
+// ProtocolLane) by Graph::schedule, and each lane runs its layers in a
+// thread of its own, e.g., the HomConv of one branch while the ReLU of
+// another is waiting for the network. The per-layer logs then interleave;
+// the layers are numbered after their graph node (see kGraphNode). The
+// memory plan identifies the allocations by their order, so it keeps the
+// layers on lane 0, as do the calibration and the bitwidth configs.
+//
+// With Cheetah and kConvTiles > 1, the chains of Graph::plan_pipeline run
+// through Conv2DReluWrapper instead, with the ReLUs on lane 1, and the
+// layers keep the order of the graph otherwise.
+class GraphExecutor {
+   public:
+    explicit GraphExecutor(const Graph &graph)
+        : graph_(graph), buf_(graph.tensors().size(), nullptr) {}
+
+    ~GraphExecutor() {
+        for (size_t t = 0; t < buf_.size(); ++t) release(t);
+    }
+
+    // The client reads the inputs and the server reads the weights from `in`,
+    // in the order of declaration. The other party holds zeros. Weights that
+    // no layer reads are dropped right away.
+    void load(std::istream &in) {
+        const auto &tensors = graph_.tensors();
+        for (int t : graph_.inputs()) {
+            read(t, in, party == CLIENT);
+            if (kActivationCHW && tensors[t].shape.size() == 4) {
+                const auto &s = tensors[t].shape;
+                NHWCToNCHW(s[0], s[1], s[2], s[3], buf_[t]);
+            }
+        }
+        for (int t : graph_.weights()) {
+            read(t, in, party == SERVER);
+            if (tensors[t].last_use < 0) release(t);
+        }
+    }
+
+    void run() {
+        const auto &nodes = graph_.nodes();
+        readers_ = std::vector<std::atomic<int>>(buf_.size());
+        for (const GraphNode &node : nodes) {
+            for (int t : node.inputs) readers_[t]++;
+        }
+        if (pipelined()) {
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                if (nodes[i].pipe < 0) {
+                    run_node(i);
+                } else if (nodes[i].pipe == (int)i) {
+                    run_pipe(i);
+                }
+            }
+        } else if (kLanes > 1 && !ordered()) {
+            run_lanes(graph_.schedule(kLanes));
+        } else {
+            for (size_t i = 0; i < nodes.size(); ++i) run_node(i);
+        }
+        for (size_t t = 0; t < buf_.size(); ++t) {
+            const auto &s = graph_.tensors()[t].shape;
+            if (kActivationCHW && s.size() == 4 && buf_[t] != nullptr &&
+                graph_.tensors()[t].is_output) {
+                NCHWToNHWC(s[0], s[1], s[2], s[3], buf_[t]);
+            }
+        }
+    }
+
+    // The shares of an output, in the NHWC order.
+    const intType *tensor(int t) const { return buf_[t]; }
+
+   private:
+    // The layers must run in the order of the graph.
+    static bool ordered() {
+        return activationPlanner != nullptr || bitwidthCalibrator != nullptr ||
+               bitwidthConfig != nullptr;
+    }
+
+    static bool pipelined() {
+#if USE_CHEETAH
+        return kConvTiles > 1 && kLanes > 1 && !ordered();
+#else
+        return false;
+#endif
+    }
+
+    void run_node(size_t i) {
+        const GraphNode &node = graph_.nodes()[i];
+        const int out = node.output;
+        if (node.inplace) {
+            buf_[out] = buf_[node.inputs[0]];
+            buf_[node.inputs[0]] = nullptr;
+        } else {
+            buf_[out] = make_array<intType>(graph_.tensors()[out].size());
+        }
+        kGraphNode = i;
+        execute(node);
+        kGraphNode = -1;
+        retire(node);
+    }
+
+    void retire(const GraphNode &node) {
+        for (int t : node.inputs) {
+            if (--readers_[t] == 0 && !graph_.tensors()[t].is_output) {
+                release(t);
+            }
+        }
+    }
+
+    // The chain conv [-> bias_add] -> relu ending at the ReLU `k`. The
+    // intermediate tensors are never allocated.
+    void run_pipe(size_t k) {
+#if USE_CHEETAH
+        const auto &nodes = graph_.nodes();
+        const GraphNode &relu = nodes[k];
+        const GraphNode *bias_add = nullptr;
+        auto producer = [&](int t) {
+            return &nodes[graph_.tensors()[t].producer];
+        };
+        const GraphNode *conv = producer(relu.inputs[0]);
+        if (conv->op == GraphOp::kBiasAdd) {
+            bias_add = conv;
+            conv = producer(bias_add->inputs[0]);
+        }
+
+        const auto &s = shape(conv->inputs[0]);
+        const auto &f = shape(conv->inputs[1]);
+        const int64_t nf = f[0] * f[1] * f[2] * f[3];
+        auto pad = [&](int i) { return (int32_t)conv->attr("pad", i, 0); };
+        auto stride = [&](int i) {
+            return (int32_t)conv->attr("stride", i, 1);
+        };
+        intType *filter = buf_[conv->inputs[1]];
+        intType *bias = nullptr;
+        if (conv->op == GraphOp::kFusedBNConv) {
+            filter = make_array<intType>(nf);
+            scale_filter(
+                buf_[conv->inputs[1]], f, buf_[conv->inputs[2]], filter
+            );
+            if (party == SERVER) {
+                bias = make_array<intType>(f[3]);
+                std::copy_n(buf_[conv->inputs[3]], f[3], bias);
+                ScaleUp(f[3], bias, kScale);
+            }
+        }
+
+        buf_[relu.output] =
+            make_array<intType>(graph_.tensors()[relu.output].size());
+        kIsSharedInput = conv->attr("private", 0, 0) == 0;
+        kGraphNode = k;
+        Conv2DReluWrapper(
+            s[0], s[1], s[2], s[3], f[0], f[1], f[3], pad(0), pad(1), pad(2),
+            pad(3), stride(0), stride(1), buf_[conv->inputs[0]], filter,
+            bias_add ? buf_[bias_add->inputs[1]] : bias, buf_[relu.output],
+            kScale, relu.attr("trunc", 0, 0) != 0, kConvTiles
+        );
+        kGraphNode = -1;
+        kIsSharedInput = true;
+
+        if (conv->op == GraphOp::kFusedBNConv) {
+            ClearMemSecret1(nf, filter);
+            if (bias != nullptr) ClearMemSecret1(f[3], bias);
+        }
+        retire(*conv);
+        if (bias_add) retire(*bias_add);
+        retire(relu);
+#endif
+    }
+
+    // Both parties run the layers of a lane in the same order, on the same
+    // lane, so the lanes never wait for each other across the parties.
+    void run_lanes(const std::vector<int> &lane) {
+        const size_t n = graph_.nodes().size();
+        const auto deps = graph_.dependencies();
+        std::vector<char> done(n, 0);
+        std::mutex lock;
+        std::condition_variable cond;
+        int cross = 0;
+        for (size_t i = 0; i < n; ++i) {
+            for (int d : deps[i]) cross += lane[d] != lane[i];
+        }
+        std::cerr << "GraphExecutor: " << kLanes << " lanes, " << cross
+                  << " dependencies across them" << std::endl;
+
+        auto worker = [&](int l) {
+            EnterLane(l);
+            for (size_t i = 0; i < n; ++i) {
+                if (lane[i] != l) continue;
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    cond.wait(guard, [&] {
+                        for (int d : deps[i]) {
+                            if (!done[d]) return false;
+                        }
+                        return true;
+                    });
+                }
+                run_node(i);
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    done[i] = 1;
+                }
+                cond.notify_all();
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int l = 1; l < kLanes; ++l) threads.emplace_back(worker, l);
+        worker(0);
+        for (auto &t : threads) t.join();
+    }
+
+    void read(int t, std::istream &in, bool is_owner) {
+        const int64_t n = graph_.tensors()[t].size();
+        buf_[t] = make_array<intType>(n);
+        intType v = 0;
+        for (int64_t i = 0; i < n; ++i) {
+            if (is_owner) in >> v;
+            buf_[t][i] = is_owner ? v : 0;
+        }
+    }
+
+    void release(int t) {
+        if (buf_[t] == nullptr) return;
+        ClearMemSecret1(graph_.tensors()[t].size(), buf_[t]);
+        buf_[t] = nullptr;
+    }
+
+    static int64_t resolve(int64_t v) {
+        return v == GraphNode::kScaleToken ? kScale : v;
+    }
+
+    const std::vector<int64_t> &shape(int t) const {
+        return graph_.tensors()[t].shape;
+    }
+
+    // The shape in memory order, and the position of each logical
+    // dimension in it.
+    void physical(
+        const std::vector<int64_t> &s,
+        std::vector<int64_t> &phys,
+        std::vector<int> &pos
+    ) const {
+        phys = s;
+        pos.resize(s.size());
+        for (size_t d = 0; d < s.size(); ++d) pos[d] = d;
+        if (kActivationCHW && s.size() == 4) {
+            phys = {s[0], s[3], s[1], s[2]};
+            pos = {0, 2, 3, 1};
+        }
+    }
+
+    // The channel of the activation at a flat position.
+    static int64_t channel(const std::vector<int64_t> &s, int64_t linIdx) {
+        if (kActivationCHW && s.size() == 4) {
+            return (linIdx / (s[1] * s[2])) % s[3];
+        }
+        return linIdx % s.back();
+    }
+
+    static int64_t signed_value(intType x) {
+        const uint64_t mask = sci::all1Mask(bitlength);
+        const uint64_t half = 1ULL << (bitlength - 1);
+        x &= mask;
+        return x >= half ? (int64_t)(x - mask - 1) : (int64_t)x;
+    }
+
+    void execute(const GraphNode &node) {
+        const int out = node.output;
+        intType *y = buf_[out];
+        const std::vector<int64_t> &ys = shape(out);
+        const int64_t size = graph_.tensors()[out].size();
+        auto x = [&](int i) { return buf_[node.inputs[i]]; };
+        auto xs = [&](int i) -> const std::vector<int64_t> & {
+            return shape(node.inputs[i]);
+        };
+        auto pad = [&](int i) { return (int32_t)node.attr("pad", i, 0); };
+        auto stride = [&](int i) {
+            return (int32_t)node.attr("stride", i, 1);
+        };
+
+        switch (node.op) {
+            case GraphOp::kPad: {
+                pad4d(node, x(0), xs(0), y, ys);
+                break;
+            }
+            case GraphOp::kConv2D:
+            case GraphOp::kFusedBNConv: {
+                const auto &s = xs(0);
+                const auto &f = xs(1);
+                const int64_t groups = node.attr("groups", 0, 1);
+                intType *filter = x(1);
+                if (node.op == GraphOp::kFusedBNConv) {
+                    filter = make_array<intType>(f[0] * f[1] * f[2] * f[3]);
+                    scale_filter(x(1), f, x(2), filter);
+                }
+#if USE_CHEETAH
+                kIsSharedInput = node.attr("private", 0, 0) == 0;
+#endif
+                if (groups == 1) {
+                    Conv2DWrapper(
+                        s[0], s[1], s[2], s[3], f[0], f[1], f[3], pad(0),
+                        pad(1), pad(2), pad(3), stride(0), stride(1), x(0),
+                        filter, y
+                    );
+                } else {
+                    Conv2DGroupWrapper(
+                        s[0], s[1], s[2], s[3], f[0], f[1], f[3], pad(0),
+                        pad(1), pad(2), pad(3), stride(0), stride(1), groups,
+                        x(0), filter, y
+                    );
+                }
+#if USE_CHEETAH
+                kIsSharedInput = true;
+#endif
+                if (node.op == GraphOp::kFusedBNConv) {
+                    ClearMemSecret1(f[0] * f[1] * f[2] * f[3], filter);
+                    if (party == SERVER) {
+                        intType *bias = make_array<intType>(f[3]);
+                        std::copy_n(x(3), f[3], bias);
+                        ScaleUp(f[3], bias, kScale);
+                        add_bias(y, ys, bias, y);
+                        ClearMemSecret1(f[3], bias);
+                    }
+                }
+                break;
+            }
+            case GraphOp::kBatchNorm: {
+                batch_norm(node, x(0), xs(0), x(1), x(2), y);
+                break;
+            }
+            case GraphOp::kRelu: {
+                Relu(size, x(0), y, kScale, node.attr("trunc", 0, 0) != 0);
+                break;
+            }
+            case GraphOp::kMaxPool:
+            case GraphOp::kAvgPool: {
+                const auto &s = xs(0);
+                auto pool = node.op == GraphOp::kMaxPool ? MaxPool : AvgPool;
+                pool(
+                    ys[0], ys[1], ys[2], ys[3], node.attr("kernel", 0, 1),
+                    node.attr("kernel", 1, 1), pad(0), pad(1), pad(2), pad(3),
+                    stride(0), stride(1), s[0], s[1], s[2], s[3], x(0), y
+                );
+                break;
+            }
+            case GraphOp::kAdd: {
+                ElemWiseSecretAdd(size, x(0), x(1), y);
+                break;
+            }
+            case GraphOp::kBiasAdd: {
+                add_bias(x(0), ys, x(1), y);
+                break;
+            }
+            case GraphOp::kScaleUp:
+            case GraphOp::kScaleDown: {
+                if (y != x(0)) std::copy_n(x(0), size, y);
+                const int32_t sf = resolve(node.attr("shift", 0, 0));
+                if (node.op == GraphOp::kScaleUp) {
+                    ScaleUp(size, y, sf);
+                } else {
+                    ScaleDown(size, y, sf);
+                }
+                break;
+            }
+            case GraphOp::kConcat: {
+                concat(node, y, ys);
+                break;
+            }
+            case GraphOp::kReshape: {
+                std::copy_n(x(0), size, y);
+                const auto &s = xs(0);
+                if (kActivationCHW && s.size() == 4) {
+                    NCHWToNHWC(s[0], s[1], s[2], s[3], y);
+                }
+                if (kActivationCHW && ys.size() == 4) {
+                    NHWCToNCHW(ys[0], ys[1], ys[2], ys[3], y);
+                }
+                break;
+            }
+            case GraphOp::kMatMul: {
+                const bool model_is_a =
+                    graph_.tensors()[node.inputs[0]].kind ==
+                    GraphTensor::kWeight;
+                MatMul2D(
+                    xs(0)[0], xs(0)[1], xs(1)[1], x(0), x(1), y, model_is_a
+                );
+                break;
+            }
+            case GraphOp::kArgMax: {
+                const auto &s = xs(0);
+                const int64_t n = graph_.tensors()[node.inputs[0]].size();
+                intType *in = make_array<intType>(n);
+                std::copy_n(x(0), n, in);
+                if (kActivationCHW && s.size() == 4) {
+                    NCHWToNHWC(s[0], s[1], s[2], s[3], in);
+                }
+                ArgMax(size, s.back(), in, y);
+                ClearMemSecret1(n, in);
+                break;
+            }
+        }
+    }
+
+    // The fixed-point product of each filter with the BN scale of its
+    // output channel.
+    void scale_filter(
+        const intType *filter,
+        const std::vector<int64_t> &f,
+        const intType *bn_scale,
+        intType *out
+    ) const {
+        const int64_t n = f[0] * f[1] * f[2] * f[3];
+        if (party != SERVER) {
+            std::fill_n(out, n, 0);
+            return;
+        }
+        const double scale = std::pow(2., kScale);
+        for (int64_t i = 0; i < n; ++i) {
+            const double s = signed_value(bn_scale[i % f[3]]) / scale;
+            const double v = signed_value(filter[i]) / scale;
+            out[i] = sci::neg_mod(
+                static_cast<int64_t>(std::round(v * s * scale)), prime_mod
+            );
+        }
+    }
+
+    void add_bias(
+        const intType *in,
+        const std::vector<int64_t> &s,
+        const intType *bias,
+        intType *out
+    ) const {
+        const int64_t C = s.back();
+        if (kActivationCHW && s.size() == 4) {
+            const int64_t n = s[1] * s[2] * s[3];
+            for (int64_t b = 0; b < s[0]; ++b) {
+                MatAddBroadCastRows(
+                    C, s[1] * s[2], in + b * n, bias, out + b * n
+                );
+            }
+        } else {
+            int64_t rows = 1;
+            for (size_t d = 0; d + 1 < s.size(); ++d) rows *= s[d];
+            MatAddBroadCast(rows, C, in, bias, out);
+        }
+    }
+
+    void batch_norm(
+        const GraphNode &node,
+        const intType *in,
+        const std::vector<int64_t> &s,
+        const intType *mul,
+        const intType *bias,
+        intType *out
+    ) const {
+        const int64_t C = s[3];
+        const int64_t n = s[0] * s[1] * s[2] * s[3];
+        const int64_t mul_shift = resolve(node.attr("mul_shift", 0, 0));
+        const int64_t bias_shift = resolve(node.attr("bias_shift", 0, 0));
+        intType *bias_up = make_array<intType>(C);
+        std::copy_n(bias, C, bias_up);
+        if (bias_shift > 0) ScaleUp(C, bias_up, bias_shift);
+
+#if USE_CHEETAH
+        if (gemini::IsTwoPower(prime_mod) && mul_shift == 0) {
+            int64_t n_ct_coeff_packing = ((s[1] * s[2] + 4095) / 4096) * C;
+            int64_t n_ct_bfv_packing = ((s[1] * s[2] * C + 4095) / 4096) * 3;
+            if (n_ct_coeff_packing < n_ct_bfv_packing) {
+                BatchNorm(s[0], s[1], s[2], C, in, mul, bias_up, out);
+                ClearMemSecret1(C, bias_up);
+                return;
+            }
+        }
+#endif
+        intType *in_copy = make_array<intType>(n);
+        intType *mul_vec = make_array<intType>(n);
+        intType *prod = make_array<intType>(n);
+        std::copy_n(in, n, in_copy);
+        for (int64_t i = 0; i < n; ++i) mul_vec[i] = mul[channel(s, i)];
+        ElemWiseActModelVectorMult(n, in_copy, mul_vec, prod);
+        if (mul_shift > 0) ScaleDown(n, prod, mul_shift);
+        for (int64_t i = 0; i < n; ++i) {
+            out[i] = SecretAdd(prod[i], bias_up[channel(s, i)]);
+        }
+        ClearMemSecret1(n, in_copy);
+        ClearMemSecret1(n, mul_vec);
+        ClearMemSecret1(n, prod);
+        ClearMemSecret1(C, bias_up);
+    }
+
+    void pad4d(
+        const GraphNode &node,
+        const intType *in,
+        const std::vector<int64_t> &s,
+        intType *out,
+        const std::vector<int64_t> &ys
+    ) const {
+        std::vector<int64_t> in_phys, out_phys;
+        std::vector<int> pos;
+        physical(s, in_phys, pos);
+        physical(ys, out_phys, pos);
+        int64_t lo[4];
+        for (int d = 0; d < 4; ++d) lo[pos[d]] = node.attr("pads", 2 * d, 0);
+
+        const int64_t n = out_phys[0] * out_phys[1] * out_phys[2] * out_phys[3];
+        std::fill_n(out, n, 0);
+        for (int64_t i = 0; i < in_phys[0]; ++i) {
+            for (int64_t j = 0; j < in_phys[1]; ++j) {
+                for (int64_t k = 0; k < in_phys[2]; ++k) {
+                    const int64_t src_off =
+                        ((i * in_phys[1] + j) * in_phys[2] + k) * in_phys[3];
+                    const int64_t dst_off =
+                        (((i + lo[0]) * out_phys[1] + j + lo[1]) *
+                             out_phys[2] +
+                         k + lo[2]) *
+                            out_phys[3] +
+                        lo[3];
+                    std::copy_n(in + src_off, in_phys[3], out + dst_off);
+                }
+            }
+        }
+    }
+
+    // Row-major concatenation in the memory order.
+    void concat(
+        const GraphNode &node, intType *out, const std::vector<int64_t> &ys
+    ) const {
+        const int a = node.inputs[0], b = node.inputs[1];
+        std::vector<int64_t> a_phys, b_phys;
+        std::vector<int> pos;
+        physical(shape(a), a_phys, pos);
+        physical(shape(b), b_phys, pos);
+        const int axis = pos[node.attr("axis", 0, ys.size() - 1)];
+        int64_t outer = 1, inner = 1;
+        for (int d = 0; d < axis; ++d) outer *= a_phys[d];
+        for (size_t d = axis + 1; d < a_phys.size(); ++d) inner *= a_phys[d];
+        const int64_t na = a_phys[axis] * inner, nb = b_phys[axis] * inner;
+        for (int64_t o = 0; o < outer; ++o) {
+            std::copy_n(buf_[a] + o * na, na, out + o * (na + nb));
+            std::copy_n(buf_[b] + o * nb, nb, out + o * (na + nb) + na);
+        }
+    }
+
+    const Graph &graph_;
+    std::vector<intType *> buf_;
+    // The layers yet to read each tensor.
+    std::vector<std::atomic<int>> readers_;
+};
+
+#endif  // GRAPH_RUNTIME_H__
@@ -66,6 +66,7 @@ void initialize() {
     xt = xtArr[0];
     mult = multArr[0];
     math = mathArr[0];
+    SaveLane(0);
 
     io->sync();
     num_rounds = io->num_rounds;
@@ -77,25 +78,55 @@ void initialize() {
 }
 
 void finalize() {
-    for (int i = 0; i < num_threads; i++) {
-        delete ioArr[i];
-#if !USE_CHEETAH
-        delete otpackArr[i];
+    for (int lane = kLanes - 1; lane >= 0; lane--) {
+        EnterLane(lane);
+        // Only lane 0 has bit-triple pools (see kTriplePoolCmps). Their
+        // refill threads run on the pools' own channels and OT packs.
+        for (int i = 0; i < num_threads; i++) {
+            TriplePool<sci::NetIO> *pool = triplePoolArr[i];
+            if (pool == nullptr) continue;
+            pool->stop();
+            sci::NetIO *pool_io = pool->io();
+#if USE_CHEETAH
+            // Only with a state store, as for the lanes below. Destroying
+            // the pack publishes its claimed pre-OT states back to the store.
+            if (!kOTStateDir.empty()) delete pool->otpack();
+#else
+            delete pool->otpack();
 #endif
-        delete auxArr[i];
-        delete xtArr[i];
-        delete truncationArr[i];
-        delete multArr[i];
-        delete mathArr[i];
-    }
+            delete pool;
+            delete pool_io;
+            triplePoolArr[i] = nullptr;
+        }
+        for (int i = 0; i < num_threads; i++) {
 #if USE_CHEETAH
-    // TODO(juhou): fix pre_ot_file
-    delete otpackArr[0];
+            // Only with a state store: the others share the PRE_OT_DATA_*
+            // files.
+            if ((lane > 0 || i > 0) && !kOTStateDir.empty()) {
+                delete otpackArr[i];
+            }
+#else
+            delete otpackArr[i];
 #endif
+            delete auxArr[i];
+            delete xtArr[i];
+            delete truncationArr[i];
+            delete multArr[i];
+            delete mathArr[i];
+        }
+#if USE_CHEETAH
+        if (lane == 0) delete otpackArr[0];
+#endif
+        // The OTPacks send nothing when destroyed, but close the channels
+        // last.
+        for (int i = 0; i < num_threads; i++) {
+            delete ioArr[i];
+        }
 
 #if USE_CHEETAH
-    delete cheetah_linear;
+        delete cheetah_linear;
 #endif
+    }
 }
 
 void reconstruct(int64_t *A, int64_t *B, int32_t I, int32_t J, int bwA) {
@@ -497,7 +528,7 @@ void MulCir(
     int lnum_threads = chunks_per_thread.size();
     std::thread threads[lnum_threads];
     for (int i = 0; i < lnum_threads; i++) {
-        threads[i] = std::thread(
+        threads[i] = LaneThread(
             MulCir_thread, i, A + offset, B + offset, C + offset,
             chunks_per_thread[i], bwA, bwB, bwC, bwTemp, shiftA, shiftB,
             shift_demote
@@ -658,7 +689,7 @@ void MatMul(
     std::thread threads[lnum_threads];
     for (int i = 0; i < lnum_threads; i++) {
         MultMode mode = (i & 1 ? MultMode::Bob_has_B : MultMode::Alice_has_B);
-        threads[i] = std::thread(
+        threads[i] = LaneThread(
             MatMul_thread, i, A + (K * offset), B, C + (J * offset),
             chunks_per_thread[i], K, J, bwA, bwB, bwC, bwTemp, shiftA, shiftB,
             H1, shift_demote, mode
@@ -817,7 +848,7 @@ void Sigmoid(
     int lnum_threads = chunks_per_thread.size();
     std::thread threads[lnum_threads];
     for (int i = 0; i < lnum_threads; i++) {
-        threads[i] = std::thread(
+        threads[i] = LaneThread(
             Sigmoid_thread, i, A + offset, B + offset, chunks_per_thread[i],
             bwA, bwB, s_A, s_B
         );
@@ -911,7 +942,7 @@ void TanH(
     int lnum_threads = chunks_per_thread.size();
     std::thread threads[lnum_threads];
     for (int i = 0; i < lnum_threads; i++) {
-        threads[i] = std::thread(
+        threads[i] = LaneThread(
             TanH_thread, i, A + offset, B + offset, chunks_per_thread[i], bwA,
             bwB, s_A, s_B
         );
@@ -1002,7 +1033,7 @@ void Sqrt(
     int lnum_threads = chunks_per_thread.size();
     std::thread threads[lnum_threads];
     for (int i = 0; i < lnum_threads; i++) {
-        threads[i] = std::thread(
+        threads[i] = LaneThread(
             Sqrt_thread, i, A + offset, B + offset, chunks_per_thread[i], bwA,
             bwB, s_A, s_B, inverse
         );
@@ -1050,6 +1081,238 @@ void Sqrt(
 #endif
 }
 
+void Softmax_thread(
+    int32_t tid,
+    uint64_t *A,
+    uint64_t *B,
+    int32_t rows,
+    int32_t cols,
+    int32_t bwA,
+    int32_t bwB,
+    int32_t sA,
+    int32_t sB
+) {
+    mathArr[tid]->softmax(rows, cols, A, B, bwA, bwB, sA, sB);
+}
+
+void Softmax(
+    int64_t I,
+    int64_t J,
+    int64_t scale_in,
+    int64_t scale_out,
+    int64_t bwA,
+    int64_t bwB,
+    uint64_t *A,
+    uint64_t *B
+) {
+#ifdef LOG_LAYERWISE
+    std::cout << ctr++ << ". Softmax (" << I << " x " << J << ")" << std::endl;
+    INIT_TIMER;
+    INIT_ALL_IO_DATA_SENT;
+#endif
+    int32_t s_A = log2(scale_in);
+    int32_t s_B = log2(scale_out);
+
+    // Whole rows per thread
+    int min_chunk_size = ceil(THREADING_MIN_CHUNK_SIZE / double(J));
+    std::vector<int> chunks_per_thread =
+        divide_instances(::num_threads, I, min_chunk_size);
+
+    int offset = 0;
+    int lnum_threads = chunks_per_thread.size();
+    std::thread threads[lnum_threads];
+    for (int i = 0; i < lnum_threads; i++) {
+        threads[i] = LaneThread(
+            Softmax_thread, i, A + offset * J, B + offset * J,
+            chunks_per_thread[i], J, bwA, bwB, s_A, s_B
+        );
+        offset += chunks_per_thread[i];
+    }
+    for (int i = 0; i < lnum_threads; ++i) {
+        threads[i].join();
+    }
+
+#ifdef LOG_LAYERWISE
+    auto temp = TIMER_TILL_NOW;
+    std::cout << "Time in sec for current Softmax = " << (temp / 1000.0)
+              << std::endl;
+#endif
+}
+
+void LayerNorm_thread(
+    int32_t tid,
+    uint64_t *A,
+    uint64_t *B,
+    int32_t rows,
+    int32_t cols,
+    int32_t bwA,
+    int32_t bwB,
+    int32_t sA,
+    int32_t sB
+) {
+    mathArr[tid]->layer_norm(rows, cols, A, B, bwA, bwB, sA, sB);
+}
+
+void LayerNorm(
+    int64_t I,
+    int64_t J,
+    int64_t scale_in,
+    int64_t scale_out,
+    int64_t bwA,
+    int64_t bwB,
+    uint64_t *A,
+    uint64_t *B
+) {
+#ifdef LOG_LAYERWISE
+    std::cout << ctr++ << ". LayerNorm (" << I << " x " << J << ")"
+              << std::endl;
+    INIT_TIMER;
+    INIT_ALL_IO_DATA_SENT;
+#endif
+    int32_t s_A = log2(scale_in);
+    int32_t s_B = log2(scale_out);
+
+    // Whole rows per thread
+    int min_chunk_size = ceil(THREADING_MIN_CHUNK_SIZE / double(J));
+    std::vector<int> chunks_per_thread =
+        divide_instances(::num_threads, I, min_chunk_size);
+
+    int offset = 0;
+    int lnum_threads = chunks_per_thread.size();
+    std::thread threads[lnum_threads];
+    for (int i = 0; i < lnum_threads; i++) {
+        threads[i] = LaneThread(
+            LayerNorm_thread, i, A + offset * J, B + offset * J,
+            chunks_per_thread[i], J, bwA, bwB, s_A, s_B
+        );
+        offset += chunks_per_thread[i];
+    }
+    for (int i = 0; i < lnum_threads; ++i) {
+        threads[i].join();
+    }
+
+#ifdef LOG_LAYERWISE
+    auto temp = TIMER_TILL_NOW;
+    std::cout << "Time in sec for current LayerNorm = " << (temp / 1000.0)
+              << std::endl;
+#endif
+}
+
+void GELU_thread(
+    int32_t tid,
+    uint64_t *A,
+    uint64_t *B,
+    int32_t dim,
+    int32_t bwA,
+    int32_t bwB,
+    int32_t sA,
+    int32_t sB
+) {
+    mathArr[tid]->gelu(dim, A, B, bwA, bwB, sA, sB);
+}
+
+void GELU(
+    int64_t I,
+    int64_t J,
+    int64_t scale_in,
+    int64_t scale_out,
+    int64_t bwA,
+    int64_t bwB,
+    uint64_t *A,
+    uint64_t *B
+) {
+#ifdef LOG_LAYERWISE
+    std::cout << ctr++ << ". GELU (" << I << " x " << J << ")" << std::endl;
+    INIT_TIMER;
+    INIT_ALL_IO_DATA_SENT;
+#endif
+    int32_t s_A = log2(scale_in);
+    int32_t s_B = log2(scale_out);
+
+    int min_chunk_size = THREADING_MIN_CHUNK_SIZE;
+    std::vector<int> chunks_per_thread =
+        divide_instances(::num_threads, I * J, min_chunk_size);
+
+    int offset = 0;
+    int lnum_threads = chunks_per_thread.size();
+    std::thread threads[lnum_threads];
+    for (int i = 0; i < lnum_threads; i++) {
+        threads[i] = LaneThread(
+            GELU_thread, i, A + offset, B + offset, chunks_per_thread[i], bwA,
+            bwB, s_A, s_B
+        );
+        offset += chunks_per_thread[i];
+    }
+    for (int i = 0; i < lnum_threads; ++i) {
+        threads[i].join();
+    }
+
+#ifdef LOG_LAYERWISE
+    auto temp = TIMER_TILL_NOW;
+    std::cout << "Time in sec for current GELU = " << (temp / 1000.0)
+              << std::endl;
+#endif
+}
+
+void Spline_thread(
+    int32_t tid,
+    uint64_t *A,
+    uint64_t *B,
+    int32_t dim,
+    int32_t bwA,
+    int32_t bwB,
+    int32_t sA,
+    int32_t sB,
+    const PiecewisePoly *pp
+) {
+    mathArr[tid]->piecewise_poly(dim, A, B, bwA, bwB, sA, sB, *pp);
+}
+
+void Spline(
+    int64_t I,
+    int64_t J,
+    int64_t scale_in,
+    int64_t scale_out,
+    int64_t bwA,
+    int64_t bwB,
+    const PiecewisePoly &pp,
+    uint64_t *A,
+    uint64_t *B
+) {
+#ifdef LOG_LAYERWISE
+    std::cout << ctr++ << ". Spline (" << I << " x " << J << ", "
+              << pp.num_segments() << " segments)" << std::endl;
+    INIT_TIMER;
+    INIT_ALL_IO_DATA_SENT;
+#endif
+    int32_t s_A = log2(scale_in);
+    int32_t s_B = log2(scale_out);
+
+    int min_chunk_size = THREADING_MIN_CHUNK_SIZE;
+    std::vector<int> chunks_per_thread =
+        divide_instances(::num_threads, I * J, min_chunk_size);
+
+    int offset = 0;
+    int lnum_threads = chunks_per_thread.size();
+    std::thread threads[lnum_threads];
+    for (int i = 0; i < lnum_threads; i++) {
+        threads[i] = LaneThread(
+            Spline_thread, i, A + offset, B + offset, chunks_per_thread[i],
+            bwA, bwB, s_A, s_B, &pp
+        );
+        offset += chunks_per_thread[i];
+    }
+    for (int i = 0; i < lnum_threads; ++i) {
+        threads[i].join();
+    }
+
+#ifdef LOG_LAYERWISE
+    auto temp = TIMER_TILL_NOW;
+    std::cout << "Time in sec for current Spline = " << (temp / 1000.0)
+              << std::endl;
+#endif
+}
+
 void Exp(
     uint64_t *A,
     uint64_t *B,
@@ -1318,7 +1581,7 @@ void Convolution(
     for (int i = 0; i < lnum_threads; i++) {
         MultMode mode = (i & 1 ? MultMode::Bob_has_A : MultMode::Alice_has_A);
         if (G > 1) {
-            threads[i] = std::thread(
+            threads[i] = LaneThread(
                 GroupedMatMul_thread, i,
                 Filter + (offset * COUTF * HF * WF * CINF),
                 Image + (offset * reshaped_image_size),
@@ -1327,7 +1590,7 @@ void Convolution(
                 bwC, bwTemp, shiftB, shiftA, H1, H2, shift_demote, mode
             );
         } else {
-            threads[i] = std::thread(
+            threads[i] = LaneThread(
                 GroupedMatMul_thread, i, Filter + (offset * HF * WF * CINF),
                 Image, Output + (offset * N * HOUT * WOUT),
                 chunks_per_thread[i], HF * WF * CINF, N * HOUT * WOUT, 1, bwB,
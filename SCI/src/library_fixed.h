@@ -691,6 +691,56 @@ void Sqrt(
     uint64_t *B
 );
 
+// Row-wise over the J columns of each of the I rows; see MathFunctions.
+void Softmax(
+    int64_t I,
+    int64_t J,
+    int64_t scale_in,
+    int64_t scale_out,
+    int64_t bwA,
+    int64_t bwB,
+    uint64_t *A,
+    uint64_t *B
+);
+
+// Without the affine transform; bwB <= bwA.
+void LayerNorm(
+    int64_t I,
+    int64_t J,
+    int64_t scale_in,
+    int64_t scale_out,
+    int64_t bwA,
+    int64_t bwB,
+    uint64_t *A,
+    uint64_t *B
+);
+
+// x * sigmoid(1.702 * x)
+void GELU(
+    int64_t I,
+    int64_t J,
+    int64_t scale_in,
+    int64_t scale_out,
+    int64_t bwA,
+    int64_t bwB,
+    uint64_t *A,
+    uint64_t *B
+);
+
+// pp: segment table of scale log2(scale_in), e.g., PiecewisePoly::load of a
+// table fitted offline. Both parties MUST use the same table.
+void Spline(
+    int64_t I,
+    int64_t J,
+    int64_t scale_in,
+    int64_t scale_out,
+    int64_t bwA,
+    int64_t bwB,
+    const PiecewisePoly &pp,
+    uint64_t *A,
+    uint64_t *B
+);
+
 void reconstruct(int64_t *A, int64_t *B, int32_t I, int32_t J, int bwA);
 
 // template<class int64_t>
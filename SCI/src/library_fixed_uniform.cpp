@@ -26,6 +26,7 @@ SOFTWARE.
 #include "functionalities_uniform.h"
 #include "globals.h"
 #include "library_fixed_common.h"
+#include "utils/ring-ops.h"
 
 #define LOG_LAYERWISE
 #define VERIFY_LAYERWISE
@@ -40,6 +41,149 @@ uint64_t moduloMask = prime_mod - 1;
 uint64_t moduloMidPt = prime_mod / 2;
 #endif
 
+#if USE_CHEETAH
+static sci::OTStateStore *otStateStore = nullptr;
+#endif
+
+#ifdef SCI_OT
+// Account the bit-triples consumed by the following comparisons to `layer`.
+static void setTriplePoolLayer(const std::string &layer) {
+    // Only lane 0 has pools.
+    if (kTriplePoolCmps <= 0 || triplePoolArr[0] == nullptr) return;
+    for (int i = 0; i < num_threads; i++) {
+        triplePoolArr[i]->set_layer(layer);
+    }
+}
+
+static void attachTriplePool(AuxProtocols *a, TriplePool<sci::NetIO> *pool) {
+    a->mill->triple_pool = pool;
+    a->mill_and_eq->mill->triple_pool = pool;
+}
+
+static void useBitSlicedCmp(AuxProtocols *a) {
+    a->mill->bit_sliced = true;
+    a->mill_and_eq->mill->bit_sliced = true;
+}
+
+// The comparisons of the ReLU (and thus MaxPool and ArgMax) and truncation
+// layers of the calling lane, see kBitSlicedCmp.
+static void setupBitSlicedCmp() {
+    auto relu_0 = static_cast<ReLURingProtocol<sci::NetIO, intType> *>(relu);
+    relu_0->millionaire->bit_sliced = true;
+    useBitSlicedCmp(relu_0->aux);
+    for (int i = 0; i < num_threads; i++) {
+        auto relu_i = static_cast<ReLURingProtocol<sci::NetIO, intType> *>(
+            reluArr[i]
+        );
+        relu_i->millionaire->bit_sliced = true;
+        useBitSlicedCmp(relu_i->aux);
+        useBitSlicedCmp(auxArr[i]);
+    }
+}
+
+static void setupTriplePools(int64_t expected_cmps) {
+    const int64_t per_thread_cmps =
+        (expected_cmps + num_threads - 1) / num_threads;
+    const int64_t num_triples =
+        per_thread_cmps *
+        TriplePool<sci::NetIO>::triples_per_cmp(bitlength, MILL_PARAM);
+#if USE_CHEETAH
+    const TripleGenMethod method = _2ROT;
+#else
+    const TripleGenMethod method = _16KKOT_to_4OT;
+#endif
+    // The array is this thread's.
+    TriplePool<sci::NetIO> **pools = triplePoolArr;
+    std::cout << "Generating " << num_triples << " bit-triples per thread for "
+              << expected_cmps << " comparisons" << std::endl;
+    // Each pool refills in the background on its own channel and OT pack, on
+    // the ports after the ones of the lanes. The threads fill them in
+    // parallel.
+    std::vector<std::thread> fillThreads;
+    for (int i = 0; i < num_threads; i++) {
+        fillThreads.emplace_back([=]() {
+            const int slot = MAX_LANES * MAX_THREADS + i;
+            const int role = (i & 1) ? 3 - party : party;
+            auto pool_io = new sci::NetIO(
+                party == sci::ALICE ? nullptr : address.c_str(), port + slot,
+                /*quit*/ true
+            );
+#if USE_CHEETAH
+            auto pool_otpack = new sci::OTPack<sci::NetIO>(
+                pool_io, role, true, otStateStore, slot
+            );
+#else
+            auto pool_otpack = new sci::OTPack<sci::NetIO>(pool_io, role);
+#endif
+            auto pool = new TriplePool<sci::NetIO>(
+                role, pool_io, pool_otpack, method, /*background*/ true
+            );
+            pool->fill(num_triples);
+            // Top up with 1/4 of the initial size once 1/4 is left.
+            const int64_t refill =
+                std::max<int64_t>(num_triples / 4, 1LL << 16);
+            pool->set_watermark(refill, refill);
+            pools[i] = pool;
+        });
+    }
+    for (auto &t : fillThreads) t.join();
+    for (int i = 0; i < num_threads; i++) {
+        auto pool = pools[i];
+        auto relu_i = static_cast<ReLURingProtocol<sci::NetIO, intType> *>(
+            reluArr[i]
+        );
+        relu_i->millionaire->triple_pool = pool;
+        attachTriplePool(relu_i->aux, pool);
+        attachTriplePool(auxArr[i], pool);
+        truncationArr[i]->mill_eq->mill->triple_pool = pool;
+    }
+
+    // The single-threaded instances share the pool of thread 0.
+    auto relu_0 = static_cast<ReLURingProtocol<sci::NetIO, intType> *>(relu);
+    relu_0->millionaire->triple_pool = triplePoolArr[0];
+    attachTriplePool(relu_0->aux, triplePoolArr[0]);
+}
+#endif
+
+// Reveals the input of a ReLU/truncation layer to the client, where it is
+// recorded by the cleartext layer. Only for the offline calibration run.
+static void calibrateLayer(
+    const std::string &layer,
+    int32_t size,
+    const intType *inArr,
+    int sf,
+    bool isRelu,
+    bool doTruncation
+) {
+    if (party == SERVER) {
+        funcReconstruct2PCCons(nullptr, inArr, size);
+        return;
+    }
+    signedIntType *VinArr = new signedIntType[size];
+    funcReconstruct2PCCons(VinArr, inArr, size);
+    std::vector<uint64_t> VinVec(size);
+    for (int i = 0; i < size; i++) {
+        VinVec[i] = getRingElt(VinArr[i]);
+    }
+    bitwidthCalibrator->set_layer(layer);
+    if (isRelu) {
+        std::vector<uint64_t> VoutVec(size);
+        Relu_pt(size, VinVec, VoutVec, sf, doTruncation);
+    } else {
+        ScaleDown_pt(size, VinVec, sf);
+    }
+    delete[] VinArr;
+}
+
+// Bytes sent by this party so far, over all the threads.
+static uint64_t sentBytes() {
+    uint64_t bytes = 0;
+    for (int i = 0; i < num_threads; i++) {
+        bytes += ioArr[i]->counter;
+    }
+    return bytes;
+}
+
 #if !USE_CHEETAH
 void MatMul2D(
     int32_t s1,
@@ -136,7 +280,7 @@ void MatMul2D(
     std::thread matmulThreads[required_num_threads];
     for (int i = 0; i < required_num_threads; i++) {
         C_ans_arr[i] = new intType[s1 * s3];
-        matmulThreads[i] = std::thread(
+        matmulThreads[i] = LaneThread(
             funcMatmulThread, i, required_num_threads, s1, s2, s3, (intType *)A,
             (intType *)B, (intType *)C_ans_arr[i], partyWithAInAB_mul
         );
@@ -174,11 +318,7 @@ void MatMul2D(
 #endif
     }
 #endif
-    intType moduloMask = (1ULL << bitlength) - 1;
-    if (bitlength == 64) moduloMask = -1;
-    for (int i = 0; i < s1 * s3; i++) {
-        C[i] = C[i] & moduloMask;
-    }
+    sci::ring_reduce(s1 * s3, C, sci::all1Mask(bitlength));
 
 #elif defined(SCI_HE)
     // We only support matrix vector multiplication.
@@ -186,28 +326,9 @@ void MatMul2D(
         modelIsA == false &&
         "Assuming code generated by compiler produces B as the model."
     );
-    std::vector<std::vector<intType>> At(s2);
-    std::vector<std::vector<intType>> Bt(s3);
-    std::vector<std::vector<intType>> Ct(s3);
-    for (int i = 0; i < s2; i++) {
-        At[i].resize(s1);
-        for (int j = 0; j < s1; j++) {
-            At[i][j] = getRingElt(Arr2DIdxRowM(A, s1, s2, j, i));
-        }
-    }
-    for (int i = 0; i < s3; i++) {
-        Bt[i].resize(s2);
-        Ct[i].resize(s1);
-        for (int j = 0; j < s2; j++) {
-            Bt[i][j] = getRingElt(Arr2DIdxRowM(B, s2, s3, j, i));
-        }
-    }
-    he_fc->matrix_multiplication(s3, s2, s1, Bt, At, Ct);
-    for (int i = 0; i < s1; i++) {
-        for (int j = 0; j < s3; j++) {
-            Arr2DIdxRowM(C, s1, s3, i, j) = getRingElt(Ct[j][i]);
-        }
-    }
+    assert(s1 == 1);
+    // C^T = B^T * A^T: B^T is read in place as a strided view of B.
+    he_fc->matrix_multiplication(s3, s2, B, 1, s3, A, C);
 #endif
 
 #ifdef LOG_LAYERWISE
@@ -362,11 +483,11 @@ void Conv2DWrapper(
     INIT_TIMER;
 #endif
 
-    static int ctr = 1;
-    std::cout << "Conv2DCSF " << ctr << " called N=" << N << ", H=" << H
+    static std::atomic<int> ctr{1};
+    const int layerId = layerNumber(ctr);
+    std::cout << "Conv2DCSF " << layerId << " called N=" << N << ", H=" << H
               << ", W=" << W << ", CI=" << CI << ", FH=" << FH << ", FW=" << FW
               << ", CO=" << CO << ", S=" << strideH << std::endl;
-    ctr++;
 
     signedIntType newH = (((H + (zPadHLeft + zPadHRight) - FH) / strideH) + 1);
     signedIntType newW = (((W + (zPadWLeft + zPadWRight) - FW) / strideW) + 1);
@@ -382,70 +503,14 @@ void Conv2DWrapper(
 
 #ifdef SCI_HE
     // If its a field, then its a HE based -- use the HE based conv
-    // implementation
-    std::vector<std::vector<std::vector<std::vector<intType>>>> inputVec;
-    inputVec.resize(
-        N,
-        std::vector<std::vector<std::vector<intType>>>(
-            H, std::vector<std::vector<intType>>(W, std::vector<intType>(CI, 0))
-        )
-    );
-
-    std::vector<std::vector<std::vector<std::vector<intType>>>> filterVec;
-    filterVec.resize(
-        FH,
-        std::vector<std::vector<std::vector<intType>>>(
-            FW,
-            std::vector<std::vector<intType>>(CI, std::vector<intType>(CO, 0))
-        )
-    );
-
-    std::vector<std::vector<std::vector<std::vector<intType>>>> outputVec;
-    outputVec.resize(
-        N,
-        std::vector<std::vector<std::vector<intType>>>(
-            newH,
-            std::vector<std::vector<intType>>(newW, std::vector<intType>(CO, 0))
-        )
-    );
-
-    for (int i = 0; i < N; i++) {
-        for (int j = 0; j < H; j++) {
-            for (int k = 0; k < W; k++) {
-                for (int p = 0; p < CI; p++) {
-                    inputVec[i][j][k][p] = getRingElt(
-                        Arr4DIdxRowM(inputArr, N, H, W, CI, i, j, k, p)
-                    );
-                }
-            }
-        }
-    }
-    for (int i = 0; i < FH; i++) {
-        for (int j = 0; j < FW; j++) {
-            for (int k = 0; k < CI; k++) {
-                for (int p = 0; p < CO; p++) {
-                    filterVec[i][j][k][p] = getRingElt(
-                        Arr4DIdxRowM(filterArr, FH, FW, CI, CO, i, j, k, p)
-                    );
-                }
-            }
-        }
-    }
-
-    he_conv->convolution(
-        N, H, W, CI, FH, FW, CO, zPadHLeft, zPadHRight, zPadWLeft, zPadWRight,
-        strideH, strideW, inputVec, filterVec, outputVec
-    );
-
+    // implementation. The NHWC/HWIO arrays are handed over as they are; the
+    // reduction to the field is done by ConvField.
     for (int i = 0; i < N; i++) {
-        for (int j = 0; j < newH; j++) {
-            for (int k = 0; k < newW; k++) {
-                for (int p = 0; p < CO; p++) {
-                    Arr4DIdxRowM(outArr, N, newH, newW, CO, i, j, k, p) =
-                        getRingElt(outputVec[i][j][k][p]);
-                }
-            }
-        }
+        he_conv->convolution(
+            1, H, W, CI, FH, FW, CO, zPadHLeft, zPadHRight, zPadWLeft,
+            zPadWRight, strideH, strideW, inputArr + i * H * W * CI, filterArr,
+            outArr + i * newH * newW * CO
+        );
     }
 
 #endif
@@ -572,6 +637,7 @@ void Conv2DWrapper(
 }
 #endif
 
+#if !USE_CHEETAH
 #ifdef SCI_OT
 void Conv2DGroup(
     int32_t N,
@@ -618,11 +684,12 @@ void Conv2DGroupWrapper(
     INIT_TIMER;
 #endif
 
-    static int ctr = 1;
-    std::cout << "Conv2DGroupCSF " << ctr << " called N=" << N << ", H=" << H
-              << ", W=" << W << ", CI=" << CI << ", FH=" << FH << ", FW=" << FW
-              << ", CO=" << CO << ", S=" << strideH << ",G=" << G << std::endl;
-    ctr++;
+    static std::atomic<int> ctr{1};
+    const int layerId = layerNumber(ctr);
+    std::cout << "Conv2DGroupCSF " << layerId << " called N=" << N
+              << ", H=" << H << ", W=" << W << ", CI=" << CI << ", FH=" << FH
+              << ", FW=" << FW << ", CO=" << CO << ", S=" << strideH
+              << ",G=" << G << std::endl;
 
 #ifdef SCI_OT
     // If its a ring, then its a OT based -- use the default Conv2DGroupCSF
@@ -653,6 +720,7 @@ void Conv2DGroupWrapper(
     ConvCommSent += curComm;
 #endif
 }
+#endif  // !USE_CHEETAH
 
 #if !USE_CHEETAH
 void ElemWiseActModelVectorMult(
@@ -703,7 +771,7 @@ void ElemWiseActModelVectorMult(
             curSize = chunk_size;
         }
         */
-        dotProdThreads[i] = std::thread(
+        dotProdThreads[i] = LaneThread(
             funcDotProdThread, i, num_threads, curSize, multArrVec + offset,
             inArr + offset, outputArr + offset, false
         );
@@ -732,20 +800,7 @@ void ElemWiseActModelVectorMult(
 #endif  // SCI_OT
 
 #ifdef SCI_HE
-    std::vector<uint64_t> tempInArr(size);
-    std::vector<uint64_t> tempOutArr(size);
-    std::vector<uint64_t> tempMultArr(size);
-
-    for (int i = 0; i < size; i++) {
-        tempInArr[i] = getRingElt(inArr[i]);
-        tempMultArr[i] = getRingElt(multArrVec[i]);
-    }
-
-    he_prod->elemwise_product(size, tempInArr, tempMultArr, tempOutArr);
-
-    for (int i = 0; i < size; i++) {
-        outputArr[i] = getRingElt(tempOutArr[i]);
-    }
+    he_prod->elemwise_product(size, inArr, multArrVec, outputArr);
 #endif
 
 #ifdef LOG_LAYERWISE
@@ -814,10 +869,10 @@ void ArgMax(int32_t s1, int32_t s2, intType *inArr, intType *outArr) {
     INIT_TIMER;
 #endif
 
-    static int ctr = 1;
-    std::cout << "ArgMax " << ctr << " called, s1=" << s1 << ", s2=" << s2
+    static std::atomic<int> ctr{1};
+    const int layerId = layerNumber(ctr);
+    std::cout << "ArgMax " << layerId << " called, s1=" << s1 << ", s2=" << s2
               << std::endl;
-    ctr++;
 
     assert(s1 == 1 && "ArgMax impl right now assumes s1==1");
     argmax->ArgMaxMPC(s2, inArr, outArr);
@@ -882,12 +937,36 @@ void Relu(
     INIT_TIMER;
 #endif
 
-    static int ctr = 1;
+    static std::atomic<int> ctr{1};
+    const int layerId = layerNumber(ctr);
+    const std::string layer = "relu." + std::to_string(layerId);
+#ifdef SCI_OT
+    setTriplePoolLayer("Relu #" + std::to_string(layerId));
+#endif
     printf(
-        "Relu #%d on %d points, truncate=%d by %d bits\n", ctr++, size,
+        "Relu #%d on %d points, truncate=%d by %d bits\n", layerId, size,
         doTruncation, sf
     );
-    ctr++;
+
+    LayerBitwidth layerBw;
+    int32_t boundBits = -1;
+#ifdef SCI_OT
+    if (bitwidthCalibrator != nullptr) {
+        calibrateLayer(layer, size, inArr, sf, true, doTruncation);
+    }
+    if (bitwidthConfig != nullptr && bitwidthConfig->find(layer) != nullptr) {
+        layerBw = *bitwidthConfig->find(layer);
+        boundBits = bitlength - layerBw.drop_hi - 1;
+    }
+#endif
+    // Mixed bitwidths: the ReLU (and truncation) run over Z_{2^ringBits},
+    // and the output is extended back to the global ring.
+    const int32_t ringBits = (layerBw.ring > 0 && layerBw.ring < bitlength)
+                                 ? layerBw.ring
+                                 : bitlength;
+    const intType ringMask = sci::all1Mask(ringBits);
+    const bool localTrunc = doTruncation && localTruncation != nullptr &&
+                            localTruncation->allows(boundBits, ringBits);
 
     intType moduloMask = sci::all1Mask(bitlength);
     int eightDivElemts = ((size + 8 - 1) / 8) * 8;  //(ceil of s1*s2/8.0)*8
@@ -895,6 +974,17 @@ void Relu(
     intType *tempInp = new intType[eightDivElemts];
     intType *tempOutp = new intType[eightDivElemts];
     sci::copyElemWisePadded(size, inArr, eightDivElemts, tempInp, 0);
+#ifdef SCI_OT
+    if (ringBits < bitlength) {
+        sci::ring_reduce(eightDivElemts, tempInp, ringMask);
+    }
+#endif
+#ifndef VERIFY_LAYERWISE
+    // inArr is not read past this point, so outArr may reuse its memory.
+    if (activationPlanner != nullptr) {
+        activationPlanner->note_inplace(inArr, outArr);
+    }
+#endif
 
 // #ifndef MULTITHREADED_NONLIN
 #if 0
@@ -910,9 +1000,10 @@ void Relu(
         } else {
             lnum_relu = chunk_size;
         }
-        relu_threads[i] = std::thread(
+        relu_threads[i] = LaneThread(
             funcReLUThread, i, tempOutp + offset, tempInp + offset, lnum_relu,
-            nullptr, false, doTruncation, /*approx*/ true
+            nullptr, false, doTruncation, /*approx*/ true, layerBw.drop_lo,
+            layerBw.drop_hi, ringBits
         );
     }
     for (int i = 0; i < num_threads; ++i) {
@@ -941,20 +1032,38 @@ void Relu(
 
         intType *tempTruncOutp = new intType[eightDivElemts];
 #ifdef SCI_OT
-        for (int i = 0; i < eightDivElemts; i++) {
-            tempOutp[i] = tempOutp[i] & moduloMask;
-        }
+        sci::ring_reduce(eightDivElemts, tempOutp, ringMask);
 
+        if (localTrunc) {
+            LocalTruncation::truncate(
+                party == SERVER, eightDivElemts, tempOutp, tempTruncOutp, sf,
+                ringMask
+            );
+            localTruncation->add_local(true, size, boundBits, ringBits);
+        } else {
+            const uint64_t bytesBefore = sentBytes();
 #if USE_CHEETAH == 0
-        funcTruncateTwoPowerRingWrapper(
-            eightDivElemts, tempOutp, tempTruncOutp, sf, bitlength, true,
-            msbShare
-        );
+            funcTruncateTwoPowerRingWrapper(
+                eightDivElemts, tempOutp, tempTruncOutp, sf, ringBits, true,
+                msbShare
+            );
 #else
-        funcReLUTruncateTwoPowerRingWrapper(
-            eightDivElemts, tempOutp, tempTruncOutp, sf, bitlength, true
-        );
+            funcReLUTruncateTwoPowerRingWrapper(
+                eightDivElemts, tempOutp, tempTruncOutp, sf, ringBits, true
+            );
 #endif
+            if (localTruncation != nullptr) {
+                localTruncation->add_fallback(
+                    true, size, sentBytes() - bytesBefore
+                );
+            }
+        }
+        if (ringBits < bitlength) {
+            funcExtendRingWrapper(
+                eightDivElemts, tempTruncOutp, tempTruncOutp, ringBits,
+                bitlength, /*nonNegative*/ true
+            );
+        }
 
 #else
         funcFieldDivWrapper<intType>(
@@ -972,15 +1081,22 @@ void Relu(
         TruncationCommSent += curComm;
 #endif
     } else {
+#ifdef SCI_OT
+        if (ringBits < bitlength) {
+            sci::ring_reduce(eightDivElemts, tempOutp, ringMask);
+            funcExtendRingWrapper(
+                eightDivElemts, tempOutp, tempOutp, ringBits, bitlength,
+                /*nonNegative*/ true
+            );
+        }
+#endif
         for (int i = 0; i < size; i++) {
             outArr[i] = tempOutp[i];
         }
     }
 
 #ifdef SCI_OT
-    for (int i = 0; i < size; i++) {
-        outArr[i] = outArr[i] & moduloMask;
-    }
+    sci::ring_reduce(size, outArr, moduloMask);
 #endif
 
 #ifdef VERIFY_LAYERWISE
@@ -1032,7 +1148,7 @@ void Relu(
 #if USE_CHEETAH
         constexpr signedIntType error_upper = 1;
 #else
-        constexpr signedIntType error_upper = 0;
+        const signedIntType error_upper = localTrunc ? 1 : 0;
 #endif
         for (int i = 0; i < size; i++) {
             if (std::abs(VoutArr[i] - getSignedVal(VoutVec[i])) > error_upper) {
@@ -1082,11 +1198,14 @@ void MaxPool(
     INIT_TIMER;
 #endif
 
-    static int ctr = 1;
-    std::cout << "Maxpool " << ctr << " called N=" << N << ", H=" << H
+    static std::atomic<int> ctr{1};
+    const int layerId = layerNumber(ctr);
+#ifdef SCI_OT
+    setTriplePoolLayer("Maxpool #" + std::to_string(layerId));
+#endif
+    std::cout << "Maxpool " << layerId << " called N=" << N << ", H=" << H
               << ", W=" << W << ", C=" << C << ", ksizeH=" << ksizeH
               << ", ksizeW=" << ksizeW << std::endl;
-    ctr++;
 
     uint64_t moduloMask = sci::all1Mask(bitlength);
     int rowsOrig = N * H * W * C;
@@ -1097,6 +1216,12 @@ void MaxPool(
     intType *maxi = new intType[rows];
     intType *maxiIdx = new intType[rows];
 
+    // Strides of the input activation, either NHWC or NCHW.
+    const int64_t inStrideN = (int64_t)imgH * imgW * C;
+    const int64_t inStrideC = kActivationCHW ? (int64_t)imgH * imgW : 1;
+    const int64_t inStrideH = kActivationCHW ? imgW : (int64_t)imgW * C;
+    const int64_t inStrideW = kActivationCHW ? 1 : C;
+
     int rowIdx = 0;
     for (int n = 0; n < N; n++) {
         for (int c = 0; c < C; c++) {
@@ -1121,10 +1246,9 @@ void MaxPool(
                                  ((curPosW < 0) || (curPosW >= imgW)))) {
                                 temp = 0;
                             } else {
-                                temp = Arr4DIdxRowM(
-                                    inArr, N, imgH, imgW, C, n, curPosH,
-                                    curPosW, c
-                                );
+                                temp = inArr
+                                    [n * inStrideN + c * inStrideC +
+                                     curPosH * inStrideH + curPosW * inStrideW];
                             }
                             reInpArr[finalIdx] = temp;
                         }
@@ -1158,7 +1282,7 @@ void MaxPool(
         } else {
             lnum_rows = chunk_size;
         }
-        maxpool_threads[i] = std::thread(
+        maxpool_threads[i] = LaneThread(
             funcMaxpoolThread, i, lnum_rows, cols, reInpArr + offset * cols,
             maxi + offset, maxiIdx + offset
         );
@@ -1168,13 +1292,18 @@ void MaxPool(
     }
 #endif
 
-    for (int n = 0; n < N; n++) {
-        for (int c = 0; c < C; c++) {
-            for (int h = 0; h < H; h++) {
-                for (int w = 0; w < W; w++) {
-                    int iidx = n * C * H * W + c * H * W + h * W + w;
-                    Arr4DIdxRowM(outArr, N, H, W, C, n, h, w, c) =
-                        getRingElt(maxi[iidx]);
+    // The rows of `maxi` are already in NCHW order.
+    if (kActivationCHW) {
+        std::transform(maxi, maxi + rowsOrig, outArr, getRingElt);
+    } else {
+        for (int n = 0; n < N; n++) {
+            for (int c = 0; c < C; c++) {
+                for (int h = 0; h < H; h++) {
+                    for (int w = 0; w < W; w++) {
+                        int iidx = n * C * H * W + c * H * W + h * W + w;
+                        Arr4DIdxRowM(outArr, N, H, W, C, n, h, w, c) =
+                            getRingElt(maxi[iidx]);
+                    }
                 }
             }
         }
@@ -1216,6 +1345,10 @@ void MaxPool(
         funcReconstruct2PCCons(VinArr, inArr, N * imgH * imgW * C);
         signedIntType *VoutArr = new signedIntType[N * H * W * C];
         funcReconstruct2PCCons(VoutArr, outArr, N * H * W * C);
+        if (kActivationCHW) {
+            NCHWToNHWC(N, imgH, imgW, C, (intType *)VinArr);
+            NCHWToNHWC(N, H, W, C, (intType *)VoutArr);
+        }
 
         std::vector<std::vector<std::vector<std::vector<uint64_t>>>> VinVec;
         VinVec.resize(
@@ -1307,11 +1440,14 @@ void AvgPool(
     INIT_TIMER;
 #endif
 
-    static int ctr = 1;
-    std::cout << "AvgPool " << ctr << " called N=" << N << ", H=" << H
+    static std::atomic<int> ctr{1};
+    const int layerId = layerNumber(ctr);
+#ifdef SCI_OT
+    setTriplePoolLayer("AvgPool #" + std::to_string(layerId));
+#endif
+    std::cout << "AvgPool " << layerId << " called N=" << N << ", H=" << H
               << ", W=" << W << ", C=" << C << ", ksizeH=" << ksizeH
               << ", ksizeW=" << ksizeW << std::endl;
-    ctr++;
 
     uint64_t moduloMask = sci::all1Mask(bitlength);
     int rows = N * H * W * C;
@@ -1319,6 +1455,12 @@ void AvgPool(
     intType *filterSum = new intType[rowsPadded];
     intType *filterAvg = new intType[rowsPadded];
 
+    // Strides of the input activation, either NHWC or NCHW.
+    const int64_t inStrideN = (int64_t)imgH * imgW * C;
+    const int64_t inStrideC = kActivationCHW ? (int64_t)imgH * imgW : 1;
+    const int64_t inStrideH = kActivationCHW ? imgW : (int64_t)imgW * C;
+    const int64_t inStrideW = kActivationCHW ? 1 : C;
+
     int rowIdx = 0;
     for (int n = 0; n < N; n++) {
         for (int c = 0; c < C; c++) {
@@ -1340,10 +1482,9 @@ void AvgPool(
                                  ((curPosW < 0) || (curPosW >= imgW)))) {
                                 temp = 0;
                             } else {
-                                temp = Arr4DIdxRowM(
-                                    inArr, N, imgH, imgW, C, n, curPosH,
-                                    curPosW, c
-                                );
+                                temp = inArr
+                                    [n * inStrideN + c * inStrideC +
+                                     curPosH * inStrideH + curPosW * inStrideW];
                             }
 #ifdef SCI_OT
                             curFilterSum += temp;
@@ -1370,9 +1511,7 @@ void AvgPool(
     }
 
 #ifdef SCI_OT
-    for (int i = 0; i < rowsPadded; i++) {
-        filterSum[i] = filterSum[i] & moduloMask;
-    }
+    sci::ring_reduce(rowsPadded, filterSum, moduloMask);
     funcAvgPoolTwoPowerRingWrapper(
         rowsPadded, filterSum, filterAvg, ksizeH * ksizeW
     );
@@ -1385,18 +1524,21 @@ void AvgPool(
     );
 #endif
 
-    for (int n = 0; n < N; n++) {
-        for (int c = 0; c < C; c++) {
-            for (int h = 0; h < H; h++) {
-                for (int w = 0; w < W; w++) {
-                    int iidx = n * C * H * W + c * H * W + h * W + w;
-                    Arr4DIdxRowM(outArr, N, H, W, C, n, h, w, c) =
-                        filterAvg[iidx];
 #ifdef SCI_OT
-                    Arr4DIdxRowM(outArr, N, H, W, C, n, h, w, c) =
-                        Arr4DIdxRowM(outArr, N, H, W, C, n, h, w, c) &
-                        moduloMask;
+    sci::ring_reduce(rows, filterAvg, moduloMask);
 #endif
+    // The rows of `filterAvg` are already in NCHW order.
+    if (kActivationCHW) {
+        std::copy_n(filterAvg, rows, outArr);
+    } else {
+        for (int n = 0; n < N; n++) {
+            for (int c = 0; c < C; c++) {
+                for (int h = 0; h < H; h++) {
+                    for (int w = 0; w < W; w++) {
+                        int iidx = n * C * H * W + c * H * W + h * W + w;
+                        Arr4DIdxRowM(outArr, N, H, W, C, n, h, w, c) =
+                            filterAvg[iidx];
+                    }
                 }
             }
         }
@@ -1437,6 +1579,10 @@ void AvgPool(
         funcReconstruct2PCCons(VinArr, inArr, N * imgH * imgW * C);
         signedIntType *VoutArr = new signedIntType[N * H * W * C];
         funcReconstruct2PCCons(VoutArr, outArr, N * H * W * C);
+        if (kActivationCHW) {
+            NCHWToNHWC(N, imgH, imgW, C, (intType *)VinArr);
+            NCHWToNHWC(N, H, W, C, (intType *)VoutArr);
+        }
 
         std::vector<std::vector<std::vector<std::vector<uint64_t>>>> VinVec;
         VinVec.resize(
@@ -1504,8 +1650,13 @@ void ScaleDown(int32_t size, intType *inArr, int32_t sf) {
     INIT_ALL_IO_DATA_SENT;
     INIT_TIMER;
 #endif
-    static int ctr = 1;
-    printf("Truncate #%d on %d points by %d bits\n", ctr++, size, sf);
+    static std::atomic<int> ctr{1};
+    const int layerId = layerNumber(ctr);
+    const std::string layer = "trunc." + std::to_string(layerId);
+#ifdef SCI_OT
+    setTriplePoolLayer("Truncate #" + std::to_string(layerId));
+#endif
+    printf("Truncate #%d on %d points by %d bits\n", layerId, size, sf);
 
     int eightDivElemts = ((size + 8 - 1) / 8) * 8;  //(ceil of s1*s2/8.0)*8
     intType *tempInp;
@@ -1518,15 +1669,54 @@ void ScaleDown(int32_t size, intType *inArr, int32_t sf) {
     intType *outp = new intType[eightDivElemts];
 
 #ifdef SCI_OT
-    uint64_t moduloMask = sci::all1Mask(bitlength);
-    for (int i = 0; i < eightDivElemts; i++) {
-        tempInp[i] = tempInp[i] & moduloMask;
+    sci::ring_reduce(eightDivElemts, tempInp, sci::all1Mask(bitlength));
+
+    if (bitwidthCalibrator != nullptr) {
+        calibrateLayer(layer, size, tempInp, sf, false, false);
+    }
+    // The msb0 heuristic assumes |x| < 2^(ring - 3). With a calibrated
+    // bound, use it as the offset, or fall back to the exact truncation.
+    bool msb0Heuristic = true;
+    int32_t boundBits = -1;
+    int32_t ringBits = bitlength;
+    if (bitwidthConfig != nullptr && bitwidthConfig->find(layer) != nullptr) {
+        const LayerBitwidth &bw = *bitwidthConfig->find(layer);
+        boundBits = bitlength - bw.drop_hi - 1;
+        if (bw.ring > 0 && bw.ring < bitlength) {
+            ringBits = bw.ring;
+            sci::ring_reduce(eightDivElemts, tempInp, sci::all1Mask(ringBits));
+        }
+        msb0Heuristic = boundBits <= ringBits - 3;
     }
 
-    funcTruncateTwoPowerRingWrapper(
-        eightDivElemts, tempInp, outp, sf, bitlength, true, nullptr
-    );
+    const bool localTrunc = localTruncation != nullptr &&
+                            localTruncation->allows(boundBits, ringBits);
+    if (localTrunc) {
+        LocalTruncation::truncate(
+            party == SERVER, eightDivElemts, tempInp, outp, sf,
+            sci::all1Mask(ringBits)
+        );
+        localTruncation->add_local(false, size, boundBits, ringBits);
+    } else {
+        const uint64_t bytesBefore = sentBytes();
+        funcTruncateTwoPowerRingWrapper(
+            eightDivElemts, tempInp, outp, sf, ringBits, true, nullptr,
+            msb0Heuristic, boundBits
+        );
+        if (localTruncation != nullptr) {
+            localTruncation->add_fallback(
+                false, size, sentBytes() - bytesBefore
+            );
+        }
+    }
+    if (ringBits < bitlength) {
+        funcExtendRingWrapper(
+            eightDivElemts, outp, outp, ringBits, bitlength,
+            /*nonNegative*/ false
+        );
+    }
 #else
+    constexpr bool localTrunc = false;
     for (int i = 0; i < eightDivElemts; i++) {
         tempInp[i] = sci::neg_mod(tempInp[i], (int64_t)prime_mod);
     }
@@ -1572,7 +1762,7 @@ void ScaleDown(int32_t size, intType *inArr, int32_t sf) {
 #if USE_CHEETAH
         constexpr signedIntType error_upper = 1;
 #else
-        constexpr signedIntType error_upper = 0;
+        const signedIntType error_upper = localTrunc ? 1 : 0;
 #endif
         for (int i = 0; i < size; i++) {
             if (std::abs(VoutpArr[i] - getSignedVal(VinVec[i])) > error_upper) {
@@ -1598,50 +1788,25 @@ void ScaleDown(int32_t size, intType *inArr, int32_t sf) {
 }
 
 void ScaleUp(int32_t size, intType *arr, int32_t sf) {
-    for (int i = 0; i < size; i++) {
 #ifdef SCI_OT
-        arr[i] = (arr[i] << sf);
+    sci::ring_scalar_mul(size, arr, 1ULL << sf, arr, moduloMask);
 #else
-        arr[i] = sci::neg_mod(arr[i] << sf, (int64_t)prime_mod);
+    sci::field_scalar_mul(size, arr, 1ULL << sf, arr, prime_mod);
 #endif
-    }
 }
 
-void StartComputation() {
-    assert(bitlength < 64 && bitlength > 0);
-    assert(num_threads <= MAX_THREADS);
-
-    std::string backend;
-
-#ifdef SCI_HE
-    backend = "PrimeField";
-    auto kv = sci::default_prime_mod.find(bitlength);
-    if (kv == sci::default_prime_mod.end()) {
-        bitlength = 41;
-        prime_mod = sci::default_prime_mod.at(bitlength);
-    } else {
-        prime_mod = kv->second;
-    }
-#elif SCI_OT
-    prime_mod = (bitlength == 64 ? 0ULL : 1ULL << bitlength);
-    moduloMask = prime_mod - 1;
-    moduloMidPt = prime_mod / 2;
-    backend = "Ring";
-#endif
-
-#if USE_CHEETAH
-    backend += "-SilentOT";
-#else
-    backend += "-OT";
-#endif
-
-    checkIfUsingEigen();
-    printf("Doing BaseOT ...\n");
+// Sets up the protocol instances of `lane` for the calling thread.
+static void setupLane(int lane, const sci::NetProfile &netProfile) {
+    kLane = lane;
     for (int i = 0; i < num_threads; i++) {
+        const int slot = lane * MAX_THREADS + i;
         ioArr[i] = new sci::NetIO(
-            party == sci::ALICE ? nullptr : address.c_str(), port + i,
+            party == sci::ALICE ? nullptr : address.c_str(), port + slot,
             /*quit*/ true
         );
+        if (!kNetProfile.empty()) {
+            ioArr[i]->emulator.reset(new sci::NetEmulator(netProfile, slot));
+        }
         otInstanceArr[i] = new sci::IKNP<sci::NetIO>(ioArr[i]);
         prgInstanceArr[i] = new sci::PRG128();
         kkotInstanceArr[i] = new sci::KKOT<sci::NetIO>(ioArr[i]);
@@ -1651,13 +1816,39 @@ void StartComputation() {
                 party, bitlength, ioArr[i], otInstanceArr[i], nullptr
             );
 #endif
-        if (i & 1) {
-            otpackArr[i] = new sci::OTPack<sci::NetIO>(ioArr[i], 3 - party);
-        } else {
-            otpackArr[i] = new sci::OTPack<sci::NetIO>(ioArr[i], party);
-        }
     }
 
+    // The OTPacks bootstrap their base OTs on their own channels, so the
+    // threads set them up in parallel. The arrays are this thread's.
+    sci::NetIO **ios = ioArr;
+    sci::OTPack<sci::NetIO> **packs = otpackArr;
+    std::vector<int64_t> setupMs(num_threads);
+    std::vector<std::thread> setupThreads;
+    for (int i = 0; i < num_threads; i++) {
+        setupThreads.emplace_back([=, &setupMs]() {
+            auto start = std::chrono::high_resolution_clock::now();
+            const int role = (i & 1) ? 3 - party : party;
+#if USE_CHEETAH
+            packs[i] = new sci::OTPack<sci::NetIO>(
+                ios[i], role, true, otStateStore, lane * MAX_THREADS + i
+            );
+#else
+            packs[i] = new sci::OTPack<sci::NetIO>(ios[i], role);
+#endif
+            auto elapsed = std::chrono::high_resolution_clock::now() - start;
+            setupMs[i] =
+                std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+                    .count();
+        });
+    }
+    for (auto &t : setupThreads) t.join();
+    std::ostringstream report;
+    for (int i = 0; i < num_threads; i++) {
+        report << "OTPack setup of thread i = " << lane * MAX_THREADS + i
+               << ": " << setupMs[i] << " ms" << std::endl;
+    }
+    std::cout << report.str();
+
     io = ioArr[0];
     otpack = otpackArr[0];
     iknpOT = new sci::IKNP<sci::NetIO>(io);
@@ -1684,14 +1875,10 @@ void StartComputation() {
 #endif
 
 #if USE_CHEETAH
-    backend += "-Cheetah";
     cheetah_linear =
         new gemini::CheetahLinear(party, io, prime_mod, num_threads);
 #elif defined(SCI_HE)
-    backend += "-SCI_HE";
     he_conv = new ConvField(party, io);
-#elif defined(SCI_OT)
-    backend += "-SCI_OT";
 #endif
 
 #ifdef SCI_HE
@@ -1706,7 +1893,6 @@ void StartComputation() {
     );
     he_fc = new FCField(party, io);
     he_prod = new ElemWiseProdField(party, io);
-    assertFieldRun();
 #endif
 
 #if defined MULTITHREADED_NONLIN && defined SCI_OT
@@ -1783,6 +1969,9 @@ void StartComputation() {
     xt = xtArr[0];
     mult = multArr[0];
     math = mathArr[0];
+    if (kBitSlicedCmp) {
+        setupBitSlicedCmp();
+    }
 #endif
 
     if (party == sci::ALICE) {
@@ -1793,13 +1982,168 @@ void StartComputation() {
         iknpOTRoleReversed->setup_send();
     }
 
+    SaveLane(lane);
+}
+
+void StartComputation() {
+    assert(bitlength < 64 && bitlength > 0);
+    assert(num_threads <= MAX_THREADS);
+
+    std::string backend;
+
+#ifdef SCI_HE
+    backend = "PrimeField";
+    auto kv = sci::default_prime_mod.find(bitlength);
+    if (kv == sci::default_prime_mod.end()) {
+        bitlength = 41;
+        prime_mod = sci::default_prime_mod.at(bitlength);
+    } else {
+        prime_mod = kv->second;
+    }
+#elif SCI_OT
+    prime_mod = (bitlength == 64 ? 0ULL : 1ULL << bitlength);
+    moduloMask = prime_mod - 1;
+    moduloMidPt = prime_mod / 2;
+    backend = "Ring";
+#endif
+
+#if USE_CHEETAH
+    backend += "-SilentOT";
+#else
+    backend += "-OT";
+#endif
+
+    checkIfUsingEigen();
+    sci::NetProfile netProfile;
+    if (!kNetProfile.empty() &&
+        !sci::NetProfile::parse(kNetProfile, netProfile)) {
+        std::cerr << "invalid network profile: " << kNetProfile << std::endl;
+        exit(1);
+    }
+    if (kLanes < 1 || kLanes > MAX_LANES) {
+        std::cerr << "lanes must be in [1, " << MAX_LANES << "]" << std::endl;
+        exit(1);
+    }
+#if USE_CHEETAH
+    if (!kOTStateDir.empty() && !otStateStore) {
+        std::string session = kOTSession;
+        if (session.empty()) {
+            session = party == sci::ALICE
+                          ? "server-p" + std::to_string(port)
+                          : "client-" + address + "-p" + std::to_string(port);
+        }
+        otStateStore =
+            new sci::OTStateStore(kOTStateDir, session, party, kOTWarmUp);
+    }
+#endif
+    printf("Doing BaseOT ...\n");
+    // The other lanes connect on their own ports meanwhile.
+    std::vector<std::thread> laneThreads;
+    for (int lane = 1; lane < kLanes; lane++) {
+        laneThreads.emplace_back(setupLane, lane, std::cref(netProfile));
+    }
+    setupLane(0, netProfile);
+    for (auto &t : laneThreads) t.join();
+
+#if USE_CHEETAH
+    backend += "-Cheetah";
+    // The workers serve one coordinator at a time: only lane 0 shards.
+    if (party == SERVER && !kConvWorkers.empty()) {
+        cheetah_linear->set_conv_workers(kConvWorkers);
+    }
+    if (party == SERVER && kHomMaskPool > 0) {
+        cheetah_linear->set_mask_pool(kHomMaskPool);
+    }
+#elif defined(SCI_HE)
+    backend += "-SCI_HE";
+#elif defined(SCI_OT)
+    backend += "-SCI_OT";
+#endif
+#ifdef SCI_HE
+    assertFieldRun();
+#endif
+
+#ifdef SCI_OT
+    if (kTriplePoolCmps > 0) {
+        setupTriplePools(kTriplePoolCmps);
+    }
+
+    if (!kCalibStatsPath.empty()) {
+        std::cout << "Calibration run: the inputs of the ReLU and truncation "
+                     "layers are revealed to the client"
+                  << std::endl;
+        bitwidthCalibrator = new BitwidthCalibrator();
+        if (party == CLIENT &&
+            bitwidthCalibrator->load_stats(kCalibStatsPath) &&
+            bitwidthCalibrator->stats_version() != kCalibrationVersion) {
+            std::cerr << kCalibStatsPath << " has version "
+                      << bitwidthCalibrator->stats_version() << ", expected "
+                      << kCalibrationVersion
+                      << ": its layers are named differently, start the "
+                         "calibration stats anew"
+                      << std::endl;
+            exit(1);
+        }
+    } else if (!kBitwidthConfigPath.empty()) {
+        bitwidthConfig = new BitwidthConfig();
+        if (!bitwidthConfig->load(kBitwidthConfigPath)) {
+            std::cerr << "Can not read " << kBitwidthConfigPath << std::endl;
+            exit(1);
+        }
+        if (bitwidthConfig->version() != kCalibrationVersion) {
+            std::cerr << kBitwidthConfigPath << " has version "
+                      << bitwidthConfig->version() << ", expected "
+                      << kCalibrationVersion
+                      << ": its layers are named differently, run the "
+                         "calibration again"
+                      << std::endl;
+            exit(1);
+        }
+        // The local truncation decisions depend on kLocalTruncFail too.
+        uint64_t digest = bitwidthConfig->digest() ^
+                          std::hash<double>()(kLocalTruncFail),
+                 other_digest;
+        if (party == SERVER) {
+            io->send_data(&digest, sizeof(uint64_t));
+            io->recv_data(&other_digest, sizeof(uint64_t));
+        } else {
+            io->recv_data(&other_digest, sizeof(uint64_t));
+            io->send_data(&digest, sizeof(uint64_t));
+        }
+        if (digest != other_digest) {
+            std::cerr << "The parties use different bitwidth configs or "
+                         "local truncation settings"
+                      << std::endl;
+            exit(1);
+        }
+        std::cout << "Using the bitwidths of " << bitwidthConfig->size()
+                  << " layers from " << kBitwidthConfigPath << std::endl;
+    }
+    if (kLocalTruncFail > 0) {
+        if (bitwidthConfig == nullptr) {
+            std::cerr << "Local truncation needs the calibrated bounds of "
+                         "a bitwidth config, every layer falls back"
+                      << std::endl;
+        }
+        localTruncation = new LocalTruncation(kLocalTruncFail);
+    }
+#endif
+
+    // The triple pools of lane 0.
+    SaveLane(0);
+
     std::cout << "After one-time setup, communication" << std::endl;
     start_time = std::chrono::high_resolution_clock::now();
-    for (int i = 0; i < num_threads; i++) {
-        auto temp = ioArr[i]->counter;
-        comm_threads[i] = temp;
-        std::cout << "Thread i = " << i
-                  << ", total data sent till now = " << temp << std::endl;
+    for (int lane = 0; lane < kLanes; lane++) {
+        for (int i = 0; i < num_threads; i++) {
+            sci::NetIO *laneIO = protocolLanes[lane].ioArr[i];
+            const int slot = lane * MAX_THREADS + i;
+            comm_threads[slot] = laneIO->counter;
+            if (laneIO->emulator) laneIO->emulator->reset();
+            std::cout << "Thread i = " << slot
+                      << ", total data sent till now = " << laneIO->counter
+                      << std::endl;
+        }
     }
     std::cout << "-----------Syncronizing-----------" << std::endl;
     io->sync();
@@ -1819,11 +2163,14 @@ void EndComputation() {
         )
             .count();
     uint64_t totalComm = 0;
-    for (int i = 0; i < num_threads; i++) {
-        auto temp = ioArr[i]->counter;
-        std::cout << "Thread i = " << i
-                  << ", total data sent till now = " << temp << std::endl;
-        totalComm += (temp - comm_threads[i]);
+    for (int lane = 0; lane < kLanes; lane++) {
+        for (int i = 0; i < num_threads; i++) {
+            auto temp = protocolLanes[lane].ioArr[i]->counter;
+            const int slot = lane * MAX_THREADS + i;
+            std::cout << "Thread i = " << slot
+                      << ", total data sent till now = " << temp << std::endl;
+            totalComm += (temp - comm_threads[slot]);
+        }
     }
     uint64_t totalCommClient;
     std::cout << "------------------------------------------------------\n";
@@ -1835,6 +2182,24 @@ void EndComputation() {
               << " MiB." << std::endl;
     std::cout << "Number of rounds = " << ioArr[0]->num_rounds - num_rounds
               << std::endl;
+    if (io->emulator) {
+        // The threads run concurrently: the slowest one is on the critical
+        // path.
+        double delayMilliSec = 0.;
+        for (int lane = 0; lane < kLanes; lane++) {
+            for (int i = 0; i < num_threads; i++) {
+                delayMilliSec = std::max(
+                    delayMilliSec,
+                    protocolLanes[lane].ioArr[i]->emulator->delay_ms()
+                );
+            }
+        }
+        std::cout << "Projected time on network "
+                  << io->emulator->profile().name << " = "
+                  << (execTimeInMilliSec + delayMilliSec)
+                  << " milliseconds (real " << execTimeInMilliSec
+                  << " + network " << delayMilliSec << ").\n";
+    }
     if (party == SERVER) {
         io->recv_data(&totalCommClient, sizeof(uint64_t));
         std::cout << "Total comm (sent+received) = "
@@ -1928,13 +2293,37 @@ void EndComputation() {
     std::cout << "------------------------------------------------------\n";
 #if USE_CHEETAH
     int64_t rcot = 0;
-    for (size_t i = 0; i < MAX_THREADS; ++i) {
-        rcot += otpackArr[i]->silent_ot->get_rcot_count();
+    for (int lane = 0; lane < kLanes; lane++) {
+        for (int i = 0; i < num_threads; i++) {
+            const auto *pack = protocolLanes[lane].otpackArr[i];
+            rcot += pack->silent_ot->get_rcot_count();
+        }
     }
     std::cout << "Total #Ferret's RCOT " << rcot << std::endl;
     std::cout << "Total #Elementwise Mul " << CountElementMul << std::endl;
+    if (const auto *pool = cheetah_linear->mask_pool()) {
+        std::cout << "HomMaskPool hits " << pool->hits() << ", misses "
+                  << pool->misses() << std::endl;
+    }
     std::cout << "------------------------------------------------------\n";
 #endif
+#ifdef SCI_OT
+    if (kTriplePoolCmps > 0) {
+        for (int i = 0; i < num_threads; i++) {
+            std::cout << "Thread i = " << i << ", ";
+            triplePoolArr[i]->print_stats(std::cout);
+        }
+        std::cout << "------------------------------------------------------\n";
+    }
+    if (localTruncation != nullptr) {
+        localTruncation->print_report(std::cout);
+        std::cout << "------------------------------------------------------\n";
+    }
+#endif
+    if (activationPlanner != nullptr) {
+        activationPlanner->finish(std::cout);
+        std::cout << "------------------------------------------------------\n";
+    }
     if (party == SERVER) {
         uint64_t ConvCommSentClient = 0;
         uint64_t MatMulCommSentClient = 0;
@@ -2085,22 +2474,28 @@ void EndComputation() {
         result.close();
 #endif
     } else if (party == CLIENT) {
-        io->send_data(&ConvCommSent, sizeof(uint64_t));
-        io->send_data(&MatMulCommSent, sizeof(uint64_t));
-        io->send_data(&BatchNormCommSent, sizeof(uint64_t));
-        io->send_data(&TruncationCommSent, sizeof(uint64_t));
-        io->send_data(&ReluCommSent, sizeof(uint64_t));
-        io->send_data(&MaxpoolCommSent, sizeof(uint64_t));
-        io->send_data(&AvgpoolCommSent, sizeof(uint64_t));
-        io->send_data(&ArgMaxCommSent, sizeof(uint64_t));
-        io->send_data(&MatAddCommSent, sizeof(uint64_t));
-        io->send_data(&MatAddBroadCastCommSent, sizeof(uint64_t));
-        io->send_data(&MulCirCommSent, sizeof(uint64_t));
-        io->send_data(&ScalarMulCommSent, sizeof(uint64_t));
-        io->send_data(&SigmoidCommSent, sizeof(uint64_t));
-        io->send_data(&TanhCommSent, sizeof(uint64_t));
-        io->send_data(&SqrtCommSent, sizeof(uint64_t));
-        io->send_data(&NormaliseL2CommSent, sizeof(uint64_t));
+        const uint64_t commSent[] = {
+            ConvCommSent, MatMulCommSent, BatchNormCommSent,
+            TruncationCommSent, ReluCommSent, MaxpoolCommSent, AvgpoolCommSent,
+            ArgMaxCommSent, MatAddCommSent, MatAddBroadCastCommSent,
+            MulCirCommSent, ScalarMulCommSent, SigmoidCommSent, TanhCommSent,
+            SqrtCommSent, NormaliseL2CommSent
+        };
+        io->send_data(commSent, sizeof(commSent));
+    }
+#endif
+
+#ifdef SCI_OT
+    if (bitwidthCalibrator != nullptr && party == CLIENT) {
+        bitwidthCalibrator->save_stats(kCalibStatsPath);
+        BitwidthConfig config =
+            bitwidthCalibrator->derive(bitlength, kCalibBudget, 1, kMixedRings);
+        bitwidthCalibrator->print_report(config, bitlength);
+        if (!kBitwidthConfigPath.empty()) {
+            config.save(kBitwidthConfigPath);
+            std::cout << "Bitwidth config written to " << kBitwidthConfigPath
+                      << std::endl;
+        }
     }
 #endif
 }
@@ -2126,6 +2521,82 @@ intType SecretMult(intType x, intType y) {
     return x * y;
 }
 
+void ElemWiseSecretAdd(
+    int64_t size, const intType *A, const intType *B, intType *outArr
+) {
+#ifdef SCI_OT
+    sci::ring_add(size, A, B, outArr, moduloMask);
+#else
+    sci::field_add(size, A, B, outArr, prime_mod);
+#endif
+}
+
+void ElemWiseSecretSub(
+    int64_t size, const intType *A, const intType *B, intType *outArr
+) {
+#ifdef SCI_OT
+    sci::ring_sub(size, A, B, outArr, moduloMask);
+#else
+    sci::field_sub(size, A, B, outArr, prime_mod);
+#endif
+}
+
+void MatAddBroadCast(
+    int64_t rows,
+    int64_t cols,
+    const intType *A,
+    const intType *B,
+    intType *outArr
+) {
+#ifdef SCI_OT
+    sci::ring_add_bcast(rows, cols, A, B, outArr, moduloMask);
+#else
+    sci::field_add_bcast(rows, cols, A, B, outArr, prime_mod);
+#endif
+}
+
+void MatAddBroadCastRows(
+    int64_t rows,
+    int64_t cols,
+    const intType *A,
+    const intType *B,
+    intType *outArr
+) {
+#ifdef SCI_OT
+    sci::ring_add_rowbcast(rows, cols, A, B, outArr, moduloMask);
+#else
+    sci::field_add_rowbcast(rows, cols, A, B, outArr, prime_mod);
+#endif
+}
+
+void NHWCToNCHW(int32_t N, int32_t H, int32_t W, int32_t C, intType *arr) {
+    const int64_t HW = (int64_t)H * W;
+    std::vector<intType> tmp(HW * C);
+    for (int32_t n = 0; n < N; ++n) {
+        intType *arr_n = arr + n * HW * C;
+        for (int64_t hw = 0; hw < HW; ++hw) {
+            for (int32_t c = 0; c < C; ++c) {
+                tmp[c * HW + hw] = arr_n[hw * C + c];
+            }
+        }
+        std::copy(tmp.begin(), tmp.end(), arr_n);
+    }
+}
+
+void NCHWToNHWC(int32_t N, int32_t H, int32_t W, int32_t C, intType *arr) {
+    const int64_t HW = (int64_t)H * W;
+    std::vector<intType> tmp(HW * C);
+    for (int32_t n = 0; n < N; ++n) {
+        intType *arr_n = arr + n * HW * C;
+        for (int64_t hw = 0; hw < HW; ++hw) {
+            for (int32_t c = 0; c < C; ++c) {
+                tmp[hw * C + c] = arr_n[c * HW + hw];
+            }
+        }
+        std::copy(tmp.begin(), tmp.end(), arr_n);
+    }
+}
+
 void ElemWiseVectorPublicDiv(
     int32_t s1, intType *arr1, int32_t divisor, intType *outArr
 ) {
@@ -2184,7 +2655,7 @@ void ElemWiseSecretSharedVectorMult(
         } else {
             curSize = chunk_size;
         }
-        dotProdThreads[i] = std::thread(
+        dotProdThreads[i] = LaneThread(
             funcDotProdThread, i, num_threads, curSize, multArrVec + offset,
             inArr + offset, outputArr + offset, true
         );
@@ -23,6 +23,7 @@ SOFTWARE.
 #define LIBRARY_FIXED_UNIFORM_H__
 
 #include "defines_uniform.h"
+#include "memory-planner.h"
 #include "utils/ArgMapping/ArgMapping.h"
 
 // Note of the bracket around each expression use -- if this is not there, not
@@ -40,6 +41,9 @@ SOFTWARE.
 
 #define Arr2DIdxColM(arr, s0, s1, i, j) (*((arr) + (j) * (s0) + (i)))
 
+// Expected #comparisons per inference for the bit-triple pool (0: disabled).
+extern int64_t kTriplePoolCmps;
+
 intType funcSSCons(int64_t x);
 void funcReconstruct2PCCons(signedIntType *y, const intType *x, int len);
 signedIntType funcReconstruct2PCCons(intType x, int revealParty);
@@ -110,8 +114,37 @@ void BatchNorm(
 );
 #endif
 
+#if USE_CHEETAH
+// Conv2DWrapper, the bias (nullptr: none) and Relu, with the ReLU of the first
+// output channels overlapping the HomConv of the others on lane 1.
+void Conv2DReluWrapper(
+    signedIntType N,
+    signedIntType H,
+    signedIntType W,
+    signedIntType CI,
+    signedIntType FH,
+    signedIntType FW,
+    signedIntType CO,
+    signedIntType zPadHLeft,
+    signedIntType zPadHRight,
+    signedIntType zPadWLeft,
+    signedIntType zPadWRight,
+    signedIntType strideH,
+    signedIntType strideW,
+    intType *inputArr,
+    intType *filterArr,
+    const intType *biasArr,
+    intType *outArr,
+    int sf,
+    bool doTruncation,
+    int32_t nTiles
+);
+#endif
+
 void ArgMax(int32_t s1, int32_t s2, intType *inArr, intType *outArr);
 
+// Relu and ScaleDown are element-wise, and thus work on both activation
+// layouts. MaxPool and AvgPool follow kActivationCHW.
 void Relu(
     int32_t size, intType *inArr, intType *outArr, int sf, bool doTruncation
 );
@@ -172,6 +205,39 @@ intType SecretSub(intType x, intType y);
 
 intType SecretMult(intType x, intType y);
 
+// Share-wise outArr = A + B and outArr = A - B over contiguous arrays.
+void ElemWiseSecretAdd(
+    int64_t size, const intType *A, const intType *B, intType *outArr
+);
+
+void ElemWiseSecretSub(
+    int64_t size, const intType *A, const intType *B, intType *outArr
+);
+
+// outArr[i][j] = A[i][j] + B[j] for a row-major `rows` x `cols` matrix A.
+void MatAddBroadCast(
+    int64_t rows,
+    int64_t cols,
+    const intType *A,
+    const intType *B,
+    intType *outArr
+);
+
+// outArr[i][j] = A[i][j] + B[i] for a row-major `rows` x `cols` matrix A,
+// e.g., a per-channel bias on a CHW activation.
+void MatAddBroadCastRows(
+    int64_t rows,
+    int64_t cols,
+    const intType *A,
+    const intType *B,
+    intType *outArr
+);
+
+// In-place NHWC <-> NCHW re-layout of an activation (see kActivationCHW).
+void NHWCToNCHW(int32_t N, int32_t H, int32_t W, int32_t C, intType *arr);
+
+void NCHWToNHWC(int32_t N, int32_t H, int32_t W, int32_t C, intType *arr);
+
 void ElemWiseVectorPublicDiv(
     int32_t s1, intType *arr1, int32_t divisor, intType *outArr
 );
@@ -182,99 +248,119 @@ void ElemWiseSecretSharedVectorMult(
 
 void Floor(int32_t s1, intType *inArr, intType *outArr, int32_t sf);
 
-inline void ClearMemSecret1(int32_t s1, intType *arr) { delete[] arr; }
+// The arrays of the generated programs live in the planned arena when a
+// memory plan is used, see memory-planner.h.
+template <typename T>
+T *alloc_array(size_t n) {
+    if (activationPlanner != nullptr) {
+        return activationPlanner->allocate<T>(n);
+    }
+    return new T[n];
+}
+
+template <typename T>
+void free_array(T *arr) {
+    if (activationPlanner != nullptr) {
+        activationPlanner->release(arr);
+    } else {
+        delete[] arr;
+    }
+}
+
+inline void ClearMemSecret1(int32_t s1, intType *arr) { free_array(arr); }
 
 inline void ClearMemSecret2(int32_t s1, int32_t s2, intType *arr) {
-    delete[] arr;  // At the end of the day, everything is done using 1D array
+    // At the end of the day, everything is done using 1D array
+    free_array(arr);
 }
 
 inline void ClearMemSecret3(int32_t s1, int32_t s2, int32_t s3, intType *arr) {
-    delete[] arr;
+    free_array(arr);
 }
 
 inline void ClearMemSecret4(
     int32_t s1, int32_t s2, int32_t s3, int32_t s4, intType *arr
 ) {
-    delete[] arr;
+    free_array(arr);
 }
 
 inline void ClearMemSecret5(
     int32_t s1, int32_t s2, int32_t s3, int32_t s4, int32_t s5, intType *arr
 ) {
-    delete[] arr;
+    free_array(arr);
 }
 
 inline void ClearMemPublic(int32_t x) { return; }
 
-inline void ClearMemPublic1(int32_t s1, int32_t *arr) { delete[] arr; }
+inline void ClearMemPublic1(int32_t s1, int32_t *arr) { free_array(arr); }
 
 inline void ClearMemPublic2(int32_t s1, int32_t s2, int32_t *arr) {
-    delete[] arr;
+    free_array(arr);
 }
 
 inline void ClearMemPublic3(int32_t s1, int32_t s2, int32_t s3, int32_t *arr) {
-    delete[] arr;
+    free_array(arr);
 }
 
 inline void ClearMemPublic4(
     int32_t s1, int32_t s2, int32_t s3, int32_t s4, int32_t *arr
 ) {
-    delete[] arr;
+    free_array(arr);
 }
 
 inline void ClearMemPublic5(
     int32_t s1, int32_t s2, int32_t s3, int32_t s4, int32_t s5, int32_t *arr
 ) {
-    delete[] arr;
+    free_array(arr);
 }
 
 inline void ClearMemPublic(int64_t x) { return; }
 
-inline void ClearMemPublic1(int32_t s1, int64_t *arr) { delete[] arr; }
+inline void ClearMemPublic1(int32_t s1, int64_t *arr) { free_array(arr); }
 
 inline void ClearMemPublic2(int32_t s1, int32_t s2, int64_t *arr) {
-    delete[] arr;
+    free_array(arr);
 }
 
 inline void ClearMemPublic3(int32_t s1, int32_t s2, int32_t s3, int64_t *arr) {
-    delete[] arr;
+    free_array(arr);
 }
 
 inline void ClearMemPublic4(
     int32_t s1, int32_t s2, int32_t s3, int32_t s4, int64_t *arr
 ) {
-    delete[] arr;
+    free_array(arr);
 }
 
 inline void ClearMemPublic5(
     int32_t s1, int32_t s2, int32_t s3, int32_t s4, int32_t s5, int64_t *arr
 ) {
-    delete[] arr;
+    free_array(arr);
 }
 
 template <typename T>
 T *make_array(size_t s1) {
-    return new T[s1];
+    return alloc_array<T>(s1);
 }
 
 template <typename T>
 T *make_array(size_t s1, size_t s2) {
-    return new T[s1 * s2];
+    return alloc_array<T>(s1 * s2);
 }
 
 template <typename T>
 T *make_array(size_t s1, size_t s2, size_t s3) {
-    return new T[s1 * s2 * s3];
+    return alloc_array<T>(s1 * s2 * s3);
 }
 
 template <typename T>
 T *make_array(size_t s1, size_t s2, size_t s3, size_t s4) {
-    return new T[s1 * s2 * s3 * s4];
+    return alloc_array<T>(s1 * s2 * s3 * s4);
 }
 
 template <typename T>
 T *make_array(size_t s1, size_t s2, size_t s3, size_t s4, size_t s5) {
-    return new T[s1 * s2 * s3 * s4 * s5];
+    return alloc_array<T>(s1 * s2 * s3 * s4 * s5);
 }
 
 #endif
@@ -4,6 +4,10 @@
 
 #include <gemini/cheetah/tensor.h>
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
 #include "cheetah/cheetah-api.h"
 #include "defines_uniform.h"
 #include "globals.h"
@@ -33,7 +37,27 @@ static inline uint64_t getRingElt(int64_t x) {
 }
 #endif
 
-extern uint64_t SecretAdd(uint64_t x, uint64_t y);
+extern void MatAddBroadCastRows(
+    int64_t rows,
+    int64_t cols,
+    const uint64_t *A,
+    const uint64_t *B,
+    uint64_t *outArr
+);
+extern void NCHWToNHWC(
+    int32_t N, int32_t H, int32_t W, int32_t C, uint64_t *arr
+);
+extern void MatAddBroadCast(
+    int64_t rows,
+    int64_t cols,
+    const uint64_t *A,
+    const uint64_t *B,
+    uint64_t *outArr
+);
+extern void Relu(
+    int32_t size, intType *inArr, intType *outArr, int sf, bool doTruncation
+);
+extern intType SecretAdd(intType x, intType y);
 
 #ifdef LOG_LAYERWISE
 #include <vector>
@@ -66,6 +90,26 @@ extern void Conv2DWrapper_pt(
     uint64_4D &outArr
 );
 
+extern void Conv2DGroupWrapper_pt(
+    uint64_t N,
+    uint64_t H,
+    uint64_t W,
+    uint64_t CI,
+    uint64_t FH,
+    uint64_t FW,
+    uint64_t CO,
+    uint64_t zPadHLeft,
+    uint64_t zPadHRight,
+    uint64_t zPadWLeft,
+    uint64_t zPadWRight,
+    uint64_t strideH,
+    uint64_t strideW,
+    uint64_t G,
+    uint64_4D &inputArr,
+    uint64_4D &filterArr,
+    uint64_4D &outArr
+);
+
 extern void MatMul2DEigen_pt(
     int64_t i,
     int64_t j,
@@ -239,7 +283,10 @@ void MatMul2D(
 #endif
 }
 
-void Conv2DWrapper(
+// The filter is of shape FH x FW x (CI / G) x CO. The G groups are evaluated
+// in one HomConv call: the filters of a group are only multiplied with the
+// encrypted channel slices that hold the group's CI / G input channels.
+void Conv2DGroupWrapper(
     signedIntType N,
     signedIntType H,
     signedIntType W,
@@ -253,10 +300,12 @@ void Conv2DWrapper(
     signedIntType zPadWRight,
     signedIntType strideH,
     signedIntType strideW,
+    signedIntType G,
     intType *inputArr,
     intType *filterArr,
     intType *outArr
 ) {
+    assert(G > 0 && CI % G == 0 && CO % G == 0);
 #ifdef LOG_LAYERWISE
     INIT_ALL_IO_DATA_SENT;
     INIT_TIMER;
@@ -268,14 +317,17 @@ void Conv2DWrapper(
     if (zPadHLeft < zPadHRight) {
         std::swap(zPadHLeft, zPadHRight);
     }
-    static int ctr = 1;
+    static std::atomic<int> ctr{1};
+    const int layerId = layerNumber(ctr);
     signedIntType newH = (((H + (zPadHLeft + zPadHRight) - FH) / strideH) + 1);
     signedIntType newW = (((W + (zPadWLeft + zPadWRight) - FW) / strideW) + 1);
 
+    const signedIntType CIG = CI / G;
     gemini::CheetahLinear::ConvMeta meta;
     meta.ishape = gemini::TensorShape({CI, H, W});
-    meta.fshape = gemini::TensorShape({CI, FH, FW});
+    meta.fshape = gemini::TensorShape({CIG, FH, FW});
     meta.n_filters = CO;
+    meta.n_groups = G;
 
     std::vector<gemini::Tensor<intType>> filters(CO);
     for (auto &f : filters) {
@@ -284,10 +336,10 @@ void Conv2DWrapper(
 
     for (int i = 0; i < FH; i++) {
         for (int j = 0; j < FW; j++) {
-            for (int k = 0; k < CI; k++) {
+            for (int k = 0; k < CIG; k++) {
                 for (int p = 0; p < CO; p++) {
                     filters.at(p)(k, i, j) = getRingElt(
-                        Arr4DIdxRowM(filterArr, FH, FW, CI, CO, i, j, k, p)
+                        Arr4DIdxRowM(filterArr, FH, FW, CIG, CO, i, j, k, p)
                     );
                 }
             }
@@ -301,10 +353,10 @@ void Conv2DWrapper(
 
     printf(
         "HomConv #%d called N=%ld, H=%ld, W=%ld, CI=%ld, FH=%ld, FW=%ld, "
-        "CO=%ld, S=%ld, Padding %s (%d %d %d %d)\n",
-        ctr++, N, meta.ishape.height(), meta.ishape.width(),
+        "CO=%ld, S=%ld, G=%ld, Padding %s (%d %d %d %d)\n",
+        layerId, N, meta.ishape.height(), meta.ishape.width(),
         meta.ishape.channels(), meta.fshape.height(), meta.fshape.width(),
-        meta.n_filters, meta.stride,
+        meta.n_filters, meta.stride, G,
         (meta.padding == gemini::Padding::VALID ? "VALID" : "SAME"), zPadHLeft,
         zPadHRight, zPadWLeft, zPadWRight
     );
@@ -315,12 +367,18 @@ void Conv2DWrapper(
 
     for (int i = 0; i < N; ++i) {
         gemini::Tensor<intType> image(meta.ishape);
-        for (int j = 0; j < H; j++) {
-            for (int k = 0; k < W; k++) {
-                for (int p = 0; p < CI; p++) {
-                    image(p, j, k) = getRingElt(
-                        Arr4DIdxRowM(inputArr, N, H, W, CI, i, j, k, p)
-                    );
+        if (kActivationCHW) {
+            // Same layout as the gemini tensor: no transpose needed.
+            const intType *in_i = inputArr + (int64_t)i * CI * H * W;
+            std::transform(in_i, in_i + CI * H * W, image.data(), getRingElt);
+        } else {
+            for (int j = 0; j < H; j++) {
+                for (int k = 0; k < W; k++) {
+                    for (int p = 0; p < CI; p++) {
+                        image(p, j, k) = getRingElt(
+                            Arr4DIdxRowM(inputArr, N, H, W, CI, i, j, k, p)
+                        );
+                    }
                 }
             }
         }
@@ -328,6 +386,13 @@ void Conv2DWrapper(
         gemini::Tensor<intType> out_tensor;
         cheetah_linear->conv2d(image, filters, meta, out_tensor);
 
+        if (kActivationCHW) {
+            std::copy_n(
+                out_tensor.data(), CO * newH * newW,
+                outArr + (int64_t)i * CO * newH * newW
+            );
+            continue;
+        }
         for (int j = 0; j < newH; j++) {
             for (int k = 0; k < newW; k++) {
                 for (int p = 0; p < CO; p++) {
@@ -369,15 +434,19 @@ void Conv2DWrapper(
 
     if (party == SERVER) {
         funcReconstruct2PCCons(nullptr, inputArr, N * H * W * CI);
-        funcReconstruct2PCCons(nullptr, filterArr, FH * FW * CI * CO);
+        funcReconstruct2PCCons(nullptr, filterArr, FH * FW * CIG * CO);
         funcReconstruct2PCCons(nullptr, outArr, N * newH * newW * CO);
     } else {
         signedIntType *VinputArr = new signedIntType[N * H * W * CI];
         funcReconstruct2PCCons(VinputArr, inputArr, N * H * W * CI);
-        signedIntType *VfilterArr = new signedIntType[FH * FW * CI * CO];
-        funcReconstruct2PCCons(VfilterArr, filterArr, FH * FW * CI * CO);
+        signedIntType *VfilterArr = new signedIntType[FH * FW * CIG * CO];
+        funcReconstruct2PCCons(VfilterArr, filterArr, FH * FW * CIG * CO);
         signedIntType *VoutputArr = new signedIntType[N * newH * newW * CO];
         funcReconstruct2PCCons(VoutputArr, outArr, N * newH * newW * CO);
+        if (kActivationCHW) {
+            NCHWToNHWC(N, H, W, CI, (uint64_t *)VinputArr);
+            NCHWToNHWC(N, newH, newW, CO, (uint64_t *)VoutputArr);
+        }
 
         std::vector<std::vector<std::vector<std::vector<uint64_t>>>> VinputVec;
         VinputVec.resize(
@@ -392,7 +461,7 @@ void Conv2DWrapper(
         VfilterVec.resize(
             FH, std::vector<std::vector<std::vector<uint64_t>>>(
                     FW, std::vector<std::vector<uint64_t>>(
-                            CI, std::vector<uint64_t>(CO, 0)
+                            CIG, std::vector<uint64_t>(CO, 0)
                         )
                 )
         );
@@ -419,20 +488,28 @@ void Conv2DWrapper(
         }
         for (int i = 0; i < FH; i++) {
             for (int j = 0; j < FW; j++) {
-                for (int k = 0; k < CI; k++) {
+                for (int k = 0; k < CIG; k++) {
                     for (int p = 0; p < CO; p++) {
-                        VfilterVec[i][j][k][p] = getRingElt(
-                            Arr4DIdxRowM(VfilterArr, FH, FW, CI, CO, i, j, k, p)
-                        );
+                        VfilterVec[i][j][k][p] = getRingElt(Arr4DIdxRowM(
+                            VfilterArr, FH, FW, CIG, CO, i, j, k, p
+                        ));
                     }
                 }
             }
         }
 
-        Conv2DWrapper_pt(
-            N, H, W, CI, FH, FW, CO, zPadHLeft, zPadHRight, zPadWLeft,
-            zPadWRight, strideH, strideW, VinputVec, VfilterVec, VoutputVec
-        );
+        if (G == 1) {
+            Conv2DWrapper_pt(
+                N, H, W, CI, FH, FW, CO, zPadHLeft, zPadHRight, zPadWLeft,
+                zPadWRight, strideH, strideW, VinputVec, VfilterVec, VoutputVec
+            );
+        } else {
+            Conv2DGroupWrapper_pt(
+                N, H, W, CI, FH, FW, CO, zPadHLeft, zPadHRight, zPadWLeft,
+                zPadWRight, strideH, strideW, G, VinputVec, VfilterVec,
+                VoutputVec
+            );
+        }
 
         bool pass = true;
         int err_cnt = 0;
@@ -490,6 +567,246 @@ void Conv2DWrapper(
 #endif  // VERIFY_LAYERWISE
 }
 
+void Conv2DWrapper(
+    signedIntType N,
+    signedIntType H,
+    signedIntType W,
+    signedIntType CI,
+    signedIntType FH,
+    signedIntType FW,
+    signedIntType CO,
+    signedIntType zPadHLeft,
+    signedIntType zPadHRight,
+    signedIntType zPadWLeft,
+    signedIntType zPadWRight,
+    signedIntType strideH,
+    signedIntType strideW,
+    intType *inputArr,
+    intType *filterArr,
+    intType *outArr
+) {
+    Conv2DGroupWrapper(
+        N, H, W, CI, FH, FW, CO, zPadHLeft, zPadHRight, zPadWLeft, zPadWRight,
+        strideH, strideW, /*G*/ 1, inputArr, filterArr, outArr
+    );
+}
+
+// Conv2D -> (+bias) -> Relu, pipelined over nTiles tiles of output channels:
+// the ReLU of a tile runs on lane 1 while lane 0 is still busy with the
+// HomConv of the next tiles, see CheetahLinear::conv2d_tiled. The bias (one
+// per output channel, already scaled, nullptr: none) is added to the conv
+// output before the ReLU. Only the ReLU output is written. Needs kLanes >= 2,
+// and runs the layers one after another otherwise.
+void Conv2DReluWrapper(
+    signedIntType N,
+    signedIntType H,
+    signedIntType W,
+    signedIntType CI,
+    signedIntType FH,
+    signedIntType FW,
+    signedIntType CO,
+    signedIntType zPadHLeft,
+    signedIntType zPadHRight,
+    signedIntType zPadWLeft,
+    signedIntType zPadWRight,
+    signedIntType strideH,
+    signedIntType strideW,
+    intType *inputArr,
+    intType *filterArr,
+    const intType *biasArr,
+    intType *outArr,
+    int sf,
+    bool doTruncation,
+    int32_t nTiles
+) {
+    signedIntType newH = (((H + (zPadHLeft + zPadHRight) - FH) / strideH) + 1);
+    signedIntType newW = (((W + (zPadWLeft + zPadWRight) - FW) / strideW) + 1);
+    const int64_t n_one_channel = newH * newW;
+    const int64_t n_out = N * CO * n_one_channel;
+
+    auto add_bias = [&](int64_t c0, int64_t nc, intType *arr) {
+        if (biasArr == nullptr) return;
+        for (int64_t c = 0; c < nc; ++c) {
+            intType *ch = arr + c * n_one_channel;
+            for (int64_t k = 0; k < n_one_channel; ++k) {
+                ch[k] = SecretAdd(ch[k], biasArr[c0 + c]);
+            }
+        }
+    };
+
+    if (kLanes < 2 || nTiles <= 1) {
+        intType *convArr = new intType[n_out];
+        Conv2DWrapper(
+            N, H, W, CI, FH, FW, CO, zPadHLeft, zPadHRight, zPadWLeft,
+            zPadWRight, strideH, strideW, inputArr, filterArr, convArr
+        );
+        if (biasArr != nullptr) {
+            if (kActivationCHW) {
+                for (int i = 0; i < N; ++i) {
+                    add_bias(0, CO, convArr + (int64_t)i * CO * n_one_channel);
+                }
+            } else {
+                MatAddBroadCast(
+                    N * n_one_channel, CO, convArr, biasArr, convArr
+                );
+            }
+        }
+        Relu(n_out, convArr, outArr, sf, doTruncation);
+        delete[] convArr;
+        return;
+    }
+
+#ifdef LOG_LAYERWISE
+    INIT_TIMER;
+    const int64_t io_counter = cheetah_linear->io_counter();
+#endif
+
+    if (zPadWLeft < zPadWRight) {
+        std::swap(zPadWLeft, zPadWRight);
+    }
+    if (zPadHLeft < zPadHRight) {
+        std::swap(zPadHLeft, zPadHRight);
+    }
+    gemini::CheetahLinear::ConvMeta meta;
+    meta.ishape = gemini::TensorShape({CI, H, W});
+    meta.fshape = gemini::TensorShape({CI, FH, FW});
+    meta.n_filters = CO;
+    const int npads = zPadHLeft + zPadHRight + zPadWLeft + zPadWRight;
+    meta.padding = npads == 0 ? gemini::Padding::VALID : gemini::Padding::SAME;
+    meta.stride = strideH;
+    meta.is_shared_input = kIsSharedInput;
+
+    std::vector<gemini::Tensor<intType>> filters(CO);
+    for (auto &f : filters) {
+        f.Reshape(meta.fshape);
+    }
+    for (int i = 0; i < FH; i++) {
+        for (int j = 0; j < FW; j++) {
+            for (int k = 0; k < CI; k++) {
+                for (int p = 0; p < CO; p++) {
+                    filters.at(p)(k, i, j) = getRingElt(
+                        Arr4DIdxRowM(filterArr, FH, FW, CI, CO, i, j, k, p)
+                    );
+                }
+            }
+        }
+    }
+
+    printf(
+        "HomConv+Relu in %d tiles N=%ld, H=%ld, W=%ld, CI=%ld, FH=%ld, "
+        "FW=%ld, CO=%ld, S=%ld\n",
+        nTiles, N, H, W, CI, FH, FW, CO, strideH
+    );
+
+    // The output shares of the tiles, in the order of the channels, as
+    // queued by lane 0 for lane 1.
+    struct Tile {
+        int64_t offset;
+        gemini::Tensor<intType> share;
+    };
+
+    for (int i = 0; i < N; ++i) {
+        gemini::Tensor<intType> image(meta.ishape);
+        if (kActivationCHW) {
+            const intType *in_i = inputArr + (int64_t)i * CI * H * W;
+            std::transform(in_i, in_i + CI * H * W, image.data(), getRingElt);
+        } else {
+            for (int j = 0; j < H; j++) {
+                for (int k = 0; k < W; k++) {
+                    for (int p = 0; p < CI; p++) {
+                        image(p, j, k) = getRingElt(
+                            Arr4DIdxRowM(inputArr, N, H, W, CI, i, j, k, p)
+                        );
+                    }
+                }
+            }
+        }
+
+        std::deque<Tile> tiles;
+        bool finished = false;
+        std::mutex lock;
+        std::condition_variable cond;
+
+        std::thread relu_lane([&, node = kGraphNode] {
+            EnterLane(1);
+            kGraphNode = node;
+            while (true) {
+                Tile tile;
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    cond.wait(guard, [&] {
+                        return finished || !tiles.empty();
+                    });
+                    if (tiles.empty()) return;
+                    tile = std::move(tiles.front());
+                    tiles.pop_front();
+                }
+                const int64_t nc = tile.share.shape().channels();
+                const int64_t n = nc * n_one_channel;
+                intType *share = tile.share.data();
+                add_bias(tile.offset, nc, share);
+                intType *relu_out = new intType[n];
+                Relu(n, share, relu_out, sf, doTruncation);
+
+                if (kActivationCHW) {
+                    std::copy_n(
+                        relu_out, n,
+                        outArr + ((int64_t)i * CO + tile.offset) * n_one_channel
+                    );
+                } else {
+                    for (int64_t c = 0; c < nc; ++c) {
+                        for (int64_t k = 0; k < n_one_channel; ++k) {
+                            outArr
+                                [((int64_t)i * n_one_channel + k) * CO +
+                                 tile.offset + c] =
+                                    relu_out[c * n_one_channel + k];
+                        }
+                    }
+                }
+                delete[] relu_out;
+            }
+        });
+
+        auto finish = [&] {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                finished = true;
+            }
+            cond.notify_all();
+            relu_lane.join();
+        };
+
+        try {
+            cheetah_linear->conv2d_tiled(
+                image, filters, meta, nTiles,
+                [&](const gemini::CheetahLinear::ConvMeta &tile_meta,
+                    gemini::Tensor<intType> &share) {
+                    {
+                        std::lock_guard<std::mutex> guard(lock);
+                        tiles.push_back(
+                            {(int64_t)tile_meta.filter_offset, std::move(share)}
+                        );
+                    }
+                    cond.notify_all();
+                }
+            );
+        } catch (...) {
+            finish();
+            throw;
+        }
+        finish();
+    }
+
+#ifdef LOG_LAYERWISE
+    auto temp = TIMER_TILL_NOW;
+    ConvTimeInMilliSec += temp;
+    const int64_t nbytes_sent = cheetah_linear->io_counter() - io_counter;
+    std::cout << "Time in sec for current conv+relu = [" << (temp / 1000.0)
+              << "] sent [" << (nbytes_sent / 1024. / 1024.) << "] MB"
+              << std::endl;
+#endif
+}
+
 void BatchNorm(
     int32_t B,
     int32_t H,
@@ -525,26 +842,38 @@ void BatchNorm(
     gemini::Tensor<intType> in_tensor(meta.ishape);
     gemini::Tensor<intType> out_tensor;
     for (int b = 0; b < B; ++b) {
-        for (int32_t h = 0; h < H; ++h) {
-            for (int32_t w = 0; w < W; ++w) {
-                for (int32_t c = 0; c < C; ++c) {
-                    in_tensor(c, h, w) = getRingElt(
-                        Arr4DIdxRowM(inputArr, B, H, W, C, b, h, w, c)
-                    );
+        if (kActivationCHW) {
+            const intType *in_b = inputArr + (int64_t)b * C * H * W;
+            std::transform(
+                in_b, in_b + C * H * W, in_tensor.data(), getRingElt
+            );
+        } else {
+            for (int32_t h = 0; h < H; ++h) {
+                for (int32_t w = 0; w < W; ++w) {
+                    for (int32_t c = 0; c < C; ++c) {
+                        in_tensor(c, h, w) = getRingElt(
+                            Arr4DIdxRowM(inputArr, B, H, W, C, b, h, w, c)
+                        );
+                    }
                 }
             }
         }
 
         cheetah_linear->bn_direct(in_tensor, scale_vec, meta, out_tensor);
 
+        intType *out_b = outArr + (int64_t)b * H * W * C;
+        if (kActivationCHW) {
+            MatAddBroadCastRows(C, H * W, out_tensor.data(), bias, out_b);
+            continue;
+        }
         for (int32_t h = 0; h < H; ++h) {
             for (int32_t w = 0; w < W; ++w) {
                 for (int32_t c = 0; c < C; ++c) {
-                    Arr4DIdxRowM(outArr, B, H, W, C, b, h, w, c) =
-                        SecretAdd(out_tensor(c, h, w), bias[c]);
+                    Arr3DIdxRowM(out_b, H, W, C, h, w, c) = out_tensor(c, h, w);
                 }
             }
         }
+        MatAddBroadCast(H * W, C, out_b, bias, out_b);
     }
 
     if (cheetah_linear->party() == SERVER) {
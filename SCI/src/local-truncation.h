@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef LOCAL_TRUNCATION_H__
+#define LOCAL_TRUNCATION_H__
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+
+// Truncation of arithmetic shares without any communication (SecureML,
+// Mohassel and Zhang, S&P 2017).
+//
+// Let x = x0 + x1 mod 2^l with |x| < 2^b, and x0 uniform. The server
+// outputs x0 >> s, and the client outputs -((-x1) >> s) mod 2^l. The two
+// outputs add up to floor(x / 2^s) or floor(x / 2^s) + 1, except with
+// probability at most 2^(b + 1 - l) per element. Such a failure is a wrap
+// around, i.e., the output is off by about 2^(l - s), and it is not
+// detected. The local truncation is thus only used for the layers whose
+// calibrated bound b (see calibration.h) keeps 2^(b + 1 - l) under the given
+// failure probability; the other layers run the truncation protocol.
+class LocalTruncation {
+   public:
+    explicit LocalTruncation(double max_fail_prob)
+        : max_fail_prob_(max_fail_prob) {}
+
+    static double fail_prob(int bound_bits, int bitlength) {
+        return std::ldexp(1.0, bound_bits + 1 - bitlength);
+    }
+
+    // bound_bits < 0: no calibrated bound for the layer.
+    bool allows(int bound_bits, int bitlength) const {
+        return bound_bits >= 0 &&
+               fail_prob(bound_bits, bitlength) <= max_fail_prob_;
+    }
+
+    template <typename T>
+    static void truncate(
+        bool is_server, int64_t n, const T *in, T *out, int sf, T mask
+    ) {
+        if (is_server) {
+            for (int64_t i = 0; i < n; ++i) out[i] = (in[i] & mask) >> sf;
+        } else {
+            for (int64_t i = 0; i < n; ++i) {
+                out[i] = (-((-in[i] & mask) >> sf)) & mask;
+            }
+        }
+    }
+
+    // A layer of n elements truncated locally.
+    void add_local(bool is_relu, int64_t n, int bound_bits, int bitlength) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        Kind &k = kinds_[is_relu];
+        k.local_layers += 1;
+        k.local_elems += n;
+        expected_fails_ += n * fail_prob(bound_bits, bitlength);
+    }
+
+    // A layer of n elements that ran the protocol, which cost `bytes` sent
+    // by this party.
+    void add_fallback(bool is_relu, int64_t n, uint64_t bytes) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        Kind &k = kinds_[is_relu];
+        k.fallback_layers += 1;
+        k.fallback_elems += n;
+        k.fallback_bytes += bytes;
+    }
+
+    // The saved bytes are estimated with the cost per element of the layers
+    // of the same kind that ran the protocol.
+    void print_report(std::ostream &os = std::cout) const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        int64_t local_elems = 0;
+        double saved = 0.;
+        bool estimated = true;
+        for (int r : {0, 1}) {
+            const Kind &k = kinds_[r];
+            os << "Local truncation" << (r ? " (after ReLU)" : "") << ": "
+               << k.local_layers << " layers (" << k.local_elems
+               << " elements) local, " << k.fallback_layers
+               << " layers fall back\n";
+            local_elems += k.local_elems;
+            if (k.local_elems == 0) continue;
+            if (k.fallback_elems == 0) {
+                estimated = false;
+                continue;
+            }
+            saved += k.local_elems * (1. * k.fallback_bytes / k.fallback_elems);
+        }
+        os << "Local truncation: expected #failures " << expected_fails_;
+        if (local_elems > 0) {
+            os << " (rate " << (expected_fails_ / local_elems) << ")";
+        }
+        os << ", saved ~" << (saved / (1ULL << 20)) << " MiB sent";
+        if (!estimated) {
+            os << " (not counting the kinds without a fallback layer)";
+        }
+        os << std::endl;
+    }
+
+   private:
+    struct Kind {
+        int64_t local_layers = 0;
+        int64_t local_elems = 0;
+        int64_t fallback_layers = 0;
+        int64_t fallback_elems = 0;
+        uint64_t fallback_bytes = 0;
+    };
+
+    double max_fail_prob_;
+    mutable std::mutex mtx_;
+    Kind kinds_[2];  // ScaleDown, ReLU+truncation
+    double expected_fails_ = 0.;
+};
+
+// Set when the program runs with kLocalTruncFail > 0.
+extern LocalTruncation *localTruncation;
+
+#endif  // LOCAL_TRUNCATION_H__
@@ -0,0 +1,285 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef MEMORY_PLANNER_H__
+#define MEMORY_PLANNER_H__
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Places the arrays of the generated network programs (make_array/ClearMem*)
+// in one preallocated arena.
+//
+// The layer sequence of a generated program is fixed, and so is the sequence
+// of its allocations. A first run records the size and the lifetime of every
+// array, and assigns arena offsets such that arrays with overlapping
+// lifetimes never overlap in memory. The output of an element-wise layer may
+// also take the place of its input when the input dies right after the
+// layer (see note_inplace). The plan is saved, and the following runs of the
+// same program serve the k-th allocation from arena + offset[k].
+//
+// An allocation that does not match the plan (e.g., another network or
+// input shape) falls back to the heap, and so do all the later ones.
+class ActivationPlanner {
+   public:
+    static constexpr size_t kAlign = 64;
+    static constexpr size_t kHugePage = 2ULL << 20;
+
+    // Replays the plan in `path` if it exists, otherwise records one and
+    // writes it to `path` at finish().
+    explicit ActivationPlanner(const std::string &path) : path_(path) {
+        if (load(path)) {
+            map_arena();
+        }
+        recording_ = !replaying_;
+    }
+
+    ~ActivationPlanner() {
+        if (arena_ != nullptr) munmap(arena_, arena_mapped_);
+    }
+
+    template <typename T>
+    T *allocate(size_t n) {
+        const size_t bytes = n * sizeof(T);
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (replaying_) {
+            if (next_ < blocks_.size() && blocks_[next_].bytes == bytes) {
+                return reinterpret_cast<T *>(
+                    arena_ + blocks_[next_++].offset
+                );
+            }
+            std::cerr << "ActivationPlanner: allocation #" << next_
+                      << " does not match the plan, using the heap"
+                      << std::endl;
+            replaying_ = false;
+        }
+        T *p = new T[n];
+        if (recording_) {
+            live_[p] = blocks_.size();
+            blocks_.push_back({bytes, clock_++, kNever});
+            cur_bytes_ += bytes;
+            peak_bytes_ = std::max(peak_bytes_, cur_bytes_);
+        }
+        return p;
+    }
+
+    template <typename T>
+    void release(T *p) {
+        if (p == nullptr) return;
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (in_arena(p)) return;
+        if (recording_) {
+            auto kv = live_.find(p);
+            if (kv != live_.end()) {
+                blocks_[kv->second].free_t = clock_++;
+                cur_bytes_ -= blocks_[kv->second].bytes;
+                live_.erase(kv);
+            }
+        }
+        delete[] p;
+    }
+
+    // Called by an element-wise layer, which reads in[i] before writing
+    // out[i], and thus is correct for out == in.
+    void note_inplace(const void *in, const void *out) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!recording_ || in == out) return;
+        auto kin = live_.find(in);
+        auto kout = live_.find(out);
+        if (kin == live_.end() || kout == live_.end()) return;
+        inplace_.push_back({kin->second, kout->second, clock_++});
+    }
+
+    // Ends the recording: plans the offsets and saves the plan.
+    void finish(std::ostream &os = std::cout) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (recording_) {
+            recording_ = false;
+            plan();
+            save(path_);
+            os << "ActivationPlanner: saved the plan to " << path_ << "\n";
+        }
+        os << "ActivationPlanner: " << blocks_.size() << " arrays, peak "
+           << (peak_bytes_ / (1.0 * (1ULL << 20)))
+           << " MiB with one allocation each, arena "
+           << (arena_bytes_ / (1.0 * (1ULL << 20))) << " MiB ("
+           << num_inplace_ << " in-place)";
+        if (arena_ != nullptr) {
+            os << (huge_pages_ ? ", huge pages" : ", transparent huge pages");
+        }
+        os << std::endl;
+    }
+
+   private:
+    static constexpr uint64_t kNever = std::numeric_limits<uint64_t>::max();
+
+    struct Block {
+        size_t bytes;
+        uint64_t alloc_t;
+        uint64_t free_t;
+        size_t offset = 0;
+    };
+
+    struct InPlace {
+        size_t in, out;
+        uint64_t t;
+    };
+
+    bool in_arena(const void *p) const {
+        auto c = static_cast<const uint8_t *>(p);
+        return arena_ != nullptr && c >= arena_ && c < arena_ + arena_bytes_;
+    }
+
+    static size_t align(size_t n, size_t a) { return (n + a - 1) / a * a; }
+
+    size_t find(std::vector<size_t> &group, size_t b) {
+        while (group[b] != b) b = group[b] = group[group[b]];
+        return b;
+    }
+
+    // Greedy by size: the largest group is placed first, at the lowest
+    // offset that does not collide with any placed group alive at the same
+    // time.
+    void plan() {
+        const size_t n = blocks_.size();
+        std::vector<size_t> group(n);
+        std::iota(group.begin(), group.end(), 0);
+
+        // The output of an element-wise layer joins the group of its input,
+        // if it is allocated right before the layer and the input is freed
+        // right after it, i.e., nothing else touches the shared memory.
+        num_inplace_ = 0;
+        for (const InPlace &ip : inplace_) {
+            if (blocks_[ip.out].alloc_t + 1 != ip.t) continue;
+            if (blocks_[ip.in].free_t != ip.t + 1) continue;
+            if (blocks_[ip.out].bytes > blocks_[ip.in].bytes) continue;
+            group[find(group, ip.out)] = find(group, ip.in);
+            ++num_inplace_;
+        }
+
+        std::vector<size_t> roots;
+        std::vector<size_t> bytes(n, 0);
+        std::vector<uint64_t> begin(n, kNever), end(n, 0);
+        for (size_t b = 0; b < n; ++b) {
+            size_t r = find(group, b);
+            if (r == b) roots.push_back(r);
+            bytes[r] = std::max(bytes[r], align(blocks_[b].bytes, kAlign));
+            begin[r] = std::min(begin[r], blocks_[b].alloc_t);
+            end[r] = std::max(end[r], blocks_[b].free_t);
+        }
+        std::stable_sort(roots.begin(), roots.end(), [&](size_t a, size_t b) {
+            return bytes[a] > bytes[b];
+        });
+
+        std::vector<size_t> offset(n, 0);
+        std::vector<size_t> placed;
+        arena_bytes_ = 0;
+        for (size_t r : roots) {
+            std::vector<std::pair<size_t, size_t>> taken;
+            for (size_t q : placed) {
+                if (begin[q] < end[r] && begin[r] < end[q]) {
+                    taken.push_back({offset[q], offset[q] + bytes[q]});
+                }
+            }
+            std::sort(taken.begin(), taken.end());
+            size_t off = 0;
+            for (const auto &iv : taken) {
+                if (off + bytes[r] <= iv.first) break;
+                off = std::max(off, iv.second);
+            }
+            offset[r] = off;
+            placed.push_back(r);
+            arena_bytes_ = std::max(arena_bytes_, off + bytes[r]);
+        }
+
+        for (size_t b = 0; b < n; ++b) {
+            blocks_[b].offset = offset[find(group, b)];
+        }
+    }
+
+    // Format: "<#arrays> <arena bytes> <peak bytes> <#in-place>", then one
+    // "<bytes> <offset>" per array in allocation order.
+    bool save(const std::string &path) const {
+        std::ofstream out(path);
+        if (!out) return false;
+        out << blocks_.size() << " " << arena_bytes_ << " " << peak_bytes_
+            << " " << num_inplace_ << "\n";
+        for (const Block &b : blocks_) {
+            out << b.bytes << " " << b.offset << "\n";
+        }
+        return true;
+    }
+
+    bool load(const std::string &path) {
+        std::ifstream in(path);
+        if (!in) return false;
+        size_t n = 0;
+        if (!(in >> n >> arena_bytes_ >> peak_bytes_ >> num_inplace_)) {
+            return false;
+        }
+        blocks_.resize(n);
+        for (Block &b : blocks_) {
+            if (!(in >> b.bytes >> b.offset)) return false;
+            if (b.offset + b.bytes > arena_bytes_) return false;
+        }
+        return true;
+    }
+
+    // Explicit huge pages when reserved by the system, otherwise ask for
+    // transparent ones.
+    void map_arena() {
+        arena_mapped_ = align(std::max<size_t>(arena_bytes_, 1), kHugePage);
+        void *p = mmap(
+            nullptr, arena_mapped_, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0
+        );
+        huge_pages_ = (p != MAP_FAILED);
+        if (!huge_pages_) {
+            p = mmap(
+                nullptr, arena_mapped_, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+            );
+            if (p == MAP_FAILED) {
+                std::cerr << "ActivationPlanner: failed to map the arena"
+                          << std::endl;
+                return;
+            }
+            madvise(p, arena_mapped_, MADV_HUGEPAGE);
+        }
+        arena_ = static_cast<uint8_t *>(p);
+        replaying_ = true;
+    }
+
+    std::string path_;
+    std::mutex mtx_;
+    bool recording_ = false;
+    bool replaying_ = false;
+
+    std::vector<Block> blocks_;
+    std::vector<InPlace> inplace_;
+    std::unordered_map<const void *, size_t> live_;
+    uint64_t clock_ = 0;
+    size_t next_ = 0;
+
+    size_t cur_bytes_ = 0;
+    size_t peak_bytes_ = 0;
+    size_t arena_bytes_ = 0;
+    size_t num_inplace_ = 0;
+
+    uint8_t *arena_ = nullptr;
+    size_t arena_mapped_ = 0;
+    bool huge_pages_ = false;
+};
+
+// Set when the program runs with a memory plan (see kMemPlanPath).
+extern ActivationPlanner *activationPlanner;
+
+#endif  // MEMORY_PLANNER_H__
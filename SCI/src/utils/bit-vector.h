@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef BIT_VECTOR_H__
+#define BIT_VECTOR_H__
+#include <immintrin.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Bit packing, LSB first: bit j of byte i is the (8 * i + j)-th bool, as for
+// bool_to_uint8/uint8_to_bool and IOChannel::send_bool. A bool is set when
+// its byte is non-zero.
+namespace sci {
+    // Packs the n bools of `in` into the ceil(n / 8) bytes of `out`.
+    inline void pack_bits(const uint8_t *in, size_t n, uint8_t *out) {
+        size_t i = 0;
+#if defined(__AVX512BW__)
+        for (; i + 64 <= n; i += 64) {
+            __m512i v = _mm512_loadu_si512((const void *)(in + i));
+            uint64_t bits = _mm512_test_epi8_mask(v, v);
+            std::memcpy(out + i / 8, &bits, sizeof(bits));
+        }
+#endif
+#if defined(__AVX2__)
+        const __m256i zero = _mm256_setzero_si256();
+        for (; i + 32 <= n; i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+            uint32_t bits =
+                ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero));
+            std::memcpy(out + i / 8, &bits, sizeof(bits));
+        }
+#endif
+        for (; i + 8 <= n; i += 8) {
+            uint64_t v;
+            std::memcpy(&v, in + i, sizeof(v));
+            // Sets the LSB of every non-zero byte, then gathers the LSBs.
+            v |= v >> 4;
+            v |= v >> 2;
+            v |= v >> 1;
+            v &= 0x0101010101010101ULL;
+            out[i / 8] = (uint8_t)((v * 0x0102040810204080ULL) >> 56);
+        }
+        if (i < n) {
+            uint8_t last = 0;
+            for (size_t j = 0; i + j < n; ++j) {
+                if (in[i + j]) last |= (uint8_t)(1 << j);
+            }
+            out[i / 8] = last;
+        }
+    }
+
+    inline void pack_bits(const bool *in, size_t n, uint8_t *out) {
+        pack_bits((const uint8_t *)in, n, out);
+    }
+
+    // Unpacks the ceil(n / 8) bytes of `in` into n bools (0 or 1).
+    inline void unpack_bits(const uint8_t *in, size_t n, uint8_t *out) {
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256i shuffle = _mm256_setr_epi64x(
+            0x0000000000000000LL, 0x0101010101010101LL, 0x0202020202020202LL,
+            0x0303030303030303LL
+        );
+        const __m256i select = _mm256_set1_epi64x(0x8040201008040201LL);
+        const __m256i one = _mm256_set1_epi8(1);
+        for (; i + 32 <= n; i += 32) {
+            uint32_t bits;
+            std::memcpy(&bits, in + i / 8, sizeof(bits));
+            // Byte j gets the byte of its bit, and keeps only that bit.
+            __m256i v = _mm256_shuffle_epi8(_mm256_set1_epi32(bits), shuffle);
+            v = _mm256_cmpeq_epi8(_mm256_and_si256(v, select), select);
+            _mm256_storeu_si256((__m256i *)(out + i), _mm256_and_si256(v, one));
+        }
+#endif
+        for (; i + 8 <= n; i += 8) {
+#if defined(__BMI2__)
+            uint64_t v = _pdep_u64(in[i / 8], 0x0101010101010101ULL);
+#else
+            uint64_t v = 0;
+            for (int j = 0; j < 8; ++j) {
+                v |= (uint64_t)((in[i / 8] >> j) & 1) << (8 * j);
+            }
+#endif
+            std::memcpy(out + i, &v, sizeof(v));
+        }
+        for (; i < n; ++i) {
+            out[i] = (in[i / 8] >> (i % 8)) & 1;
+        }
+    }
+
+    inline void unpack_bits(const uint8_t *in, size_t n, bool *out) {
+        unpack_bits(in, n, (uint8_t *)out);
+    }
+
+    // A vector of n bits, packed as above, for the protocols that keep their
+    // shares of bits in one byte each. It costs 8 times less memory, and is
+    // sent as is by IOChannel::send_bits. The bits past n are kept at zero.
+    class BitVector {
+       public:
+        BitVector() = default;
+
+        explicit BitVector(size_t n) : n_(n), bytes_((n + 7) / 8, 0) {}
+
+        BitVector(const uint8_t *bits, size_t n) : BitVector(n) {
+            pack_bits(bits, n, bytes_.data());
+        }
+
+        BitVector(const bool *bits, size_t n) : BitVector(n) {
+            pack_bits(bits, n, bytes_.data());
+        }
+
+        size_t size() const { return n_; }
+
+        size_t num_bytes() const { return bytes_.size(); }
+
+        uint8_t *data() { return bytes_.data(); }
+
+        const uint8_t *data() const { return bytes_.data(); }
+
+        void resize(size_t n) {
+            n_ = n;
+            bytes_.resize((n + 7) / 8, 0);
+            clear_tail();
+        }
+
+        bool get(size_t i) const { return (bytes_[i / 8] >> (i % 8)) & 1; }
+
+        void set(size_t i, bool b) {
+            const uint8_t bit = (uint8_t)(1 << (i % 8));
+            bytes_[i / 8] = b ? (bytes_[i / 8] | bit) : (bytes_[i / 8] & ~bit);
+        }
+
+        void to_bools(uint8_t *out) const {
+            unpack_bits(bytes_.data(), n_, out);
+        }
+
+        void to_bools(bool *out) const { unpack_bits(bytes_.data(), n_, out); }
+
+        // Called after writing to data(), e.g., after a recv.
+        void clear_tail() {
+            if (n_ % 8) bytes_.back() &= (uint8_t)((1 << (n_ % 8)) - 1);
+        }
+
+        BitVector &operator^=(const BitVector &oth) {
+            for (size_t i = 0; i < bytes_.size(); ++i) {
+                bytes_[i] ^= oth.bytes_[i];
+            }
+            return *this;
+        }
+
+        BitVector &operator&=(const BitVector &oth) {
+            for (size_t i = 0; i < bytes_.size(); ++i) {
+                bytes_[i] &= oth.bytes_[i];
+            }
+            return *this;
+        }
+
+       private:
+        size_t n_ = 0;
+        std::vector<uint8_t> bytes_;
+    };
+}  // namespace sci
+#endif  // BIT_VECTOR_H__
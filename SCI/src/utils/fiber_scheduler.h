@@ -0,0 +1,192 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef FIBER_SCHEDULER_H__
+#define FIBER_SCHEDULER_H__
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace sci {
+    /*
+     * Runs many protocol sessions on one thread. Each session is a fiber
+     * with its own stack, and the NetIO channels created on a fiber are
+     * cooperative: instead of blocking on the socket, they park the fiber
+     * on an epoll loop and switch to a session that has data ready. The
+     * protocols themselves are unchanged.
+     *
+     * The fibers of a thread share its thread_local state, e.g., the
+     * protocol pointers of globals.h, so the sessions MUST own their
+     * protocol objects, as in tests/test_ring_sessions.cpp.
+     */
+    class FiberScheduler {
+       public:
+        static constexpr size_t kDefaultStackSize = 8 << 20;
+
+        explicit FiberScheduler(size_t stack_size = kDefaultStackSize)
+            : stack_size_(stack_size) {
+            epfd_ = epoll_create1(EPOLL_CLOEXEC);
+            if (epfd_ < 0) {
+                perror("error: epoll_create1");
+                exit(1);
+            }
+        }
+
+        ~FiberScheduler() {
+            for (Fiber *f : ready_) destroy(f);
+            close(epfd_);
+        }
+
+        FiberScheduler(const FiberScheduler &) = delete;
+        FiberScheduler &operator=(const FiberScheduler &) = delete;
+
+        // The scheduler run()ning on this thread, if any
+        static FiberScheduler *&current() {
+            static thread_local FiberScheduler *sched = nullptr;
+            return sched;
+        }
+
+        bool in_fiber() const { return running_ != nullptr; }
+
+        void spawn(std::function<void()> fn) {
+            Fiber *f = new Fiber;
+            f->fn = std::move(fn);
+            // Lazily committed, with a guard page below the stack
+            const size_t page = sysconf(_SC_PAGESIZE);
+            f->stack_size = stack_size_ + page;
+            f->stack = mmap(
+                nullptr, f->stack_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0
+            );
+            if (f->stack == MAP_FAILED || mprotect(f->stack, page, PROT_NONE)) {
+                perror("error: fiber stack");
+                exit(1);
+            }
+            getcontext(&f->ctx);
+            f->ctx.uc_stack.ss_sp = (char *)f->stack + page;
+            f->ctx.uc_stack.ss_size = stack_size_;
+            f->ctx.uc_link = &loop_ctx_;
+            makecontext(&f->ctx, &FiberScheduler::entry, 0);
+            ready_.push_back(f);
+        }
+
+        // Until all the fibers are done
+        void run() {
+            FiberScheduler *outer = current();
+            current() = this;
+            std::vector<epoll_event> events(64);
+            while (!ready_.empty() || num_waiting_ > 0) {
+                if (ready_.empty()) {
+                    int n = epoll_wait(epfd_, events.data(), events.size(), -1);
+                    if (n < 0 && errno != EINTR) {
+                        perror("error: epoll_wait");
+                        exit(1);
+                    }
+                    for (int i = 0; i < n; i++) {
+                        ready_.push_back((Fiber *)events[i].data.ptr);
+                        num_waiting_--;
+                    }
+                    continue;
+                }
+                running_ = ready_.front();
+                ready_.pop_front();
+                swapcontext(&loop_ctx_, &running_->ctx);
+                if (running_->done) destroy(running_);
+                running_ = nullptr;
+            }
+            current() = outer;
+        }
+
+        // From a fiber: parks it until fd has the (EPOLLIN/EPOLLOUT) events
+        void wait(int fd, uint32_t events) {
+            epoll_event ev;
+            ev.events = events | EPOLLONESHOT;
+            ev.data.ptr = running_;
+            if (epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev) < 0 &&
+                (errno != ENOENT ||
+                 epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) < 0)) {
+                perror("error: epoll_ctl");
+                exit(1);
+            }
+            num_waiting_++;
+            swapcontext(&running_->ctx, &loop_ctx_);
+        }
+
+        // From a fiber: lets the other ready fibers run first
+        void yield() {
+            ready_.push_back(running_);
+            swapcontext(&running_->ctx, &loop_ctx_);
+        }
+
+        // Waits for fd on the fiber of this thread, or blocks the thread
+        // if there is none.
+        static void wait_fd(int fd, uint32_t events) {
+            FiberScheduler *sched = current();
+            if (sched != nullptr && sched->in_fiber()) {
+                sched->wait(fd, events);
+            } else {
+                pollfd pfd{fd, short(events), 0};
+                poll(&pfd, 1, -1);
+            }
+        }
+
+        // num_sessions sessions over num_threads threads, session(s) for
+        // s = t, t + num_threads, ... on thread t
+        static void run_sessions(
+            int num_threads,
+            int num_sessions,
+            const std::function<void(int)> &session,
+            size_t stack_size = kDefaultStackSize
+        ) {
+            std::vector<std::thread> threads;
+            for (int t = 0; t < num_threads; t++) {
+                threads.emplace_back([=, &session]() {
+                    FiberScheduler sched(stack_size);
+                    for (int s = t; s < num_sessions; s += num_threads) {
+                        sched.spawn([s, &session]() { session(s); });
+                    }
+                    sched.run();
+                });
+            }
+            for (auto &t : threads) t.join();
+        }
+
+       private:
+        struct Fiber {
+            ucontext_t ctx;
+            void *stack = nullptr;
+            size_t stack_size = 0;
+            std::function<void()> fn;
+            bool done = false;
+        };
+
+        static void entry() {
+            Fiber *f = current()->running_;
+            f->fn();
+            f->done = true;
+            // Back to loop_ctx_ through uc_link
+        }
+
+        void destroy(Fiber *f) {
+            munmap(f->stack, f->stack_size);
+            delete f;
+        }
+
+        size_t stack_size_;
+        int epfd_ = -1;
+        ucontext_t loop_ctx_;
+        Fiber *running_ = nullptr;
+        std::deque<Fiber *> ready_;
+        size_t num_waiting_ = 0;
+    };
+}  // namespace sci
+#endif  // FIBER_SCHEDULER_H__
@@ -67,7 +67,9 @@ namespace emp {
         Point(const Point &p);
         Point &operator=(Point p);
 
-        void to_bin(unsigned char *buf, size_t buf_len);
+        void to_bin(
+            unsigned char *buf, size_t buf_len, bool compressed = false
+        );
         size_t size();
         void from_bin(Group *g, const unsigned char *buf, size_t buf_len);
 
@@ -90,6 +92,8 @@ namespace emp {
         Group();
         ~Group();
         void resize_scratch(size_t size);
+        // The length of a point in the compressed form.
+        size_t compressed_size();
         void get_rand_bn(BigInt &n);
         Point get_generator();
         Point mul_gen(const BigInt &m);
@@ -106,10 +106,14 @@ namespace emp {
         return *this;
     }
 
-    inline void Point::to_bin(unsigned char *buf, size_t buf_len) {
+    inline void Point::to_bin(
+        unsigned char *buf, size_t buf_len, bool compressed
+    ) {
         int ret = EC_POINT_point2oct(
-            group->ec_group, point, POINT_CONVERSION_UNCOMPRESSED, buf, buf_len,
-            group->bn_ctx
+            group->ec_group, point,
+            compressed ? POINT_CONVERSION_COMPRESSED
+                       : POINT_CONVERSION_UNCOMPRESSED,
+            buf, buf_len, group->bn_ctx
         );
         if (ret == 0) sci::error("ECC TO_BIN");
     }
@@ -192,6 +196,10 @@ namespace emp {
         }
     }
 
+    inline size_t Group::compressed_size() {
+        return (EC_GROUP_get_degree(ec_group) + 7) / 8 + 1;
+    }
+
     inline void Group::get_rand_bn(BigInt &n) { BN_rand_range(n.n, order.n); }
 
     inline Point Group::get_generator() {
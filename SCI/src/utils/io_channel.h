@@ -27,10 +27,14 @@ Modified by Deevashwer Rathee
 
 #ifndef IO_CHANNEL_H__
 #define IO_CHANNEL_H__
+#include <algorithm>
 #include <memory>  // std::align
+#include <vector>
 
+#include "utils/bit-vector.h"
 #include "utils/block.h"
 #include "utils/group.h"
+#include "utils/net_emulation.h"
 
 /** @addtogroup IO
   @{
@@ -41,11 +45,15 @@ namespace sci {
     class IOChannel {
        public:
         uint64_t counter = 0;
+        // When set, the traffic is also projected onto its network profile.
+        std::unique_ptr<NetEmulator> emulator;
         void send_data(const void *data, int nbyte) {
             counter += nbyte;
+            if (emulator) emulator->on_send(nbyte);
             derived().send_data_internal(data, nbyte);
         }
         void recv_data(void *data, int nbyte) {
+            if (emulator) emulator->on_recv(nbyte);
             derived().recv_data_internal(data, nbyte);
         }
 
@@ -83,6 +91,26 @@ namespace sci {
             }
         }
 
+        // Sends the points back to back in the compressed form, in one
+        // buffer without the length prefixes of send_pt.
+        void send_pts(emp::Group *g, emp::Point *A, int num_pts) {
+            const size_t len = g->compressed_size();
+            std::vector<unsigned char> buf(len * num_pts);
+            for (int i = 0; i < num_pts; ++i) {
+                A[i].to_bin(buf.data() + i * len, len, /*compressed*/ true);
+            }
+            send_data(buf.data(), buf.size());
+        }
+
+        void recv_pts(emp::Group *g, emp::Point *A, int num_pts) {
+            const size_t len = g->compressed_size();
+            std::vector<unsigned char> buf(len * num_pts);
+            recv_data(buf.data(), buf.size());
+            for (int i = 0; i < num_pts; ++i) {
+                A[i].from_bin(g, buf.data() + i * len, len);
+            }
+        }
+
         void send_bool(bool *data, int length) {
             void *ptr = (void *)data;
             size_t space = length;
@@ -111,50 +139,44 @@ namespace sci {
             }
         }
 
+        // The bools are packed 8 per byte, and sent in chunks of at most
+        // kBoolChunk bytes, the remaining length % 8 bools as is.
         void send_bool_aligned(const bool *data, int length) {
-            unsigned long long *data64 = (unsigned long long *)data;
-            int i = 0;
-            for (; i < length / 8; ++i) {
-                unsigned long long mask = 0x0101010101010101ULL;
-                unsigned long long tmp = 0;
-#if defined(__BMI2__)
-                tmp = _pext_u64(data64[i], mask);
-#else
-                // https://github.com/Forceflow/libmorton/issues/6
-                for (unsigned long long bb = 1; mask != 0; bb += bb) {
-                    if (data64[i] & mask & -mask) {
-                        tmp |= bb;
-                    }
-                    mask &= (mask - 1);
-                }
-#endif
-                send_data(&tmp, 1);
+            const int nbytes = length / 8;
+            std::vector<uint8_t> staging(std::min(nbytes, kBoolChunk));
+            for (int i = 0; i < nbytes; i += kBoolChunk) {
+                const int m = std::min(kBoolChunk, nbytes - i);
+                pack_bits(data + 8 * i, 8 * m, staging.data());
+                send_data(staging.data(), m);
             }
-            if (8 * i != length) send_data(data + 8 * i, length - 8 * i);
+            if (8 * nbytes != length)
+                send_data(data + 8 * nbytes, length - 8 * nbytes);
         }
         void recv_bool_aligned(bool *data, int length) {
-            unsigned long long *data64 = (unsigned long long *)data;
-            int i = 0;
-            for (; i < length / 8; ++i) {
-                unsigned long long mask = 0x0101010101010101ULL;
-                unsigned long long tmp = 0;
-                recv_data(&tmp, 1);
-#if defined(__BMI2__)
-                data64[i] = _pdep_u64(tmp, mask);
-#else
-                data64[i] = 0;
-                for (unsigned long long bb = 1; mask != 0; bb += bb) {
-                    if (tmp & bb) {
-                        data64[i] |= mask & (-mask);
-                    }
-                    mask &= (mask - 1);
-                }
-#endif
+            const int nbytes = length / 8;
+            std::vector<uint8_t> staging(std::min(nbytes, kBoolChunk));
+            for (int i = 0; i < nbytes; i += kBoolChunk) {
+                const int m = std::min(kBoolChunk, nbytes - i);
+                recv_data(staging.data(), m);
+                unpack_bits(staging.data(), 8 * m, data + 8 * i);
             }
-            if (8 * i != length) recv_data(data + 8 * i, length - 8 * i);
+            if (8 * nbytes != length)
+                recv_data(data + 8 * nbytes, length - 8 * nbytes);
+        }
+
+        void send_bits(const BitVector &bits) {
+            send_data(bits.data(), bits.num_bytes());
+        }
+
+        // `bits` MUST have the size of the sent one.
+        void recv_bits(BitVector &bits) {
+            recv_data(bits.data(), bits.num_bytes());
+            bits.clear_tail();
         }
 
        private:
+        static constexpr int kBoolChunk = 1 << 16;
+
         T &derived() { return *static_cast<T *>(this); }
     };
     /**@}*/
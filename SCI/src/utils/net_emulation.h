@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef NET_EMULATION_H__
+#define NET_EMULATION_H__
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace sci {
+    // The network a run is projected onto, see NetEmulator.
+    struct NetProfile {
+        std::string name;
+        double latency_ms = 0.;      // one-way
+        double bandwidth_mbps = 0.;  // 0: unlimited
+        double jitter_ms = 0.;       // uniform in [0, jitter_ms), per message
+        uint64_t overhead_bytes = 0; // per message, e.g., the TCP/IP headers
+
+        // "lan" and "wan" are the settings of scripts/throttle.sh, otherwise
+        // "latency_ms:bandwidth_mbps[:jitter_ms[:overhead_bytes]]".
+        static bool parse(const std::string &spec, NetProfile &profile) {
+            profile = NetProfile();
+            profile.name = spec;
+            if (spec == "lan") {
+                profile.latency_ms = 0.15;
+                profile.bandwidth_mbps = 3000.;
+                return true;
+            }
+            if (spec == "wan") {
+                profile.latency_ms = 20.;
+                profile.bandwidth_mbps = 400.;
+                return true;
+            }
+            std::istringstream in(spec);
+            std::string field;
+            double values[4] = {0., 0., 0., 0.};
+            int n = 0;
+            while (n < 4 && std::getline(in, field, ':')) {
+                char *end = nullptr;
+                values[n] = std::strtod(field.c_str(), &end);
+                if (field.empty() || *end != '\0' || values[n] < 0.) {
+                    return false;
+                }
+                ++n;
+            }
+            if (n < 2 || !in.eof()) {
+                return false;
+            }
+            profile.latency_ms = values[0];
+            profile.bandwidth_mbps = values[1];
+            profile.jitter_ms = values[2];
+            profile.overhead_bytes = static_cast<uint64_t>(values[3]);
+            return true;
+        }
+    };
+
+    // Projects the traffic of one channel onto a NetProfile, without
+    // delaying it: the channel runs at the speed of the actual link (e.g.,
+    // the loopback), and the emulator accumulates the time the same traffic
+    // would have spent on the profile.
+    //
+    // A message is a maximal run of sends (or receives) between two changes
+    // of direction, as for NetIO::num_rounds. Every received message costs
+    // the one-way latency plus a jitter, every message its overhead bytes,
+    // and every byte, sent or received, 1/bandwidth: a party is assumed not
+    // to overlap its sends with its receives, which is how the protocols
+    // alternate anyway. The jitter is drawn from a seeded generator, so
+    // that two runs of the same program project the same time.
+    class NetEmulator {
+       public:
+        explicit NetEmulator(const NetProfile &profile, uint64_t seed = 0)
+            : profile_(profile), gen_(seed) {}
+
+        const NetProfile &profile() const { return profile_; }
+
+        void on_send(uint64_t nbyte) {
+            if (last_ != Direction::Send) {
+                last_ = Direction::Send;
+                ++messages_;
+                bytes_ += profile_.overhead_bytes;
+            }
+            bytes_ += nbyte;
+        }
+
+        void on_recv(uint64_t nbyte) {
+            if (last_ != Direction::Recv) {
+                last_ = Direction::Recv;
+                ++messages_;
+                bytes_ += profile_.overhead_bytes;
+                latency_ms_ += profile_.latency_ms;
+                if (profile_.jitter_ms > 0.) {
+                    std::uniform_real_distribution<double> jitter(
+                        0., profile_.jitter_ms
+                    );
+                    latency_ms_ += jitter(gen_);
+                }
+            }
+            bytes_ += nbyte;
+        }
+
+        uint64_t messages() const { return messages_; }
+
+        uint64_t bytes() const { return bytes_; }
+
+        // The time the traffic since the last reset() would have spent on
+        // the network.
+        double delay_ms() const {
+            double transfer_ms = 0.;
+            if (profile_.bandwidth_mbps > 0.) {
+                transfer_ms = bytes_ * 8. / (profile_.bandwidth_mbps * 1e3);
+            }
+            return latency_ms_ + transfer_ms;
+        }
+
+        void reset() {
+            messages_ = 0;
+            bytes_ = 0;
+            latency_ms_ = 0.;
+        }
+
+       private:
+        enum class Direction { None, Send, Recv };
+
+        NetProfile profile_;
+        std::mt19937_64 gen_;
+        Direction last_ = Direction::None;
+        uint64_t messages_ = 0;
+        uint64_t bytes_ = 0;
+        double latency_ms_ = 0.;
+    };
+}  // namespace sci
+#endif  // NET_EMULATION_H__
@@ -32,11 +32,14 @@ Enquiries about further applications and development opportunities are welcome.
 #include <iostream>
 #include <memory>  // std::align
 #include <string>
+#include <vector>
 
+#include "utils/fiber_scheduler.h"
 #include "utils/io_channel.h"
 using std::string;
 
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <sys/socket.h>
@@ -62,9 +65,17 @@ namespace sci {
         int port;
         uint64_t num_rounds = 0;
         LastCall last_call = LastCall::None;
+        // Created on a fiber (FiberScheduler): the socket is non-blocking,
+        // and the fiber waits on the scheduler instead. The stdio stream is
+        // bypassed for the buffers below.
+        bool cooperative = false;
+        std::vector<char> send_buf, recv_buf;
+        size_t recv_pos = 0, recv_end = 0;
         NetIO(const char *address, int port, bool quiet = false) {
             this->port = port;
             is_server = (address == nullptr);
+            FiberScheduler *sched = FiberScheduler::current();
+            cooperative = (sched != nullptr && sched->in_fiber());
             if (address == nullptr) {
                 struct sockaddr_in dest;
                 struct sockaddr_in serv;
@@ -91,8 +102,22 @@ namespace sci {
                     perror("error: listen");
                     exit(1);
                 }
-                consocket =
-                    accept(mysocket, (struct sockaddr *)&dest, &socksize);
+                if (cooperative) {
+                    set_nonblocking(mysocket);
+                    while ((consocket = accept(
+                                mysocket, (struct sockaddr *)&dest, &socksize
+                            )) < 0) {
+                        if (errno != EAGAIN && errno != EWOULDBLOCK &&
+                            errno != EINTR) {
+                            perror("error: accept");
+                            exit(1);
+                        }
+                        FiberScheduler::wait_fd(mysocket, EPOLLIN);
+                    }
+                } else {
+                    consocket =
+                        accept(mysocket, (struct sockaddr *)&dest, &socksize);
+                }
                 close(mysocket);
             } else {
                 addr = string(address);
@@ -115,9 +140,15 @@ namespace sci {
 
                     close(consocket);
                     usleep(1000);
+                    if (cooperative) sched->yield();
                 }
             }
             set_nodelay();
+            if (cooperative) {
+                set_nonblocking(consocket);
+                send_buf.reserve(NETWORK_BUFFER_SIZE);
+                recv_buf.resize(NETWORK_BUFFER_SIZE);
+            }
             stream = fdopen(consocket, "wb+");
             buffer = new char[NETWORK_BUFFER_SIZE];
             memset(buffer, 0, NETWORK_BUFFER_SIZE);
@@ -139,7 +170,7 @@ namespace sci {
         }
 
         ~NetIO() {
-            fflush(stream);
+            flush();
             close(consocket);
             delete[] buffer;
         }
@@ -156,13 +187,72 @@ namespace sci {
             );
         }
 
-        void flush() { fflush(stream); }
+        static void set_nonblocking(int fd) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        }
+
+        void flush() {
+            if (cooperative) {
+                send_all(send_buf.data(), send_buf.size());
+                send_buf.clear();
+            } else {
+                fflush(stream);
+            }
+        }
+
+        void send_all(const char *data, size_t len) {
+            while (len > 0) {
+                ssize_t res = ::send(consocket, data, len, MSG_NOSIGNAL);
+                if (res > 0) {
+                    data += res;
+                    len -= res;
+                } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    FiberScheduler::wait_fd(consocket, EPOLLOUT);
+                } else if (errno != EINTR) {
+                    perror("error: net_send_data");
+                    exit(1);
+                }
+            }
+        }
+
+        // At least one byte, up to len
+        size_t recv_some(char *data, size_t len) {
+            while (true) {
+                ssize_t res = ::recv(consocket, data, len, 0);
+                if (res > 0) {
+                    return res;
+                } else if (res == 0) {
+                    fprintf(stderr, "error: net_recv_data: peer closed\n");
+                    exit(1);
+                } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    FiberScheduler::wait_fd(consocket, EPOLLIN);
+                } else if (errno != EINTR) {
+                    perror("error: net_recv_data");
+                    exit(1);
+                }
+            }
+        }
 
         void send_data_internal(const void *data, int len) {
             if (last_call != LastCall::Send) {
                 num_rounds++;
                 last_call = LastCall::Send;
             }
+            if (cooperative) {
+                if (send_buf.size() + len > size_t(NETWORK_BUFFER_SIZE)) {
+                    flush();
+                }
+                if (len >= NETWORK_BUFFER_SIZE) {
+                    send_all((const char *)data, len);
+                } else {
+                    send_buf.insert(
+                        send_buf.end(), (const char *)data,
+                        (const char *)data + len
+                    );
+                }
+                has_sent = true;
+                return;
+            }
             int sent = 0;
             while (sent < len) {
                 int res = fwrite(sent + (char *)data, 1, len - sent, stream);
@@ -179,8 +269,30 @@ namespace sci {
                 num_rounds++;
                 last_call = LastCall::Recv;
             }
-            if (has_sent) fflush(stream);
+            if (has_sent) flush();
             has_sent = false;
+            if (cooperative) {
+                char *out = (char *)data;
+                size_t left = len;
+                while (left > 0) {
+                    if (recv_pos == recv_end) {
+                        if (left >= recv_buf.size()) {
+                            size_t res = recv_some(out, left);
+                            out += res;
+                            left -= res;
+                            continue;
+                        }
+                        recv_pos = 0;
+                        recv_end = recv_some(recv_buf.data(), recv_buf.size());
+                    }
+                    size_t n = std::min(left, recv_end - recv_pos);
+                    memcpy(out, recv_buf.data() + recv_pos, n);
+                    recv_pos += n;
+                    out += n;
+                    left -= n;
+                }
+                return;
+            }
             int sent = 0;
             while (sent < len) {
                 int res = fread(sent + (char *)data, 1, len - sent, stream);
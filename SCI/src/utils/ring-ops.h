@@ -0,0 +1,414 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef RING_OPS_H__
+#define RING_OPS_H__
+#include <immintrin.h>
+
+#include <cstdint>
+
+// Local (i.e., communication-free) arithmetic on arrays of shares.
+//
+// ring_*  : Z_{2^l}, `mask` = all1Mask(l). The output is always masked, the
+//           inputs can be any uint64_t.
+// field_* : Z_p for an odd p < 2^62. The output is in [0, p). The inputs
+//           outside of [0, p) are read as int64_t and reduced as
+//           sci::neg_mod does, off the vectorized path.
+//
+// The output can alias any of the inputs. The AVX-512 path is taken when the
+// translation unit is compiled with AVX-512 enabled, otherwise AVX2.
+namespace sci {
+    namespace ring_ops_internal {
+#if defined(__AVX2__)
+        // Low 64 bits of the lane-wise product of a and b.
+        inline __m256i mullo_epi64(__m256i a, __m256i b) {
+            __m256i a_hi = _mm256_srli_epi64(a, 32);
+            __m256i b_hi = _mm256_srli_epi64(b, 32);
+            __m256i lo = _mm256_mul_epu32(a, b);
+            __m256i cross = _mm256_add_epi64(
+                _mm256_mul_epu32(a_hi, b), _mm256_mul_epu32(a, b_hi)
+            );
+            return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+        }
+
+        // x - p if x >= p. Requires x < 2^63.
+        inline __m256i cond_sub(__m256i x, __m256i p) {
+            __m256i lt = _mm256_cmpgt_epi64(p, x);
+            return _mm256_sub_epi64(x, _mm256_andnot_si256(lt, p));
+        }
+
+        // Whether all the lanes of x and y, read as int64_t, are in [0, p).
+        inline bool in_field(__m256i x, __m256i y, __m256i p) {
+            const __m256i zero = _mm256_setzero_si256();
+            __m256i neg = _mm256_or_si256(
+                _mm256_cmpgt_epi64(zero, x), _mm256_cmpgt_epi64(zero, y)
+            );
+            __m256i lt = _mm256_and_si256(
+                _mm256_cmpgt_epi64(p, x), _mm256_cmpgt_epi64(p, y)
+            );
+            __m256i ok = _mm256_andnot_si256(neg, lt);
+            return _mm256_movemask_pd(_mm256_castsi256_pd(ok)) == 0xF;
+        }
+#endif
+
+        // x mod p for x read as an int64_t, as sci::neg_mod.
+        inline uint64_t field_reduce(uint64_t x, uint64_t p) {
+            if (x < p) return x;
+            const int64_t r = (int64_t)x % (int64_t)p;
+            return r < 0 ? r + p : r;
+        }
+
+        inline uint64_t field_add(uint64_t x, uint64_t y, uint64_t p) {
+            const uint64_t s = field_reduce(x, p) + field_reduce(y, p);
+            return s >= p ? s - p : s;
+        }
+
+        inline uint64_t field_sub(uint64_t x, uint64_t y, uint64_t p) {
+            x = field_reduce(x, p);
+            y = field_reduce(y, p);
+            return x >= y ? x - y : x + (p - y);
+        }
+    }  // namespace ring_ops_internal
+
+    // c[i] = (a[i] + b[i]) mod 2^l
+    inline void ring_add(
+        int64_t n,
+        const uint64_t *a,
+        const uint64_t *b,
+        uint64_t *c,
+        uint64_t mask
+    ) {
+        int64_t i = 0;
+#if defined(__AVX512F__)
+        const __m512i vmask = _mm512_set1_epi64(mask);
+        for (; i + 8 <= n; i += 8) {
+            __m512i x = _mm512_loadu_si512(a + i);
+            __m512i y = _mm512_loadu_si512(b + i);
+            _mm512_storeu_si512(
+                c + i, _mm512_and_si512(_mm512_add_epi64(x, y), vmask)
+            );
+        }
+#elif defined(__AVX2__)
+        const __m256i vmask = _mm256_set1_epi64x(mask);
+        for (; i + 4 <= n; i += 4) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+            __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+            _mm256_storeu_si256(
+                (__m256i *)(c + i),
+                _mm256_and_si256(_mm256_add_epi64(x, y), vmask)
+            );
+        }
+#endif
+        for (; i < n; ++i) c[i] = (a[i] + b[i]) & mask;
+    }
+
+    // c[i] = (a[i] - b[i]) mod 2^l
+    inline void ring_sub(
+        int64_t n,
+        const uint64_t *a,
+        const uint64_t *b,
+        uint64_t *c,
+        uint64_t mask
+    ) {
+        int64_t i = 0;
+#if defined(__AVX512F__)
+        const __m512i vmask = _mm512_set1_epi64(mask);
+        for (; i + 8 <= n; i += 8) {
+            __m512i x = _mm512_loadu_si512(a + i);
+            __m512i y = _mm512_loadu_si512(b + i);
+            _mm512_storeu_si512(
+                c + i, _mm512_and_si512(_mm512_sub_epi64(x, y), vmask)
+            );
+        }
+#elif defined(__AVX2__)
+        const __m256i vmask = _mm256_set1_epi64x(mask);
+        for (; i + 4 <= n; i += 4) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+            __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+            _mm256_storeu_si256(
+                (__m256i *)(c + i),
+                _mm256_and_si256(_mm256_sub_epi64(x, y), vmask)
+            );
+        }
+#endif
+        for (; i < n; ++i) c[i] = (a[i] - b[i]) & mask;
+    }
+
+    // c[i][j] = (a[i][j] + b[j]) mod 2^l for a row-major `rows` x `cols` a.
+    inline void ring_add_bcast(
+        int64_t rows,
+        int64_t cols,
+        const uint64_t *a,
+        const uint64_t *b,
+        uint64_t *c,
+        uint64_t mask
+    ) {
+        for (int64_t r = 0; r < rows; ++r) {
+            ring_add(cols, a + r * cols, b, c + r * cols, mask);
+        }
+    }
+
+    // c[i][j] = (a[i][j] + b[i]) mod 2^l for a row-major `rows` x `cols` a,
+    // i.e., a per-channel add on a CHW tensor.
+    inline void ring_add_rowbcast(
+        int64_t rows,
+        int64_t cols,
+        const uint64_t *a,
+        const uint64_t *b,
+        uint64_t *c,
+        uint64_t mask
+    ) {
+        for (int64_t r = 0; r < rows; ++r) {
+            const uint64_t *ar = a + r * cols;
+            uint64_t *cr = c + r * cols;
+            const uint64_t br = b[r];
+            int64_t i = 0;
+#if defined(__AVX512F__)
+            const __m512i vmask = _mm512_set1_epi64(mask);
+            const __m512i vb = _mm512_set1_epi64(br);
+            for (; i + 8 <= cols; i += 8) {
+                __m512i x = _mm512_loadu_si512(ar + i);
+                _mm512_storeu_si512(
+                    cr + i, _mm512_and_si512(_mm512_add_epi64(x, vb), vmask)
+                );
+            }
+#elif defined(__AVX2__)
+            const __m256i vmask = _mm256_set1_epi64x(mask);
+            const __m256i vb = _mm256_set1_epi64x(br);
+            for (; i + 4 <= cols; i += 4) {
+                __m256i x = _mm256_loadu_si256((const __m256i *)(ar + i));
+                _mm256_storeu_si256(
+                    (__m256i *)(cr + i),
+                    _mm256_and_si256(_mm256_add_epi64(x, vb), vmask)
+                );
+            }
+#endif
+            for (; i < cols; ++i) cr[i] = (ar[i] + br) & mask;
+        }
+    }
+
+    // c[i] = (a[i] * s) mod 2^l
+    inline void ring_scalar_mul(
+        int64_t n, const uint64_t *a, uint64_t s, uint64_t *c, uint64_t mask
+    ) {
+        int64_t i = 0;
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+        const __m512i vmask = _mm512_set1_epi64(mask);
+        const __m512i vs = _mm512_set1_epi64(s);
+        for (; i + 8 <= n; i += 8) {
+            __m512i x = _mm512_loadu_si512(a + i);
+            _mm512_storeu_si512(
+                c + i, _mm512_and_si512(_mm512_mullo_epi64(x, vs), vmask)
+            );
+        }
+#elif defined(__AVX2__)
+        const __m256i vmask = _mm256_set1_epi64x(mask);
+        const __m256i vs = _mm256_set1_epi64x(s);
+        for (; i + 4 <= n; i += 4) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+            _mm256_storeu_si256(
+                (__m256i *)(c + i),
+                _mm256_and_si256(ring_ops_internal::mullo_epi64(x, vs), vmask)
+            );
+        }
+#endif
+        for (; i < n; ++i) c[i] = (a[i] * s) & mask;
+    }
+
+    // a[i] = a[i] mod 2^l
+    inline void ring_reduce(int64_t n, uint64_t *a, uint64_t mask) {
+        int64_t i = 0;
+#if defined(__AVX512F__)
+        const __m512i vmask = _mm512_set1_epi64(mask);
+        for (; i + 8 <= n; i += 8) {
+            __m512i x = _mm512_loadu_si512(a + i);
+            _mm512_storeu_si512(a + i, _mm512_and_si512(x, vmask));
+        }
+#elif defined(__AVX2__)
+        const __m256i vmask = _mm256_set1_epi64x(mask);
+        for (; i + 4 <= n; i += 4) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+            _mm256_storeu_si256((__m256i *)(a + i), _mm256_and_si256(x, vmask));
+        }
+#endif
+        for (; i < n; ++i) a[i] &= mask;
+    }
+
+    // c[i] = (a[i] + b[i]) mod p
+    inline void field_add(
+        int64_t n,
+        const uint64_t *a,
+        const uint64_t *b,
+        uint64_t *c,
+        uint64_t p
+    ) {
+        int64_t i = 0;
+#if defined(__AVX512F__)
+        const __m512i vp = _mm512_set1_epi64(p);
+        for (; i + 8 <= n; i += 8) {
+            __m512i x = _mm512_loadu_si512(a + i);
+            __m512i y = _mm512_loadu_si512(b + i);
+            if (_mm512_cmpge_epu64_mask(x, vp) |
+                _mm512_cmpge_epu64_mask(y, vp)) {
+                for (int64_t k = i; k < i + 8; ++k) {
+                    c[k] = ring_ops_internal::field_add(a[k], b[k], p);
+                }
+                continue;
+            }
+            __m512i s = _mm512_add_epi64(x, y);
+            __mmask8 ge = _mm512_cmpge_epu64_mask(s, vp);
+            _mm512_storeu_si512(c + i, _mm512_mask_sub_epi64(s, ge, s, vp));
+        }
+#elif defined(__AVX2__)
+        const __m256i vp = _mm256_set1_epi64x(p);
+        for (; i + 4 <= n; i += 4) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+            __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+            if (!ring_ops_internal::in_field(x, y, vp)) {
+                for (int64_t k = i; k < i + 4; ++k) {
+                    c[k] = ring_ops_internal::field_add(a[k], b[k], p);
+                }
+                continue;
+            }
+            _mm256_storeu_si256(
+                (__m256i *)(c + i),
+                ring_ops_internal::cond_sub(_mm256_add_epi64(x, y), vp)
+            );
+        }
+#endif
+        for (; i < n; ++i) c[i] = ring_ops_internal::field_add(a[i], b[i], p);
+    }
+
+    // c[i] = (a[i] - b[i]) mod p
+    inline void field_sub(
+        int64_t n,
+        const uint64_t *a,
+        const uint64_t *b,
+        uint64_t *c,
+        uint64_t p
+    ) {
+        int64_t i = 0;
+#if defined(__AVX512F__)
+        const __m512i vp = _mm512_set1_epi64(p);
+        for (; i + 8 <= n; i += 8) {
+            __m512i x = _mm512_loadu_si512(a + i);
+            __m512i y = _mm512_loadu_si512(b + i);
+            if (_mm512_cmpge_epu64_mask(x, vp) |
+                _mm512_cmpge_epu64_mask(y, vp)) {
+                for (int64_t k = i; k < i + 8; ++k) {
+                    c[k] = ring_ops_internal::field_sub(a[k], b[k], p);
+                }
+                continue;
+            }
+            __m512i d = _mm512_sub_epi64(x, y);
+            __mmask8 lt = _mm512_cmplt_epu64_mask(x, y);
+            _mm512_storeu_si512(c + i, _mm512_mask_add_epi64(d, lt, d, vp));
+        }
+#elif defined(__AVX2__)
+        const __m256i vp = _mm256_set1_epi64x(p);
+        for (; i + 4 <= n; i += 4) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+            __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+            if (!ring_ops_internal::in_field(x, y, vp)) {
+                for (int64_t k = i; k < i + 4; ++k) {
+                    c[k] = ring_ops_internal::field_sub(a[k], b[k], p);
+                }
+                continue;
+            }
+            __m256i lt = _mm256_cmpgt_epi64(y, x);
+            _mm256_storeu_si256(
+                (__m256i *)(c + i),
+                _mm256_add_epi64(
+                    _mm256_sub_epi64(x, y), _mm256_and_si256(lt, vp)
+                )
+            );
+        }
+#endif
+        for (; i < n; ++i) c[i] = ring_ops_internal::field_sub(a[i], b[i], p);
+    }
+
+    // c[i][j] = (a[i][j] + b[j]) mod p for a row-major `rows` x `cols` a.
+    inline void field_add_bcast(
+        int64_t rows,
+        int64_t cols,
+        const uint64_t *a,
+        const uint64_t *b,
+        uint64_t *c,
+        uint64_t p
+    ) {
+        for (int64_t r = 0; r < rows; ++r) {
+            field_add(cols, a + r * cols, b, c + r * cols, p);
+        }
+    }
+
+    // c[i][j] = (a[i][j] + b[i]) mod p for a row-major `rows` x `cols` a.
+    inline void field_add_rowbcast(
+        int64_t rows,
+        int64_t cols,
+        const uint64_t *a,
+        const uint64_t *b,
+        uint64_t *c,
+        uint64_t p
+    ) {
+        for (int64_t r = 0; r < rows; ++r) {
+            const uint64_t *ar = a + r * cols;
+            uint64_t *cr = c + r * cols;
+            const uint64_t br = ring_ops_internal::field_reduce(b[r], p);
+            int64_t i = 0;
+#if defined(__AVX512F__)
+            const __m512i vp = _mm512_set1_epi64(p);
+            const __m512i vb = _mm512_set1_epi64(br);
+            for (; i + 8 <= cols; i += 8) {
+                __m512i x = _mm512_loadu_si512(ar + i);
+                if (_mm512_cmpge_epu64_mask(x, vp)) {
+                    for (int64_t k = i; k < i + 8; ++k) {
+                        cr[k] = ring_ops_internal::field_add(ar[k], br, p);
+                    }
+                    continue;
+                }
+                __m512i s = _mm512_add_epi64(x, vb);
+                __mmask8 ge = _mm512_cmpge_epu64_mask(s, vp);
+                _mm512_storeu_si512(
+                    cr + i, _mm512_mask_sub_epi64(s, ge, s, vp)
+                );
+            }
+#elif defined(__AVX2__)
+            const __m256i vp = _mm256_set1_epi64x(p);
+            const __m256i vb = _mm256_set1_epi64x(br);
+            for (; i + 4 <= cols; i += 4) {
+                __m256i x = _mm256_loadu_si256((const __m256i *)(ar + i));
+                if (!ring_ops_internal::in_field(x, vb, vp)) {
+                    for (int64_t k = i; k < i + 4; ++k) {
+                        cr[k] = ring_ops_internal::field_add(ar[k], br, p);
+                    }
+                    continue;
+                }
+                _mm256_storeu_si256(
+                    (__m256i *)(cr + i),
+                    ring_ops_internal::cond_sub(_mm256_add_epi64(x, vb), vp)
+                );
+            }
+#endif
+            for (; i < cols; ++i) {
+                cr[i] = ring_ops_internal::field_add(ar[i], br, p);
+            }
+        }
+    }
+
+    // c[i] = (a[i] * s) mod p. There is no 64x64 -> 128 bit vector multiply
+    // on x86, so this uses Shoup's precomputed quotient for the fixed `s`.
+    inline void field_scalar_mul(
+        int64_t n, const uint64_t *a, uint64_t s, uint64_t *c, uint64_t p
+    ) {
+        s %= p;
+        const uint64_t s_shoup =
+            (uint64_t)(((unsigned __int128)s << 64) / p);
+        for (int64_t i = 0; i < n; ++i) {
+            const uint64_t x = ring_ops_internal::field_reduce(a[i], p);
+            uint64_t q = (uint64_t)(((unsigned __int128)x * s_shoup) >> 64);
+            uint64_t r = x * s - q * p;
+            c[i] = r >= p ? r - p : r;
+        }
+    }
+}  // namespace sci
+
+#endif  // RING_OPS_H__
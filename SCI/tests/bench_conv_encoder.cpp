@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: MIT
+
+// Times the coefficient index maps and the plaintext encoding of
+// gemini::TensorEncoder over the convolutions of ResNet50. The index maps
+// are built from scratch, as every layer used to, and then taken from the
+// process-wide cache; both must agree.
+
+#include <seal/seal.h>
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "gemini/cheetah/tensor_encoder.h"
+#include "gemini/cheetah/tensor_shape.h"
+
+using namespace gemini;
+using namespace std;
+
+int reps = 5;
+size_t num_filters = 4;
+
+struct ConvShape {
+    int64_t hw, ic, oc, k;
+    size_t stride;
+};
+
+// The distinct convolutions of ResNet50.
+const vector<ConvShape> kResNet50 = {
+    {224, 3, 64, 7, 2},     {56, 64, 64, 1, 1},     {56, 64, 64, 3, 1},
+    {56, 64, 256, 1, 1},    {56, 256, 64, 1, 1},    {56, 256, 512, 1, 2},
+    {28, 128, 128, 3, 1},   {28, 512, 128, 1, 1},   {28, 512, 1024, 1, 2},
+    {14, 256, 256, 3, 1},   {14, 1024, 256, 1, 1},  {14, 1024, 2048, 1, 2},
+    {7, 512, 512, 3, 1},    {7, 2048, 512, 1, 1},
+};
+
+double time_ms(const function<void()> &f) {
+    f();  // warm-up
+    auto start = chrono::high_resolution_clock::now();
+    for (int r = 0; r < reps; ++r) f();
+    auto end = chrono::high_resolution_clock::now();
+    return chrono::duration<double, milli>(end - start).count() / reps;
+}
+
+// Visits all the (h, w) slices of the indexer, as HomConv2DSS does.
+bool get_all(
+    const ConvCoeffIndexCalculator &indexer,
+    vector<vector<size_t>> &all_indices
+) {
+    all_indices.clear();
+    TensorShape out_shape;
+    for (int h = 0; h < indexer.slice_size(0); ++h) {
+        for (int w = 0; w < indexer.slice_size(1); ++w) {
+            all_indices.emplace_back();
+            if (indexer.Get({h, w}, out_shape, all_indices.back()) !=
+                Code::OK) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) reps = atoi(argv[1]);
+    const size_t N = 4096;
+    seal::EncryptionParameters parms(seal::scheme_type::bfv);
+    parms.set_poly_modulus_degree(N);
+    parms.set_coeff_modulus(seal::CoeffModulus::Create(N, {60, 49}));
+    parms.set_plain_modulus(1ULL << 37);
+    parms.set_n_special_primes(0);
+    seal::SEALContext context(parms, true, seal::sec_level_type::tc128);
+    TensorEncoder encoder(context);
+
+    mt19937_64 rdv(42);
+    const uint64_t mask = (1ULL << 37) - 1;
+    auto randomize = [&](Tensor<uint64_t> &t) {
+        for (int64_t i = 0; i < t.NumElements(); ++i) {
+            t.data()[i] = rdv() & mask;
+        }
+    };
+
+    bool all_pass = true;
+    for (const auto &s : kResNet50) {
+        TensorShape ishape({s.ic, s.hw, s.hw});
+        TensorShape fshape({s.ic, s.k, s.k});
+        const Padding padding = s.k > 1 ? Padding::SAME : Padding::VALID;
+
+        vector<vector<size_t>> fresh, cached;
+        double t_fresh = time_ms([&]() {
+            ConvCoeffIndexCalculator indexer(
+                N, ishape, fshape, padding, s.stride
+            );
+            get_all(indexer, fresh);
+        });
+        double t_cached = time_ms([&]() {
+            auto indexer = ConvCoeffIndexCalculator::Cached(
+                N, ishape, fshape, padding, s.stride
+            );
+            get_all(*indexer, cached);
+        });
+        const bool pass = (fresh == cached);
+        all_pass &= pass;
+
+        Tensor<uint64_t> image(ishape);
+        randomize(image);
+        vector<Tensor<uint64_t>> filters(num_filters);
+        for (auto &f : filters) {
+            f.Reshape(fshape);
+            randomize(f);
+        }
+        vector<seal::Plaintext> encoded;
+        double t_image = time_ms([&]() {
+            encoder.EncodeImageShare(
+                TensorEncoder::Role::masking, image, fshape, padding, s.stride,
+                false, encoded
+            );
+        });
+        double t_filter = time_ms([&]() {
+            for (const auto &f : filters) {
+                encoder.EncodeFilter(
+                    f, ishape, padding, s.stride, false, encoded
+                );
+            }
+        }) / num_filters;
+
+        cout << s.hw << "x" << s.hw << "x" << s.ic << " -> " << s.oc << ", "
+             << s.k << "x" << s.k << "/" << s.stride << ": index maps "
+             << t_fresh << " ms, cached " << t_cached << " ms; encode image "
+             << t_image << " ms, filter " << t_filter << " ms"
+             << (pass ? "" : "  [MISMATCH]") << endl;
+    }
+    return all_pass ? 0 : 1;
+}
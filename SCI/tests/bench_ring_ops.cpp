@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+
+// Compares the kernels of utils/ring-ops.h against the scalar loops they
+// replace, and checks that both produce the same output.
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include "utils/emp-tool.h"
+#include "utils/ring-ops.h"
+
+using namespace sci;
+using namespace std;
+
+int bitlength = 37;
+int64_t rows = 56 * 56;  // a ResNet50 activation, NHWC
+int64_t cols = 256;
+int reps = 20;
+uint64_t prime_mod = 2198100901889ULL;  // the 41-bit prime used by SCI_HE
+
+double time_ms(const function<void()> &f) {
+    f();  // warm-up
+    auto start = chrono::high_resolution_clock::now();
+    for (int r = 0; r < reps; ++r) f();
+    auto end = chrono::high_resolution_clock::now();
+    return chrono::duration<double, milli>(end - start).count() / reps;
+}
+
+void report(
+    const string &name,
+    const vector<uint64_t> &ref,
+    const vector<uint64_t> &out,
+    double t_ref,
+    double t_out
+) {
+    bool pass = (ref == out);
+    cout << name << ": scalar " << t_ref << " ms, kernel " << t_out
+         << " ms, speedup " << t_ref / t_out << "x"
+         << (pass ? "" : "  [MISMATCH]") << endl;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) bitlength = atoi(argv[1]);
+    const int64_t n = rows * cols;
+    const uint64_t mask = all1Mask(bitlength);
+    const uint64_t p = prime_mod;
+    const uint64_t s = 1ULL << 12;
+
+    PRG128 prg;
+    vector<uint64_t> a(n), b(n), bias(cols), ref(n), out(n);
+    vector<uint64_t> fa(n), fb(n), fbias(cols);
+    prg.random_data(a.data(), n * sizeof(uint64_t));
+    prg.random_data(b.data(), n * sizeof(uint64_t));
+    prg.random_data(bias.data(), cols * sizeof(uint64_t));
+    prg.random_mod_p<uint64_t>(fa.data(), n, p);
+    prg.random_mod_p<uint64_t>(fb.data(), n, p);
+    prg.random_mod_p<uint64_t>(fbias.data(), cols, p);
+
+    cout << "n = " << n << ", bitlength = " << bitlength << ", p = " << p
+         << endl;
+
+    double t0, t1;
+    t0 = time_ms([&]() {
+        for (int64_t i = 0; i < n; ++i) ref[i] = (a[i] + b[i]) & mask;
+    });
+    t1 = time_ms([&]() { ring_add(n, a.data(), b.data(), out.data(), mask); });
+    report("ring_add", ref, out, t0, t1);
+
+    t0 = time_ms([&]() {
+        for (int64_t i = 0; i < n; ++i) ref[i] = (a[i] - b[i]) & mask;
+    });
+    t1 = time_ms([&]() { ring_sub(n, a.data(), b.data(), out.data(), mask); });
+    report("ring_sub", ref, out, t0, t1);
+
+    t0 = time_ms([&]() {
+        for (int64_t r = 0; r < rows; ++r)
+            for (int64_t c = 0; c < cols; ++c)
+                ref[r * cols + c] = (a[r * cols + c] + bias[c]) & mask;
+    });
+    t1 = time_ms([&]() {
+        ring_add_bcast(rows, cols, a.data(), bias.data(), out.data(), mask);
+    });
+    report("ring_add_bcast", ref, out, t0, t1);
+
+    t0 = time_ms([&]() {
+        for (int64_t i = 0; i < n; ++i) ref[i] = (a[i] * s) & mask;
+    });
+    t1 = time_ms([&]() { ring_scalar_mul(n, a.data(), s, out.data(), mask); });
+    report("ring_scalar_mul", ref, out, t0, t1);
+
+    t0 = time_ms([&]() {
+        for (int64_t i = 0; i < n; ++i)
+            ref[i] = neg_mod((int64_t)(fa[i] + fb[i]), (int64_t)p);
+    });
+    t1 = time_ms([&]() { field_add(n, fa.data(), fb.data(), out.data(), p); });
+    report("field_add", ref, out, t0, t1);
+
+    t0 = time_ms([&]() {
+        for (int64_t i = 0; i < n; ++i)
+            ref[i] = neg_mod((int64_t)(fa[i] - fb[i]), (int64_t)p);
+    });
+    t1 = time_ms([&]() { field_sub(n, fa.data(), fb.data(), out.data(), p); });
+    report("field_sub", ref, out, t0, t1);
+
+    t0 = time_ms([&]() {
+        for (int64_t r = 0; r < rows; ++r)
+            for (int64_t c = 0; c < cols; ++c)
+                ref[r * cols + c] = neg_mod(
+                    (int64_t)(fa[r * cols + c] + fbias[c]), (int64_t)p
+                );
+    });
+    t1 = time_ms([&]() {
+        field_add_bcast(rows, cols, fa.data(), fbias.data(), out.data(), p);
+    });
+    report("field_add_bcast", ref, out, t0, t1);
+
+    t0 = time_ms([&]() {
+        for (int64_t i = 0; i < n; ++i)
+            ref[i] = (uint64_t)(((unsigned __int128)fa[i] * s) % p);
+    });
+    t1 = time_ms([&]() { field_scalar_mul(n, fa.data(), s, out.data(), p); });
+    report("field_scalar_mul", ref, out, t0, t1);
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: MIT
+
+// Checks the bit packing of utils/bit-vector.h, used by IOChannel::send_bool
+// and recv_bool, against the byte-wise bool_to_uint8/uint8_to_bool it
+// replaces. The lengths cover the tails of the 8-, 32- and 64-bool kernels;
+// build without AVX2/AVX-512 to check the scalar loops.
+
+#include <iostream>
+#include <vector>
+
+#include "utils/bit-vector.h"
+#include "utils/emp-tool.h"
+
+using namespace sci;
+using namespace std;
+
+int num_lengths = 2000;
+size_t max_length = 1 << 12;
+
+bool check(size_t n, PRG128 &prg) {
+    const size_t nbytes = (n + 7) / 8;
+    vector<uint8_t> in(n), bools(n), packed(nbytes), ref(nbytes);
+    vector<uint8_t> out(n), ref_out(n);
+    prg.random_data(in.data(), n);
+    for (size_t i = 0; i < n; ++i) {
+        // Half of the bytes are zero, the others any non-zero value.
+        if (!(in[i] & 1)) in[i] = 0;
+        bools[i] = in[i] != 0;
+    }
+
+    // Any non-zero byte is a set bool, as for bool_to_uint8.
+    for (const vector<uint8_t> *src : {&bools, &in}) {
+        pack_bits(src->data(), n, packed.data());
+        for (size_t i = 0; i < nbytes; ++i) {
+            ref[i] = bool_to_uint8(
+                src->data() + 8 * i, min<size_t>(8, n - 8 * i)
+            );
+        }
+        if (packed != ref) {
+            cout << "pack_bits mismatch for n = " << n << endl;
+            return false;
+        }
+    }
+
+    unpack_bits(packed.data(), n, out.data());
+    for (size_t i = 0; i < nbytes; ++i) {
+        uint8_to_bool(
+            ref_out.data() + 8 * i, packed[i], min<size_t>(8, n - 8 * i)
+        );
+    }
+    if (out != ref_out || out != bools) {
+        cout << "unpack_bits mismatch for n = " << n << endl;
+        return false;
+    }
+
+    BitVector bits(in.data(), n);
+    bits.to_bools(out.data());
+    if (out != bools || (n % 8 && (bits.data()[nbytes - 1] >> (n % 8)))) {
+        cout << "BitVector mismatch for n = " << n << endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) num_lengths = atoi(argv[1]);
+    PRG128 prg;
+    bool all_pass = true;
+    size_t num_checked = 0;
+    // Every length around the kernel widths, then random ones.
+    for (size_t n = 1; n <= 3 * 64 + 1; ++n, ++num_checked) {
+        all_pass &= check(n, prg);
+    }
+    for (int t = 0; t < num_lengths; ++t, ++num_checked) {
+        size_t n;
+        prg.random_data(&n, sizeof(n));
+        all_pass &= check(1 + n % max_length, prg);
+    }
+    cout << num_checked << " lengths: " << (all_pass ? "PASS" : "FAIL")
+         << endl;
+    return all_pass ? 0 : 1;
+}
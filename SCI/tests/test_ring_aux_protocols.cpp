@@ -28,6 +28,7 @@ using namespace std;
 
 int party, port = 8000, dim = 1 << 16;
 string address = "127.0.0.1";
+bool bit_sliced = false;
 NetIO *io;
 OTPack<NetIO> *otpack;
 AuxProtocols *aux;
@@ -311,6 +312,66 @@ void test_MSB_to_Wrap() {
     delete[] y;
 }
 
+void test_msb_to_arith_wrap() {
+    int bw_x = 32, bw_wrap = 12;
+    PRG128 prg;
+    uint64_t mask_x = (bw_x == 64 ? -1 : ((1ULL << bw_x) - 1));
+    uint64_t mask_wrap = (bw_wrap == 64 ? -1 : ((1ULL << bw_wrap) - 1));
+
+    uint64_t *x = new uint64_t[dim];
+    uint64_t *y = new uint64_t[dim];
+
+    for (int msb = 0; msb < 2; msb++) {
+        // ALICE picks her shares such that MSB(x) = msb
+        prg.random_data(x, dim * sizeof(uint64_t));
+        if (party == ALICE) {
+            uint64_t *x_bob = new uint64_t[dim];
+            io->recv_data(x_bob, dim * sizeof(uint64_t));
+            for (int i = 0; i < dim; i++) {
+                uint64_t val = (x[i] & (mask_x >> 1)) |
+                               (uint64_t(msb) << (bw_x - 1));
+                x[i] = (val - x_bob[i]) & mask_x;
+            }
+            delete[] x_bob;
+        } else {
+            for (int i = 0; i < dim; i++) {
+                x[i] = x[i] & mask_x;
+            }
+            io->send_data(x, dim * sizeof(uint64_t));
+        }
+
+        if (msb == 0) {
+            aux->msb0_to_arith_wrap(x, y, dim, bw_x, bw_wrap);
+        } else {
+            aux->msb1_to_arith_wrap(x, y, dim, bw_x, bw_wrap);
+        }
+
+        if (party == ALICE) {
+            io->send_data(x, dim * sizeof(uint64_t));
+            io->send_data(y, dim * sizeof(uint64_t));
+        } else {
+            uint64_t *x0 = new uint64_t[dim];
+            uint64_t *y0 = new uint64_t[dim];
+            io->recv_data(x0, dim * sizeof(uint64_t));
+            io->recv_data(y0, dim * sizeof(uint64_t));
+
+            for (int i = 0; i < dim; i++) {
+                assert(
+                    uint64_t(x0[i] > (mask_x - x[i])) ==
+                    ((y0[i] + y[i]) & mask_wrap)
+                );
+            }
+            delete[] x0;
+            delete[] y0;
+        }
+    }
+    if (party == BOB) {
+        cout << "MSB to Arithmetic Wrap Tests passed" << endl;
+    }
+    delete[] x;
+    delete[] y;
+}
+
 void test_AND() {
     int bw_in = 32;
     PRG128 prg;
@@ -471,12 +532,14 @@ int main(int argc, char **argv) {
     amap.arg("p", port, "Port Number");
     amap.arg("d", dim, "Size of vector");
     amap.arg("ip", address, "IP Address of server (ALICE)");
+    amap.arg("bs", bit_sliced, "Bit-sliced comparisons");
     amap.parse(argc, argv);
 
     io = new NetIO(party == 1 ? nullptr : address.c_str(), port);
     otpack = new OTPack<NetIO>(io, party);
 
     aux = new AuxProtocols(party, io, otpack);
+    aux->mill->bit_sliced = bit_sliced;
 
     test_MSB_computation();
     test_wrap_computation();
@@ -487,6 +550,7 @@ int main(int argc, char **argv) {
     test_lookup_table<uint8_t>();
     test_lookup_table<uint64_t>();
     test_MSB_to_Wrap();
+    test_msb_to_arith_wrap();
     test_AND();
 
     return 0;
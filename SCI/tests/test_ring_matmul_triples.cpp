@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: MIT
+
+#include <iostream>
+
+#include "LinearOT/matmul-triples.h"
+#include "OT/emp-ot.h"
+#include "utils/emp-tool.h"
+
+using namespace sci;
+using namespace std;
+
+int party, port = 32000;
+string address = "127.0.0.1";
+NetIO *io;
+OTPack<NetIO> *otpack;
+MatMulTriples<NetIO, uint64_t> *triples;
+
+int dim1 = 64;
+int dim2 = 256;
+int dim3 = 16;
+int bitlength = 37;
+int num_triples = 4;
+
+uint64_t mask = (bitlength == 64 ? -1 : ((1ULL << bitlength) - 1));
+
+void test_matmul(const uint64_t *inX, const uint64_t *inY) {
+    uint64_t *outZ = new uint64_t[dim1 * dim3];
+
+    INIT_TIMER;
+    START_TIMER;
+    uint64_t comm_start = io->counter;
+    triples->matmul(dim1, dim2, dim3, inX, inY, outZ);
+    uint64_t comm_end = io->counter;
+    cout << "Online bytes sent: " << (comm_end - comm_start) << endl;
+    STOP_TIMER("Online time for matmul");
+
+    if (party == ALICE) {
+        io->send_data(inX, dim1 * dim2 * sizeof(uint64_t));
+        io->send_data(inY, dim2 * dim3 * sizeof(uint64_t));
+        io->send_data(outZ, dim1 * dim3 * sizeof(uint64_t));
+    } else {  // party == BOB
+        uint64_t *inX0 = new uint64_t[dim1 * dim2];
+        uint64_t *inY0 = new uint64_t[dim2 * dim3];
+        uint64_t *outZ0 = new uint64_t[dim1 * dim3];
+        io->recv_data(inX0, dim1 * dim2 * sizeof(uint64_t));
+        io->recv_data(inY0, dim2 * dim3 * sizeof(uint64_t));
+        io->recv_data(outZ0, dim1 * dim3 * sizeof(uint64_t));
+
+        for (int i = 0; i < dim1; i++) {
+            for (int j = 0; j < dim3; j++) {
+                uint64_t res = 0;
+                for (int k = 0; k < dim2; k++) {
+                    res += (inX0[i * dim2 + k] + inX[i * dim2 + k]) *
+                           (inY0[k * dim3 + j] + inY[k * dim3 + j]);
+                }
+                assert(
+                    (res & mask) ==
+                    ((outZ[i * dim3 + j] + outZ0[i * dim3 + j]) & mask)
+                );
+            }
+        }
+        cout << "Matmul Tests Passed" << endl;
+
+        delete[] inX0;
+        delete[] inY0;
+        delete[] outZ0;
+    }
+    delete[] outZ;
+}
+
+int main(int argc, char **argv) {
+    ArgMapping amap;
+    amap.arg("r", party, "Role of party: ALICE = 1; BOB = 2");
+    amap.arg("p", port, "Port Number");
+    amap.arg("ip", address, "IP Address of server (ALICE)");
+    amap.arg("n", num_triples, "Number of triples generated offline");
+
+    amap.parse(argc, argv);
+
+    io = new NetIO(party == 1 ? nullptr : address.c_str(), port);
+    otpack = new OTPack<NetIO>(io, party);
+    triples = new MatMulTriples<NetIO, uint64_t>(
+        party, bitlength, io, otpack->silent_ot, otpack->silent_ot_reversed
+    );
+
+    INIT_TIMER;
+    START_TIMER;
+    uint64_t comm_start = io->counter;
+    triples->generate(dim1, dim2, dim3, num_triples);
+    uint64_t comm_end = io->counter;
+    cout << "Offline bytes sent per triple: "
+         << (comm_end - comm_start) / num_triples << endl;
+    STOP_TIMER("Offline time for " << num_triples << " triples");
+
+    PRG128 prg;
+    uint64_t *inX = new uint64_t[dim1 * dim2];
+    uint64_t *inY = new uint64_t[dim2 * dim3];
+    // One more product than pre-generated triples: the last one generates its
+    // triple on the fly.
+    for (int t = 0; t <= num_triples; t++) {
+        prg.random_data(inX, dim1 * dim2 * sizeof(uint64_t));
+        prg.random_data(inY, dim2 * dim3 * sizeof(uint64_t));
+        for (int i = 0; i < dim1 * dim2; i++) inX[i] &= mask;
+        for (int i = 0; i < dim2 * dim3; i++) inY[i] &= mask;
+        test_matmul(inX, inY);
+    }
+
+    delete[] inX;
+    delete[] inY;
+    delete triples;
+    delete otpack;
+    delete io;
+}
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+
+// Checks the field kernels of utils/ring-ops.h on shares outside of [0, p),
+// e.g., negative values, against sci::neg_mod as the scalar loops they
+// replace did. The lengths cover the tails of the 4- and 8-lane kernels;
+// build without AVX2/AVX-512 to check the scalar loops.
+
+#include <iostream>
+#include <vector>
+
+#include "utils/emp-tool.h"
+#include "utils/ring-ops.h"
+
+using namespace sci;
+using namespace std;
+
+int num_lengths = 200;
+int64_t max_length = 1 << 12;
+uint64_t prime_mod = 2198100901889ULL;  // the 41-bit prime used by SCI_HE
+
+uint64_t reduce(uint64_t x, uint64_t p) {
+    return neg_mod((int64_t)x, (int64_t)p);
+}
+
+// 5/8 of the values are in [0, p), the others negative, in [p, 2^62), or
+// any uint64_t. Thus both whole vectors in [0, p) and mixed ones occur.
+void random_shares(vector<uint64_t> &v, uint64_t p, PRG128 &prg) {
+    prg.random_data(v.data(), v.size() * sizeof(uint64_t));
+    for (auto &x : v) {
+        const uint64_t r = x;
+        switch ((r >> 60) & 7) {
+            case 0:
+                x = -(int64_t)((r >> 3) % p);
+                break;
+            case 1:
+                x = p + (r >> 3) % ((1ULL << 62) - p);
+                break;
+            case 2:
+                break;
+            default:
+                x = (r >> 3) % p;
+        }
+    }
+}
+
+bool check(int64_t n, uint64_t p, PRG128 &prg) {
+    const int64_t cols = 1 + n % 13;
+    const int64_t rows = n / cols;
+    vector<uint64_t> a(n), b(n), out(n), ref(n);
+    random_shares(a, p, prg);
+    random_shares(b, p, prg);
+    uint64_t s;
+    prg.random_data(&s, sizeof(s));
+    bool pass = true;
+    auto expect = [&](const char *name) {
+        if (out != ref) {
+            cout << name << " mismatch for n = " << n << endl;
+            pass = false;
+        }
+    };
+
+    for (int64_t i = 0; i < n; ++i) {
+        ref[i] = (reduce(a[i], p) + reduce(b[i], p)) % p;
+    }
+    field_add(n, a.data(), b.data(), out.data(), p);
+    expect("field_add");
+    // In place, as ElemWiseSecretAdd is called.
+    out = a;
+    field_add(n, out.data(), b.data(), out.data(), p);
+    expect("field_add (in place)");
+
+    for (int64_t i = 0; i < n; ++i) {
+        ref[i] = (reduce(a[i], p) + p - reduce(b[i], p)) % p;
+    }
+    field_sub(n, a.data(), b.data(), out.data(), p);
+    expect("field_sub");
+
+    fill(ref.begin(), ref.end(), 0);
+    fill(out.begin(), out.end(), 0);
+    for (int64_t r = 0; r < rows; ++r) {
+        for (int64_t c = 0; c < cols; ++c) {
+            ref[r * cols + c] =
+                (reduce(a[r * cols + c], p) + reduce(b[c], p)) % p;
+        }
+    }
+    field_add_bcast(rows, cols, a.data(), b.data(), out.data(), p);
+    expect("field_add_bcast");
+
+    for (int64_t r = 0; r < rows; ++r) {
+        for (int64_t c = 0; c < cols; ++c) {
+            ref[r * cols + c] =
+                (reduce(a[r * cols + c], p) + reduce(b[r], p)) % p;
+        }
+    }
+    field_add_rowbcast(rows, cols, a.data(), b.data(), out.data(), p);
+    expect("field_add_rowbcast");
+
+    for (int64_t i = 0; i < n; ++i) {
+        ref[i] =
+            (uint64_t)((unsigned __int128)reduce(a[i], p) * (s % p) % p);
+    }
+    field_scalar_mul(n, a.data(), s, out.data(), p);
+    expect("field_scalar_mul");
+    return pass;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) num_lengths = atoi(argv[1]);
+    PRG128 prg;
+    bool all_pass = true;
+    int num_checked = 0;
+    const uint64_t primes[] = {prime_mod, 65537, (1ULL << 61) - 1};
+    for (uint64_t p : primes) {
+        // Every length around the kernel widths, then random ones.
+        for (int64_t n = 1; n <= 3 * 8 + 1; ++n, ++num_checked) {
+            all_pass &= check(n, p, prg);
+        }
+        for (int t = 0; t < num_lengths; ++t, ++num_checked) {
+            uint64_t n;
+            prg.random_data(&n, sizeof(n));
+            all_pass &= check(1 + n % max_length, p, prg);
+        }
+    }
+    cout << num_checked << " lengths: " << (all_pass ? "PASS" : "FAIL")
+         << endl;
+    return all_pass ? 0 : 1;
+}
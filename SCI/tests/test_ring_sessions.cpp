@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: MIT
+
+#include <atomic>
+#include <iostream>
+
+#include "BuildingBlocks/aux-protocols.h"
+#include "BuildingBlocks/truncation.h"
+#include "utils/emp-tool.h"
+#include "utils/fiber_scheduler.h"
+
+using namespace sci;
+using namespace std;
+
+int party, port = 32000;
+int num_threads = 2;
+int num_sessions = 64;
+string address = "127.0.0.1";
+
+int dim = 1 << 12;
+int bw_x = 32;
+int shift = 12;
+
+std::atomic<int> num_passed{0};
+
+// One client session: MSB and truncation of dim random values, each on the
+// channel and OT pack of the session.
+void session(int s) {
+    NetIO *io =
+        new NetIO(party == ALICE ? nullptr : address.c_str(), port + s, true);
+    OTPack<NetIO> *otpack = new OTPack<NetIO>(io, party);
+    AuxProtocols *aux = new AuxProtocols(party, io, otpack);
+    Truncation *trunc = new Truncation(party, io, otpack, aux);
+
+    uint64_t mask_x = (bw_x == 64 ? -1 : ((1ULL << bw_x) - 1));
+    PRG128 prg;
+    uint64_t *x = new uint64_t[dim];
+    uint8_t *msb_x = new uint8_t[dim];
+    uint64_t *y = new uint64_t[dim];
+    prg.random_data(x, dim * sizeof(uint64_t));
+    for (int i = 0; i < dim; i++) {
+        x[i] &= mask_x;
+    }
+
+    aux->MSB(x, msb_x, dim, bw_x);
+    trunc->truncate(dim, x, y, shift, bw_x, true, msb_x);
+
+    if (party == ALICE) {
+        io->send_data(x, dim * sizeof(uint64_t));
+        io->send_data(y, dim * sizeof(uint64_t));
+        io->flush();
+    } else {  // party == BOB
+        uint64_t *x0 = new uint64_t[dim];
+        uint64_t *y0 = new uint64_t[dim];
+        io->recv_data(x0, dim * sizeof(uint64_t));
+        io->recv_data(y0, dim * sizeof(uint64_t));
+
+        bool pass = true;
+        for (int i = 0; i < dim; i++) {
+            int64_t X = signed_val(x0[i] + x[i], bw_x);
+            int64_t Y = signed_val(y0[i] + y[i], bw_x);
+            // Within one unit of the floor
+            int64_t diff = Y - (X >> shift);
+            pass &= (diff == 0 || diff == 1 || diff == -1);
+        }
+        if (pass) {
+            num_passed++;
+        } else {
+            cerr << "Session " << s << " failed" << endl;
+        }
+        delete[] x0;
+        delete[] y0;
+    }
+
+    delete[] x;
+    delete[] msb_x;
+    delete[] y;
+    delete trunc;
+    delete aux;
+    delete otpack;
+    delete io;
+}
+
+int main(int argc, char **argv) {
+    /************* Argument Parsing  ************/
+    /********************************************/
+    ArgMapping amap;
+    amap.arg("r", party, "Role of party: ALICE = 1; BOB = 2");
+    amap.arg("p", port, "Port Number (one per session, from p)");
+    amap.arg("S", num_sessions, "Number of concurrent sessions");
+    amap.arg("N", dim, "Number of truncations per session");
+    amap.arg("nt", num_threads, "Number of threads for all the sessions");
+    amap.arg("ip", address, "IP Address of server (ALICE)");
+
+    amap.parse(argc, argv);
+
+    /************ Run the Sessions **************/
+    /********************************************/
+    auto start = clock_start();
+    FiberScheduler::run_sessions(num_threads, num_sessions, session);
+    long long t = time_from(start);
+
+    if (party == BOB) {
+        cout << "Sessions passed: " << num_passed << "/" << num_sessions
+             << endl;
+        assert(num_passed == num_sessions);
+    }
+    cout << "Sessions Time\t" << t / (1000.0) << " ms on " << num_threads
+         << " threads" << endl;
+}
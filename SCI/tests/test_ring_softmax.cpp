@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include "Math/math-functions.h"
+
+using namespace sci;
+using namespace std;
+
+#define MAX_THREADS 4
+
+int party, port = 32000;
+int num_threads = 4;
+string address = "127.0.0.1";
+
+int rows = 1000;
+int cols = 64;
+int bw_x = 16;
+int bw_y = 16;
+int s_x = 12;
+int s_y = 12;
+
+uint64_t mask_x;
+
+sci::NetIO *ioArr[MAX_THREADS];
+sci::OTPack<sci::NetIO> *otpackArr[MAX_THREADS];
+
+uint64_t computeULPErr(double calc, double actual, int SCALE) {
+    int64_t calc_fixed = (double(calc) * (1ULL << SCALE));
+    int64_t actual_fixed = (double(actual) * (1ULL << SCALE));
+    uint64_t ulp_err = (calc_fixed - actual_fixed) > 0
+                           ? (calc_fixed - actual_fixed)
+                           : (actual_fixed - calc_fixed);
+    return ulp_err;
+}
+
+void OP_thread(int tid, uint64_t *x, uint64_t *y, int num_rows) {
+    MathFunctions *math;
+    if (tid & 1) {
+        math = new MathFunctions(3 - party, ioArr[tid], otpackArr[tid]);
+    } else {
+        math = new MathFunctions(party, ioArr[tid], otpackArr[tid]);
+    }
+    math->softmax(num_rows, cols, x, y, bw_x, bw_y, s_x, s_y);
+
+    delete math;
+}
+
+int main(int argc, char **argv) {
+    /************* Argument Parsing  ************/
+    /********************************************/
+    ArgMapping amap;
+    amap.arg("r", party, "Role of party: ALICE = 1; BOB = 2");
+    amap.arg("p", port, "Port Number");
+    amap.arg("R", rows, "Number of rows of the softmax");
+    amap.arg("C", cols, "Number of columns");
+    amap.arg("nt", num_threads, "Number of threads");
+    amap.arg("ip", address, "IP Address of server (ALICE)");
+
+    amap.parse(argc, argv);
+
+    assert(num_threads <= MAX_THREADS);
+    mask_x = (bw_x == 64 ? -1 : ((1ULL << bw_x) - 1));
+    uint64_t mask_r = (1ULL << (s_x + 2)) - 1;
+
+    /********** Setup IO and Base OTs ***********/
+    /********************************************/
+    for (int i = 0; i < num_threads; i++) {
+        ioArr[i] = new NetIO(party == 1 ? nullptr : address.c_str(), port + i);
+        if (i & 1) {
+            otpackArr[i] = new OTPack<NetIO>(ioArr[i], 3 - party);
+        } else {
+            otpackArr[i] = new OTPack<NetIO>(ioArr[i], party);
+        }
+    }
+    std::cout << "All Base OTs Done" << std::endl;
+
+    /************ Generate Test Data ************/
+    /********************************************/
+    PRG128 prg;
+
+    int dim = rows * cols;
+    uint64_t *x = new uint64_t[dim];
+    uint64_t *y = new uint64_t[dim];
+
+    prg.random_data(x, dim * sizeof(uint64_t));
+
+    for (int i = 0; i < dim; i++) {
+        x[i] &= mask_r;
+    }
+
+    /************** Fork Threads ****************/
+    /********************************************/
+    uint64_t total_comm = 0;
+    uint64_t thread_comm[num_threads];
+    for (int i = 0; i < num_threads; i++) {
+        thread_comm[i] = ioArr[i]->counter;
+    }
+
+    auto start = clock_start();
+    std::thread OP_threads[num_threads];
+    // Whole rows per thread
+    int chunk_size = rows / num_threads;
+    for (int i = 0; i < num_threads; ++i) {
+        int offset = i * chunk_size;
+        int lnum_rows;
+        if (i == (num_threads - 1)) {
+            lnum_rows = rows - offset;
+        } else {
+            lnum_rows = chunk_size;
+        }
+        OP_threads[i] = std::thread(
+            OP_thread, i, x + offset * cols, y + offset * cols, lnum_rows
+        );
+    }
+    for (int i = 0; i < num_threads; ++i) {
+        OP_threads[i].join();
+    }
+    long long t = time_from(start);
+
+    for (int i = 0; i < num_threads; i++) {
+        thread_comm[i] = ioArr[i]->counter - thread_comm[i];
+        total_comm += thread_comm[i];
+    }
+
+    /************** Verification ****************/
+    /********************************************/
+    if (party == ALICE) {
+        ioArr[0]->send_data(x, dim * sizeof(uint64_t));
+        ioArr[0]->send_data(y, dim * sizeof(uint64_t));
+    } else {  // party == BOB
+        uint64_t *x0 = new uint64_t[dim];
+        uint64_t *y0 = new uint64_t[dim];
+        ioArr[0]->recv_data(x0, dim * sizeof(uint64_t));
+        ioArr[0]->recv_data(y0, dim * sizeof(uint64_t));
+
+        uint64_t total_err = 0;
+        uint64_t max_ULP_err = 0;
+        vector<double> dbl_x(cols), expected(cols);
+        for (int r = 0; r < rows; r++) {
+            for (int j = 0; j < cols; j++) {
+                dbl_x[j] =
+                    signed_val(x0[r * cols + j] + x[r * cols + j], bw_x) /
+                    double(1LL << s_x);
+            }
+            double max_x = *std::max_element(dbl_x.begin(), dbl_x.end());
+            double sum = 0.0;
+            for (int j = 0; j < cols; j++) {
+                expected[j] = exp(dbl_x[j] - max_x);
+                sum += expected[j];
+            }
+            for (int j = 0; j < cols; j++) {
+                expected[j] /= sum;
+            }
+            for (int j = 0; j < cols; j++) {
+                int i = r * cols + j;
+                double dbl_y =
+                    (signed_val(y0[i] + y[i], bw_y)) / double(1LL << s_y);
+                uint64_t err = computeULPErr(dbl_y, expected[j], s_y);
+                total_err += err;
+                max_ULP_err = std::max(max_ULP_err, err);
+            }
+        }
+
+        cerr << "Average ULP error: " << total_err / dim << endl;
+        cerr << "Max ULP error: " << max_ULP_err << endl;
+        cerr << "Number of tests: " << dim << endl;
+
+        delete[] x0;
+        delete[] y0;
+    }
+
+    cout << "Number of Softmax rows/s:\t" << (double(rows) / t) * 1e6
+         << std::endl;
+    cout << "Softmax Time\t" << t / (1000.0) << " ms" << endl;
+    cout << "Softmax Bytes Sent\t" << total_comm << " bytes" << endl;
+
+    /******************* Cleanup ****************/
+    /********************************************/
+    delete[] x;
+    delete[] y;
+    for (int i = 0; i < num_threads; i++) {
+        delete ioArr[i];
+        delete otpackArr[i];
+    }
+}
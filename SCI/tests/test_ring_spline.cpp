@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: MIT
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include "Math/math-functions.h"
+
+using namespace sci;
+using namespace std;
+
+#define MAX_THREADS 4
+
+int party, port = 32000;
+int num_threads = 4;
+string address = "127.0.0.1";
+
+int dim = 10000;
+int bw_x = 20;
+int bw_y = 20;
+int s_x = 12;
+int s_y = 12;
+string func = "silu";
+int degree = 2;
+int max_segments = 16;
+int s_c = 16;
+
+PiecewisePoly spline;
+
+uint64_t mask_x = (bw_x == 64 ? -1 : ((1ULL << bw_x) - 1));
+uint64_t mask_y = (bw_y == 64 ? -1 : ((1ULL << bw_y) - 1));
+
+sci::NetIO *ioArr[MAX_THREADS];
+sci::OTPack<sci::NetIO> *otpackArr[MAX_THREADS];
+
+uint64_t computeULPErr(double calc, double actual, int SCALE) {
+    int64_t calc_fixed = (double(calc) * (1ULL << SCALE));
+    int64_t actual_fixed = (double(actual) * (1ULL << SCALE));
+    uint64_t ulp_err = (calc_fixed - actual_fixed) > 0
+                           ? (calc_fixed - actual_fixed)
+                           : (actual_fixed - calc_fixed);
+    return ulp_err;
+}
+
+double activation(double x) {
+    if (func == "gelu") {
+        return 0.5 * x * (1 + erf(x / std::sqrt(2.0)));
+    } else if (func == "mish") {
+        return x * std::tanh(log1p(exp(x)));
+    } else if (func == "tanh") {
+        return std::tanh(x);
+    }
+    return x / (1 + exp(-x));  // silu/swish
+}
+
+void spline_thread(int tid, uint64_t *x, uint64_t *y, int num_ops) {
+    MathFunctions *math;
+    if (tid & 1) {
+        math = new MathFunctions(3 - party, ioArr[tid], otpackArr[tid]);
+    } else {
+        math = new MathFunctions(party, ioArr[tid], otpackArr[tid]);
+    }
+    math->piecewise_poly(num_ops, x, y, bw_x, bw_y, s_x, s_y, spline);
+
+    delete math;
+}
+
+int main(int argc, char **argv) {
+    /************* Argument Parsing  ************/
+    /********************************************/
+    ArgMapping amap;
+    amap.arg("r", party, "Role of party: ALICE = 1; BOB = 2");
+    amap.arg("p", port, "Port Number");
+    amap.arg("N", dim, "Number of spline operations");
+    amap.arg("f", func, "Function: silu, gelu, mish or tanh");
+    amap.arg("d", degree, "Degree of the segments");
+    amap.arg("S", max_segments, "Max. number of segments");
+    amap.arg("nt", num_threads, "Number of threads");
+    amap.arg("ip", address, "IP Address of server (ALICE)");
+
+    amap.parse(argc, argv);
+
+    assert(num_threads <= MAX_THREADS);
+
+    // The same table on both sides, as if loaded from a file
+    spline = fit_piecewise_poly(
+        activation, -8.0, 8.0, degree, 1.0 / (1 << (s_y - 2)), s_x, s_c,
+        max_segments
+    );
+    std::cout << "Segments: " << spline.num_segments()
+              << ", fit error: " << spline.max_err << std::endl;
+
+    /********** Setup IO and Base OTs ***********/
+    /********************************************/
+    for (int i = 0; i < num_threads; i++) {
+        ioArr[i] = new NetIO(party == 1 ? nullptr : address.c_str(), port + i);
+        if (i & 1) {
+            otpackArr[i] = new OTPack<NetIO>(ioArr[i], 3 - party);
+        } else {
+            otpackArr[i] = new OTPack<NetIO>(ioArr[i], party);
+        }
+    }
+    std::cout << "All Base OTs Done" << std::endl;
+
+    /************ Generate Test Data ************/
+    /********************************************/
+    PRG128 prg;
+
+    uint64_t *x = new uint64_t[dim];
+    uint64_t *y = new uint64_t[dim];
+
+    prg.random_data(x, dim * sizeof(uint64_t));
+
+    // x in [-16, 16), half of it on the linear tails
+    for (int i = 0; i < dim; i++) {
+        x[i] &= (1ULL << (s_x + 4)) - 1;
+        if (party == ALICE) {
+            x[i] = (x[i] - (1ULL << (s_x + 4))) & mask_x;
+        }
+    }
+
+    /************** Fork Threads ****************/
+    /********************************************/
+    uint64_t total_comm = 0;
+    uint64_t thread_comm[num_threads];
+    for (int i = 0; i < num_threads; i++) {
+        thread_comm[i] = ioArr[i]->counter;
+    }
+
+    auto start = clock_start();
+    std::thread spline_threads[num_threads];
+    int chunk_size = dim / num_threads;
+    for (int i = 0; i < num_threads; ++i) {
+        int offset = i * chunk_size;
+        int lnum_ops;
+        if (i == (num_threads - 1)) {
+            lnum_ops = dim - offset;
+        } else {
+            lnum_ops = chunk_size;
+        }
+        spline_threads[i] =
+            std::thread(spline_thread, i, x + offset, y + offset, lnum_ops);
+    }
+    for (int i = 0; i < num_threads; ++i) {
+        spline_threads[i].join();
+    }
+    long long t = time_from(start);
+
+    for (int i = 0; i < num_threads; i++) {
+        thread_comm[i] = ioArr[i]->counter - thread_comm[i];
+        total_comm += thread_comm[i];
+    }
+
+    /************** Verification ****************/
+    /********************************************/
+    if (party == ALICE) {
+        ioArr[0]->send_data(x, dim * sizeof(uint64_t));
+        ioArr[0]->send_data(y, dim * sizeof(uint64_t));
+    } else {  // party == BOB
+        uint64_t *x0 = new uint64_t[dim];
+        uint64_t *y0 = new uint64_t[dim];
+        ioArr[0]->recv_data(x0, dim * sizeof(uint64_t));
+        ioArr[0]->recv_data(y0, dim * sizeof(uint64_t));
+
+        uint64_t total_err = 0;
+        uint64_t max_ULP_err = 0;
+        for (int i = 0; i < dim; i++) {
+            double dbl_x =
+                (signed_val(x0[i] + x[i], bw_x)) / double(1LL << s_x);
+            double dbl_y =
+                (signed_val(y0[i] + y[i], bw_y)) / double(1LL << s_y);
+            double f_x = activation(dbl_x);
+            uint64_t err = computeULPErr(dbl_y, f_x, s_y);
+            total_err += err;
+            max_ULP_err = std::max(max_ULP_err, err);
+        }
+
+        cerr << "Average ULP error: " << total_err / dim << endl;
+        cerr << "Max ULP error: " << max_ULP_err << endl;
+        cerr << "Number of tests: " << dim << endl;
+
+        delete[] x0;
+        delete[] y0;
+    }
+
+    cout << "Number of spline ops/s:\t" << (double(dim) / t) * 1e6
+         << std::endl;
+    cout << "Spline Time\t" << t / (1000.0) << " ms" << endl;
+    cout << "Spline Bytes Sent\t" << total_comm << " bytes" << endl;
+
+    /******************* Cleanup ****************/
+    /********************************************/
+    delete[] x;
+    delete[] y;
+    for (int i = 0; i < num_threads; i++) {
+        delete ioArr[i];
+        delete otpackArr[i];
+    }
+}
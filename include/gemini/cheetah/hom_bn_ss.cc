@@ -6,6 +6,7 @@
 #include <seal/util/polyarithsmallmod.h>
 #include <seal/util/rlwe.h>
 
+#include "gemini/cheetah/hom_mask_pool.h"
 #include "gemini/cheetah/sliced_3d_tensor.h"
 #include "gemini/core/logging.h"
 #include "gemini/core/util/ThreadPool.h"
@@ -903,9 +904,19 @@ namespace gemini {
                 );
 
                 direct_evaluator_->sub_plain_inplace(out_share0[cid], rnd[cid]);
-                direct_pk_encryptor_->encrypt_zero(
-                    out_share0[cid].parms_id(), zero
-                );
+#if !USE_APPROX_RESHARE
+                // The pool holds the same encryptions of zero then.
+                if (!mask_pool_ ||
+                    !mask_pool_->takeZero(
+                        out_share0[cid].parms_id(),
+                        out_share0[cid].is_ntt_form(), zero
+                    ))
+#endif
+                {
+                    direct_pk_encryptor_->encrypt_zero(
+                        out_share0[cid].parms_id(), zero
+                    );
+                }
                 direct_evaluator_->add_inplace(out_share0[cid], zero);
 
                 std::array<size_t, 3> indices;
@@ -22,6 +22,7 @@ namespace seal {
 
 namespace gemini {
     class ThreadPool;
+    class HomMaskPool;
     class HomBNSS {
        public:
 #ifdef HOM_CONV2D_SS_MAX_THREADS
@@ -56,6 +57,12 @@ namespace gemini {
             std::shared_ptr<seal::PublicKey> pk = nullptr
         );
 
+        // Server: take the encryptions of zero of bn_direct from `pool` when
+        // it has them, see hom_mask_pool.h.
+        void setMaskPool(std::shared_ptr<HomMaskPool> pool) {
+            mask_pool_ = pool;
+        }
+
         inline seal::scheme_type scheme() const { return scheme_; }
 
         inline size_t poly_degree() const { return poly_degree_; }
@@ -236,6 +243,7 @@ namespace gemini {
         std::shared_ptr<seal::Evaluator> direct_evaluator_;
         std::shared_ptr<seal::Encryptor> direct_encryptor_;
         std::shared_ptr<seal::Encryptor> direct_pk_encryptor_;
+        std::shared_ptr<HomMaskPool> mask_pool_{nullptr};
 
         // CrytoFlow2-like BN
         std::vector<std::shared_ptr<seal::SEALContext>> contexts_;
@@ -8,6 +8,7 @@
 
 #include <functional>
 
+#include "gemini/cheetah/hom_mask_pool.h"
 #include "gemini/cheetah/tensor_encoder.h"
 #include "gemini/core/logging.h"
 #include "gemini/core/util/ThreadPool.h"
@@ -17,9 +18,17 @@
 
 namespace gemini {
 
+    // The image packing and the output layout of a grouped convolution are
+    // the ones of the dense [C, h, w] filter.
+    static TensorShape DenseFilterShape(const HomConv2DSS::Meta &meta) {
+        TensorShape fshape = meta.fshape;
+        fshape.Update(0, meta.ishape.channels());
+        return fshape;
+    }
+
     static TensorShape GetConv2DOutShape(const HomConv2DSS::Meta &meta) {
         auto o = shape_inference::Conv2D(
-            meta.ishape, meta.fshape, meta.padding, meta.stride
+            meta.ishape, DenseFilterShape(meta), meta.padding, meta.stride
         );
         if (!o) {
             LOG(WARNING) << "GetConv2DOutShape failed";
@@ -29,6 +38,11 @@ namespace gemini {
         return *o;
     }
 
+    static size_t TotalFilters(const HomConv2DSS::Meta &meta) {
+        return meta.n_total_filters > 0 ? meta.n_total_filters
+                                        : meta.n_filters;
+    }
+
     static Code LaunchWorks(
         ThreadPool &tpool,
         size_t num_works,
@@ -194,6 +208,27 @@ namespace gemini {
     }
 
 #if USE_APPROX_RESHARE
+    Code sample_mask_poly(
+        seal::Plaintext &mask,
+        seal::parms_id_type pid,
+        std::shared_ptr<seal::UniformRandomGenerator> prng,
+        const seal::SEALContext &context
+    ) {
+        auto cntxt_data = context.get_context_data(pid);
+        ENSURE_OR_RETURN(cntxt_data != nullptr, Code::ERR_INVALID_ARG);
+        ENSURE_OR_RETURN(prng != nullptr, Code::ERR_NULL_POINTER);
+
+        auto parms = cntxt_data->parms();
+        const size_t N = parms.poly_modulus_degree();
+        const size_t L = parms.coeff_modulus().size();
+        mask.parms_id() = seal::parms_id_zero;  // foo SEAL when using BFV
+        mask.resize(N * L);
+        // sample in [0, Q) in RNS form
+        seal::util::sample_poly_uniform(prng, parms, mask.data());
+        mask.parms_id() = cntxt_data->parms_id();
+        return Code::OK;
+    }
+
     Code sample_random_mask(
         const std::vector<size_t> &targets,
         uint64_t *coeffs_buff,
@@ -201,7 +236,8 @@ namespace gemini {
         seal::Plaintext &mask,
         seal::parms_id_type pid,
         std::shared_ptr<seal::UniformRandomGenerator> prng,
-        const seal::SEALContext &context
+        const seal::SEALContext &context,
+        HomMaskPool *pool
     ) {
         using namespace seal::util;
 
@@ -222,11 +258,9 @@ namespace gemini {
             return Code::ERR_INVALID_ARG;
         }
 
-        mask.parms_id() = seal::parms_id_zero;  // foo SEAL when using BFV
-        mask.resize(N * L);
-        // sample in [0, Q) in RNS form
-        sample_poly_uniform(prng, parms, mask.data());
-        mask.parms_id() = cntxt_data->parms_id();
+        if (pool == nullptr || !pool->takeMask(pid, mask)) {
+            CHECK_ERR(sample_mask_poly(mask, pid, prng, context), "mask");
+        }
 
         std::vector<uint64_t> coeffs_rns(targets.size() * L);
         auto src_ptr = mask.data();
@@ -245,10 +279,7 @@ namespace gemini {
         return Code::OK;
     }
 #else
-    Code sample_random_mask(
-        const std::vector<size_t> &targets,
-        uint64_t *coeffs_buff,
-        size_t buff_size,
+    Code sample_mask_poly(
         seal::Plaintext &mask,
         seal::parms_id_type pid,
         std::shared_ptr<seal::UniformRandomGenerator> prng,
@@ -258,19 +289,9 @@ namespace gemini {
 
         auto cntxt_data = context.get_context_data(pid);
         ENSURE_OR_RETURN(cntxt_data != nullptr, Code::ERR_INVALID_ARG);
-        ENSURE_OR_RETURN(!targets.empty(), Code::ERR_INVALID_ARG);
-        ENSURE_OR_RETURN(buff_size >= targets.size(), Code::ERR_OUT_BOUND);
-        ENSURE_OR_RETURN(coeffs_buff != nullptr, Code::ERR_NULL_POINTER);
-        ENSURE_OR_RETURN(prng != nullptr, Code::ERR_NULL_POINTER);
 
         auto parms = cntxt_data->parms();
         const size_t N = parms.poly_modulus_degree();
-        if (std::any_of(targets.begin(), targets.end(), [N](size_t c) {
-                return c >= N;
-            })) {
-            return Code::ERR_INVALID_ARG;
-        }
-
         mask.parms_id() = seal::parms_id_zero;  // foo SEAL when using BFV
         mask.resize(N);
 
@@ -294,6 +315,36 @@ namespace gemini {
             // t).
             modulo_poly_coeffs(mask.data(), mask.coeff_count(), t, mask.data());
         }
+        return Code::OK;
+    }
+
+    Code sample_random_mask(
+        const std::vector<size_t> &targets,
+        uint64_t *coeffs_buff,
+        size_t buff_size,
+        seal::Plaintext &mask,
+        seal::parms_id_type pid,
+        std::shared_ptr<seal::UniformRandomGenerator> prng,
+        const seal::SEALContext &context,
+        HomMaskPool *pool
+    ) {
+        auto cntxt_data = context.get_context_data(pid);
+        ENSURE_OR_RETURN(cntxt_data != nullptr, Code::ERR_INVALID_ARG);
+        ENSURE_OR_RETURN(!targets.empty(), Code::ERR_INVALID_ARG);
+        ENSURE_OR_RETURN(buff_size >= targets.size(), Code::ERR_OUT_BOUND);
+        ENSURE_OR_RETURN(coeffs_buff != nullptr, Code::ERR_NULL_POINTER);
+        ENSURE_OR_RETURN(prng != nullptr, Code::ERR_NULL_POINTER);
+
+        const size_t N = cntxt_data->parms().poly_modulus_degree();
+        if (std::any_of(targets.begin(), targets.end(), [N](size_t c) {
+                return c >= N;
+            })) {
+            return Code::ERR_INVALID_ARG;
+        }
+
+        if (pool == nullptr || !pool->takeMask(pid, mask)) {
+            CHECK_ERR(sample_mask_poly(mask, pid, prng, context), "mask");
+        }
 
         auto coeff_ptr = coeffs_buff;
         for (size_t idx : targets) {
@@ -303,7 +354,7 @@ namespace gemini {
     }
 #endif
 
-    static void asymmetric_encrypt_zero(
+    void asymmetric_encrypt_zero(
         const seal::SEALContext &context,
         const seal::PublicKey &public_key,
         const seal::parms_id_type parms_id,
@@ -387,7 +438,8 @@ namespace gemini {
         std::shared_ptr<seal::UniformRandomGenerator> prng,
         const seal::SEALContext &context,
         const seal::PublicKey &pk,
-        const seal::Evaluator &evaluator
+        const seal::Evaluator &evaluator,
+        HomMaskPool *pool
     ) {
         if (ct.size() != 2) {
             LOG(WARNING) << "flood_ciphertext: demands more coeff_modulus";
@@ -431,9 +483,12 @@ namespace gemini {
         evaluator.mod_switch_to_inplace(ct, context.last_parms_id());
 
         seal::Ciphertext zero;
-        asymmetric_encrypt_zero(
-            context, pk, ct.parms_id(), ct.is_ntt_form(), prng, zero
-        );
+        if (pool == nullptr ||
+            !pool->takeZero(ct.parms_id(), ct.is_ntt_form(), zero)) {
+            asymmetric_encrypt_zero(
+                context, pk, ct.parms_id(), ct.is_ntt_form(), prng, zero
+            );
+        }
         evaluator.add_inplace(ct, zero);
         if (ct.is_ntt_form()) {
             evaluator.transform_from_ntt_inplace(ct);
@@ -577,7 +632,8 @@ namespace gemini {
         std::vector<seal::Plaintext> polys;
         CHECK_ERR(
             tencoder_->EncodeImageShare(
-                encode_role, img, meta.fshape, meta.padding, meta.stride,
+                encode_role, img, DenseFilterShape(meta), meta.padding,
+                meta.stride,
                 /*to_ntt*/ false, polys
             ),
             "encryptImage"
@@ -609,8 +665,8 @@ namespace gemini {
 
         CHECK_ERR(
             tencoder_->EncodeImageShare(
-                TensorEncoder::Role::evaluator, img, meta.fshape, meta.padding,
-                meta.stride,
+                TensorEncoder::Role::evaluator, img, DenseFilterShape(meta),
+                meta.padding, meta.stride,
                 /*to_ntt*/ false, encoded_img
             ),
             "HomConv2DSS::encryptImage: encode failed"
@@ -626,6 +682,7 @@ namespace gemini {
     ) const {
         const size_t M = filters.size();
         ENSURE_OR_RETURN(M > 0 && M == meta.n_filters, Code::ERR_INVALID_ARG);
+        CHECK_ERR(checkGroups(meta), "encodeFilters");
         for (const auto &f : filters) {
             ENSURE_OR_RETURN(
                 f.shape().IsSameSize(meta.fshape), Code::ERR_DIM_MISMATCH
@@ -634,14 +691,28 @@ namespace gemini {
 
         encoded_filters.resize(M);
         const bool to_ntt = scheme() == seal::scheme_type::ckks;
+        const size_t filters_per_group = TotalFilters(meta) / meta.n_groups;
         auto encode_program = [&](long wid, size_t start, size_t end) {
             for (size_t i = start; i < end; ++i) {
+                if (meta.n_groups == 1) {
+                    CHECK_ERR(
+                        tencoder_->EncodeFilter(
+                            filters[i], meta.ishape, meta.padding, meta.stride,
+                            to_ntt, encoded_filters[i]
+                        ),
+                        "EncodeFilter"
+                    );
+                    continue;
+                }
+                const size_t channel_offset =
+                    ((meta.filter_offset + i) / filters_per_group) *
+                    meta.fshape.channels();
                 CHECK_ERR(
-                    tencoder_->EncodeFilter(
-                        filters[i], meta.ishape, meta.padding, meta.stride,
-                        to_ntt, encoded_filters[i]
+                    tencoder_->EncodeGroupFilter(
+                        filters[i], meta.ishape, channel_offset, meta.padding,
+                        meta.stride, to_ntt, encoded_filters[i]
                     ),
-                    "EncodeFilter"
+                    "EncodeGroupFilter"
                 );
             }
             return Code::OK;
@@ -651,6 +722,34 @@ namespace gemini {
         return LaunchWorks(tpool, M, encode_program);
     }
 
+    Code HomConv2DSS::checkGroups(const Meta &meta) const {
+        const size_t G = meta.n_groups;
+        ENSURE_OR_RETURN(G > 0, Code::ERR_INVALID_ARG);
+        ENSURE_OR_RETURN(
+            meta.ishape.channels() == G * meta.fshape.channels(),
+            Code::ERR_DIM_MISMATCH
+        );
+        const size_t M = TotalFilters(meta);
+        ENSURE_OR_RETURN(M % G == 0, Code::ERR_DIM_MISMATCH);
+        ENSURE_OR_RETURN(
+            meta.filter_offset + meta.n_filters <= M, Code::ERR_DIM_MISMATCH
+        );
+        return Code::OK;
+    }
+
+    HomConv2DSS::Meta HomConv2DSS::ShardMeta(
+        const Meta &meta, size_t shard, size_t n_shards
+    ) {
+        const size_t M = meta.n_filters;
+        const size_t begin = shard * M / n_shards;
+        const size_t end = (shard + 1) * M / n_shards;
+        Meta ret = meta;
+        ret.filter_offset = begin;
+        ret.n_filters = end - begin;
+        ret.n_total_filters = M;
+        return ret;
+    }
+
     size_t HomConv2DSS::conv2DOneFilter(
         const std::vector<seal::Ciphertext> &image,
         const std::vector<seal::Plaintext> &filter,
@@ -740,6 +839,7 @@ namespace gemini {
         ENSURE_OR_RETURN(
             filters.size() == meta.n_filters, Code::ERR_DIM_MISMATCH
         );
+        CHECK_ERR(checkGroups(meta), "conv2DSS");
         if (meta.is_shared_input) {
             ENSURE_OR_RETURN(
                 img_share0.size() == img_share1.size(), Code::ERR_DIM_MISMATCH
@@ -778,9 +878,10 @@ namespace gemini {
         }
 
         const size_t N = poly_degree();
-        ConvCoeffIndexCalculator indexer(
-            N, meta.ishape, meta.fshape, meta.padding, meta.stride
+        const auto indexer_ptr = ConvCoeffIndexCalculator::Cached(
+            N, meta.ishape, DenseFilterShape(meta), meta.padding, meta.stride
         );
+        const ConvCoeffIndexCalculator &indexer = *indexer_ptr;
         const size_t n_one_channel =
             indexer.slice_size(1) * indexer.slice_size(2);
         const size_t n_out_ct = meta.n_filters * n_one_channel;
@@ -837,7 +938,8 @@ namespace gemini {
     ) const {
         ENSURE_OR_RETURN(context_, Code::ERR_CONFIG);
         return sample_random_mask(
-            targets, coeffs_buff, buff_size, mask, pid, prng, *context_
+            targets, coeffs_buff, buff_size, mask, pid, prng, *context_,
+            mask_pool_.get()
         );
     }
 
@@ -852,9 +954,10 @@ namespace gemini {
         TensorShape strided_ishape;
         std::array<int, 2> pads{0};
         std::array<int, 3> slice_width{0};
+        const TensorShape fshape = DenseFilterShape(meta);
         if (!shape_inference::Conv2D(
-                meta.ishape, meta.fshape, poly_degree(), meta.padding,
-                meta.stride, strided_ishape, pads, slice_width
+                meta.ishape, fshape, poly_degree(), meta.padding, meta.stride,
+                strided_ishape, pads, slice_width
             )) {
             LOG(WARNING) << "addRandomMask: shape inference failed";
             return Code::ERR_INTERNAL;
@@ -863,11 +966,12 @@ namespace gemini {
         bool is_input_compressed =
             strided_ishape.num_elements() < meta.ishape.num_elements();
 
-        ConvCoeffIndexCalculator indexer(
+        const auto indexer_ptr = ConvCoeffIndexCalculator::Cached(
             poly_degree(), is_input_compressed ? strided_ishape : meta.ishape,
-            meta.fshape, is_input_compressed ? Padding::VALID : meta.padding,
+            fshape, is_input_compressed ? Padding::VALID : meta.padding,
             is_input_compressed ? 1 : meta.stride
         );
+        const ConvCoeffIndexCalculator &indexer = *indexer_ptr;
 
         const size_t n_one_channel =
             indexer.slice_size(1) * indexer.slice_size(2);
@@ -904,7 +1008,8 @@ namespace gemini {
                         auto &this_ct = enc_tensor.at(cid++);
 
                         flood_ciphertext(
-                            this_ct, prng, *context_, *pk_, *evaluator_
+                            this_ct, prng, *context_, *pk_, *evaluator_,
+                            mask_pool_.get()
                         );
                         CHECK_ERR(
                             sampleRandomMask(
@@ -950,8 +1055,9 @@ namespace gemini {
         TensorShape strided_ishape;
         std::array<int, 2> pads{0};
         std::array<int, 3> slice_width{0};
+        const TensorShape fshape = DenseFilterShape(meta);
         if (!shape_inference::Conv2D(
-                meta.ishape, meta.fshape, N, meta.padding, meta.stride,
+                meta.ishape, fshape, N, meta.padding, meta.stride,
                 strided_ishape, pads, slice_width
             )) {
             LOG(WARNING) << "shape inference failed";
@@ -959,9 +1065,10 @@ namespace gemini {
         }
 
         // Treat the strided image with stride = 1
-        ConvCoeffIndexCalculator indexer(
-            N, strided_ishape, meta.fshape, Padding::VALID, 1
+        const auto indexer_ptr = ConvCoeffIndexCalculator::Cached(
+            N, strided_ishape, fshape, Padding::VALID, 1
         );
+        const ConvCoeffIndexCalculator &indexer = *indexer_ptr;
         const size_t one_channel =
             indexer.slice_size(1) * indexer.slice_size(2);
         if (ct.size() != one_channel * meta.n_filters) {
@@ -1016,8 +1123,9 @@ namespace gemini {
         TensorShape strided_ishape;
         std::array<int, 2> pads{0};
         std::array<int, 3> slice_width{0};
+        const TensorShape fshape = DenseFilterShape(meta);
         if (!shape_inference::Conv2D(
-                meta.ishape, meta.fshape, N, meta.padding, meta.stride,
+                meta.ishape, fshape, N, meta.padding, meta.stride,
                 strided_ishape, pads, slice_width
             )) {
             LOG(WARNING) << "decryptToTensor: shape inference failed";
@@ -1027,11 +1135,12 @@ namespace gemini {
         bool is_input_compressed =
             strided_ishape.num_elements() < meta.ishape.num_elements();
 
-        ConvCoeffIndexCalculator indexer(
-            N, is_input_compressed ? strided_ishape : meta.ishape, meta.fshape,
+        const auto indexer_ptr = ConvCoeffIndexCalculator::Cached(
+            N, is_input_compressed ? strided_ishape : meta.ishape, fshape,
             is_input_compressed ? Padding::VALID : meta.padding,
             is_input_compressed ? 1 : meta.stride
         );
+        const ConvCoeffIndexCalculator &indexer = *indexer_ptr;
 
         const size_t n_one_channel =
             indexer.slice_size(1) * indexer.slice_size(2);
@@ -1151,6 +1260,7 @@ namespace gemini {
         ENSURE_OR_RETURN(
             meta.n_filters == filters.size(), Code::ERR_DIM_MISMATCH
         );
+        CHECK_ERR(checkGroups(meta), "idealFunctionality");
         for (const auto &f : filters) {
             ENSURE_OR_RETURN(
                 meta.fshape.IsSameSize(f.shape()), Code::ERR_DIM_MISMATCH
@@ -1164,16 +1274,38 @@ namespace gemini {
         const uint64_t base_mod = plain_modulus();
         ENSURE_OR_RETURN(base_mod != -1, Code::ERR_INTERNAL);
 
+        const size_t filters_per_group = TotalFilters(meta) / meta.n_groups;
+        const int64_t group_c = meta.fshape.channels();
+        Tensor<uint64_t> group_tensor(
+            TensorShape({group_c, meta.ishape.height(), meta.ishape.width()})
+        );
         for (size_t m = 0; m < meta.n_filters; ++m) {
+            const Tensor<uint64_t> *image = &in_tensor;
+            if (meta.n_groups > 1) {
+                // Input channels of the group of the m-th filter.
+                const size_t gm = meta.filter_offset + m;
+                if (m == 0 || gm % filters_per_group == 0) {
+                    const int64_t g = gm / filters_per_group;
+                    std::array<int64_t, 3> offset = {g * group_c, 0, 0};
+                    std::array<int64_t, 3> extent{0};
+                    for (int d : {0, 1, 2}) {
+                        extent[d] = group_tensor.dim_size(d);
+                    }
+                    group_tensor.tensor() =
+                        in_tensor.tensor().slice(offset, extent);
+                }
+                image = &group_tensor;
+            }
+
             Tensor<uint64_t> one_channel;
             if (base_mod > 1) {
                 // mod p
-                in_tensor.Conv2D(
+                image->Conv2D(
                     filters[m], meta.stride, meta.padding, one_channel, base_mod
                 );
             } else {
                 // mod 2^64
-                in_tensor.Conv2D(
+                image->Conv2D(
                     filters[m], meta.stride, meta.padding, one_channel
                 );
             }
@@ -23,6 +23,7 @@ namespace seal {
 namespace gemini {
 
     class TensorEncoder;
+    class HomMaskPool;
 
     class HomConv2DSS {
        public:
@@ -39,8 +40,24 @@ namespace gemini {
             Padding padding;
             size_t stride;
             bool is_shared_input;
+            // Grouped convolution: fshape = [C / n_groups, h, w] and the m-th
+            // filter only sees the (m / (n_filters / n_groups))-th block of
+            // C / n_groups input channels. Depthwise: n_groups = C.
+            size_t n_groups = 1;
+            // Model-parallel HomConv: the meta of a shard holds the filters
+            // [filter_offset, filter_offset + n_filters) of a layer of
+            // n_total_filters filters (0: not sharded), see ShardMeta.
+            size_t filter_offset = 0;
+            size_t n_total_filters = 0;
         };
 
+        // The meta of the shard-th of n_shards (almost) equal shards of the
+        // filters of the layer `meta`. A shard is empty (n_filters = 0) when
+        // there are more shards than filters. The outputs of conv2DSS on the
+        // shards, concatenated in the shard order, are the output of conv2DSS
+        // on the whole layer.
+        static Meta ShardMeta(const Meta &meta, size_t shard, size_t n_shards);
+
         explicit HomConv2DSS() = default;
 
         ~HomConv2DSS() = default;
@@ -51,6 +68,12 @@ namespace gemini {
             std::shared_ptr<seal::PublicKey> pk = nullptr
         );
 
+        // Server: take the encryptions of zero and the masks of the output
+        // re-randomization from `pool` when it has them, see hom_mask_pool.h.
+        void setMaskPool(std::shared_ptr<HomMaskPool> pool) {
+            mask_pool_ = pool;
+        }
+
         [[nodiscard]] seal::scheme_type scheme() const;
 
         [[nodiscard]] size_t poly_degree() const;
@@ -103,6 +126,8 @@ namespace gemini {
         ) const;
 
        protected:
+        Code checkGroups(const Meta &meta) const;
+
         size_t conv2DOneFilter(
             const std::vector<seal::Ciphertext> &enc_tensor,
             const std::vector<seal::Plaintext> &filter,
@@ -146,6 +171,7 @@ namespace gemini {
         std::shared_ptr<seal::Evaluator> evaluator_{nullptr};
         std::shared_ptr<seal::Encryptor> encryptor_{nullptr};
         std::shared_ptr<seal::PublicKey> pk_{nullptr};
+        std::shared_ptr<HomMaskPool> mask_pool_{nullptr};
 
         std::optional<seal::SecretKey> sk_{std::nullopt};
     };
@@ -85,7 +85,8 @@ namespace gemini {
         std::shared_ptr<seal::UniformRandomGenerator> prng,
         const seal::SEALContext &context,
         const seal::PublicKey &pk,
-        const seal::Evaluator &evaluator
+        const seal::Evaluator &evaluator,
+        HomMaskPool *pool
     );
 
     // defined in hom_conv2d_ss.cc
@@ -103,7 +104,8 @@ namespace gemini {
         seal::Plaintext &mask,
         seal::parms_id_type pid,
         std::shared_ptr<seal::UniformRandomGenerator> prng,
-        const seal::SEALContext &context
+        const seal::SEALContext &context,
+        HomMaskPool *pool
     );
 
     namespace internal {
@@ -568,7 +570,10 @@ namespace gemini {
             for (size_t r_blk = start; r_blk < end; ++r_blk) {
                 auto &this_ct = cts.at(r_blk);
 
-                flood_ciphertext(this_ct, prng, *context_, *pk_, *evaluator_);
+                flood_ciphertext(
+                    this_ct, prng, *context_, *pk_, *evaluator_,
+                    mask_pool_.get()
+                );
                 CHECK_ERR(
                     sampleRandomMask(
                         targets, coeffs.data(), coeffs.size(), mask,
@@ -656,7 +661,8 @@ namespace gemini {
     ) const {
         ENSURE_OR_RETURN(context_, Code::ERR_CONFIG);
         return sample_random_mask(
-            targets, coeffs_buff, buff_size, mask, pid, prng, *context_
+            targets, coeffs_buff, buff_size, mask, pid, prng, *context_,
+            mask_pool_.get()
         );
     }
 
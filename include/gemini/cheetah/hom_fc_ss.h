@@ -24,6 +24,8 @@ namespace seal {
 
 namespace gemini {
 
+    class HomMaskPool;
+
     class HomFCSS {
        public:
 #ifdef HOM_CONV2D_SS_MAX_THREADS
@@ -47,6 +49,12 @@ namespace gemini {
             std::shared_ptr<seal::PublicKey> pk = nullptr
         );
 
+        // Server: take the encryptions of zero and the masks of the output
+        // re-randomization from `pool` when it has them, see hom_mask_pool.h.
+        void setMaskPool(std::shared_ptr<HomMaskPool> pool) {
+            mask_pool_ = pool;
+        }
+
         [[nodiscard]] seal::scheme_type scheme() const;
 
         [[nodiscard]] size_t poly_degree() const;
@@ -151,6 +159,7 @@ namespace gemini {
         std::shared_ptr<seal::Evaluator> evaluator_{nullptr};
         std::shared_ptr<seal::Encryptor> encryptor_{nullptr};
         std::shared_ptr<seal::PublicKey> pk_{nullptr};
+        std::shared_ptr<HomMaskPool> mask_pool_{nullptr};
 
         std::optional<seal::SecretKey> sk_{std::nullopt};
     };
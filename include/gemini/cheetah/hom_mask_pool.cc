@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: MIT
+
+#include "gemini/cheetah/hom_mask_pool.h"
+
+#include <seal/seal.h>
+
+#include <functional>
+#include <vector>
+
+#include "gemini/core/common.h"
+#include "gemini/core/logging.h"
+#include "gemini/core/util/ThreadPool.h"
+
+namespace gemini {
+
+    static Code LaunchWorks(
+        ThreadPool &tpool,
+        size_t num_works,
+        std::function<Code(long wid, size_t start, size_t end)> program
+    ) {
+        if (num_works == 0) return Code::OK;
+        const long pool_sze = tpool.pool_size();
+        if (pool_sze <= 1L) {
+            return program(0, 0, num_works);
+        } else {
+            Code code;
+            std::vector<std::future<Code>> futures;
+            size_t work_load = (num_works + pool_sze - 1) / pool_sze;
+            for (long wid = 0; wid < pool_sze; ++wid) {
+                size_t start = wid * work_load;
+                size_t end = std::min(start + work_load, num_works);
+                futures.push_back(tpool.enqueue(program, wid, start, end));
+            }
+
+            code = Code::OK;
+            for (auto &&work : futures) {
+                Code c = work.get();
+                if (code == Code::OK && c != Code::OK) {
+                    code = c;
+                }
+            }
+            return code;
+        }
+    }
+
+    // defined in hom_conv2d_ss.cc
+    void asymmetric_encrypt_zero(
+        const seal::SEALContext &context,
+        const seal::PublicKey &public_key,
+        const seal::parms_id_type parms_id,
+        bool is_ntt_form,
+        std::shared_ptr<seal::UniformRandomGenerator> prng,
+        seal::Ciphertext &destination
+    );
+
+    // defined in hom_conv2d_ss.cc
+    Code sample_mask_poly(
+        seal::Plaintext &mask,
+        seal::parms_id_type pid,
+        std::shared_ptr<seal::UniformRandomGenerator> prng,
+        const seal::SEALContext &context
+    );
+
+    HomMaskPool::HomMaskPool(
+        const seal::SEALContext &context,
+        std::shared_ptr<seal::PublicKey> pk,
+        size_t capacity
+    )
+        : context_(std::make_shared<seal::SEALContext>(context)),
+          pk_(pk),
+          capacity_(capacity) {
+        if (!pk_) {
+            LOG(FATAL) << "HomMaskPool: requires the public key";
+        }
+    }
+
+    HomMaskPool::~HomMaskPool() {
+        stop();
+        // The masks are the server's output shares.
+        for (auto &kv : masks_) {
+            for (auto &mask : kv.second) {
+                seal::util::seal_memzero(
+                    mask.data(), sizeof(uint64_t) * mask.coeff_count()
+                );
+            }
+        }
+    }
+
+    void HomMaskPool::makeZero(
+        const ZeroKey &key,
+        std::shared_ptr<seal::UniformRandomGenerator> prng,
+        seal::Ciphertext &zero
+    ) const {
+        asymmetric_encrypt_zero(
+            *context_, *pk_, key.first, key.second, prng, zero
+        );
+    }
+
+    void HomMaskPool::makeMask(
+        seal::parms_id_type pid,
+        std::shared_ptr<seal::UniformRandomGenerator> prng,
+        seal::Plaintext &mask
+    ) const {
+        Code code = sample_mask_poly(mask, pid, prng, *context_);
+        if (code != Code::OK) {
+            LOG(WARNING) << "HomMaskPool: " << CodeMessage(code);
+        }
+    }
+
+    Code HomMaskPool::fill(
+        seal::parms_id_type pid, bool is_ntt_form, size_t nthreads
+    ) {
+        ENSURE_OR_RETURN(
+            context_->get_context_data(pid) != nullptr, Code::ERR_INVALID_ARG
+        );
+        const ZeroKey key{pid, is_ntt_form};
+        size_t n_zeros, n_masks;
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            auto &zeros = zeros_[key];
+            auto &masks = masks_[pid];
+            n_zeros = capacity_ - std::min(capacity_, zeros.size());
+            n_masks = capacity_ - std::min(capacity_, masks.size());
+        }
+
+        std::vector<seal::Ciphertext> zeros(n_zeros);
+        std::vector<seal::Plaintext> masks(n_masks);
+        auto prepare = [&](long wid, size_t start, size_t end) {
+            auto prng = context_->first_context_data()
+                            ->parms()
+                            .random_generator()
+                            ->create();
+            for (size_t i = start; i < end; ++i) {
+                if (i < n_zeros) {
+                    makeZero(key, prng, zeros[i]);
+                } else {
+                    makeMask(pid, prng, masks[i - n_zeros]);
+                }
+            }
+            return Code::OK;
+        };
+
+        ThreadPool tpool(std::max<size_t>(1, nthreads));
+        CHECK_ERR(LaunchWorks(tpool, n_zeros + n_masks, prepare), "fill");
+
+        std::lock_guard<std::mutex> guard(lock_);
+        for (auto &zero : zeros) {
+            zeros_[key].push_back(std::move(zero));
+        }
+        for (auto &mask : masks) {
+            masks_[pid].push_back(std::move(mask));
+        }
+        return Code::OK;
+    }
+
+    void HomMaskPool::start() {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (!stopped_) return;
+        stopped_ = false;
+        worker_ = std::thread(&HomMaskPool::refill, this);
+    }
+
+    void HomMaskPool::stop() {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (stopped_) return;
+            stopped_ = true;
+        }
+        cond_.notify_all();
+        worker_.join();
+    }
+
+    bool HomMaskPool::takeZero(
+        seal::parms_id_type pid, bool is_ntt_form, seal::Ciphertext &zero
+    ) {
+        std::unique_lock<std::mutex> guard(lock_);
+        auto &zeros = zeros_[{pid, is_ntt_form}];
+        if (zeros.empty()) {
+            ++misses_;
+            guard.unlock();
+            cond_.notify_one();
+            return false;
+        }
+        zero = std::move(zeros.front());
+        zeros.pop_front();
+        ++hits_;
+        guard.unlock();
+        cond_.notify_one();
+        return true;
+    }
+
+    bool HomMaskPool::takeMask(seal::parms_id_type pid, seal::Plaintext &mask) {
+        std::unique_lock<std::mutex> guard(lock_);
+        auto &masks = masks_[pid];
+        if (masks.empty()) {
+            ++misses_;
+            guard.unlock();
+            cond_.notify_one();
+            return false;
+        }
+        mask = std::move(masks.front());
+        masks.pop_front();
+        ++hits_;
+        guard.unlock();
+        cond_.notify_one();
+        return true;
+    }
+
+    size_t HomMaskPool::hits() const {
+        std::lock_guard<std::mutex> guard(lock_);
+        return hits_;
+    }
+
+    size_t HomMaskPool::misses() const {
+        std::lock_guard<std::mutex> guard(lock_);
+        return misses_;
+    }
+
+    // One item at a time, so that the layers are never blocked for long.
+    void HomMaskPool::refill() {
+        auto prng = context_->first_context_data()
+                        ->parms()
+                        .random_generator()
+                        ->create();
+        std::unique_lock<std::mutex> guard(lock_);
+        while (!stopped_) {
+            const ZeroKey *zero_key = nullptr;
+            const seal::parms_id_type *mask_pid = nullptr;
+            for (auto &kv : zeros_) {
+                if (kv.second.size() < capacity_) {
+                    zero_key = &kv.first;
+                    break;
+                }
+            }
+            for (auto &kv : masks_) {
+                if (!zero_key && kv.second.size() < capacity_) {
+                    mask_pid = &kv.first;
+                    break;
+                }
+            }
+
+            if (zero_key) {
+                const ZeroKey key = *zero_key;
+                guard.unlock();
+                seal::Ciphertext zero;
+                makeZero(key, prng, zero);
+                guard.lock();
+                zeros_[key].push_back(std::move(zero));
+            } else if (mask_pid) {
+                const seal::parms_id_type pid = *mask_pid;
+                guard.unlock();
+                seal::Plaintext mask;
+                makeMask(pid, prng, mask);
+                guard.lock();
+                masks_[pid].push_back(std::move(mask));
+            } else {
+                cond_.wait(guard);
+            }
+        }
+    }
+
+}  // namespace gemini
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef GEMINI_CHEETAH_HOM_MASK_POOL_H_
+#define GEMINI_CHEETAH_HOM_MASK_POOL_H_
+#include <seal/ciphertext.h>
+#include <seal/context.h>
+#include <seal/plaintext.h>
+#include <seal/publickey.h>
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "gemini/core/types.h"
+
+namespace gemini {
+
+    // Offline re-randomization material of the server.
+    //
+    // The outputs of HomConv2DSS and HomFCSS are flooded with a public-key
+    // encryption of zero and masked with a uniform random polynomial, the
+    // outputs of HomBNSS::bn_direct with an encryption of zero. Neither
+    // depends on the client's ciphertexts, so the pool prepares them ahead of
+    // time and the layers take them online. The layers fall back to the
+    // fresh sampling when the pool runs dry.
+    //
+    // The encryptions of zero are keyed by (parms_id, is_ntt_form), the mask
+    // polynomials by parms_id. A key becomes known when it is filled, or at
+    // its first miss. Once started, a background thread keeps every known
+    // key at `capacity` items. Every item is handed out at most once.
+    class HomMaskPool {
+       public:
+        HomMaskPool(
+            const seal::SEALContext &context,
+            std::shared_ptr<seal::PublicKey> pk,
+            size_t capacity
+        );
+
+        ~HomMaskPool();
+
+        HomMaskPool(const HomMaskPool &) = delete;
+        HomMaskPool &operator=(const HomMaskPool &) = delete;
+
+        // Prepares `capacity` zeros and masks of the key, using `nthreads`
+        // threads, e.g., while the server waits for the client.
+        Code fill(
+            seal::parms_id_type pid, bool is_ntt_form, size_t nthreads = 1
+        );
+
+        // Refills the known keys in the background until stop().
+        void start();
+
+        void stop();
+
+        bool takeZero(
+            seal::parms_id_type pid, bool is_ntt_form, seal::Ciphertext &zero
+        );
+
+        bool takeMask(seal::parms_id_type pid, seal::Plaintext &mask);
+
+        size_t capacity() const { return capacity_; }
+
+        size_t hits() const;
+
+        size_t misses() const;
+
+       private:
+        using ZeroKey = std::pair<seal::parms_id_type, bool>;
+
+        void makeZero(
+            const ZeroKey &key,
+            std::shared_ptr<seal::UniformRandomGenerator> prng,
+            seal::Ciphertext &zero
+        ) const;
+
+        void makeMask(
+            seal::parms_id_type pid,
+            std::shared_ptr<seal::UniformRandomGenerator> prng,
+            seal::Plaintext &mask
+        ) const;
+
+        void refill();
+
+        std::shared_ptr<seal::SEALContext> context_;
+        std::shared_ptr<seal::PublicKey> pk_;
+        size_t capacity_;
+
+        mutable std::mutex lock_;
+        std::condition_variable cond_;
+        std::map<ZeroKey, std::deque<seal::Ciphertext>> zeros_;
+        std::map<seal::parms_id_type, std::deque<seal::Plaintext>> masks_;
+        size_t hits_{0};
+        size_t misses_{0};
+        bool stopped_{true};
+        std::thread worker_;
+    };
+
+}  // namespace gemini
+
+#endif  // GEMINI_CHEETAH_HOM_MASK_POOL_H_
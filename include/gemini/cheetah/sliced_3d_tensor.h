@@ -1,8 +1,10 @@
 //  Authors: Wen-jie Lu on 2021/9/11.
 #pragma once
+#include <algorithm>
 #include <array>
 #include <cassert>
 
+#include "gemini/cheetah/tensor.h"
 #include "gemini/cheetah/tensor_shape.h"
 #include "gemini/core/common.h"
 #include "gemini/core/logging.h"
@@ -10,6 +12,37 @@
 
 namespace gemini {
 
+    // Bulk reads for the encoders: dst[i] = t(c, h, w0 + i * step) for i in
+    // [0, n), with the zeros of Tensor::operator() outside of the tensor, but
+    // checking the bounds once per row instead of once per element.
+    template <class T>
+    inline void GatherRow(
+        const Tensor<T> &t, long c, long h, long w0, long n, long step, T *dst
+    ) {
+        const long H = t.dim_size(1);
+        const long W = t.dim_size(2);
+        if (c < 0 || c >= t.dim_size(0) || h < 0 || h >= H) {
+            std::fill_n(dst, n, T(0));
+            return;
+        }
+        const T *row = t.data() + (c * H + h) * W;
+        if (step == 1 && w0 >= 0 && w0 + n <= W) {
+            std::copy_n(row + w0, n, dst);
+            return;
+        }
+        for (long i = 0; i < n; ++i) {
+            const long w = w0 + i * step;
+            dst[i] = (w >= 0 && w < W) ? row[w] : T(0);
+        }
+    }
+
+    template <class Base, class T>
+    inline void GatherRow(
+        const Base &t, long c, long h, long w0, long n, long step, T *dst
+    ) {
+        t.GatherRow(c, h, w0, n, step, dst);
+    }
+
     template <class Base>
     class Strided3DTensor {
        public:
@@ -29,6 +62,15 @@ namespace gemini {
             return base_(c * stride3d_[0], h * stride3d_[1], w * stride3d_[2]);
         }
 
+        void GatherRow(
+            long c, long h, long w0, long n, long step, ScalarType *dst
+        ) const {
+            gemini::GatherRow(
+                base_, c * stride3d_[0], h * stride3d_[1], w0 * stride3d_[2],
+                n, step * stride3d_[2], dst
+            );
+        }
+
         explicit Strided3DTensor(const Base &base, std::array<int, 3> strides3d)
             : base_(base), stride3d_(strides3d) {
             shape_ = base.shape();
@@ -76,6 +118,27 @@ namespace gemini {
             );
         }
 
+        // The row (c, h) of the mocked shape, i.e., dst[w] = (*this)(c, h, w)
+        // for w in [0, width()).
+        void GatherRow(long c, long h, ScalarType *dst) const {
+            const long W = mock_shape_.dim_size(2);
+            if (c >= shape_.dim_size(0) || h < hpads_[0] ||
+                h + hpads_[1] >= shape_.dim_size(1)) {
+                std::fill_n(dst, W, zero_);
+                return;
+            }
+            const long w_lo = std::min<long>(wpads_[0], W);
+            const long w_hi = std::max<long>(
+                w_lo, std::min<long>(shape_.dim_size(2) - wpads_[1], W)
+            );
+            std::fill_n(dst, w_lo, zero_);
+            gemini::GatherRow(
+                *base_, c + offsets_[0], h - hpads_[0] + offsets_[1],
+                offsets_[2], w_hi - w_lo, 1, dst + w_lo
+            );
+            std::fill(dst + w_hi, dst + W, zero_);
+        }
+
         SlicedPaddedTensor(const SlicedPaddedTensor &oth)
             : zero_(oth.zero_),
               base_(oth.base_),
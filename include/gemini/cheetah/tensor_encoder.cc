@@ -4,10 +4,17 @@
 #include <seal/plaintext.h>
 #include <seal/util/polyarithsmallmod.h>
 
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
 #include "gemini/cheetah/sliced_3d_tensor.h"
 #include "gemini/core/common.h"
 #include "gemini/core/logging.h"
 #include "gemini/core/types.h"
+#include "gemini/core/util/math.h"
 namespace gemini {
 
     struct ConvIndexer {
@@ -201,6 +208,85 @@ namespace gemini {
         return Code::OK;
     }
 
+    Code TensorEncoder::EncodeGroupFilter(
+        const U64Tensor &filter,
+        const TensorShape &img_shape,
+        const size_t channel_offset,
+        const Padding &padding,
+        const size_t stride,
+        const bool is_ntt_form,
+        std::vector<RLWEPt> &out
+    ) const {
+        TensorShape fshape = filter.shape();
+        ENSURE_OR_RETURN(
+            img_shape.dims() == 3 && fshape.dims() == 3, Code::ERR_DIM_MISMATCH
+        );
+        ENSURE_OR_RETURN(
+            channel_offset + fshape.channels() <= img_shape.channels(),
+            Code::ERR_OUT_BOUND
+        );
+        if (filter.width() * filter.height() > poly_degree()) {
+            LOG(FATAL) << "filter.num_elements > poly_degree";
+        }
+
+        // Use the slicing of the dense filter so that the plaintexts line up
+        // with the encrypted image.
+        TensorShape dense_fshape = fshape;
+        dense_fshape.Update(0, img_shape.channels());
+
+        TensorShape strided_tshape;
+        std::array<int, 2> paddings;
+        std::array<int, 3> slice_strides;
+        if (!shape_inference::Conv2D(
+                img_shape, dense_fshape, poly_degree(), padding, stride,
+                strided_tshape, paddings, slice_strides
+            )) {
+            LOG(WARNING) << "EncodeGroupFilter: shape_inference failed";
+            return Code::ERR_INVALID_ARG;
+        }
+
+        const long C = img_shape.channels();
+        const long slice_c = slice_strides[0];
+        TensorShape sliced_ishape(
+            {slice_c, slice_strides[1], slice_strides[2]}
+        );
+        TensorShape sliced_fshape({slice_c, fshape.height(), fshape.width()});
+        FilterIndexer indexer(poly_degree(), sliced_ishape, sliced_fshape);
+
+        out.clear();
+        out.resize(CeilDiv<long>(C, slice_c));
+
+        auto pool = seal::MemoryManager::GetPool(seal::mm_force_thread_local);
+        auto tmp_buf = seal::util::allocate_poly(poly_degree(), 1, pool);
+
+        const long c_begin = static_cast<long>(channel_offset);
+        const long c_end = c_begin + fshape.channels();
+        const long fw = fshape.width();
+        std::vector<U64> row(fw);
+        for (long s = c_begin / slice_c; s * slice_c < c_end; ++s) {
+            std::fill_n(tmp_buf.get(), poly_degree(), 0);
+            const long lo = std::max(c_begin, s * slice_c);
+            const long hi = std::min(c_end, (s + 1) * slice_c);
+            for (long c = lo; c < hi; ++c) {
+                for (long h = 0; h < fshape.height(); ++h) {
+                    // The filter indexer runs backwards in w.
+                    GatherRow(filter, c - c_begin, h, 0, fw, 1, row.data());
+                    U64 *dst = tmp_buf.get() + indexer(c - s * slice_c, h, 0);
+                    for (long w = 0; w < fw; ++w) {
+                        *(dst - w) = row[w];
+                    }
+                }
+            }
+            CHECK_ERR(
+                A2H(tmp_buf.get(), poly_degree(), out.at(s), Role::evaluator,
+                    is_ntt_form),
+                "A2H"
+            );
+        }
+
+        return Code::OK;
+    }
+
     Code TensorEncoder::EncodeImageShare(
         Role role,
         const U64Tensor &img_tensor,
@@ -313,15 +399,27 @@ namespace gemini {
 
         std::fill_n(out_poly, N, 0);
         TensorShape shape = tensor.shape();
+        const long W = shape.width();
+        if (W == 0) return Code::OK;
+        // Both indexers are affine in w, with step +1 (image) or -1
+        // (filter): a row is gathered at once and written as a block.
+        std::vector<U64> row(W);
         for (int c = 0; c < shape.channels(); ++c) {
             for (int h = 0; h < shape.height(); ++h) {
-                for (int w = 0; w < shape.width(); ++w) {
-                    int coeff_index = indexer(c, h, w);
-                    if (coeff_index < 0 || coeff_index >= N) {
-                        LOG(FATAL)
-                            << "invalid index " << c << "," << h << "," << w;
-                    }
-                    out_poly[coeff_index] = tensor(c, h, w);
+                const long first = indexer(c, h, 0);
+                const long last = indexer(c, h, W - 1);
+                if (std::min(first, last) < 0 ||
+                    std::max(first, last) >= static_cast<long>(N)) {
+                    LOG(FATAL) << "invalid index " << c << "," << h;
+                }
+                tensor.GatherRow(c, h, row.data());
+                if (last >= first) {
+                    std::copy(row.cbegin(), row.cend(), out_poly + first);
+                } else {
+                    std::copy(
+                        row.cbegin(), row.cend(),
+                        std::reverse_iterator<U64 *>(out_poly + first + 1)
+                    );
                 }
             }
         }
@@ -421,6 +519,50 @@ namespace gemini {
         for (int d = 0; d < 3; ++d) {
             mock_shape_.Update(d, slice_strides[d]);
         }
+
+        const size_t n_slices = slice_size(1) * slice_size(2);
+        out_shapes_.resize(n_slices);
+        indices_.resize(n_slices);
+        for (int h = 0, i = 0; h < slice_size(1); ++h) {
+            for (int w = 0; w < slice_size(2); ++w, ++i) {
+                if (Compute({h, w}, out_shapes_[i], &indices_[i]) != Code::OK) {
+                    LOG(FATAL) << "ConvCoeffIndexCalculator: slice failed";
+                }
+                num_all_indices_ += indices_[i].size();
+            }
+        }
+    }
+
+    std::shared_ptr<const ConvCoeffIndexCalculator>
+    ConvCoeffIndexCalculator::Cached(
+        size_t poly_degree,
+        TensorShape ishape,
+        TensorShape fshape,
+        Padding padding,
+        size_t stride
+    ) {
+        using Key = std::tuple<size_t, std::vector<int64_t>,
+                               std::vector<int64_t>, int, size_t>;
+        static std::mutex lock;
+        static std::map<Key, std::shared_ptr<const ConvCoeffIndexCalculator>>
+            cache;
+
+        auto dims = [](const TensorShape &shape) {
+            std::vector<int64_t> d(shape.dims());
+            for (size_t i = 0; i < d.size(); ++i) d[i] = shape.dim_size(i);
+            return d;
+        };
+        Key key{poly_degree, dims(ishape), dims(fshape),
+                static_cast<int>(padding), stride};
+
+        std::lock_guard<std::mutex> guard(lock);
+        auto &entry = cache[key];
+        if (!entry) {
+            entry = std::make_shared<ConvCoeffIndexCalculator>(
+                poly_degree, ishape, fshape, padding, stride
+            );
+        }
+        return entry;
     }
 
     int ConvCoeffIndexCalculator::slice_size(size_t d) const {
@@ -432,10 +574,19 @@ namespace gemini {
         TensorShape &out_shape,
         std::vector<size_t> &indices
     ) const {
-        return Get(coords, out_shape, &indices);
+        ENSURE_OR_RETURN(
+            coords[0] >= 0 && coords[0] < slice_size(1), Code::ERR_INVALID_ARG
+        );
+        ENSURE_OR_RETURN(
+            coords[1] >= 0 && coords[1] < slice_size(2), Code::ERR_INVALID_ARG
+        );
+        const size_t i = coords[0] * slice_size(2) + coords[1];
+        out_shape = out_shapes_[i];
+        indices = indices_[i];
+        return Code::OK;
     }
 
-    Code ConvCoeffIndexCalculator::Get(
+    Code ConvCoeffIndexCalculator::Compute(
         std::array<int, 2> coords,
         TensorShape &out_shape,
         std::vector<size_t> *indices
@@ -495,15 +646,7 @@ namespace gemini {
     }
 
     size_t ConvCoeffIndexCalculator::NumAllIndices() const {
-        TensorShape oshape;
-        size_t accum_sze = 0;
-        for (int h = 0; h < slice_size(1); ++h) {
-            for (int w = 0; w < slice_size(2); ++w) {
-                Get({h, w}, oshape, nullptr);
-                accum_sze += oshape.num_elements();
-            }
-        }
-        return accum_sze;
+        return num_all_indices_;
     }
 
 }  // namespace gemini
@@ -1,7 +1,9 @@
 //  Authors: Wen-jie Lu on 2021/9/15.
 #ifndef GEMINI_HE_LINEAR_TENSOR_ENCODER_H
 #define GEMINI_HE_LINEAR_TENSOR_ENCODER_H
+#include <array>
 #include <memory>
+#include <vector>
 
 #include "gemini/cheetah/shape_inference.h"
 #include "gemini/cheetah/tensor.h"
@@ -45,6 +47,20 @@ namespace gemini {
             std::vector<RLWEPt> &out
         ) const;
 
+        // The filter of a grouped convolution covers the image channels
+        // [channel_offset, channel_offset + filter.channels()). Only the
+        // channel slices that overlap this range are encoded; the others are
+        // left empty (i.e., zero) so that the evaluator can skip them.
+        Code EncodeGroupFilter(
+            const U64Tensor &filter,
+            const TensorShape &image_shape,
+            size_t channel_offset,
+            const Padding &padding,
+            size_t stride,
+            bool is_ntt,
+            std::vector<RLWEPt> &out
+        ) const;
+
        private:
         template <class TensorType, class Indexer>
         Code Encode(
@@ -90,6 +106,9 @@ namespace gemini {
         const RunTime &rt_;
     };
 
+    // The output coefficients of every (h, w) slice of a convolution. The
+    // slice geometry and the index vectors are computed once, at
+    // construction.
     class ConvCoeffIndexCalculator {
        public:
         explicit ConvCoeffIndexCalculator(
@@ -99,6 +118,18 @@ namespace gemini {
             Padding padding,
             size_t stride
         );
+
+        // The calculator of this geometry, shared by all the calls (and the
+        // threads) of the process: the layers of a network are run once per
+        // inference with the same metas.
+        static std::shared_ptr<const ConvCoeffIndexCalculator> Cached(
+            size_t poly_degree,
+            TensorShape ishape,
+            TensorShape fshape,
+            Padding padding,
+            size_t stride
+        );
+
         int slice_size(size_t d) const;
 
         Code Get(
@@ -110,7 +141,7 @@ namespace gemini {
         size_t NumAllIndices() const;
 
        private:
-        Code Get(
+        Code Compute(
             std::array<int, 2> coords,
             TensorShape &out_shape,
             std::vector<size_t> *indices
@@ -120,6 +151,10 @@ namespace gemini {
         TensorShape ishape_, fshape_;
         TensorShape mock_shape_;
         std::shared_ptr<Conv2DSliceHelper<U64Tensor>> helper_;
+        // Row-major over the (h, w) slices.
+        std::vector<TensorShape> out_shapes_;
+        std::vector<std::vector<size_t>> indices_;
+        size_t num_all_indices_{0};
     };
 
 }  // namespace gemini
@@ -27,88 +27,32 @@ int64_t getSignValue(uint64_t x) {
 
 void MatAddBroadCast2(int64_t s1, int64_t s2, uint64_t *A, uint64_t *B,
                       uint64_t *outArr) {
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      Arr2DIdxRowM(outArr, s1, s2, i1, i2) =
-          SecretAdd(Arr2DIdxRowM(A, s1, s2, i1, i2), Arr1DIdxRowM(B, s2, i2));
-    }
-  }
+  MatAddBroadCast(s1, s2, A, B, outArr);
 }
 
 void MatAdd2(int64_t s1, int64_t s2, uint64_t *A, uint64_t *B,
              uint64_t *outArr) {
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      Arr2DIdxRowM(outArr, s1, s2, i1, i2) = SecretAdd(
-          Arr2DIdxRowM(A, s1, s2, i1, i2), Arr2DIdxRowM(B, s1, s2, i1, i2));
-    }
-  }
+  ElemWiseSecretAdd(s1 * s2, A, B, outArr);
 }
 
 void MatAddBroadCast4(int64_t s1, int64_t s2, int64_t s3, int64_t s4,
                       uint64_t *A, uint64_t *B, uint64_t *outArr) {
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        for (uint64_t i4 = 0; i4 < s4; i4++) {
-          Arr4DIdxRowM(outArr, s1, s2, s3, s4, i1, i2, i3, i4) =
-              SecretAdd(Arr4DIdxRowM(A, s1, s2, s3, s4, i1, i2, i3, i4),
-                        Arr1DIdxRowM(B, s4, i4));
-        }
-      }
-    }
-  }
+  MatAddBroadCast(s1 * s2 * s3, s4, A, B, outArr);
 }
 
 void MatAdd4(int64_t s1, int64_t s2, int64_t s3, int64_t s4, uint64_t *A,
              uint64_t *B, uint64_t *outArr) {
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        for (uint64_t i4 = 0; i4 < s4; i4++) {
-          Arr4DIdxRowM(outArr, s1, s2, s3, s4, i1, i2, i3, i4) =
-              SecretAdd(Arr4DIdxRowM(A, s1, s2, s3, s4, i1, i2, i3, i4),
-                        Arr4DIdxRowM(B, s1, s2, s3, s4, i1, i2, i3, i4));
-        }
-      }
-    }
-  }
+  ElemWiseSecretAdd(s1 * s2 * s3 * s4, A, B, outArr);
 }
 
 void MatAddBroadCast5(int64_t s1, int64_t s2, int64_t s3, int64_t s4,
                       int64_t s5, uint64_t *A, uint64_t *B, uint64_t *outArr) {
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        for (uint64_t i4 = 0; i4 < s4; i4++) {
-          for (uint64_t i5 = 0; i5 < s5; i5++) {
-            Arr5DIdxRowM(outArr, s1, s2, s3, s4, s5, i1, i2, i3, i4, i5) =
-                SecretAdd(
-                    Arr5DIdxRowM(A, s1, s2, s3, s4, s5, i1, i2, i3, i4, i5),
-                    Arr1DIdxRowM(B, s5, i5));
-          }
-        }
-      }
-    }
-  }
+  MatAddBroadCast(s1 * s2 * s3 * s4, s5, A, B, outArr);
 }
 
 void MatAdd5(int64_t s1, int64_t s2, int64_t s3, int64_t s4, int64_t s5,
              uint64_t *A, uint64_t *B, uint64_t *outArr) {
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        for (uint64_t i4 = 0; i4 < s4; i4++) {
-          for (uint64_t i5 = 0; i5 < s5; i5++) {
-            Arr5DIdxRowM(outArr, s1, s2, s3, s4, s5, i1, i2, i3, i4, i5) =
-                SecretAdd(
-                    Arr5DIdxRowM(A, s1, s2, s3, s4, s5, i1, i2, i3, i4, i5),
-                    Arr5DIdxRowM(B, s1, s2, s3, s4, s5, i1, i2, i3, i4, i5));
-          }
-        }
-      }
-    }
-  }
+  ElemWiseSecretAdd(s1 * s2 * s3 * s4 * s5, A, B, outArr);
 }
 
 void CreateTensor1(int64_t s1, int64_t val, int64_t *arr) {
@@ -314,6 +258,17 @@ void Concat2T444(int64_t s1, int64_t s2, int64_t s3, int64_t s4, int64_t inp1s1,
                  int64_t inp1s2, int64_t inp1s3, int64_t inp1s4, uint64_t *inp1,
                  int64_t inp2s1, int64_t inp2s2, int64_t inp2s3, int64_t inp2s4,
                  uint64_t *inp2, int64_t axis, uint64_t *outp) {
+  if (kActivationCHW) {
+    // Concatenation along the channels is a per-batch append in NCHW.
+    assert(axis == 3);
+    const int64_t n1 = inp1s2 * inp1s3 * inp1s4;
+    const int64_t n2 = inp2s2 * inp2s3 * inp2s4;
+    for (int64_t i1 = 0; i1 < s1; i1++) {
+      std::copy_n(inp1 + i1 * n1, n1, outp + i1 * (n1 + n2));
+      std::copy_n(inp2 + i1 * n2, n2, outp + i1 * (n1 + n2) + n1);
+    }
+    return;
+  }
   for (uint64_t i1 = 0; i1 < s1; i1++) {
     for (uint64_t i2 = 0; i2 < s2; i2++) {
       for (uint64_t i3 = 0; i3 < s3; i3++) {
@@ -1473,19 +1428,14 @@ void FusedBatchNorm4411(int64_t s1, int64_t s2, int64_t s3, int64_t s4,
   uint64_t *multArrReshaped = make_array<uint64_t>(inpSize);
 
   uint64_t *multExprAns = make_array<uint64_t>(inpSize);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        for (uint64_t i4 = 0; i4 < s4; i4++) {
-          int64_t linIdx =
-              ((((((i1 * s2) * s3) * s4) + ((i2 * s3) * s4)) + (i3 * s4)) + i4);
-          Arr1DIdxRowM(inArrReshaped, inpSize, linIdx) =
-              Arr4DIdxRowM(inArr, s1, s2, s3, s4, i1, i2, i3, i4);
-          Arr1DIdxRowM(multArrReshaped, inpSize, linIdx) =
-              Arr1DIdxRowM(multArr, s4, i4);
-        }
-      }
-    }
+  // The channel of the activation at a flat position.
+  auto channel = [=](int64_t linIdx) -> int64_t {
+    return kActivationCHW ? (linIdx / (s2 * s3)) % s4 : linIdx % s4;
+  };
+  std::copy_n(inArr, inpSize, inArrReshaped);
+  for (int64_t linIdx = 0; linIdx < inpSize; linIdx++) {
+    Arr1DIdxRowM(multArrReshaped, inpSize, linIdx) =
+        Arr1DIdxRowM(multArr, s4, channel(linIdx));
   }
   ElemWiseActModelVectorMult(inpSize, inArrReshaped, multArrReshaped,
                              multExprAns);
@@ -1493,19 +1443,10 @@ void FusedBatchNorm4411(int64_t s1, int64_t s2, int64_t s3, int64_t s4,
     ScaleDown(inpSize, multExprAns, multExprScaleDownSf);
   }
 
-
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        for (uint64_t i4 = 0; i4 < s4; i4++) {
-          int64_t linIdx =
-              ((((((i1 * s2) * s3) * s4) + ((i2 * s3) * s4)) + (i3 * s4)) + i4);
-          Arr4DIdxRowM(outputArr, s1, s2, s3, s4, i1, i2, i3, i4) =
-              SecretAdd(Arr1DIdxRowM(multExprAns, inpSize, linIdx),
-                        Arr1DIdxRowM(biasArrScaledUp, s4, i4));
-        }
-      }
-    }
+  for (int64_t linIdx = 0; linIdx < inpSize; linIdx++) {
+    Arr1DIdxRowM(outputArr, inpSize, linIdx) =
+        SecretAdd(Arr1DIdxRowM(multExprAns, inpSize, linIdx),
+                  Arr1DIdxRowM(biasArrScaledUp, s4, channel(linIdx)));
   }
   ClearMemSecret1(inpSize, inArrReshaped);
   ClearMemSecret1(inpSize, multArrReshaped);
@@ -1838,38 +1779,9 @@ void Relu2(int64_t s1, int64_t s2, uint64_t *inArr, uint64_t *outArr,
 
 void Relu4(int64_t s1, int64_t s2, int64_t s3, int64_t s4, uint64_t *inArr,
            uint64_t *outArr, int64_t sf, uint64_t doTruncation) {
+  // Element-wise: works on the flat array for both NHWC and NCHW.
   int64_t size = (((s1 * s2) * s3) * s4);
-
-  uint64_t *reshapedInArr = make_array<uint64_t>(size);
-
-  uint64_t *reshapedOutArr = make_array<uint64_t>(size);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        for (uint64_t i4 = 0; i4 < s4; i4++) {
-          int64_t linIdx =
-              ((((((i1 * s2) * s3) * s4) + ((i2 * s3) * s4)) + (i3 * s4)) + i4);
-          Arr1DIdxRowM(reshapedInArr, size, linIdx) =
-              Arr4DIdxRowM(inArr, s1, s2, s3, s4, i1, i2, i3, i4);
-        }
-      }
-    }
-  }
-  Relu(size, reshapedInArr, reshapedOutArr, sf, doTruncation);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        for (uint64_t i4 = 0; i4 < s4; i4++) {
-          int64_t linIdx =
-              ((((((i1 * s2) * s3) * s4) + ((i2 * s3) * s4)) + (i3 * s4)) + i4);
-          Arr4DIdxRowM(outArr, s1, s2, s3, s4, i1, i2, i3, i4) =
-              Arr1DIdxRowM(reshapedOutArr, size, linIdx);
-        }
-      }
-    }
-  }
-  ClearMemSecret1(size, reshapedInArr);
-  ClearMemSecret1(size, reshapedOutArr);
+  Relu(size, inArr, outArr, sf, doTruncation);
 }
 
 void Relu5(int64_t s1, int64_t s2, int64_t s3, int64_t s4, int64_t s5,
@@ -1948,84 +1860,16 @@ void Floor2(int64_t s1, int64_t s2, uint64_t *inArr, uint64_t *outArr,
 void ScaleUp1(int64_t s1, uint64_t *arr, int64_t sf) { ScaleUp(s1, arr, sf); }
 
 void ScaleUp2(int64_t s1, int64_t s2, uint64_t *arr, int64_t sf) {
-  int64_t size = (s1 * s2);
-
-  uint64_t *reshapedArr = make_array<uint64_t>(size);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      int64_t linIdx = ((i1 * s2) + i2);
-      Arr1DIdxRowM(reshapedArr, size, linIdx) =
-          Arr2DIdxRowM(arr, s1, s2, i1, i2);
-    }
-  }
-  ScaleUp(size, reshapedArr, sf);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      int64_t linIdx = ((i1 * s2) + i2);
-      Arr2DIdxRowM(arr, s1, s2, i1, i2) =
-          Arr1DIdxRowM(reshapedArr, size, linIdx);
-    }
-  }
-  ClearMemSecret1(size, reshapedArr);
+  ScaleUp(s1 * s2, arr, sf);
 }
 
 void ScaleUp3(int64_t s1, int64_t s2, int64_t s3, uint64_t *arr, int64_t sf) {
-  int64_t size = ((s1 * s2) * s3);
-
-  uint64_t *reshapedArr = make_array<uint64_t>(size);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        int64_t linIdx = ((((i1 * s2) * s3) + (i2 * s3)) + i3);
-        Arr1DIdxRowM(reshapedArr, size, linIdx) =
-            Arr3DIdxRowM(arr, s1, s2, s3, i1, i2, i3);
-      }
-    }
-  }
-  ScaleUp(size, reshapedArr, sf);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        int64_t linIdx = ((((i1 * s2) * s3) + (i2 * s3)) + i3);
-        Arr3DIdxRowM(arr, s1, s2, s3, i1, i2, i3) =
-            Arr1DIdxRowM(reshapedArr, size, linIdx);
-      }
-    }
-  }
-  ClearMemSecret1(size, reshapedArr);
+  ScaleUp(s1 * s2 * s3, arr, sf);
 }
 
 void ScaleUp4(int64_t s1, int64_t s2, int64_t s3, int64_t s4, uint64_t *arr,
               int64_t sf) {
-  int64_t size = (((s1 * s2) * s3) * s4);
-
-  uint64_t *reshapedArr = make_array<uint64_t>(size);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        for (uint64_t i4 = 0; i4 < s4; i4++) {
-          int64_t linIdx =
-              ((((((i1 * s2) * s3) * s4) + ((i2 * s3) * s4)) + (i3 * s4)) + i4);
-          Arr1DIdxRowM(reshapedArr, size, linIdx) =
-              Arr4DIdxRowM(arr, s1, s2, s3, s4, i1, i2, i3, i4);
-        }
-      }
-    }
-  }
-  ScaleUp(size, reshapedArr, sf);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        for (uint64_t i4 = 0; i4 < s4; i4++) {
-          int64_t linIdx =
-              ((((((i1 * s2) * s3) * s4) + ((i2 * s3) * s4)) + (i3 * s4)) + i4);
-          Arr4DIdxRowM(arr, s1, s2, s3, s4, i1, i2, i3, i4) =
-              Arr1DIdxRowM(reshapedArr, size, linIdx);
-        }
-      }
-    }
-  }
-  ClearMemSecret1(size, reshapedArr);
+  ScaleUp(s1 * s2 * s3 * s4, arr, sf);
 }
 
 void ScaleDown1(int64_t s1, uint64_t *arr, int64_t sf) {
@@ -2083,34 +1927,7 @@ void ScaleDown3(int64_t s1, int64_t s2, int64_t s3, uint64_t *arr, int64_t sf) {
 void ScaleDown4(int64_t s1, int64_t s2, int64_t s3, int64_t s4, uint64_t *arr,
                 int64_t sf) {
   int64_t size = (((s1 * s2) * s3) * s4);
-
-  uint64_t *reshapedArr = make_array<uint64_t>(size);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        for (uint64_t i4 = 0; i4 < s4; i4++) {
-          int64_t linIdx =
-              ((((((i1 * s2) * s3) * s4) + ((i2 * s3) * s4)) + (i3 * s4)) + i4);
-          Arr1DIdxRowM(reshapedArr, size, linIdx) =
-              Arr4DIdxRowM(arr, s1, s2, s3, s4, i1, i2, i3, i4);
-        }
-      }
-    }
-  }
-  ScaleDown(size, reshapedArr, sf);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        for (uint64_t i4 = 0; i4 < s4; i4++) {
-          int64_t linIdx =
-              ((((((i1 * s2) * s3) * s4) + ((i2 * s3) * s4)) + (i3 * s4)) + i4);
-          Arr4DIdxRowM(arr, s1, s2, s3, s4, i1, i2, i3, i4) =
-              Arr1DIdxRowM(reshapedArr, size, linIdx);
-        }
-      }
-    }
-  }
-  ClearMemSecret1(size, reshapedArr);
+  ScaleDown(size, arr, sf);
 }
 
 void FusedBN(int32_t N, int32_t H, int32_t W, int32_t CI, int32_t fh,
@@ -2152,13 +1969,11 @@ void FusedBN(int32_t N, int32_t H, int32_t W, int32_t CI, int32_t fh,
     std::copy_n(bn_bias, CO, scaled_bias);
     ScaleUp1(CO, scaled_bias, kScale);
     for (int32_t n = 0; n < N; ++n) {
-      for (int32_t h = 0; h < newH; ++h) {
-        for (int32_t w = 0; w < newW; ++w) {
-          for (int32_t m = 0; m < CO; ++m) {
-            uint64_t val = Arr4DIdxRowM(out_tensor, N, newH, newW, CO, n, h, w, m);
-            Arr4DIdxRowM(out_tensor, N, newH, newW, CO, n, h, w, m) = SecretAdd(val, scaled_bias[m]);
-          }
-        }
+      uint64_t *out_n = out_tensor + (int64_t)n * newH * newW * CO;
+      if (kActivationCHW) {
+        MatAddBroadCastRows(CO, newH * newW, out_n, scaled_bias, out_n);
+      } else {
+        MatAddBroadCast(newH * newW, CO, out_n, scaled_bias, out_n);
       }
     }
     ClearMemSecret1(CO, scaled_bias);
@@ -2175,7 +1990,46 @@ int main(int argc, char **argv) {
   amap.arg("nt", num_threads, "Number of Threads");
   amap.arg("ell", bitlength, "Uniform Bitwidth");
   amap.arg("k", kScale, "bits of scale");
+  amap.arg("pool", kTriplePoolCmps,
+           "Expected #comparisons for the bit-triple pool (0: off)");
+  amap.arg("bitslice", kBitSlicedCmp,
+           "Bit-sliced comparisons for the ReLU, MaxPool, ArgMax, truncation");
+  amap.arg("calib", kCalibStatsPath,
+           "Calibration run: accumulate the activation ranges in this file");
+  amap.arg("bwcfg", kBitwidthConfigPath,
+           "Per-layer ReLU/truncation bitwidths (written by a calibration "
+           "run)");
+  amap.arg("budget", kCalibBudget,
+           "Max. fraction of ReLU inputs perturbed by the calibrated "
+           "bitwidths");
+  amap.arg("memplan", kMemPlanPath,
+           "Activation memory plan: recorded if missing, replayed otherwise");
+  amap.arg("workers", kConvWorkers,
+           "Server: run HomConv on these workers (ip:port,...), Cheetah only");
+  amap.arg("hompool", kHomMaskPool,
+           "Server: #pre-computed output masks per ciphertext level, "
+           "Cheetah only");
+  amap.arg("ltrunc", kLocalTruncFail,
+           "Local truncation for the layers of failure prob. below this "
+           "(0: off, needs bwcfg)");
+  amap.arg("mixed", kMixedRings,
+           "Calibration run: also derive a smaller ring per ReLU layer");
+  amap.arg("net", kNetProfile,
+           "Also report the time projected on this network: lan, wan or "
+           "latency_ms:bandwidth_mbps[:jitter_ms[:overhead_bytes]]");
+#if USE_CHEETAH
+  amap.arg("otdir", kOTStateDir,
+           "Keep the pre-OT states here between the runs (empty: off)");
+  amap.arg("otsession", kOTSession,
+           "Name of the pre-OT states (default: from the port and address)");
+  amap.arg("otwarm", kOTWarmUp, "Extend the first batch of COTs at setup");
+#endif
+  amap.arg("chw", kActivationCHW,
+           "Keep the activations in NCHW layout between layers");
   amap.parse(argc, argv);
+  if (!kMemPlanPath.empty()) {
+    activationPlanner = new ActivationPlanner(kMemPlanPath);
+  }
 
 
   assert(party == SERVER || party == CLIENT);
@@ -9711,6 +9565,9 @@ int main(int argc, char **argv) {
     Arr1DIdxRowM(tmp606, 1000, i0) = (party == SERVER) ? __tmp_in_tmp606 : 0;
   }
   StartComputation();
+  if (kActivationCHW) {
+    NHWCToNCHW(1, 224, 224, 3, tmp0);
+  }
   kIsSharedInput = false;
 
   uint64_t *tmp610 = make_array<uint64_t>(1, 112, 112, 64);
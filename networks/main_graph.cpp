@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: MIT
+
+/*
+ Runs a network described by the graph IR (see SCI/src/graph-ir.h), e.g.,
+ networks/graphs/resnet50.graph, instead of a generated main_*.cpp.
+
+ The inputs are read from stdin as for the generated programs: the image by
+ the client, the weights by the server.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+
+#include "graph-runtime.h"
+#include "library_fixed.h"
+using namespace std;
+
+int party = 0;
+int port = 32000;
+string address = "127.0.0.1";
+int num_threads = 4;
+int32_t bitlength = 41;
+int32_t kScale = 12;
+string kGraphPath;
+
+int main(int argc, char **argv) {
+  ArgMapping amap;
+
+  amap.arg("r", party, "Role of party: ALICE/SERVER = 1; BOB/CLIENT = 2");
+  amap.arg("p", port, "Port Number");
+  amap.arg("ip", address, "IP Address of server (ALICE)");
+  amap.arg("nt", num_threads, "Number of Threads");
+  amap.arg("ell", bitlength, "Uniform Bitwidth");
+  amap.arg("k", kScale, "bits of scale");
+  amap.arg("graph", kGraphPath, "Network graph, e.g., networks/graphs/*.graph");
+  amap.arg("pool", kTriplePoolCmps,
+           "Expected #comparisons for the bit-triple pool (0: off)");
+  amap.arg("bitslice", kBitSlicedCmp,
+           "Bit-sliced comparisons for the ReLU, MaxPool, ArgMax, truncation");
+  amap.arg("chw", kActivationCHW,
+           "Keep the activations in NCHW between layers (Cheetah only)");
+  amap.arg("calib", kCalibStatsPath,
+           "Calibration run: accumulate the activation ranges in this file");
+  amap.arg("bwcfg", kBitwidthConfigPath,
+           "Per-layer ReLU/truncation bitwidths (written by a calibration "
+           "run)");
+  amap.arg("budget", kCalibBudget,
+           "Max. fraction of ReLU inputs perturbed by the calibrated "
+           "bitwidths");
+  amap.arg("memplan", kMemPlanPath,
+           "Activation memory plan: recorded if missing, replayed otherwise");
+  amap.arg("workers", kConvWorkers,
+           "Server: run HomConv on these workers (ip:port,...), Cheetah only");
+  amap.arg("hompool", kHomMaskPool,
+           "Server: #pre-computed output masks per ciphertext level, "
+           "Cheetah only");
+  amap.arg("ltrunc", kLocalTruncFail,
+           "Local truncation for the layers of failure prob. below this "
+           "(0: off, needs bwcfg)");
+  amap.arg("mixed", kMixedRings,
+           "Calibration run: also derive a smaller ring per ReLU layer");
+  amap.arg("net", kNetProfile,
+           "Also report the time projected on this network: lan, wan or "
+           "latency_ms:bandwidth_mbps[:jitter_ms[:overhead_bytes]]");
+#if USE_CHEETAH
+  amap.arg("otdir", kOTStateDir,
+           "Keep the pre-OT states here between the runs (empty: off)");
+  amap.arg("otsession", kOTSession,
+           "Name of the pre-OT states (default: from the port and address)");
+  amap.arg("otwarm", kOTWarmUp, "Extend the first batch of COTs at setup");
+  amap.arg("tiles", kConvTiles,
+           "Pipeline the conv -> relu layers over this many channel tiles "
+           "(needs lanes >= 2)");
+#endif
+  amap.arg("lanes", kLanes,
+           "Run the independent branches on up to this many protocol lanes");
+  amap.parse(argc, argv);
+  if (!kMemPlanPath.empty()) {
+    activationPlanner = new ActivationPlanner(kMemPlanPath);
+  }
+
+  assert(party == SERVER || party == CLIENT);
+  Graph graph;
+  if (!graph.load(kGraphPath)) {
+    return 1;
+  }
+  graph.plan_inplace();
+  if (kConvTiles > 1) {
+    graph.plan_pipeline();
+  }
+  graph.print_summary(std::cerr);
+
+  std::cerr << "Loading input from stdin..." << std::endl;
+  GraphExecutor executor(graph);
+  executor.load(std::cin);
+  std::cerr << "input loaded, starting computation..." << std::endl;
+
+  StartComputation();
+  executor.run();
+  EndComputation();
+
+  for (size_t t = 0; t < graph.tensors().size(); ++t) {
+    const GraphTensor &out = graph.tensors()[t];
+    if (!out.is_output) {
+      continue;
+    }
+    const intType *shares = executor.tensor(t);
+    const bool is_label = graph.nodes()[out.producer].op == GraphOp::kArgMax;
+    std::vector<int64_t> values(out.size());
+    for (int64_t i = 0; i < out.size(); i++) {
+      values[i] = funcReconstruct2PCCons(shares[i], 2);
+    }
+    if (party != CLIENT) {
+      continue;
+    }
+    if (is_label) {
+      for (int64_t v : values) {
+        printf("predicted label=%lld\n", (long long)v);
+      }
+      continue;
+    }
+    std::vector<int64_t> order(values.size());
+    std::iota(order.begin(), order.end(), 0);
+    const size_t top = std::min<size_t>(10, order.size());
+    std::partial_sort(
+        order.begin(), order.begin() + top, order.end(),
+        [&](int64_t u, int64_t v) { return values[u] > values[v]; });
+    printf("top-%zu of %s\n", top, out.name.c_str());
+    printf("[");
+    for (size_t i = 0; i < top; ++i) {
+      printf("%lld,", (long long)order[i]);
+    }
+    printf("]\n");
+  }
+
+  finalize();
+}
@@ -29,27 +29,12 @@ int64_t getSignValue(uint64_t x) {
 
 void MatAddBroadCast2(int64_t s1, int64_t s2, uint64_t *A, uint64_t *B,
                       uint64_t *outArr) {
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      Arr2DIdxRowM(outArr, s1, s2, i1, i2) =
-          SecretAdd(Arr2DIdxRowM(A, s1, s2, i1, i2), Arr1DIdxRowM(B, s2, i2));
-    }
-  }
+  MatAddBroadCast(s1, s2, A, B, outArr);
 }
 
 void MatAdd4(int64_t s1, int64_t s2, int64_t s3, int64_t s4, uint64_t *A,
              uint64_t *B, uint64_t *outArr) {
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        for (uint64_t i4 = 0; i4 < s4; i4++) {
-          Arr4DIdxRowM(outArr, s1, s2, s3, s4, i1, i2, i3, i4) =
-              SecretAdd(Arr4DIdxRowM(A, s1, s2, s3, s4, i1, i2, i3, i4),
-                        Arr4DIdxRowM(B, s1, s2, s3, s4, i1, i2, i3, i4));
-        }
-      }
-    }
-  }
+  ElemWiseSecretAdd(s1 * s2 * s3 * s4, A, B, outArr);
 }
 
 void Conv2DReshapeFilter(int64_t FH, int64_t FW, int64_t CI, int64_t CO,
@@ -1570,84 +1555,16 @@ void Floor2(int64_t s1, int64_t s2, uint64_t *inArr, uint64_t *outArr,
 void ScaleUp1(int64_t s1, uint64_t *arr, int64_t sf) { ScaleUp(s1, arr, sf); }
 
 void ScaleUp2(int64_t s1, int64_t s2, uint64_t *arr, int64_t sf) {
-  int64_t size = (s1 * s2);
-
-  uint64_t *reshapedArr = make_array<uint64_t>(size);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      int64_t linIdx = ((i1 * s2) + i2);
-      Arr1DIdxRowM(reshapedArr, size, linIdx) =
-          Arr2DIdxRowM(arr, s1, s2, i1, i2);
-    }
-  }
-  ScaleUp(size, reshapedArr, sf);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      int64_t linIdx = ((i1 * s2) + i2);
-      Arr2DIdxRowM(arr, s1, s2, i1, i2) =
-          Arr1DIdxRowM(reshapedArr, size, linIdx);
-    }
-  }
-  ClearMemSecret1(size, reshapedArr);
+  ScaleUp(s1 * s2, arr, sf);
 }
 
 void ScaleUp3(int64_t s1, int64_t s2, int64_t s3, uint64_t *arr, int64_t sf) {
-  int64_t size = ((s1 * s2) * s3);
-
-  uint64_t *reshapedArr = make_array<uint64_t>(size);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        int64_t linIdx = ((((i1 * s2) * s3) + (i2 * s3)) + i3);
-        Arr1DIdxRowM(reshapedArr, size, linIdx) =
-            Arr3DIdxRowM(arr, s1, s2, s3, i1, i2, i3);
-      }
-    }
-  }
-  ScaleUp(size, reshapedArr, sf);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        int64_t linIdx = ((((i1 * s2) * s3) + (i2 * s3)) + i3);
-        Arr3DIdxRowM(arr, s1, s2, s3, i1, i2, i3) =
-            Arr1DIdxRowM(reshapedArr, size, linIdx);
-      }
-    }
-  }
-  ClearMemSecret1(size, reshapedArr);
+  ScaleUp(s1 * s2 * s3, arr, sf);
 }
 
 void ScaleUp4(int64_t s1, int64_t s2, int64_t s3, int64_t s4, uint64_t *arr,
               int64_t sf) {
-  int64_t size = (((s1 * s2) * s3) * s4);
-
-  uint64_t *reshapedArr = make_array<uint64_t>(size);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        for (uint64_t i4 = 0; i4 < s4; i4++) {
-          int64_t linIdx =
-              ((((((i1 * s2) * s3) * s4) + ((i2 * s3) * s4)) + (i3 * s4)) + i4);
-          Arr1DIdxRowM(reshapedArr, size, linIdx) =
-              Arr4DIdxRowM(arr, s1, s2, s3, s4, i1, i2, i3, i4);
-        }
-      }
-    }
-  }
-  ScaleUp(size, reshapedArr, sf);
-  for (uint64_t i1 = 0; i1 < s1; i1++) {
-    for (uint64_t i2 = 0; i2 < s2; i2++) {
-      for (uint64_t i3 = 0; i3 < s3; i3++) {
-        for (uint64_t i4 = 0; i4 < s4; i4++) {
-          int64_t linIdx =
-              ((((((i1 * s2) * s3) * s4) + ((i2 * s3) * s4)) + (i3 * s4)) + i4);
-          Arr4DIdxRowM(arr, s1, s2, s3, s4, i1, i2, i3, i4) =
-              Arr1DIdxRowM(reshapedArr, size, linIdx);
-        }
-      }
-    }
-  }
-  ClearMemSecret1(size, reshapedArr);
+  ScaleUp(s1 * s2 * s3 * s4, arr, sf);
 }
 
 void ScaleDown1(int64_t s1, uint64_t *arr, int64_t sf) {
@@ -1808,7 +1725,44 @@ int main(int argc, char **argv) {
   amap.arg("nt", num_threads, "Number of Threads");
   amap.arg("ell", bitlength, "Uniform Bitwidth");
   amap.arg("k", kScale, "bits of scale");
+  amap.arg("pool", kTriplePoolCmps,
+           "Expected #comparisons for the bit-triple pool (0: off)");
+  amap.arg("bitslice", kBitSlicedCmp,
+           "Bit-sliced comparisons for the ReLU, MaxPool, ArgMax, truncation");
+  amap.arg("calib", kCalibStatsPath,
+           "Calibration run: accumulate the activation ranges in this file");
+  amap.arg("bwcfg", kBitwidthConfigPath,
+           "Per-layer ReLU/truncation bitwidths (written by a calibration "
+           "run)");
+  amap.arg("budget", kCalibBudget,
+           "Max. fraction of ReLU inputs perturbed by the calibrated "
+           "bitwidths");
+  amap.arg("memplan", kMemPlanPath,
+           "Activation memory plan: recorded if missing, replayed otherwise");
+  amap.arg("workers", kConvWorkers,
+           "Server: run HomConv on these workers (ip:port,...), Cheetah only");
+  amap.arg("hompool", kHomMaskPool,
+           "Server: #pre-computed output masks per ciphertext level, "
+           "Cheetah only");
+  amap.arg("ltrunc", kLocalTruncFail,
+           "Local truncation for the layers of failure prob. below this "
+           "(0: off, needs bwcfg)");
+  amap.arg("mixed", kMixedRings,
+           "Calibration run: also derive a smaller ring per ReLU layer");
+  amap.arg("net", kNetProfile,
+           "Also report the time projected on this network: lan, wan or "
+           "latency_ms:bandwidth_mbps[:jitter_ms[:overhead_bytes]]");
+#if USE_CHEETAH
+  amap.arg("otdir", kOTStateDir,
+           "Keep the pre-OT states here between the runs (empty: off)");
+  amap.arg("otsession", kOTSession,
+           "Name of the pre-OT states (default: from the port and address)");
+  amap.arg("otwarm", kOTWarmUp, "Extend the first batch of COTs at setup");
+#endif
   amap.parse(argc, argv);
+  if (!kMemPlanPath.empty()) {
+    activationPlanner = new ActivationPlanner(kMemPlanPath);
+  }
 
   assert(party == SERVER || party == CLIENT);
   std::cerr << "Loading input from stdin..." << std::endl;
@@ -0,0 +1,254 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""
+Translates a generated network program (networks/main_*.cpp) into the graph
+IR of SCI/src/graph-ir.h, which is run by the graph-cheetah binary.
+
+Usage: athos2graph.py networks/main_resnet50.cpp > networks/graphs/resnet50.graph
+
+The layers are taken from the straight-line code between StartComputation()
+and EndComputation(), with the preprocessor conditionals evaluated for the
+Cheetah build (USE_CHEETAH=1). The inputs and the weights are taken from the
+stdin reads before StartComputation(), in the same order.
+"""
+
+import os
+import re
+import sys
+
+DEFINES = {"USE_CHEETAH": 1, "SCI_OT": 1}
+
+
+def preprocess(lines, defines):
+    """Keeps the lines of the active #if/#else branches."""
+    out, stack = [], []
+    for line in lines:
+        s = line.strip()
+        m = re.match(r"#\s*define\s+(\w+)\s+(\d+)", s)
+        if m and all(stack):
+            defines[m.group(1)] = int(m.group(2))
+            continue
+        m = re.match(r"#\s*(if|ifdef|ifndef)\s+(!?)\s*(\w+)", s)
+        if m:
+            kind, neg, name = m.groups()
+            if kind == "if":
+                val = int(name) if name.isdigit() else defines.get(name, 0)
+                cond = bool(val) != bool(neg)
+            else:
+                cond = (name in defines) == (kind == "ifdef")
+            stack.append(cond)
+            continue
+        if re.match(r"#\s*else", s):
+            stack[-1] = not stack[-1]
+            continue
+        if re.match(r"#\s*endif", s):
+            stack.pop()
+            continue
+        if all(stack):
+            out.append(line)
+    return "\n".join(out)
+
+
+def split_top(text, sep):
+    """Splits on `sep` outside of parentheses."""
+    parts, depth, cur = [], 0, []
+    for ch in text:
+        if ch == "(":
+            depth += 1
+        elif ch == ")":
+            depth -= 1
+        if ch == sep and depth == 0:
+            parts.append("".join(cur))
+            cur = []
+        else:
+            cur.append(ch)
+    parts.append("".join(cur))
+    return [p.strip() for p in parts]
+
+
+class Converter:
+    def __init__(self, src):
+        src = preprocess(src.splitlines(), dict(DEFINES))
+        src = re.sub(r"/\*.*?\*/", "", src, flags=re.S)
+        src = re.sub(r"//[^\n]*", "", src)
+        src = re.sub(r"\((?:u?int(?:32|64)_t)\)", "", src)
+        self.src = src
+        self.scalars = {}
+        for m in re.finditer(r"^\s*int(?:32|64)_t\s+(\w+)\s*=\s*(-?\d+)\s*;",
+                             src, re.M):
+            self.scalars[m.group(1)] = int(m.group(2))
+        self.scalars["kScale"] = "scale"  # given at run time
+        self.shapes = {}  # make_array shapes
+        self.consts = {}  # public int arrays
+        self.version = {}  # name in the C++ code -> name in the graph
+        self.lines = []
+        self.private = False
+        self.outputs = []
+
+    def value(self, arg):
+        arg = arg.strip()
+        if re.fullmatch(r"-?\d+", arg):
+            return int(arg)
+        if arg in self.scalars:
+            return self.scalars[arg]
+        raise ValueError("unknown value " + arg)
+
+    def ints(self, args):
+        return [self.value(a) for a in args]
+
+    def ref(self, name):
+        return self.version.get(name, name)
+
+    def define(self, name):
+        """A fresh graph name for a write to `name`."""
+        if name not in self.version:
+            self.version[name] = name
+            return name
+        base = name
+        k = 1
+        while "%s.%d" % (base, k) in self.version.values():
+            k += 1
+        self.version[name] = "%s.%d" % (base, k)
+        return self.version[name]
+
+    def emit(self, op, out, inputs, attrs=(), shape_of=None):
+        inputs = [self.ref(i) for i in inputs]
+        line = "%s %s = %s" % (op, self.define(out), " ".join(inputs))
+        for key, vals in attrs:
+            line += " %s=%s" % (key, ",".join(str(v) for v in vals))
+        shape = self.shapes.get(shape_of or out)
+        if shape:
+            line += "  # " + "x".join(str(d) for d in shape)
+        self.lines.append(line)
+
+    def declarations(self, head):
+        decls = []
+        for m in re.finditer(r"\*\s*(\w+)\s*=\s*make_array<uint64_t>\(([^;]*)\)\s*;",
+                             head):
+            self.shapes[m.group(1)] = self.ints(split_top(m.group(2), ","))
+        pat = (r"\(\s*\(?\s*party\s*==\s*(CLIENT|SERVER)\s*\)?\s*\)\s*\{\s*"
+               r"(?:gINPUT|cin)\s*>>\s*__tmp_in_(\w+)")
+        for m in re.finditer(pat, head):
+            owner, name = m.groups()
+            kind = "input" if owner == "CLIENT" else "weight"
+            decls.append("%s %s %s" % (kind, name,
+                                       " ".join(str(d) for d in self.shapes[name])))
+            self.version[name] = name
+        return decls
+
+    def statement(self, stmt):
+        stmt = re.sub(r"^[\s}]*", "", stmt)
+        if not stmt:
+            return
+        if re.match(r"if\s*\(\s*kActivationCHW\s*\)\s*\{", stmt):
+            return  # the executor converts the inputs itself
+        m = re.match(r"kIsSharedInput\s*=\s*(true|false)", stmt)
+        if m:
+            self.private = m.group(1) == "false"
+            return
+        m = re.match(r"u?int64_t\s*\*\s*(\w+)\s*=\s*make_array<(u?)int64_t>\((.*)\)$",
+                     stmt, re.S)
+        if m:
+            dims = self.ints(split_top(m.group(3), ","))
+            if m.group(2):
+                self.shapes[m.group(1)] = dims
+            else:
+                n = 1
+                for d in dims:
+                    n *= d
+                self.consts[m.group(1)] = [0] * n
+            return
+        m = re.match(r"int(?:32|64)_t\s+(\w+)\s*=\s*(-?\d+)$", stmt)
+        if m:
+            self.scalars[m.group(1)] = int(m.group(2))
+            return
+        m = re.match(r"Arr2DIdxRowM\((.*)\)\s*=\s*(-?\d+)$", stmt, re.S)
+        if m:
+            arr, _, s1, i, j = split_top(m.group(1), ",")
+            self.consts[arr][self.value(i) * self.value(s1) + self.value(j)] = \
+                int(m.group(2))
+            return
+        m = re.match(r"(\w+)\((.*)\)$", stmt, re.S)
+        if not m:
+            raise ValueError("unsupported statement: " + stmt)
+        self.call(m.group(1), split_top(m.group(2), ","))
+
+    def call(self, fn, a):
+        if fn.startswith("ClearMem") or fn == "NHWCToNCHW":
+            return
+        if fn == "Pad442":
+            self.emit("pad", a[12], [a[8]], [("pads", self.consts[a[11]])])
+        elif fn in ("Conv2DWrapper", "Conv2DGroupWrapper"):
+            attrs = [("stride", self.ints(a[11:13])),
+                     ("pad", self.ints(a[7:11]))]
+            if fn == "Conv2DGroupWrapper":
+                attrs.append(("groups", [self.value(a[13])]))
+            if self.private:
+                attrs.append(("private", [1]))
+            self.emit("conv2d", a[-1], a[-3:-1], attrs)
+        elif fn == "FusedBN":
+            attrs = [("stride", self.ints(a[11:13])),
+                     ("pad", self.ints(a[7:11]))]
+            if self.private:
+                attrs.append(("private", [1]))
+            self.emit("fused_bn_conv", a[17], a[13:17], attrs)
+        elif fn in ("MaxPool", "AvgPool"):
+            self.emit(fn.lower(), a[17], [a[16]],
+                      [("kernel", self.ints(a[4:6])),
+                       ("stride", self.ints(a[10:12])),
+                       ("pad", self.ints(a[6:10]))])
+        elif fn == "FusedBatchNorm4411":
+            self.emit("batchnorm", a[9], a[4:7],
+                      [("mul_shift", [self.value(a[7])]),
+                       ("bias_shift", [self.value(a[8])])])
+        elif fn in ("Relu4", "Relu"):
+            n = 4 if fn == "Relu4" else 1
+            self.emit("relu", a[n + 1], [a[n]],
+                      [("trunc", [self.value(a[n + 3])])])
+        elif fn in ("MatAdd4", "ElemWiseSecretAdd"):
+            self.emit("add", a[-1], a[-3:-1])
+        elif fn in ("MatAddBroadCast4", "MatAddBroadCast2", "MatAddBroadCast"):
+            self.emit("bias_add", a[-1], a[-3:-1])
+        elif re.fullmatch(r"Scale(Up|Down)\d?", fn):
+            op = "scale_up" if "Up" in fn else "scale_down"
+            name = a[-2]
+            self.emit(op, name, [name], [("shift", [self.value(a[-1])])],
+                      shape_of=name)
+        elif fn == "Concat2T444":
+            self.emit("concat", a[15], [a[8], a[13]],
+                      [("axis", [self.value(a[14])])])
+        elif fn == "Squeeze24":
+            self.emit("reshape", a[9], [a[8]], [("shape", self.ints(a[0:2]))])
+        elif fn == "MatMul2D":
+            self.emit("matmul", a[5], a[3:5])
+        elif fn in ("ArgMax1", "ArgMax3"):
+            self.outputs += [self.ref(a[-3]), a[-1]]
+            self.emit("argmax", a[-1], [a[-3]])
+        else:
+            raise ValueError("unsupported layer " + fn)
+
+    def convert(self, name):
+        main = self.src[self.src.index("int main("):]
+        start = main.index("StartComputation();")
+        end = main.index("EndComputation();")
+        out = ["# Generated by scripts/athos2graph.py", "graph " + name]
+        out += self.declarations(main[:start])
+        body = main[start + len("StartComputation();"):end]
+        for stmt in split_top(body, ";"):
+            self.statement(stmt)
+        out += self.lines
+        out.append("output " + " ".join(self.outputs))
+        return "\n".join(out) + "\n"
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    path = sys.argv[1]
+    name = re.sub(r"^main_", "", os.path.splitext(os.path.basename(path))[0])
+    with open(path) as f:
+        sys.stdout.write(Converter(f.read()).convert(name))
+
+
+if __name__ == "__main__":
+    main()